@@ -0,0 +1,29 @@
+// Copyright 2025 JesusTouchMe
+
+#ifndef BIBBLEVM_AOT_TRANSLATOR_H
+#define BIBBLEVM_AOT_TRANSLATOR_H 1
+
+#include <BibbleVM/core/module/module.h>
+
+#include <span>
+#include <string>
+#include <string_view>
+
+namespace bibble::aot {
+    struct Translation {
+        std::string source;
+        size_t translated = 0; // functions that became C++
+        size_t interpreted = 0; // functions found that didn't verify, which the VM keeps interpreting
+    };
+
+    // C++ source for the functions of module at the code offsets in entries, every function its link table lists by
+    // address and every function those call by address, recursively. Each function that verifies becomes one C++
+    // function with its instructions inlined, calling the others it translated directly. Calls to anything else go
+    // through the VM as usual.
+    //
+    // The source defines `bool <ns>::Register(bibble::VM& vm, bibble::u32 module)`, which makes the VM run the
+    // translations for the functions of module. It refuses modules whose code isn't what this was translated from
+    Translation TranslateModule(Module& module, std::span<const size_t> entries, std::string_view ns);
+}
+
+#endif // BIBBLEVM_AOT_TRANSLATOR_H
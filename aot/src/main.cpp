@@ -0,0 +1,54 @@
+// Copyright 2025 JesusTouchMe
+
+#include "BibbleVM-aot/translator.h"
+
+#include <BibbleVM/core/module/bbx_loader.h>
+
+#include <charconv>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+// Translates a bbx file to C++ that runs its functions without interpreting them. Compile the output into the host and
+// call <namespace>::Register(vm, module) once the module is added to a VM
+int main(int argc, char** argv) {
+    if (argc < 4) {
+        std::cerr << "usage: " << argv[0] << " <input.bbx> <output.cpp> <namespace> [entry...]\n";
+        return 1;
+    }
+
+    std::unique_ptr<bibble::Module> module = bibble::LoadBbxFile(argv[1]);
+    if (module == nullptr) {
+        std::cerr << "Could not load '" << argv[1] << "'\n";
+        return 1;
+    }
+
+    // main is at the start of the code section, anything else only reachable from the host has to be named
+    std::vector<size_t> entries;
+    if (module->code().getSize() != 0) entries.push_back(0);
+
+    for (int i = 4; i < argc; i++) {
+        std::string_view text = argv[i];
+
+        size_t entry;
+        auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), entry);
+        if (error != std::errc() || end != text.data() + text.size()) {
+            std::cerr << "Invalid entry '" << text << "'\n";
+            return 1;
+        }
+
+        entries.push_back(entry);
+    }
+
+    bibble::aot::Translation translation = bibble::aot::TranslateModule(*module, entries, argv[3]);
+
+    std::ofstream output(argv[2], std::ios::binary);
+    output << translation.source;
+    if (!output.flush()) {
+        std::cerr << "Could not write '" << argv[2] << "'\n";
+        return 1;
+    }
+
+    std::cout << argv[1] << ": " << translation.translated << " translated, " << translation.interpreted << " left to the interpreter\n";
+    return 0;
+}
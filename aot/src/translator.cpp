@@ -0,0 +1,528 @@
+// Copyright 2025 JesusTouchMe
+
+#include "BibbleVM-aot/translator.h"
+
+#include <BibbleVM/core/bytecode/operand_layout.h>
+
+#include <BibbleVM/core/exec/predecoder.h>
+#include <BibbleVM/core/exec/verifier.h>
+
+#include <BibbleVM/util/string.h>
+
+#include <bit>
+#include <cstdio>
+#include <limits>
+#include <map>
+#include <set>
+#include <sstream>
+
+namespace bibble::aot {
+    // What every translated module starts with. The arithmetic wraps like the interpreter does on every machine it runs
+    // on, instead of being undefined behaviour the C++ compiler gets to optimize around
+    static constexpr std::string_view Prelude = R"(
+    static inline i64 Add(i64 a, i64 b) { return static_cast<i64>(static_cast<u64>(a) + static_cast<u64>(b)); }
+    static inline i64 Sub(i64 a, i64 b) { return static_cast<i64>(static_cast<u64>(a) - static_cast<u64>(b)); }
+    static inline i64 Mul(i64 a, i64 b) { return static_cast<i64>(static_cast<u64>(a) * static_cast<u64>(b)); }
+    static inline i64 Neg(i64 a) { return static_cast<i64>(0 - static_cast<u64>(a)); }
+
+    static inline DispatchErr Fail(VM& vm) {
+        vm.exit(-2);
+        return DISPATCH_ERROR;
+    }
+
+    // Calls anything that isn't translated with it through its CallEntry, like CALL would
+    static inline DispatchErr Call(VM& vm, ExecState& state, u32 entry, u16 argc) {
+        const CallableTarget* target = vm.currentModule()->data().getCallable(entry, vm);
+        if (target == nullptr) return Fail(vm);
+
+        return CallNested(vm, state, *target, argc);
+    }
+
+    // Calls a function translated with it straight into its code, or through its CallEntry like Call once there's too
+    // little native stack left for that, which interprets it
+    static inline DispatchErr CallTranslated(VM& vm, ExecState& state, NativeEntry native, u32 entry, u16 argc) {
+        if (!vm.interpreter().canEnterCompiled()) return Call(vm, state, entry, argc);
+
+        return CallNative(vm, state, native, argc);
+    }
+)";
+
+    struct FunctionInfo {
+        DecodedFunction decoded;
+        std::vector<std::optional<i64>> depths; // empty if it didn't verify
+    };
+
+    static bool IsBetween(ByteOpcode opcode, ByteOpcode first, ByteOpcode last) {
+        return opcode >= first && opcode <= last;
+    }
+
+    static bool IsCall(ByteOpcode opcode) {
+        return opcode == ByteOpcode::CALL || opcode == ByteOpcode::CALL_EX || opcode == ByteOpcode::CALL_TINY || opcode == ByteOpcode::CALL_TINY_EX;
+    }
+
+    // Code offset of the function the CallEntry at offset calls, if it's in this module by address
+    static std::optional<size_t> GetLocalCallee(Module& module, u32 offset) {
+        std::optional<CallEntry> entry = CallEntry::ReadFromSection(module.data().getSection(), offset);
+        if (!entry.has_value() || entry->module != 0xFFFFFFFF || entry->address == 0xFFFFFFFF) return std::nullopt;
+
+        return entry->address;
+    }
+
+    static std::string FunctionName(size_t entry) {
+        return "Function_" + std::to_string(entry);
+    }
+
+    static std::string Integer(i64 value) {
+        if (value == std::numeric_limits<i64>::min()) return "std::numeric_limits<i64>::min()";
+        return std::to_string(value);
+    }
+
+    static std::string Floating(double value) {
+        char text[64];
+        std::snprintf(text, sizeof(text), "std::bit_cast<double>(0x%016llXull) /* %g */", static_cast<unsigned long long>(std::bit_cast<u64>(value)), value);
+        return text;
+    }
+
+    // Stack slot that holds the value at depth, relative to the stack pointer the function was entered with
+    static std::string Slot(i64 depth) {
+        return "base[" + std::to_string(depth - 1) + "]";
+    }
+
+    static std::string Pointer(i64 depth) {
+        if (depth == 0) return "base";
+        if (depth < 0) return "(base - " + std::to_string(-depth) + ")";
+        return "(base + " + std::to_string(depth) + ")";
+    }
+
+    static std::string Local(const Instruction& instruction) {
+        return "frame[" + std::to_string(static_cast<i32>(instruction.a)) + "]";
+    }
+
+    // ADD through SHR, in the order each form lays them out in
+    static std::string IntegerExpression(size_t operation, const std::string& a, const std::string& b) {
+        switch (operation) {
+            case 0: return "Add(" + a + ", " + b + ")";
+            case 1: return "Sub(" + a + ", " + b + ")";
+            case 2: return "Mul(" + a + ", " + b + ")";
+            case 3: return a + " / " + b;
+            case 4: return a + " % " + b;
+            case 5: return a + " & " + b;
+            case 6: return a + " | " + b;
+            case 7: return a + " ^ " + b;
+            case 8: return a + " << " + b;
+            default: return a + " >> " + b;
+        }
+    }
+
+    // FADD through FDIV
+    static std::string FloatingExpression(size_t operation, const std::string& a, const std::string& b) {
+        static constexpr const char* Operators[] = { " + ", " - ", " * ", " / " };
+        return a + Operators[operation] + b;
+    }
+
+    // EQ through GTE
+    static std::string Comparison(size_t operation, const std::string& a, const std::string& b) {
+        static constexpr const char* Operators[] = { " == ", " != ", " < ", " > ", " <= ", " >= " };
+        return a + Operators[operation] + b;
+    }
+
+    class FunctionWriter {
+    public:
+        FunctionWriter(std::ostringstream& out, const std::map<size_t, FunctionInfo>& functions, Module& module)
+            : mOut(out)
+            , mFunctions(functions)
+            , mModule(module) {}
+
+        void write(size_t entry, const FunctionInfo& function) {
+            const std::vector<Instruction>& instructions = function.decoded.instructions;
+
+            std::set<size_t> labels;
+            for (size_t i = 0; i < instructions.size(); i++) {
+                if (!function.depths[i].has_value()) continue;
+
+                std::optional<OperandLayout> layout = GetOperandLayout(static_cast<ByteOpcode>(instructions[i].opcode));
+                if (layout == OperandLayout::Branch) labels.insert(instructions[i].a);
+            }
+
+            u32 entryIndex = function.decoded.entryIndex;
+            if (entryIndex != 0) labels.insert(entryIndex);
+
+            mOut << "    static DispatchErr " << FunctionName(entry) << "(VM& vm, ExecState& state) {\n";
+            mOut << "        if (state.sp - state.frame < " << function.decoded.minArgs << " || state.limit - state.sp < "
+                 << function.decoded.maxGrowth << ") return Fail(vm);\n\n";
+            mOut << "        [[maybe_unused]] Value* const frame = state.frame;\n";
+            mOut << "        [[maybe_unused]] Value* const base = state.sp;\n";
+            mOut << "        Value acc = state.acc;\n\n";
+            if (entryIndex != 0) mOut << "        goto I" << entryIndex << ";\n\n";
+
+            for (size_t i = 0; i < instructions.size(); i++) {
+                if (!function.depths[i].has_value()) continue;
+
+                if (labels.contains(i)) mOut << "    I" << i << ":;\n";
+                writeInstruction(instructions[i], function.depths[i].value(), i == instructions.size() - 1);
+            }
+
+            mOut << "    }\n\n";
+        }
+
+    private:
+        std::ostringstream& mOut;
+        const std::map<size_t, FunctionInfo>& mFunctions;
+        Module& mModule;
+
+        void line(const std::string& text) {
+            mOut << "        " << text << "\n";
+        }
+
+        // acc and sp go back into state before anything that leaves the function can see them
+        void spill(i64 depth) {
+            line("state.acc = acc;");
+            line("state.sp = " + Pointer(depth) + ";");
+        }
+
+        void call(const std::string& expression, i64 depth) {
+            spill(depth);
+            line("if (DispatchErr err = " + expression + "; err != DISPATCH_SUCCESS) return err;");
+            line("acc = state.acc;");
+        }
+
+        void trap(const Instruction& instruction, i64 depth, const char* condition) {
+            std::string prefix;
+            if (condition != nullptr) {
+                line(std::string("if (") + condition + ") {");
+                prefix = "    ";
+            }
+
+            line(prefix + "state.acc = acc;");
+            line(prefix + "state.sp = " + Pointer(depth) + ";");
+            line(prefix + "if (DispatchErr err = CompiledTrap(&vm, &state, " + std::to_string(instruction.a) + "); err != DISPATCH_SUCCESS) return err;");
+            line(prefix + "acc = state.acc;");
+
+            if (condition != nullptr) line("}");
+        }
+
+        void writeInstruction(const Instruction& instruction, i64 depth, bool sentinel) {
+            ByteOpcode opcode = static_cast<ByteOpcode>(instruction.opcode);
+
+            // the trailing invalid instruction, or one without a handler. both fail where the interpreter would
+            if (sentinel || !GetOperandLayout(opcode).has_value() || instruction.opcode == 0xFF) {
+                spill(depth);
+                line("return DISPATCH_ERROR;");
+                return;
+            }
+
+            std::string top = Slot(depth);
+            std::string below = Slot(depth - 1);
+            std::string imm = GetOperandLayout(opcode) == OperandLayout::Branch || IsCall(opcode) ? "" : Integer(instruction.imm.integer());
+
+            if (IsBetween(opcode, ByteOpcode::ADD, ByteOpcode::SHR)) {
+                size_t operation = static_cast<size_t>(opcode) - static_cast<size_t>(ByteOpcode::ADD);
+                line("acc.integer() = " + IntegerExpression(operation, "acc.integer()", top + ".integer()") + ";");
+                return;
+            }
+
+            if (IsBetween(opcode, ByteOpcode::ADD2, ByteOpcode::SHR2)) {
+                size_t operation = static_cast<size_t>(opcode) - static_cast<size_t>(ByteOpcode::ADD2);
+                line("acc.integer() = " + IntegerExpression(operation, below + ".integer()", top + ".integer()") + ";");
+                return;
+            }
+
+            if (IsBetween(opcode, ByteOpcode::ADD_ST, ByteOpcode::SHR_ST)) {
+                size_t operation = static_cast<size_t>(opcode) - static_cast<size_t>(ByteOpcode::ADD_ST);
+                line(below + ".integer() = " + IntegerExpression(operation, below + ".integer()", top + ".integer()") + ";");
+                return;
+            }
+
+            if (IsBetween(opcode, ByteOpcode::ADD_IMM, ByteOpcode::SHR_IMM)) {
+                size_t operation = static_cast<size_t>(opcode) - static_cast<size_t>(ByteOpcode::ADD_IMM);
+                line("acc.integer() = " + IntegerExpression(operation, "acc.integer()", imm) + ";");
+                return;
+            }
+
+            if (IsBetween(opcode, ByteOpcode::ADD_IMM_ST, ByteOpcode::SHR_IMM_ST)) {
+                size_t operation = static_cast<size_t>(opcode) - static_cast<size_t>(ByteOpcode::ADD_IMM_ST);
+                line(top + ".integer() = " + IntegerExpression(operation, top + ".integer()", imm) + ";");
+                return;
+            }
+
+            if (IsBetween(opcode, ByteOpcode::FADD, ByteOpcode::FDIV)) {
+                size_t operation = static_cast<size_t>(opcode) - static_cast<size_t>(ByteOpcode::FADD);
+                line("acc.floating() = " + FloatingExpression(operation, "acc.floating()", top + ".floating()") + ";");
+                return;
+            }
+
+            if (IsBetween(opcode, ByteOpcode::FADD2, ByteOpcode::FDIV2)) {
+                size_t operation = static_cast<size_t>(opcode) - static_cast<size_t>(ByteOpcode::FADD2);
+                line("acc.floating() = " + FloatingExpression(operation, below + ".floating()", top + ".floating()") + ";");
+                return;
+            }
+
+            if (IsBetween(opcode, ByteOpcode::FADD_ST, ByteOpcode::FDIV_ST)) {
+                size_t operation = static_cast<size_t>(opcode) - static_cast<size_t>(ByteOpcode::FADD_ST);
+                line(below + ".floating() = " + FloatingExpression(operation, below + ".floating()", top + ".floating()") + ";");
+                return;
+            }
+
+            if (IsBetween(opcode, ByteOpcode::FADD_IMM, ByteOpcode::FDIV_IMM)) {
+                size_t operation = static_cast<size_t>(opcode) - static_cast<size_t>(ByteOpcode::FADD_IMM);
+                line("acc.floating() = " + FloatingExpression(operation, "acc.floating()", Floating(instruction.imm.floating())) + ";");
+                return;
+            }
+
+            if (IsBetween(opcode, ByteOpcode::FADD_IMM_ST, ByteOpcode::FDIV_IMM_ST)) {
+                size_t operation = static_cast<size_t>(opcode) - static_cast<size_t>(ByteOpcode::FADD_IMM_ST);
+                line(top + ".floating() = " + FloatingExpression(operation, top + ".floating()", Floating(instruction.imm.floating())) + ";");
+                return;
+            }
+
+            if (IsBetween(opcode, ByteOpcode::CMP_EQ, ByteOpcode::CMP_GTE)) {
+                size_t operation = static_cast<size_t>(opcode) - static_cast<size_t>(ByteOpcode::CMP_EQ);
+                line("acc.boolean() = " + Comparison(operation, "acc.integer()", top + ".integer()") + ";");
+                return;
+            }
+
+            if (IsBetween(opcode, ByteOpcode::FCMP_EQ, ByteOpcode::FCMP_GTE)) {
+                size_t operation = static_cast<size_t>(opcode) - static_cast<size_t>(ByteOpcode::FCMP_EQ);
+                line("acc.boolean() = " + Comparison(operation, "acc.floating()", top + ".floating()") + ";");
+                return;
+            }
+
+            if (IsBetween(opcode, ByteOpcode::CMP_EQ0, ByteOpcode::CMP_GTE0)) {
+                size_t operation = static_cast<size_t>(opcode) - static_cast<size_t>(ByteOpcode::CMP_EQ0);
+                line("acc.boolean() = " + Comparison(operation, "acc.integer()", "0") + ";");
+                return;
+            }
+
+            if (IsBetween(opcode, ByteOpcode::FCMP_EQ0, ByteOpcode::FCMP_GTE0)) {
+                size_t operation = static_cast<size_t>(opcode) - static_cast<size_t>(ByteOpcode::FCMP_EQ0);
+                line("acc.boolean() = " + Comparison(operation, "acc.floating()", "0") + ";");
+                return;
+            }
+
+            switch (opcode) {
+                case ByteOpcode::NOP:
+                case ByteOpcode::BRK:
+                case ByteOpcode::POP_DISCARD: // the depth of what comes after already accounts for it
+                    return;
+
+                case ByteOpcode::HLT:
+                    spill(depth);
+                    line("vm.exit(static_cast<int>(" + imm + "));");
+                    line("return DISPATCH_RETURN;");
+                    return;
+
+                case ByteOpcode::TRAP:
+                    trap(instruction, depth, nullptr);
+                    return;
+
+                case ByteOpcode::TRAP_IF_ZERO:
+                    trap(instruction, depth, "acc.integer() == 0");
+                    return;
+
+                case ByteOpcode::TRAP_IF_NOT_ZERO:
+                    trap(instruction, depth, "acc.integer() != 0");
+                    return;
+
+                case ByteOpcode::NEG:
+                    line("acc.integer() = Neg(acc.integer());");
+                    return;
+
+                case ByteOpcode::NOT:
+                    line("acc.integer() = ~acc.integer();");
+                    return;
+
+                case ByteOpcode::NEG_ST:
+                    line(top + ".integer() = Neg(" + top + ".integer());");
+                    return;
+
+                case ByteOpcode::NOT_ST:
+                    line(top + ".integer() = ~" + top + ".integer();");
+                    return;
+
+                case ByteOpcode::FNEG:
+                    line("acc.floating() = -acc.floating();");
+                    return;
+
+                case ByteOpcode::PUSH_ACC:
+                    line(Slot(depth + 1) + " = acc;");
+                    return;
+
+                case ByteOpcode::PUSH_SP:
+                    line(Slot(depth + 1) + " = Value(static_cast<i64>(" + Pointer(depth) + " - state.stack));");
+                    return;
+
+                case ByteOpcode::POP_ACC:
+                    line("acc = " + top + ";");
+                    return;
+
+                case ByteOpcode::CONST:
+                case ByteOpcode::CONST32:
+                case ByteOpcode::CONST64:
+                    line("acc.integer() = " + imm + ";");
+                    return;
+
+                case ByteOpcode::CONST_ST:
+                case ByteOpcode::CONST32_ST:
+                case ByteOpcode::CONST64_ST:
+                    line(Slot(depth + 1) + ".integer() = " + imm + ";");
+                    return;
+
+                case ByteOpcode::LOAD:
+                    line("acc = " + Local(instruction) + ";");
+                    return;
+
+                case ByteOpcode::LOAD_ST:
+                    line(Slot(depth + 1) + " = " + Local(instruction) + ";");
+                    return;
+
+                case ByteOpcode::STORE:
+                    line(Local(instruction) + " = acc;");
+                    return;
+
+                case ByteOpcode::STORE_ST:
+                    line(Local(instruction) + " = " + top + ";");
+                    return;
+
+                case ByteOpcode::RESERVE:
+                    line("if (" + std::to_string(instruction.a) + " >= state.limit - " + Pointer(depth) + ") return Fail(vm);");
+                    return;
+
+                case ByteOpcode::JMP:
+                    line("goto I" + std::to_string(instruction.a) + ";");
+                    return;
+
+                case ByteOpcode::JZ:
+                    line("if (!acc.boolean()) goto I" + std::to_string(instruction.a) + ";");
+                    return;
+
+                case ByteOpcode::JNZ:
+                    line("if (acc.boolean()) goto I" + std::to_string(instruction.a) + ";");
+                    return;
+
+                case ByteOpcode::CALL:
+                case ByteOpcode::CALL_EX:
+                case ByteOpcode::CALL_TINY:
+                case ByteOpcode::CALL_TINY_EX: {
+                    std::string argc = std::to_string(instruction.b);
+
+                    std::optional<size_t> callee = GetLocalCallee(mModule, instruction.a);
+                    auto translated = callee.has_value() ? mFunctions.find(callee.value()) : mFunctions.end();
+
+                    if (translated != mFunctions.end() && !translated->second.depths.empty()) {
+                        call("CallTranslated(vm, state, &" + FunctionName(callee.value()) + ", " + std::to_string(instruction.a) + ", " + argc + ")", depth);
+                    } else {
+                        call("Call(vm, state, " + std::to_string(instruction.a) + ", " + argc + ")", depth);
+                    }
+                    return;
+                }
+
+                case ByteOpcode::CALL_DYN:
+                    call("Call(vm, state, static_cast<u32>(acc.integer()), " + std::to_string(instruction.b) + ")", depth);
+                    return;
+
+                case ByteOpcode::RET:
+                    spill(depth);
+                    line("return DISPATCH_RETURN;");
+                    return;
+
+                default: // POP_SP, which never verifies
+                    spill(depth);
+                    line("return DISPATCH_ERROR;");
+                    return;
+            }
+        }
+    };
+
+    Translation TranslateModule(Module& module, std::span<const size_t> entries, std::string_view ns) {
+        const DispatchTables& tables = GetDispatchTables(false);
+
+        std::vector<size_t> worklist(entries.begin(), entries.end());
+
+        const LinkSection& links = module.links();
+        for (size_t i = 0; i < links.getCount(); i++) {
+            std::optional<LinkEntry> link = links.get(i);
+            if (!link.has_value()) continue;
+
+            std::optional<size_t> callee = GetLocalCallee(module, link->offset);
+            if (callee.has_value()) worklist.push_back(callee.value());
+        }
+
+        std::map<size_t, FunctionInfo> functions; // by entry, so the output doesn't depend on the order they're found in
+        std::set<size_t> visited;
+
+        while (!worklist.empty()) {
+            size_t entry = worklist.back();
+            worklist.pop_back();
+
+            if (!visited.insert(entry).second) continue;
+
+            std::optional<DecodedFunction> decoded = Predecode(module.code(), entry, tables);
+            if (!decoded.has_value()) continue;
+
+            for (const Instruction& instruction : decoded->instructions) {
+                if (instruction.handler == tables.invalidHandler || !IsCall(static_cast<ByteOpcode>(instruction.opcode))) continue;
+
+                std::optional<size_t> callee = GetLocalCallee(module, instruction.a);
+                if (callee.has_value()) worklist.push_back(callee.value());
+            }
+
+            FunctionInfo function{ std::move(decoded.value()) };
+            if (VerifyFunction(function.decoded)) function.depths = GetStackDepths(function.decoded);
+
+            functions.emplace(entry, std::move(function));
+        }
+
+        Translation translation;
+        std::ostringstream out;
+
+        std::span<const u8> code = module.code().getSection().getUnderlyingSpan();
+        u32 hash = util::HashSymbol(std::string_view(reinterpret_cast<const char*>(code.data()), code.size()));
+
+        out << "// Generated by BibbleVM-aot. Do not edit\n\n";
+        out << "#include <BibbleVM/core/jit/runtime.h>\n";
+        out << "#include <BibbleVM/core/vm.h>\n\n";
+        out << "#include <BibbleVM/util/string.h>\n\n";
+        out << "#include <bit>\n";
+        out << "#include <limits>\n\n";
+        out << "namespace " << ns << " {\n";
+        out << "    using namespace bibble;\n";
+        out << Prelude << "\n";
+
+        for (const auto& [entry, function] : functions) {
+            if (!function.depths.empty()) out << "    static DispatchErr " << FunctionName(entry) << "(VM& vm, ExecState& state);\n";
+        }
+        out << "\n";
+
+        FunctionWriter writer(out, functions, module);
+        for (const auto& [entry, function] : functions) {
+            if (function.depths.empty()) {
+                translation.interpreted++;
+                continue;
+            }
+
+            writer.write(entry, function);
+            translation.translated++;
+        }
+
+        out << "    bool Register(VM& vm, u32 module) {\n";
+        out << "        Module* owner = vm.getModule(module);\n";
+        out << "        if (owner == nullptr) return false;\n\n";
+        out << "        std::span<const u8> code = owner->code().getSection().getUnderlyingSpan();\n";
+        out << "        if (code.size() != " << code.size() << " || util::HashSymbol(std::string_view(reinterpret_cast<const char*>(code.data()), code.size())) != "
+            << hash << "u) return false;\n\n";
+        out << "        auto set = [&vm, owner, module](size_t entry, NativeEntry native) {\n";
+        out << "            std::optional<BytecodeReader> bytecode = owner->code().getBytecodeReader(entry);\n";
+        out << "            return bytecode.has_value() && vm.interpreter().setNativeCode(vm, CallableTarget(module, bytecode.value()), native);\n";
+        out << "        };\n\n";
+        out << "        return true";
+        for (const auto& [entry, function] : functions) {
+            if (!function.depths.empty()) out << "\n            && set(" << entry << ", &" << FunctionName(entry) << ")";
+        }
+        out << ";\n";
+        out << "    }\n";
+        out << "}\n";
+
+        translation.source = std::move(out).str();
+        return translation;
+    }
+}
@@ -0,0 +1,71 @@
+// Copyright 2025 JesusTouchMe
+
+#ifndef BIBBLEVM_BENCH_ASSEMBLER_H
+#define BIBBLEVM_BENCH_ASSEMBLER_H 1
+
+#include <BibbleVM/core/module/module.h>
+
+#include <string_view>
+#include <vector>
+
+namespace bibble::bench {
+    // Minimal in-memory assembler for writing benchmark programs. Operands are written big-endian like BytecodeReader expects
+    class Assembler {
+    public:
+        struct Label {
+            size_t id;
+        };
+
+        size_t getPosition() const;
+
+        Label newLabel();
+        void bind(Label label);
+
+        Assembler& op(ByteOpcode opcode);
+        Assembler& u8(bibble::u8 value);
+        Assembler& u16(bibble::u16 value);
+        Assembler& u32(bibble::u32 value);
+        Assembler& u64(bibble::u64 value);
+
+        // Emits JMP/JZ/JNZ with a branch resolved once the label is bound
+        Assembler& jump(ByteOpcode opcode, Label target);
+
+        // Resolves all branches. Every used label must be bound by now
+        std::vector<bibble::u8> finish();
+
+    private:
+        struct Fixup {
+            size_t operand;
+            size_t label;
+        };
+
+        std::vector<bibble::u8> mBytes;
+        std::vector<size_t> mLabels;
+        std::vector<Fixup> mFixups;
+    };
+
+    class ModuleBuilder {
+    public:
+        Assembler& code();
+
+        // CallEntry for a function in this module at a known code address. Returns its data section offset
+        bibble::u32 addCallEntry(size_t address);
+
+        // CallEntry resolved by name at link time. Names are stored inline, so they can be at most 8 bytes long
+        bibble::u32 addCallEntry(std::string_view name);
+
+        // The module as a bbx file, with a data and a code section and a link table listing every call entry
+        std::vector<bibble::u8> buildBbx();
+
+        std::unique_ptr<Module> build(); // loads buildBbx()
+
+    private:
+        Assembler mCode;
+        std::vector<bibble::u8> mData;
+        std::vector<bibble::u8> mLinks;
+
+        void addLinkEntry(bibble::u32 offset, bibble::u32 nameHash);
+    };
+}
+
+#endif // BIBBLEVM_BENCH_ASSEMBLER_H
@@ -0,0 +1,49 @@
+// Copyright 2025 JesusTouchMe
+
+#ifndef BIBBLEVM_BENCH_BENCH_H
+#define BIBBLEVM_BENCH_BENCH_H 1
+
+#include <chrono>
+#include <string_view>
+
+namespace bibble::bench {
+    using BenchmarkFn = void(*)();
+
+    void RegisterBenchmark(std::string_view name, BenchmarkFn function);
+
+    // Runs every registered benchmark whose name contains filter. Returns the amount of benchmarks ran
+    int RunBenchmarks(std::string_view filter);
+
+    void Report(std::string_view benchmark, std::string_view metric, double value, std::string_view unit);
+
+    long ResidentBytes(); // resident set size of the whole process, or -1 where we can't tell
+    long HeapBytes(); // bytes currently handed out by malloc, including memory it mapped directly, or -1 where we can't tell
+
+    template<class F>
+    double MeasureSeconds(F&& function) {
+        auto start = std::chrono::steady_clock::now();
+        function();
+        auto end = std::chrono::steady_clock::now();
+
+        return std::chrono::duration<double>(end - start).count();
+    }
+
+    // Best of `runs` to filter out scheduler noise
+    template<class F>
+    double MeasureBestSeconds(int runs, F&& function) {
+        double best = MeasureSeconds(function);
+        for (int i = 1; i < runs; i++) {
+            double seconds = MeasureSeconds(function);
+            if (seconds < best) best = seconds;
+        }
+
+        return best;
+    }
+}
+
+#define BENCHMARK(name) \
+    static void Benchmark_##name(); \
+    static const bool Registered_##name = (::bibble::bench::RegisterBenchmark(#name, Benchmark_##name), true); \
+    static void Benchmark_##name()
+
+#endif // BIBBLEVM_BENCH_BENCH_H
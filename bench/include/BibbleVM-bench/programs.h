@@ -0,0 +1,25 @@
+// Copyright 2025 JesusTouchMe
+
+#ifndef BIBBLEVM_BENCH_PROGRAMS_H
+#define BIBBLEVM_BENCH_PROGRAMS_H 1
+
+#include <BibbleVM/core/value/value.h>
+
+#include <span>
+#include <string_view>
+#include <vector>
+
+namespace bibble::bench {
+    // Programs the aot benchmark runs both interpreted and translated by BibbleVM-aot. BibbleVM-bench-programs writes
+    // them out as bbx files at build time and the translations are built into the bench, so both run the same bytes.
+    // Each one starts at code offset 0 with its arguments as its first locals and returns its result in acc
+    struct AotProgram {
+        std::string_view name; // of its bbx file and, prefixed with aot_, the namespace of its translation
+        std::vector<u8> (*build)();
+        std::vector<i64> arguments;
+    };
+
+    std::span<const AotProgram> GetAotPrograms();
+}
+
+#endif // BIBBLEVM_BENCH_PROGRAMS_H
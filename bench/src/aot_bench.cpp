@@ -0,0 +1,63 @@
+// Copyright 2025 JesusTouchMe
+
+#include "BibbleVM-bench/bench.h"
+#include "BibbleVM-bench/programs.h"
+
+#include <BibbleVM/core/module/bbx_loader.h>
+#include <BibbleVM/core/vm.h>
+
+#include <cstdlib>
+#include <string>
+
+// translated at build time from the bbx files BibbleVM-bench-programs writes
+namespace aot_tak { bool Register(bibble::VM& vm, bibble::u32 module); }
+namespace aot_collatz { bool Register(bibble::VM& vm, bibble::u32 module); }
+namespace aot_series { bool Register(bibble::VM& vm, bibble::u32 module); }
+
+namespace bibble::bench {
+    using RegisterFn = bool(*)(VM& vm, u32 module);
+
+    static RegisterFn GetTranslation(std::string_view program) {
+        if (program == "tak") return aot_tak::Register;
+        if (program == "collatz") return aot_collatz::Register;
+        if (program == "series") return aot_series::Register;
+        return nullptr;
+    }
+
+    // Runs program once to get its result, then times it. Translated means with the code BibbleVM-aot made from it
+    static u64 RunAotProgram(const AotProgram& program, bool translated) {
+        auto vm = CreateVM({ .jit = false });
+        u32 module = vm->addModule(LoadBbx(program.build()));
+
+        RegisterFn registerTranslation = GetTranslation(program.name);
+        if (translated && (registerTranslation == nullptr || !registerTranslation(*vm, module))) std::abort();
+
+        CallableTarget target(module, vm->getModule(module)->code().getBytecodeReader(0).value());
+
+        auto run = [&] {
+            vm->stack().pushFrame(static_cast<i64>(program.arguments.size()));
+            for (i64 argument : program.arguments) vm->push(argument);
+            CallableTrampoline(target, *vm);
+            vm->stack().popFrame();
+        };
+
+        run();
+        u64 result = vm->acc().uinteger();
+
+        double seconds = MeasureBestSeconds(5, run);
+        if (vm->hasExited() || vm->acc().uinteger() != result) std::abort();
+
+        Report(program.name, translated ? "aot" : "interpreted", seconds * 1e3, "ms");
+        return result;
+    }
+
+    // The same programs interpreted and translated ahead of time, which must agree on their results to the bit
+    BENCHMARK(aot) {
+        for (const AotProgram& program : GetAotPrograms()) {
+            u64 interpreted = RunAotProgram(program, false);
+            u64 translated = RunAotProgram(program, true);
+
+            if (interpreted != translated) std::abort();
+        }
+    }
+}
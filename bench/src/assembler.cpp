@@ -0,0 +1,141 @@
+// Copyright 2025 JesusTouchMe
+
+#include "BibbleVM-bench/assembler.h"
+
+#include <BibbleVM/core/module/bbx_loader.h>
+#include <BibbleVM/util/string.h>
+
+#include <stdexcept>
+
+namespace bibble::bench {
+    size_t Assembler::getPosition() const {
+        return mBytes.size();
+    }
+
+    Assembler::Label Assembler::newLabel() {
+        mLabels.push_back(SIZE_MAX);
+        return Label{mLabels.size() - 1};
+    }
+
+    void Assembler::bind(Label label) {
+        mLabels[label.id] = mBytes.size();
+    }
+
+    Assembler& Assembler::op(ByteOpcode opcode) {
+        return u8(static_cast<bibble::u8>(opcode));
+    }
+
+    Assembler& Assembler::u8(bibble::u8 value) {
+        mBytes.push_back(value);
+        return *this;
+    }
+
+    Assembler& Assembler::u16(bibble::u16 value) {
+        u8(static_cast<bibble::u8>(value >> 8));
+        return u8(static_cast<bibble::u8>(value));
+    }
+
+    Assembler& Assembler::u32(bibble::u32 value) {
+        u16(static_cast<bibble::u16>(value >> 16));
+        return u16(static_cast<bibble::u16>(value));
+    }
+
+    Assembler& Assembler::u64(bibble::u64 value) {
+        u32(static_cast<bibble::u32>(value >> 32));
+        return u32(static_cast<bibble::u32>(value));
+    }
+
+    Assembler& Assembler::jump(ByteOpcode opcode, Label target) {
+        op(opcode);
+        mFixups.push_back({mBytes.size(), target.id});
+        return u16(0);
+    }
+
+    std::vector<bibble::u8> Assembler::finish() {
+        for (const Fixup& fixup : mFixups) {
+            size_t target = mLabels[fixup.label];
+            if (target == SIZE_MAX) throw std::logic_error("branch to unbound label");
+
+            // branches are relative to the end of the instruction, which is right after the i16 operand
+            i64 branch = static_cast<i64>(target) - static_cast<i64>(fixup.operand + 2);
+            if (branch < INT16_MIN || branch > INT16_MAX) throw std::logic_error("branch out of range");
+
+            mBytes[fixup.operand] = static_cast<bibble::u8>(static_cast<bibble::u16>(branch) >> 8);
+            mBytes[fixup.operand + 1] = static_cast<bibble::u8>(branch);
+        }
+
+        return mBytes;
+    }
+
+    Assembler& ModuleBuilder::code() {
+        return mCode;
+    }
+
+    bibble::u32 ModuleBuilder::addCallEntry(size_t address) {
+        bibble::u32 offset = static_cast<bibble::u32>(mData.size());
+
+        for (int i = 0; i < 4; i++) mData.push_back(0xFF); // module
+        for (int shift = 24; shift >= 0; shift -= 8) mData.push_back(static_cast<bibble::u8>(address >> shift));
+
+        addLinkEntry(offset, 0);
+        return offset;
+    }
+
+    bibble::u32 ModuleBuilder::addCallEntry(std::string_view name) {
+        if (name.size() > 8) throw std::logic_error("inline call entry names are at most 8 bytes");
+
+        bibble::u32 offset = static_cast<bibble::u32>(mData.size());
+
+        for (int i = 0; i < 8; i++) mData.push_back(0xFF); // module, address
+        for (size_t i = 0; i < 8; i++) mData.push_back(i < name.size() ? static_cast<bibble::u8>(name[i]) : 0);
+
+        addLinkEntry(offset, util::HashSymbol(name));
+        return offset;
+    }
+
+    std::vector<bibble::u8> ModuleBuilder::buildBbx() {
+        std::vector<bibble::u8> code = mCode.finish();
+        std::vector<bibble::u8> bytes = { 'B', 'B', 'X', 0x00 };
+
+        auto put = [&bytes](bibble::u32 value, int size) {
+            for (int shift = (size - 1) * 8; shift >= 0; shift -= 8) bytes.push_back(static_cast<bibble::u8>(value >> shift));
+        };
+
+        bibble::u32 dataOffset = 8 + 3 * 16; // after the header and the section headers
+        bibble::u32 codeOffset = dataOffset + static_cast<bibble::u32>(mData.size());
+        bibble::u32 linkOffset = codeOffset + static_cast<bibble::u32>(code.size());
+
+        put(BbxVersion, 2);
+        put(3, 2); // section count
+
+        auto putSection = [&put](BbxSectionKind kind, bibble::u32 offset, size_t size) {
+            put(static_cast<bibble::u32>(kind), 4);
+            put(offset, 4);
+            put(static_cast<bibble::u32>(size), 4);
+            put(0, 4);
+        };
+
+        putSection(BbxSectionKind::DATA, dataOffset, mData.size());
+        putSection(BbxSectionKind::CODE, codeOffset, code.size());
+        putSection(BbxSectionKind::LINK, linkOffset, mLinks.size());
+
+        bytes.insert(bytes.end(), mData.begin(), mData.end());
+        bytes.insert(bytes.end(), code.begin(), code.end());
+        bytes.insert(bytes.end(), mLinks.begin(), mLinks.end());
+
+        return bytes;
+    }
+
+    void ModuleBuilder::addLinkEntry(bibble::u32 offset, bibble::u32 nameHash) {
+        for (bibble::u32 value : { offset, nameHash }) {
+            for (int shift = 24; shift >= 0; shift -= 8) mLinks.push_back(static_cast<bibble::u8>(value >> shift));
+        }
+    }
+
+    std::unique_ptr<Module> ModuleBuilder::build() {
+        std::unique_ptr<Module> module = LoadBbx(buildBbx());
+        if (module == nullptr) throw std::logic_error("built an invalid bbx file");
+
+        return module;
+    }
+}
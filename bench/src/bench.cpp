@@ -0,0 +1,75 @@
+// Copyright 2025 JesusTouchMe
+
+#include "BibbleVM-bench/bench.h"
+
+#include <cstdio>
+#include <vector>
+
+#ifdef __linux__
+#include <malloc.h>
+#include <unistd.h>
+#endif
+
+namespace bibble::bench {
+    struct RegisteredBenchmark {
+        std::string_view name;
+        BenchmarkFn function;
+    };
+
+    static std::vector<RegisteredBenchmark>& Registry() {
+        static std::vector<RegisteredBenchmark> registry;
+        return registry;
+    }
+
+    void RegisterBenchmark(std::string_view name, BenchmarkFn function) {
+        Registry().push_back({name, function});
+    }
+
+    int RunBenchmarks(std::string_view filter) {
+        int count = 0;
+
+        for (const RegisteredBenchmark& benchmark : Registry()) {
+            if (benchmark.name.find(filter) == std::string_view::npos) continue;
+
+            std::printf("[%.*s]\n", static_cast<int>(benchmark.name.size()), benchmark.name.data());
+            benchmark.function();
+            count++;
+        }
+
+        return count;
+    }
+
+    void Report(std::string_view benchmark, std::string_view metric, double value, std::string_view unit) {
+        std::printf("  %-32.*s %-28.*s %14.3f %.*s\n",
+                    static_cast<int>(benchmark.size()), benchmark.data(),
+                    static_cast<int>(metric.size()), metric.data(),
+                    value,
+                    static_cast<int>(unit.size()), unit.data());
+    }
+
+    long ResidentBytes() {
+#ifdef __linux__
+        std::FILE* file = std::fopen("/proc/self/statm", "r");
+        if (file == nullptr) return -1;
+
+        long size = 0;
+        long resident = 0;
+        int read = std::fscanf(file, "%ld %ld", &size, &resident);
+        std::fclose(file);
+
+        if (read != 2) return -1;
+        return resident * sysconf(_SC_PAGESIZE);
+#else
+        return -1;
+#endif
+    }
+
+    long HeapBytes() {
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || __GLIBC_MINOR__ >= 33)
+        struct mallinfo2 info = mallinfo2();
+        return static_cast<long>(info.uordblks + info.hblkhd);
+#else
+        return -1;
+#endif
+    }
+}
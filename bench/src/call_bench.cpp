@@ -0,0 +1,199 @@
+// Copyright 2025 JesusTouchMe
+
+#include "BibbleVM-bench/assembler.h"
+#include "BibbleVM-bench/bench.h"
+
+#include <BibbleVM/core/call/host_function.h>
+#include <BibbleVM/core/vm.h>
+
+#include <cstdlib>
+#include <string>
+
+namespace bibble::bench {
+    constexpr u32 CallIterations = 2'000'000;
+    constexpr i64 FibArgument = 30;
+    constexpr i64 SumArgument = 100'000;
+
+    struct CallProgram {
+        std::unique_ptr<Module> module;
+        size_t entry;
+        u64 calls; // made per run, not counting the host call
+        HostFunction add = nullptr; // registered as "add" before running
+    };
+
+    static i64 HostAdd(i64 a, i64 b) {
+        return a + b;
+    }
+
+    // A loop calling add(1, 2) which returns through acc, in bytecode or as a host function linked by name. The loop
+    // itself is 8 instructions per iteration
+    static CallProgram BuildCallLoop(bool host) {
+        ModuleBuilder builder;
+        Assembler& code = builder.code();
+
+        u32 add;
+        if (host) {
+            add = builder.addCallEntry("add");
+        } else {
+            add = builder.addCallEntry(code.getPosition());
+            code.op(ByteOpcode::LOAD).u16(0);
+            code.op(ByteOpcode::ADD);
+            code.op(ByteOpcode::RET);
+        }
+
+        size_t entry = code.getPosition();
+        Assembler::Label loop = code.newLabel();
+
+        code.op(ByteOpcode::RESERVE).u8(1);
+        code.op(ByteOpcode::CONST32).u32(CallIterations);
+        code.op(ByteOpcode::STORE).u16(0);
+        code.bind(loop);
+        code.op(ByteOpcode::CONST_ST).u8(1);
+        code.op(ByteOpcode::CONST_ST).u8(2);
+        code.op(ByteOpcode::CALL).u32(add).u8(2);
+        code.op(ByteOpcode::LOAD).u16(0);
+        code.op(ByteOpcode::SUB_IMM).u32(1);
+        code.op(ByteOpcode::STORE).u16(0);
+        code.op(ByteOpcode::CMP_GT0);
+        code.jump(ByteOpcode::JNZ, loop);
+        code.op(ByteOpcode::RET);
+
+        return { builder.build(), entry, CallIterations, host ? &BindHost<&HostAdd> : nullptr };
+    }
+
+    // Naive recursive fib(n), n taken from local 0. Deep and call-dominated
+    static CallProgram BuildFib() {
+        ModuleBuilder builder;
+        Assembler& code = builder.code();
+        Assembler::Label recurse = code.newLabel();
+
+        u32 fib = builder.addCallEntry(code.getPosition());
+        code.op(ByteOpcode::LOAD).u16(0);
+        code.op(ByteOpcode::SUB_IMM).u32(2);
+        code.op(ByteOpcode::CMP_LT0);
+        code.jump(ByteOpcode::JZ, recurse);
+        code.op(ByteOpcode::LOAD).u16(0);
+        code.op(ByteOpcode::RET);
+        code.bind(recurse);
+        code.op(ByteOpcode::LOAD).u16(0);
+        code.op(ByteOpcode::SUB_IMM).u32(1);
+        code.op(ByteOpcode::PUSH_ACC);
+        code.op(ByteOpcode::CALL).u32(fib).u8(1);
+        code.op(ByteOpcode::PUSH_ACC);
+        code.op(ByteOpcode::LOAD).u16(0);
+        code.op(ByteOpcode::SUB_IMM).u32(2);
+        code.op(ByteOpcode::PUSH_ACC);
+        code.op(ByteOpcode::CALL).u32(fib).u8(1);
+        code.op(ByteOpcode::ADD);
+        code.op(ByteOpcode::RET);
+
+        u64 a = 0;
+        u64 b = 1;
+        for (i64 i = 0; i <= FibArgument; i++) {
+            u64 next = a + b;
+            a = b;
+            b = next;
+        }
+
+        return { builder.build(), 0, 2 * a - 2 }; // fib(n) makes 2 * fib(n + 1) - 1 calls, one of them from the host
+    }
+
+    // Calls callee with its one argument and returns what it returned. POP_SP keeps it from verifying, so it's never
+    // compiled
+    static void EmitForward(Assembler& code, u32 callee) {
+        code.op(ByteOpcode::PUSH_SP);
+        code.op(ByteOpcode::POP_SP);
+        code.op(ByteOpcode::LOAD).u16(0);
+        code.op(ByteOpcode::PUSH_ACC);
+        code.op(ByteOpcode::CALL).u32(callee).u8(1);
+        code.op(ByteOpcode::RET);
+    }
+
+    // Recursive sum(n) = n + sum(n - 1), n taken from local 0. Far deeper than compiled code gets native stack for, so
+    // calls past that have to interpret their callees. With forward every recursive call goes through EmitForward,
+    // which keeps crossing between compiled and interpreted code
+    static CallProgram BuildSum(bool forward) {
+        ModuleBuilder builder;
+        Assembler& code = builder.code();
+
+        // forward's code comes first, and is as long whatever it calls
+        Assembler forwardSize;
+        if (forward) EmitForward(forwardSize, 0);
+
+        size_t entry = forwardSize.getPosition();
+        u32 sum = builder.addCallEntry(entry);
+        u32 callee = sum;
+
+        if (forward) {
+            callee = builder.addCallEntry(code.getPosition());
+            EmitForward(code, sum);
+        }
+
+        Assembler::Label recurse = code.newLabel();
+
+        code.op(ByteOpcode::LOAD).u16(0);
+        code.op(ByteOpcode::CMP_GT0);
+        code.jump(ByteOpcode::JNZ, recurse);
+        code.op(ByteOpcode::LOAD).u16(0);
+        code.op(ByteOpcode::RET);
+        code.bind(recurse);
+        code.op(ByteOpcode::LOAD).u16(0);
+        code.op(ByteOpcode::SUB_IMM).u32(1);
+        code.op(ByteOpcode::PUSH_ACC);
+        code.op(ByteOpcode::CALL).u32(callee).u8(1);
+        code.op(ByteOpcode::PUSH_ACC);
+        code.op(ByteOpcode::LOAD).u16(0);
+        code.op(ByteOpcode::ADD);
+        code.op(ByteOpcode::RET);
+
+        return { builder.build(), entry, static_cast<u64>(forward ? 2 * SumArgument : SumArgument) };
+    }
+
+    enum class CallMode {
+        Interpreted,
+        Compiled, // baseline JIT from the first call
+        Optimized, // optimizing JIT from the first call, which inlines small leaf callees
+    };
+
+    static void RunCallProgram(std::string_view name, CallProgram program, Value argument, i64 expected, CallMode mode) {
+        auto vm = CreateVM({
+            .jit = mode != CallMode::Interpreted,
+            .jitCallThreshold = 0,
+            .jitOptimize = mode == CallMode::Optimized,
+            .jitOptimizeThreshold = 0,
+        });
+        if (program.add != nullptr) vm->addHostFunction("add", program.add);
+
+        u32 module = vm->addModule(std::move(program.module));
+        CallableTarget target(module, vm->getModule(module)->code().getBytecodeReader(program.entry).value());
+
+        double seconds = MeasureBestSeconds(5, [&] {
+            vm->stack().pushFrame(1);
+            vm->push(argument);
+            CallableTrampoline(target, *vm);
+            vm->stack().popFrame();
+        });
+        if (vm->hasExited() || (expected >= 0 && vm->acc().integer() != expected)) std::abort();
+
+        std::string metric;
+        switch (mode) {
+            case CallMode::Interpreted: metric = "per call"; break;
+            case CallMode::Compiled: metric = "per call, jit"; break;
+            case CallMode::Optimized: metric = "per call, jit, optimized"; break;
+        }
+
+        Report(name, metric, seconds / program.calls * 1e9, "ns");
+    }
+
+    BENCHMARK(call) {
+        for (CallMode mode : { CallMode::Interpreted, CallMode::Compiled, CallMode::Optimized }) {
+            if (mode != CallMode::Interpreted && !BIBBLEVM_JIT) break;
+
+            RunCallProgram("call loop", BuildCallLoop(false), 0, -1, mode);
+            RunCallProgram("host call loop", BuildCallLoop(true), 0, -1, mode);
+            RunCallProgram("recursive fib", BuildFib(), FibArgument, 832040, mode);
+            RunCallProgram("deep recursive sum", BuildSum(false), SumArgument, SumArgument * (SumArgument + 1) / 2, mode);
+            RunCallProgram("deep mixed recursive sum", BuildSum(true), SumArgument, SumArgument * (SumArgument + 1) / 2, mode);
+        }
+    }
+}
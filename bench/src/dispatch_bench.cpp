@@ -0,0 +1,262 @@
+// Copyright 2025 JesusTouchMe
+
+#include "BibbleVM-bench/assembler.h"
+#include "BibbleVM-bench/bench.h"
+
+#include <BibbleVM/core/vm.h>
+
+#include <algorithm>
+#include <bit>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace bibble::bench {
+    constexpr u32 Iterations = 5'000'000;
+
+    struct DispatchProgram {
+        std::unique_ptr<Module> module;
+        u64 instructions; // executed per run
+    };
+
+    // Integer ALU work on the accumulator, counting a local down to zero. 11 instructions per iteration
+    static DispatchProgram BuildAluLoop() {
+        ModuleBuilder builder;
+        Assembler& code = builder.code();
+        Assembler::Label loop = code.newLabel();
+
+        code.op(ByteOpcode::RESERVE).u8(1);
+        code.op(ByteOpcode::CONST32).u32(Iterations);
+        code.op(ByteOpcode::STORE).u16(0);
+        code.bind(loop);
+        code.op(ByteOpcode::ADD_IMM).u32(3);
+        code.op(ByteOpcode::XOR_IMM).u32(0x55);
+        code.op(ByteOpcode::SHL_IMM).u32(1);
+        code.op(ByteOpcode::AND_IMM).u32(0xFFFF);
+        code.op(ByteOpcode::CMP_LT0);
+        code.op(ByteOpcode::LOAD).u16(0);
+        code.op(ByteOpcode::SUB_IMM).u32(1);
+        code.op(ByteOpcode::STORE).u16(0);
+        code.op(ByteOpcode::CMP_GT0);
+        code.op(ByteOpcode::NOP);
+        code.jump(ByteOpcode::JNZ, loop);
+        code.op(ByteOpcode::RET);
+
+        return { builder.build(), 3 + 11ull * Iterations + 1 };
+    }
+
+    // Operand stack traffic: the same countdown, but every operation goes through the stack. 10 instructions per iteration
+    static DispatchProgram BuildStackLoop() {
+        ModuleBuilder builder;
+        Assembler& code = builder.code();
+        Assembler::Label loop = code.newLabel();
+
+        code.op(ByteOpcode::RESERVE).u8(1);
+        code.op(ByteOpcode::CONST32).u32(Iterations);
+        code.op(ByteOpcode::STORE).u16(0);
+        code.bind(loop);
+        code.op(ByteOpcode::LOAD_ST).u16(0);
+        code.op(ByteOpcode::CONST_ST).u8(7);
+        code.op(ByteOpcode::ADD_ST);
+        code.op(ByteOpcode::CONST_ST).u8(7);
+        code.op(ByteOpcode::SUB_ST);
+        code.op(ByteOpcode::POP_ACC);
+        code.op(ByteOpcode::SUB_IMM).u32(1);
+        code.op(ByteOpcode::STORE).u16(0);
+        code.op(ByteOpcode::CMP_GT0);
+        code.jump(ByteOpcode::JNZ, loop);
+        code.op(ByteOpcode::RET);
+
+        return { builder.build(), 3 + 10ull * Iterations + 1 };
+    }
+
+    // Float arithmetic through the stack, iterating x = (x + 1.5) * 0.5 - x so the value settles instead of overflowing.
+    // 12 instructions per iteration
+    static DispatchProgram BuildFloatLoop() {
+        ModuleBuilder builder;
+        Assembler& code = builder.code();
+        Assembler::Label loop = code.newLabel();
+
+        code.op(ByteOpcode::RESERVE).u8(2);
+        code.op(ByteOpcode::CONST32).u32(Iterations);
+        code.op(ByteOpcode::STORE).u16(0);
+        code.op(ByteOpcode::CONST).u8(0);
+        code.op(ByteOpcode::STORE).u16(1);
+        code.bind(loop);
+        code.op(ByteOpcode::LOAD_ST).u16(1);
+        code.op(ByteOpcode::FADD_IMM_ST).u32(std::bit_cast<u32>(1.5f));
+        code.op(ByteOpcode::FMUL_IMM_ST).u32(std::bit_cast<u32>(0.5f));
+        code.op(ByteOpcode::LOAD_ST).u16(1);
+        code.op(ByteOpcode::FSUB_ST);
+        code.op(ByteOpcode::POP_ACC);
+        code.op(ByteOpcode::STORE).u16(1);
+        code.op(ByteOpcode::LOAD).u16(0);
+        code.op(ByteOpcode::SUB_IMM).u32(1);
+        code.op(ByteOpcode::STORE).u16(0);
+        code.op(ByteOpcode::CMP_GT0);
+        code.jump(ByteOpcode::JNZ, loop);
+        code.op(ByteOpcode::RET);
+
+        return { builder.build(), 5 + 12ull * Iterations + 1 };
+    }
+
+#if BIBBLEVM_THREADED_DISPATCH
+    constexpr std::string_view EngineName = "threaded";
+#else
+    constexpr std::string_view EngineName = "loop";
+#endif
+
+    enum class DispatchMode {
+        Checked,
+        Unchecked,
+        Registers, // unchecked, through the register form translation
+        Compiled, // baseline JIT from the first call
+        Optimized, // optimizing JIT from the first call
+        Tiered, // interpreted until the loop gets hot, then compiled mid-loop. a single run, or it's just Compiled again
+    };
+
+    static void RunDispatchProgram(std::string_view name, DispatchProgram program, DispatchMode mode) {
+        auto vm = CreateVM({
+            .trustBytecode = mode != DispatchMode::Checked,
+            .registerCode = mode == DispatchMode::Registers,
+            .jit = mode == DispatchMode::Compiled || mode == DispatchMode::Optimized || mode == DispatchMode::Tiered,
+            .jitCallThreshold = mode == DispatchMode::Tiered ? VMConfig().jitCallThreshold : 0,
+            .jitOptimize = mode != DispatchMode::Compiled,
+            .jitOptimizeThreshold = mode == DispatchMode::Optimized ? 0 : VMConfig().jitOptimizeThreshold,
+        });
+        u32 module = vm->addModule(std::move(program.module));
+        CallableTarget target(module, vm->getModule(module)->code().getBytecodeReader(0).value());
+
+        double seconds = MeasureBestSeconds(mode == DispatchMode::Tiered ? 1 : 5, [&] {
+            vm->stack().pushFrame(1);
+            CallableTrampoline(target, *vm);
+            vm->stack().popFrame();
+        });
+        if (vm->hasExited()) std::abort();
+
+        std::string metric;
+        switch (mode) {
+            case DispatchMode::Checked: metric = std::string(EngineName) + ", checked"; break;
+            case DispatchMode::Unchecked: metric = std::string(EngineName) + ", unchecked"; break;
+            case DispatchMode::Registers: metric = std::string(EngineName) + ", registers"; break;
+            case DispatchMode::Compiled: metric = "jit"; break;
+            case DispatchMode::Optimized: metric = "jit, optimized"; break;
+            case DispatchMode::Tiered: metric = "tiered, first run"; break;
+        }
+
+        Report(name, metric, program.instructions / seconds / 1e6, "Minst/s");
+    }
+
+    enum class InterpreterForm {
+        Plain,
+        Fused, // with superinstructions
+        Registers, // fused, then translated to register code
+    };
+
+    // Same kernels in each form the interpreter can run them in. Throughput is still counted in bytecode instructions so
+    // the numbers compare directly
+    static void RunFormProgram(std::string_view name, DispatchProgram program, InterpreterForm form) {
+        auto vm = CreateVM({
+            .superinstructions = form != InterpreterForm::Plain,
+            .registerCode = form == InterpreterForm::Registers,
+            .jit = false,
+        });
+        u32 module = vm->addModule(std::move(program.module));
+        CallableTarget target(module, vm->getModule(module)->code().getBytecodeReader(0).value());
+
+        auto run = [&] {
+            vm->stack().pushFrame(1);
+            CallableTrampoline(target, *vm);
+            vm->stack().popFrame();
+        };
+
+        std::string metric;
+        switch (form) {
+            case InterpreterForm::Plain: metric = std::string(EngineName) + ", plain"; break;
+            case InterpreterForm::Fused: metric = std::string(EngineName) + ", fused"; break;
+            case InterpreterForm::Registers: metric = std::string(EngineName) + ", registers"; break;
+        }
+
+#if BIBBLEVM_DISPATCH_PROFILE
+        // counting every dispatch makes the timings meaningless, so this build reports the counts instead
+        DispatchProfile& profile = GetDispatchProfile();
+        profile.dispatches = 0;
+        run();
+        if (vm->hasExited()) std::abort();
+
+        Report(name, metric, static_cast<double>(profile.dispatches) / 1e6, "Mdispatch");
+        Report(name, metric, static_cast<double>(profile.dispatches) / program.instructions, "dispatch/inst");
+#else
+        double seconds = MeasureBestSeconds(5, run);
+        if (vm->hasExited()) std::abort();
+
+        Report(name, metric, program.instructions / seconds / 1e6, "Minst/s");
+#endif
+    }
+
+#if BIBBLEVM_DISPATCH_PROFILE
+    // The most frequent opcode pairs seen so far, which is what FOR_EACH_SUPERINSTRUCTION is picked from
+    static void PrintTopPairs(size_t count) {
+        struct Pair {
+            u64 count;
+            size_t previous;
+            size_t next;
+        };
+
+        const DispatchProfile& profile = GetDispatchProfile();
+        std::vector<Pair> pairs;
+
+        for (size_t previous = 0; previous < DispatchProfileOpcodes; previous++) {
+            for (size_t next = 0; next < DispatchProfileOpcodes; next++) {
+                if (profile.pairs[previous][next] != 0) pairs.push_back({ profile.pairs[previous][next], previous, next });
+            }
+        }
+
+        count = std::min(count, pairs.size());
+        std::partial_sort(pairs.begin(), pairs.begin() + count, pairs.end(), [](const Pair& a, const Pair& b) { return a.count > b.count; });
+
+        for (size_t i = 0; i < count; i++) {
+            std::printf("  %02zx -> %02zx %12llu\n", pairs[i].previous, pairs[i].next, static_cast<unsigned long long>(pairs[i].count));
+        }
+    }
+#endif
+
+    BENCHMARK(superinstructions) {
+        for (InterpreterForm form : { InterpreterForm::Plain, InterpreterForm::Fused }) {
+            RunFormProgram("alu loop", BuildAluLoop(), form);
+            RunFormProgram("stack loop", BuildStackLoop(), form);
+            RunFormProgram("float loop", BuildFloatLoop(), form);
+
+#if BIBBLEVM_DISPATCH_PROFILE
+            std::printf("top pairs, %s:\n", form == InterpreterForm::Fused ? "fused" : "plain");
+            PrintTopPairs(12);
+            for (auto& row : GetDispatchProfile().pairs) row.fill(0);
+#endif
+        }
+    }
+
+    // Stack form against register form, both fused. Dispatch counts in a BIBBLEVM_DISPATCH_PROFILE build
+    BENCHMARK(registers) {
+        for (InterpreterForm form : { InterpreterForm::Fused, InterpreterForm::Registers }) {
+            RunFormProgram("alu loop", BuildAluLoop(), form);
+            RunFormProgram("stack loop", BuildStackLoop(), form);
+            RunFormProgram("float loop", BuildFloatLoop(), form);
+        }
+    }
+
+    BENCHMARK(dispatch) {
+        std::vector<DispatchMode> modes = { DispatchMode::Checked, DispatchMode::Unchecked, DispatchMode::Registers };
+        if (BIBBLEVM_JIT) {
+            modes.push_back(DispatchMode::Compiled);
+            modes.push_back(DispatchMode::Optimized);
+            modes.push_back(DispatchMode::Tiered);
+        }
+
+        for (DispatchMode mode : modes) {
+            RunDispatchProgram("alu loop", BuildAluLoop(), mode);
+            RunDispatchProgram("stack loop", BuildStackLoop(), mode);
+            RunDispatchProgram("float loop", BuildFloatLoop(), mode);
+        }
+    }
+}
@@ -0,0 +1,237 @@
+// Copyright 2025 JesusTouchMe
+
+#include "BibbleVM-bench/bench.h"
+
+#include <BibbleVM/core/vm.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace bibble::bench {
+    constexpr size_t NurserySize = 4 * 1024 * 1024;
+    constexpr u32 AllocationCount = 20'000'000;
+    constexpr u32 NodeFields = 2; // next, payload
+    constexpr int PauseRuns = 5;
+    constexpr u32 HandleCount = 1'000'000;
+    constexpr u32 PauseBudget = 500; // microseconds
+
+    static Handle* Allocate(VM& vm, u32 fieldCount) {
+        Handle* handle = vm.heap().allocate(fieldCount);
+        if (handle == nullptr) std::abort();
+
+        return handle;
+    }
+
+    // Objects nothing keeps alive, so every minor collection finds the nursery empty
+    static void RunAllocationRate() {
+        auto vm = CreateVM({ .nurserySize = NurserySize });
+
+        double seconds = MeasureBestSeconds(3, [&] {
+            for (u32 i = 0; i < AllocationCount; i++) Allocate(*vm, NodeFields);
+        });
+
+        double bytes = static_cast<double>(ObjectSize(NodeFields)) * AllocationCount;
+        Report("allocation", "per object", seconds / AllocationCount * 1e9, "ns");
+        Report("allocation", "rate", bytes / seconds / (1024 * 1024), "MiB/s");
+    }
+
+    // A million handles allocated and then freed again, one at a time and as one batch like a collection does
+    static void RunHandleChurn() {
+        HandleTable handles;
+        std::vector<Handle*> live(HandleCount);
+
+        auto allocateAll = [&] {
+            for (Handle*& handle : live) {
+                handle = handles.allocate(nullptr);
+                if (handle == nullptr) std::abort();
+            }
+        };
+
+        double allocateSeconds = 1e9;
+        double freeSeconds = 1e9;
+        double releaseSeconds = 1e9;
+
+        for (int run = 0; run < 3; run++) {
+            allocateSeconds = std::min(allocateSeconds, MeasureSeconds(allocateAll));
+            freeSeconds = std::min(freeSeconds, MeasureSeconds([&] {
+                for (Handle* handle : live) handles.free(handle);
+            }));
+
+            allocateAll();
+            releaseSeconds = std::min(releaseSeconds, MeasureSeconds([&] {
+                HandleTable::FreeBatch batch;
+                for (Handle* handle : live) batch.add(handle);
+                handles.release(batch);
+            }));
+        }
+
+        Report("handles", "allocate", allocateSeconds / HandleCount * 1e9, "ns");
+        Report("handles", "free", freeSeconds / HandleCount * 1e9, "ns");
+        Report("handles", "free in a batch", releaseSeconds / HandleCount * 1e9, "ns");
+    }
+
+    // A list of count nodes with payloads 0 to count - 1, its head in the first stack slot
+    static void BuildList(VM& vm, u32 count) {
+        vm.stack().sp() = 0;
+        vm.push(Value());
+
+        for (u32 i = 0; i < count; i++) {
+            Handle* node = Allocate(vm, NodeFields);
+            vm.heap().store(node, 0, vm.stack()[0]);
+            vm.heap().store(node, 1, Value(static_cast<i64>(i)));
+            vm.stack()[0] = MakeReference(node);
+        }
+    }
+
+    static i64 SumList(VM& vm) {
+        i64 sum = 0;
+        for (Handle* node = GetReference(vm.stack()[0]); node != nullptr; node = GetReference(Heap::load(node, 0))) {
+            sum += Heap::load(node, 1).integer();
+        }
+
+        return sum;
+    }
+
+    // half a nursery of garbage, without it getting collected on the way
+    static void FillNursery(VM& vm) {
+        u64 collections = vm.heap().stats().minorCollections;
+        size_t used = vm.heap().stats().allocatedBytes;
+
+        while (true) {
+            HeapStats stats = vm.heap().stats();
+            if (stats.minorCollections != collections) std::abort();
+            if (stats.allocatedBytes - used + ObjectSize(NodeFields) * 1024 > NurserySize / 2) break;
+
+            for (int i = 0; i < 1024; i++) Allocate(vm, NodeFields);
+        }
+    }
+
+    // Pauses of the first minor collection a list of live nodes sees, which copies it to to-space, the second, which
+    // promotes it, and the third, which only has the garbage around it left to deal with
+    static void RunMinorPauses(u32 live) {
+        double pauses[3] = { 1e9, 1e9, 1e9 };
+
+        for (int run = 0; run < PauseRuns; run++) {
+            auto vm = CreateVM({ .nurserySize = NurserySize });
+            BuildList(*vm, live);
+
+            for (double& pause : pauses) {
+                FillNursery(*vm);
+
+                double seconds = MeasureSeconds([&] { vm->heap().collectMinor(); });
+                if (seconds < pause) pause = seconds;
+            }
+
+            if (SumList(*vm) != static_cast<i64>(live) * (live - 1) / 2) std::abort();
+        }
+
+        std::string name = std::to_string(live) + " live nodes";
+        Report(name, "minor pause, copying", pauses[0] * 1e6, "us");
+        Report(name, "minor pause, promoting", pauses[1] * 1e6, "us");
+        Report(name, "minor pause, all old", pauses[2] * 1e6, "us");
+    }
+
+    // Old nodes that each get a new young node stored into them, which only the remembered set keeps alive
+    static void RunRememberedPause(u32 old) {
+        double pause = 1e9;
+
+        for (int run = 0; run < PauseRuns; run++) {
+            auto vm = CreateVM({ .nurserySize = NurserySize });
+            BuildList(*vm, old);
+            vm->heap().collectMinor();
+            vm->heap().collectMinor();
+
+            for (Handle* node = GetReference(vm->stack()[0]); node != nullptr; node = GetReference(Heap::load(node, 0))) {
+                Handle* young = Allocate(*vm, NodeFields);
+                vm->heap().store(young, 1, Heap::load(node, 1));
+                vm->heap().store(node, 1, MakeReference(young));
+            }
+
+            double seconds = MeasureSeconds([&] { vm->heap().collectMinor(); });
+            if (seconds < pause) pause = seconds;
+
+            i64 sum = 0;
+            for (Handle* node = GetReference(vm->stack()[0]); node != nullptr; node = GetReference(Heap::load(node, 0))) {
+                sum += Heap::load(GetReference(Heap::load(node, 1)), 1).integer();
+            }
+            if (sum != static_cast<i64>(old) * (old - 1) / 2) std::abort();
+        }
+
+        Report(std::to_string(old) + " old nodes", "minor pause, remembered", pause * 1e6, "us");
+    }
+
+    // Three lists of count old nodes each, allocated in turns so their nodes share every region, and the last two dropped,
+    // which leaves two thirds of each region garbage. Then the old generation is collected with one pause, and again in
+    // steps that keep to the pause budget
+    static void RunOldPauses(u32 count) {
+        double wholePause = 1e9;
+        double longestStep = 0;
+        u64 steps = 0;
+        HeapStats before;
+        HeapStats after;
+
+        for (int run = 0; run < PauseRuns; run++) {
+            for (bool incremental : { false, true }) {
+                auto vm = CreateVM({ .nurserySize = NurserySize, .gcPauseBudget = PauseBudget });
+                for (int list = 0; list < 3; list++) vm->push(Value());
+
+                for (u32 i = 0; i < count; i++) {
+                    for (int list = 0; list < 3; list++) {
+                        Handle* node = Allocate(*vm, NodeFields);
+                        vm->heap().store(node, 0, vm->stack()[list]);
+                        vm->heap().store(node, 1, Value(static_cast<i64>(i)));
+                        vm->stack()[list] = MakeReference(node);
+                    }
+                }
+
+                vm->heap().collectMinor();
+                vm->heap().collectMinor();
+                vm->heap().collectOld(); // the one the lists may have started on the way
+                vm->heap().collectOld();
+
+                vm->stack().sp() = 1;
+                before = vm->heap().stats();
+
+                if (incremental) {
+                    bool done = false;
+                    double longest = 0;
+
+                    while (!done) {
+                        double seconds = MeasureSeconds([&] { done = vm->heap().collectOldStep(); });
+                        longest = std::max(longest, seconds);
+                    }
+
+                    longestStep = run == 0 ? longest : std::min(longestStep, longest);
+                } else {
+                    wholePause = std::min(wholePause, MeasureSeconds([&] { vm->heap().collectOld(); }));
+                }
+
+                after = vm->heap().stats();
+                steps = after.oldSteps - before.oldSteps;
+
+                if (SumList(*vm) != static_cast<i64>(count) * (count - 1) / 2) std::abort();
+            }
+        }
+
+        std::string name = std::to_string(count * 3) + " old nodes, fragmented";
+        Report(name, "old pause, whole", wholePause * 1e3, "ms");
+        Report(name, "old pause, longest step", longestStep * 1e3, "ms");
+        Report(name, "old steps", static_cast<double>(steps), "");
+        Report(name, "evacuated", static_cast<double>(after.evacuatedBytes - before.evacuatedBytes) / (1024 * 1024), "MiB");
+        Report(name, "regions before", static_cast<double>(before.regions), "");
+        Report(name, "regions after", static_cast<double>(after.regions), "");
+    }
+
+    BENCHMARK(gc) {
+        RunAllocationRate();
+        RunHandleChurn();
+
+        for (u32 live : { 0u, 1'000u, 10'000u, 50'000u }) RunMinorPauses(live);
+
+        RunRememberedPause(10'000);
+
+        for (u32 count : { 100'000u, 1'000'000u }) RunOldPauses(count);
+    }
+}
@@ -0,0 +1,193 @@
+// Copyright 2025 JesusTouchMe
+
+#include "BibbleVM-bench/assembler.h"
+#include "BibbleVM-bench/bench.h"
+
+#include <BibbleVM/core/module/bbx_loader.h>
+#include <BibbleVM/core/vm.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace bibble::bench {
+    constexpr u32 LinkedFunctions = 10'000;
+    constexpr int LinkRuns = 5;
+    constexpr u32 RegisteredFunctions = 100'000;
+
+    // f0 to f9999, each an identity function
+    static const std::vector<std::string>& LibraryNames() {
+        static const std::vector<std::string> names = [] {
+            std::vector<std::string> result;
+            for (u32 i = 0; i < LinkedFunctions; i++) result.push_back("f" + std::to_string(i));
+            return result;
+        }();
+
+        return names;
+    }
+
+    static std::vector<u8> BuildLibrary() {
+        ModuleBuilder builder;
+        builder.code().op(ByteOpcode::LOAD).u16(0);
+        builder.code().op(ByteOpcode::RET);
+
+        return builder.buildBbx();
+    }
+
+    static u32 AddLibrary(VM& vm, std::unique_ptr<Module> library) {
+        u32 module = vm.addModule(std::move(library));
+        CallableTarget target(module, vm.getModule(module)->code().getBytecodeReader(0).value());
+
+        for (const std::string& name : LibraryNames()) {
+            vm.addFunction(module, name, target);
+        }
+
+        return module;
+    }
+
+    // One function calling every library function once by name, so each call site links on its first call
+    static std::vector<u8> BuildCaller() {
+        ModuleBuilder builder;
+        Assembler& code = builder.code();
+
+        std::vector<u32> entries;
+        for (const std::string& name : LibraryNames()) entries.push_back(builder.addCallEntry(name));
+
+        for (u32 entry : entries) {
+            code.op(ByteOpcode::CONST_ST).u8(1);
+            code.op(ByteOpcode::CALL).u32(entry).u8(1);
+        }
+        code.op(ByteOpcode::RET);
+
+        return builder.buildBbx();
+    }
+
+    static bool WriteFile(const std::filesystem::path& path, const std::vector<u8>& bytes) {
+        std::FILE* file = std::fopen(path.string().c_str(), "wb");
+        if (file == nullptr) return false;
+
+        bool written = std::fwrite(bytes.data(), 1, bytes.size(), file) == bytes.size();
+        return std::fclose(file) == 0 && written;
+    }
+
+    static bool RunMain(VM& vm, const CallableTarget& target) {
+        vm.stack().pushFrame(1);
+        CallableTrampoline(target, vm);
+        vm.stack().popFrame();
+
+        return !vm.hasExited();
+    }
+
+    static void RunLink(bool eager) {
+        double bestAdd = 0;
+        double bestRun = 0;
+
+        for (int run = 0; run < LinkRuns; run++) {
+            auto vm = CreateVM({ .jit = false, .eagerLink = eager });
+            AddLibrary(*vm, LoadBbx(BuildLibrary()));
+
+            std::unique_ptr<Module> caller = LoadBbx(BuildCaller());
+
+            u32 module = 0;
+            double add = MeasureSeconds([&] { module = vm->addModule(std::move(caller)); });
+
+            CallableTarget target(module, vm->getModule(module)->code().getBytecodeReader(0).value());
+            bool ran = false;
+            double first = MeasureSeconds([&] { ran = RunMain(*vm, target); });
+            if (!ran) std::abort();
+
+            if (run == 0 || add < bestAdd) bestAdd = add;
+            if (run == 0 || first < bestRun) bestRun = first;
+        }
+
+        std::string_view name = eager ? "eager link" : "lazy link";
+        Report(name, "addModule", bestAdd * 1e6, "us");
+        Report(name, "first run, 10k call sites", bestRun * 1e6, "us");
+    }
+
+    // Adding and looking up as many functions as a large program links against
+    static void RunRegistry() {
+        std::vector<std::string> names;
+        for (u32 i = 0; i < RegisteredFunctions; i++) names.push_back("symbol_" + std::to_string(i));
+
+        auto vm = CreateVM({ .stackSize = 4096, .jit = false });
+        ModuleBuilder builder;
+        builder.code().op(ByteOpcode::RET);
+
+        u32 module = vm->addModule(builder.build());
+        CallableTarget target(module, vm->getModule(module)->code().getBytecodeReader(0).value());
+
+        long heapBefore = HeapBytes();
+        double add = MeasureSeconds([&] {
+            for (const std::string& name : names) vm->addFunction(module, name, target);
+        });
+        long heapAfter = HeapBytes();
+
+        double find = MeasureBestSeconds(5, [&] {
+            for (const std::string& name : names) {
+                if (vm->getFunction(name) == nullptr) std::abort();
+            }
+        });
+
+        Report("100k functions", "addFunction", add / RegisteredFunctions * 1e9, "ns");
+        Report("100k functions", "getFunction", find / RegisteredFunctions * 1e9, "ns");
+        if (heapBefore >= 0 && heapAfter >= 0) {
+            Report("100k functions", "heap per function", static_cast<double>(heapAfter - heapBefore) / RegisteredFunctions, "B");
+        }
+    }
+
+    // Starting a script from its bbx files, adding its functions and linking as it runs, against starting it from an
+    // image of a VM that already did all that
+    static void RunImage() {
+        std::filesystem::path directory = std::filesystem::temp_directory_path();
+        std::filesystem::path libraryPath = directory / "bibblevm-link-bench-library.bbx";
+        std::filesystem::path callerPath = directory / "bibblevm-link-bench-caller.bbx";
+        std::filesystem::path imagePath = directory / "bibblevm-link-bench.bbi";
+
+        bool written = WriteFile(libraryPath, BuildLibrary()) && WriteFile(callerPath, BuildCaller());
+
+        auto start = [&] {
+            auto vm = CreateVM({ .stackSize = 4096, .jit = false });
+            AddLibrary(*vm, LoadBbxFile(libraryPath.string()));
+
+            u32 caller = vm->addModule(LoadBbxFile(callerPath.string()));
+            vm->addFunction(caller, "main", CallableTarget(caller, vm->getModule(caller)->code().getBytecodeReader(0).value()));
+
+            return vm;
+        };
+
+        if (written) {
+            auto saved = start();
+            if (!RunMain(*saved, saved->getFunction("main")->target()) || !saved->saveImage(imagePath.string())) std::abort();
+
+            double files = MeasureBestSeconds(LinkRuns, [&] {
+                auto vm = start();
+                if (!RunMain(*vm, vm->getFunction("main")->target())) std::abort();
+            });
+
+            double image = MeasureBestSeconds(LinkRuns, [&] {
+                auto vm = CreateVMFromImage(imagePath.string(), { .stackSize = 4096, .jit = false });
+                if (vm == nullptr || !RunMain(*vm, vm->getFunction("main")->target())) std::abort();
+            });
+
+            Report("startup + first run", "from bbx files", files * 1e6, "us");
+            Report("startup + first run", "from image", image * 1e6, "us");
+        }
+
+        std::filesystem::remove(libraryPath);
+        std::filesystem::remove(callerPath);
+        std::filesystem::remove(imagePath);
+    }
+
+    BENCHMARK(link) {
+        RunRegistry();
+
+        RunLink(false);
+        RunLink(true);
+
+        RunImage();
+    }
+}
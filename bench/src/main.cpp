@@ -0,0 +1,16 @@
+// Copyright 2025 JesusTouchMe
+
+#include "BibbleVM-bench/bench.h"
+
+#include <iostream>
+
+int main(int argc, char** argv) {
+    std::string_view filter = argc > 1 ? argv[1] : "";
+
+    if (bibble::bench::RunBenchmarks(filter) == 0) {
+        std::cerr << "No benchmarks matched '" << filter << "'\n";
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,144 @@
+// Copyright 2025 JesusTouchMe
+
+#include "BibbleVM-bench/assembler.h"
+#include "BibbleVM-bench/programs.h"
+
+#include <bit>
+
+namespace bibble::bench {
+    constexpr u32 CollatzLimit = 100'000;
+    constexpr u32 SeriesTerms = 10'000'000;
+
+    // Takeuchi's function, tak(x, y, z) from locals 0 to 2. Three arguments a call and deep recursion
+    static std::vector<u8> BuildTak() {
+        ModuleBuilder builder;
+        Assembler& code = builder.code();
+        Assembler::Label recurse = code.newLabel();
+
+        u32 tak = builder.addCallEntry(code.getPosition());
+        code.op(ByteOpcode::LOAD).u16(1);
+        code.op(ByteOpcode::PUSH_ACC);
+        code.op(ByteOpcode::LOAD).u16(0);
+        code.op(ByteOpcode::CMP_GT);
+        code.jump(ByteOpcode::JNZ, recurse);
+        code.op(ByteOpcode::LOAD).u16(2);
+        code.op(ByteOpcode::RET);
+        code.bind(recurse);
+
+        // tak(x - 1, y, z), tak(y - 1, z, x), tak(z - 1, x, y), each rotating the locals once more
+        for (u16 first = 0; first < 3; first++) {
+            code.op(ByteOpcode::LOAD).u16(first);
+            code.op(ByteOpcode::SUB_IMM).u32(1);
+            code.op(ByteOpcode::PUSH_ACC);
+            code.op(ByteOpcode::LOAD_ST).u16((first + 1) % 3);
+            code.op(ByteOpcode::LOAD_ST).u16((first + 2) % 3);
+            code.op(ByteOpcode::CALL).u32(tak).u8(3);
+            code.op(ByteOpcode::PUSH_ACC);
+        }
+
+        code.op(ByteOpcode::CALL).u32(tak).u8(3);
+        code.op(ByteOpcode::RET);
+
+        return builder.buildBbx();
+    }
+
+    // Total Collatz steps of every number up to CollatzLimit. Branchy integer work on locals: n in 0, x in 1, steps in 2
+    static std::vector<u8> BuildCollatz() {
+        ModuleBuilder builder;
+        Assembler& code = builder.code();
+        Assembler::Label outer = code.newLabel();
+        Assembler::Label inner = code.newLabel();
+        Assembler::Label odd = code.newLabel();
+        Assembler::Label done = code.newLabel();
+
+        code.op(ByteOpcode::RESERVE).u8(3);
+        code.op(ByteOpcode::CONST32).u32(CollatzLimit);
+        code.op(ByteOpcode::STORE).u16(0);
+        code.op(ByteOpcode::CONST).u8(0);
+        code.op(ByteOpcode::STORE).u16(2);
+        code.bind(outer);
+        code.op(ByteOpcode::LOAD).u16(0);
+        code.op(ByteOpcode::STORE).u16(1);
+        code.bind(inner);
+        code.op(ByteOpcode::LOAD).u16(1);
+        code.op(ByteOpcode::SUB_IMM).u32(1);
+        code.jump(ByteOpcode::JZ, done);
+        code.op(ByteOpcode::LOAD).u16(2);
+        code.op(ByteOpcode::ADD_IMM).u32(1);
+        code.op(ByteOpcode::STORE).u16(2);
+        code.op(ByteOpcode::LOAD).u16(1);
+        code.op(ByteOpcode::MOD_IMM).u32(2);
+        code.jump(ByteOpcode::JNZ, odd);
+        code.op(ByteOpcode::LOAD).u16(1);
+        code.op(ByteOpcode::DIV_IMM).u32(2);
+        code.op(ByteOpcode::STORE).u16(1);
+        code.jump(ByteOpcode::JMP, inner);
+        code.bind(odd);
+        code.op(ByteOpcode::LOAD).u16(1);
+        code.op(ByteOpcode::MUL_IMM).u32(3);
+        code.op(ByteOpcode::ADD_IMM).u32(1);
+        code.op(ByteOpcode::STORE).u16(1);
+        code.jump(ByteOpcode::JMP, inner);
+        code.bind(done);
+        code.op(ByteOpcode::LOAD).u16(0);
+        code.op(ByteOpcode::SUB_IMM).u32(1);
+        code.op(ByteOpcode::STORE).u16(0);
+        code.op(ByteOpcode::CMP_GT0);
+        code.jump(ByteOpcode::JNZ, outer);
+        code.op(ByteOpcode::LOAD).u16(2);
+        code.op(ByteOpcode::RET);
+
+        return builder.buildBbx();
+    }
+
+    // The Leibniz series for pi over SeriesTerms terms. Float work through acc and the stack: count in local 0,
+    // denominator in 1, sum in 2 and the numerator, which flips sign every term, in 3
+    static std::vector<u8> BuildSeries() {
+        ModuleBuilder builder;
+        Assembler& code = builder.code();
+        Assembler::Label loop = code.newLabel();
+
+        code.op(ByteOpcode::RESERVE).u8(4);
+        code.op(ByteOpcode::CONST32).u32(SeriesTerms);
+        code.op(ByteOpcode::STORE).u16(0);
+        code.op(ByteOpcode::CONST64).u64(std::bit_cast<u64>(1.0));
+        code.op(ByteOpcode::STORE).u16(1);
+        code.op(ByteOpcode::CONST).u8(0);
+        code.op(ByteOpcode::STORE).u16(2);
+        code.op(ByteOpcode::CONST64).u64(std::bit_cast<u64>(4.0));
+        code.op(ByteOpcode::STORE).u16(3);
+        code.bind(loop);
+        code.op(ByteOpcode::LOAD_ST).u16(1);
+        code.op(ByteOpcode::LOAD).u16(3);
+        code.op(ByteOpcode::FDIV);
+        code.op(ByteOpcode::PUSH_ACC);
+        code.op(ByteOpcode::LOAD).u16(2);
+        code.op(ByteOpcode::FADD);
+        code.op(ByteOpcode::STORE).u16(2);
+        code.op(ByteOpcode::LOAD).u16(3);
+        code.op(ByteOpcode::FNEG);
+        code.op(ByteOpcode::STORE).u16(3);
+        code.op(ByteOpcode::LOAD).u16(1);
+        code.op(ByteOpcode::FADD_IMM).u32(std::bit_cast<u32>(2.0f));
+        code.op(ByteOpcode::STORE).u16(1);
+        code.op(ByteOpcode::LOAD).u16(0);
+        code.op(ByteOpcode::SUB_IMM).u32(1);
+        code.op(ByteOpcode::STORE).u16(0);
+        code.op(ByteOpcode::CMP_GT0);
+        code.jump(ByteOpcode::JNZ, loop);
+        code.op(ByteOpcode::LOAD).u16(2);
+        code.op(ByteOpcode::RET);
+
+        return builder.buildBbx();
+    }
+
+    std::span<const AotProgram> GetAotPrograms() {
+        static const AotProgram programs[] = {
+            { "tak", BuildTak, { 18, 12, 6 } },
+            { "collatz", BuildCollatz, {} },
+            { "series", BuildSeries, {} },
+        };
+
+        return programs;
+    }
+}
@@ -0,0 +1,29 @@
+// Copyright 2025 JesusTouchMe
+
+#include "BibbleVM-bench/programs.h"
+
+#include <fstream>
+#include <iostream>
+#include <string>
+
+// Writes the aot benchmark's programs as <directory>/<name>.bbx for BibbleVM-aot to translate
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::cerr << "usage: " << argv[0] << " <directory>\n";
+        return 1;
+    }
+
+    for (const bibble::bench::AotProgram& program : bibble::bench::GetAotPrograms()) {
+        std::string path = std::string(argv[1]) + "/" + std::string(program.name) + ".bbx";
+        std::vector<bibble::u8> bytes = program.build();
+
+        std::ofstream output(path, std::ios::binary);
+        output.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+        if (!output.flush()) {
+            std::cerr << "Could not write '" << path << "'\n";
+            return 1;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,116 @@
+// Copyright 2025 JesusTouchMe
+
+#include "BibbleVM-bench/assembler.h"
+#include "BibbleVM-bench/bench.h"
+
+#include <BibbleVM/core/module/bbx_loader.h>
+#include <BibbleVM/core/vm.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <memory>
+#include <vector>
+
+namespace bibble::bench {
+    constexpr int CreateIterations = 200;
+    constexpr int LiveVMs = 32;
+    constexpr int LoadIterations = 20;
+    constexpr size_t LargeModuleCode = 16 * 1024 * 1024;
+    constexpr u32 LargeModuleCallEntries = 4096;
+
+    static void RunStartup(std::string_view name, VMConfig config) {
+        // footprint first, before freed VMs leave memory around for the allocator to hand back out
+        long heapBefore = HeapBytes();
+        long residentBefore = ResidentBytes();
+
+        std::vector<std::unique_ptr<VM>> vms;
+        for (int i = 0; i < LiveVMs; i++) {
+            vms.push_back(CreateVM(config));
+        }
+
+        long heapAfter = HeapBytes();
+        long residentAfter = ResidentBytes();
+        vms.clear();
+
+        if (heapBefore >= 0 && heapAfter >= 0) {
+            Report(name, "heap per live VM", static_cast<double>(heapAfter - heapBefore) / LiveVMs / 1024, "KiB");
+        }
+        if (residentBefore >= 0 && residentAfter >= 0) {
+            Report(name, "resident per live VM", static_cast<double>(residentAfter - residentBefore) / LiveVMs / 1024, "KiB");
+        }
+
+        double seconds = MeasureBestSeconds(5, [&] {
+            for (int i = 0; i < CreateIterations; i++) {
+                auto vm = CreateVM(config);
+            }
+        });
+
+        Report(name, "CreateVM + destroy", seconds / CreateIterations * 1e6, "us");
+    }
+
+    // A function that returns right away at the start of a code section padded to size with NOPs, and a data section of
+    // call entries
+    static std::vector<u8> BuildLargeBbx() {
+        ModuleBuilder builder;
+        Assembler& code = builder.code();
+
+        code.op(ByteOpcode::RET);
+        while (code.getPosition() < LargeModuleCode) code.op(ByteOpcode::NOP);
+
+        for (u32 i = 0; i < LargeModuleCallEntries; i++) builder.addCallEntry(0);
+
+        return builder.buildBbx();
+    }
+
+    // load returns false if it failed
+    template<class F>
+    static void RunLoad(std::string_view metric, F&& load) {
+        double seconds = MeasureBestSeconds(5, [&] {
+            for (int i = 0; i < LoadIterations; i++) {
+                if (!load()) std::abort();
+            }
+        });
+
+        Report("16 MiB bbx", metric, seconds / LoadIterations * 1e6, "us");
+    }
+
+    static void RunBbxLoad() {
+        std::vector<u8> bytes = BuildLargeBbx();
+
+        std::filesystem::path path = std::filesystem::temp_directory_path() / "bibblevm-startup-bench.bbx";
+        std::FILE* file = std::fopen(path.string().c_str(), "wb");
+        if (file == nullptr) return;
+
+        bool written = std::fwrite(bytes.data(), 1, bytes.size(), file) == bytes.size();
+        std::fclose(file);
+
+        if (written) {
+            RunLoad("LoadBbxFile, mapped", [&] { return LoadBbxFile(path.string()) != nullptr; });
+            RunLoad("LoadBbx, copied from memory", [&] { return LoadBbx(bytes) != nullptr; });
+
+            // only the function that runs is decoded and verified, the rest of the code is never read
+            RunLoad("LoadBbxFile + first call", [&] {
+                auto vm = CreateVM({ .stackSize = 4096 });
+                u32 module = vm->addModule(LoadBbxFile(path.string()));
+                CallableTarget target(module, vm->getModule(module)->code().getBytecodeReader(0).value());
+
+                vm->stack().pushFrame(1);
+                CallableTrampoline(target, *vm);
+
+                return !vm->hasExited();
+            });
+        }
+
+        std::filesystem::remove(path);
+    }
+
+    BENCHMARK(startup) {
+        Report("VM", "sizeof", sizeof(VM) / 1024.0, "KiB");
+
+        RunStartup("4096 slot stack", { .stackSize = 4096 });
+        RunStartup("default config", {});
+
+        RunBbxLoad();
+    }
+}
@@ -0,0 +1,73 @@
+// Copyright 2025 JesusTouchMe
+
+#include "BibbleVM-bench/assembler.h"
+#include "BibbleVM-bench/bench.h"
+
+#include <BibbleVM/core/vm.h>
+
+#include <cstdio>
+#include <cstdlib>
+
+namespace bibble::bench {
+    constexpr u32 TrapIterations = 1'000'000;
+
+    // What TRAP 0 used to do, flushing the line to the sink on every trap
+    static bool PrintIntegerFlushed(VM& vm, u8) {
+        OutputBuffer& output = vm.output();
+        output.writeInteger(vm.acc().integer());
+        output.writeChar('\n');
+        output.flush();
+        return true;
+    }
+
+    // A loop printing its counter with TRAP 0 every iteration
+    static std::unique_ptr<Module> BuildPrintLoop() {
+        ModuleBuilder builder;
+        Assembler& code = builder.code();
+        Assembler::Label loop = code.newLabel();
+
+        code.op(ByteOpcode::RESERVE).u8(1);
+        code.op(ByteOpcode::CONST32).u32(TrapIterations);
+        code.op(ByteOpcode::STORE).u16(0);
+        code.bind(loop);
+        code.op(ByteOpcode::LOAD).u16(0);
+        code.op(ByteOpcode::TRAP).u8(static_cast<u8>(TrapCode::PRINT_INTEGER));
+        code.op(ByteOpcode::SUB_IMM).u32(1);
+        code.op(ByteOpcode::STORE).u16(0);
+        code.op(ByteOpcode::CMP_GT0);
+        code.jump(ByteOpcode::JNZ, loop);
+        code.op(ByteOpcode::RET);
+
+        return builder.build();
+    }
+
+    static void RunPrintLoop(std::string_view metric, std::FILE* sink, bool flushed) {
+        auto vm = CreateVM({ .jit = false });
+        vm->output().setSink(sink);
+        if (flushed) vm->setTrapHandler(static_cast<u8>(TrapCode::PRINT_INTEGER), PrintIntegerFlushed);
+
+        u32 module = vm->addModule(BuildPrintLoop());
+        CallableTarget target(module, vm->getModule(module)->code().getBytecodeReader(0).value());
+
+        double seconds = MeasureBestSeconds(3, [&] {
+            vm->stack().pushFrame(1);
+            CallableTrampoline(target, *vm);
+            vm->stack().popFrame();
+            vm->output().flush();
+        });
+        if (vm->hasExited()) std::abort();
+
+        Report("print loop", metric, seconds / TrapIterations * 1e9, "ns");
+    }
+
+    BENCHMARK(traps) {
+        // a real file descriptor so flushing costs the syscall it would on a terminal or pipe
+        std::FILE* sink = std::fopen("/dev/null", "w");
+        if (sink == nullptr) return;
+
+        RunPrintLoop("per trap, flushed every trap", sink, true);
+        RunPrintLoop("per trap, buffered", sink, false);
+
+        std::fclose(sink);
+    }
+}
@@ -3,10 +3,49 @@
 #ifndef BIBBLEVM_CONFIG_H
 #define BIBBLEVM_CONFIG_H 1
 
+#include <cstddef>
+#include <functional>
+
 namespace bibble {
+    class TrapTable;
+
+    // A function that got hot enough to be compiled. Reported whether or not the compiler accepted it
+    struct TierUpEvent {
+        enum class Reason {
+            Calls, // called jitCallThreshold (or jitOptimizeThreshold) times
+            BackEdges, // one of its loops went around jitBackEdgeThreshold (or jitOptimizeThreshold) times. compiled code takes over mid-loop (OSR)
+        };
+
+        enum class Tier {
+            Baseline, // from the interpreter, by CompileBaseline
+            Optimized, // from baseline code, by CompileOptimized
+        };
+
+        Reason reason;
+        Tier tier;
+        u32 module;
+        size_t entry; // code section offset of the function
+        u32 instruction; // where compiled code takes over. the entry instruction, or the loop header for BackEdges
+        bool compiled; // false if the function stays in the tier it's in for good
+    };
+
     struct VMConfig {
         i64 stackSize = 0x100000; // this is the value of 8MB divided by 8 which is the size of a stack slot. in total, gives us 8mb big stack
         bool sandbox = false;
+        bool trustBytecode = false; // run bytecode without per-instruction bounds checks. ignored when sandbox is set
+        bool superinstructions = true; // fuse common instruction sequences into single dispatches when pre-decoding
+        bool registerCode = true; // interpret verified functions through a translation to three-address code over their frame slots
+        bool jit = true; // compile hot verified functions to machine code. needs a BIBBLEVM_JIT build
+        u32 jitCallThreshold = 1000; // interpreted calls before a function is compiled. 0 compiles it on its first call
+        u32 jitBackEdgeThreshold = 10000; // taken backward branches of one loop before its function is compiled and entered mid-loop
+        bool jitOptimize = true; // recompile functions that stay hot in baseline code with the optimizing compiler
+        u32 jitOptimizeThreshold = 10000; // calls into, or taken back-edges of one loop in, baseline code before a function is optimized. 0 optimizes it right away
+        std::function<void(const TierUpEvent&)> onTierUp; // called after each attempt to compile a hot function
+        size_t nativeStackSize = 1024 * 1024; // bytes of native stack the VM may take below the host's outermost call into it. calls into and out of compiled code and host functions calling back in each take some, past it they exit the VM with -2
+        bool eagerLink = false; // link all of a module's call entries when it's added instead of each on its first call
+        const TrapTable* traps = nullptr; // handlers for the trap codes, or nullptr for GetDefaultTrapTable(sandbox). must outlive the VM
+        size_t nurserySize = 4 * 1024 * 1024; // bytes in each of the two semi-spaces new objects are allocated in. only allocated on the first object
+        u32 gcPauseBudget = 1000; // microseconds each step of an old generation collection runs for before letting the program go on
     };
 }
 
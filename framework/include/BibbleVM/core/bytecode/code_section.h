@@ -11,6 +11,10 @@ namespace bibble {
     public:
         explicit CodeSection(Section section);
 
+        const Section& getSection() const;
+
+        size_t getSize() const;
+
         std::optional<BytecodeReader> getBytecodeReader(size_t offset) const;
 
     private:
@@ -26,6 +26,8 @@ namespace bibble {
     public:
         explicit DataSection(Section section);
 
+        const Section& getSection() const;
+
         std::optional<i8> getByte(u32 offset);
         std::optional<i16> getShort(u32 offset);
         std::optional<i32> getInt(u32 offset);
@@ -34,7 +36,13 @@ namespace bibble {
         std::optional<double> getDouble(u32 offset);
         std::optional<std::string_view> getString(u32 offset, const StrtabSection& strtab);
 
-        const CallableTarget* getCallable(u32 offset, VM& vm);
+        const CallableTarget* getCallable(u32 offset, VM& vm); // linked on first use, this is the current module's data section
+
+        // Links the CallEntry at offset, from module's code or by name. nameHash is util::HashSymbol of its name if it's
+        // already known. nullptr if it can't be linked (yet)
+        const CallableTarget* link(u32 offset, VM& vm, u32 module, std::optional<u32> nameHash = std::nullopt);
+
+        void reserveCallables(size_t count); // before linking count entries in one go
 
     private:
         Section mSection;
@@ -0,0 +1,32 @@
+// Copyright 2025 JesusTouchMe
+
+#ifndef BIBBLEVM_CORE_LINK_SECTION_H
+#define BIBBLEVM_CORE_LINK_SECTION_H 1
+
+#include "BibbleVM/core/bytecode/section.h"
+
+namespace bibble {
+    // Where a module's call entries are, so all of them can be linked at once. name hash is the util::HashSymbol of
+    // the name of entries resolved by name, and unused for the rest
+    struct LinkEntry {
+        u32 offset; // of the CallEntry in the data section
+        u32 nameHash;
+
+        static std::optional<LinkEntry> ReadFromSection(const Section& section, size_t offset);
+    };
+
+    class LinkSection {
+    public:
+        explicit LinkSection(Section section);
+
+        const Section& getSection() const;
+
+        size_t getCount() const;
+        std::optional<LinkEntry> get(size_t index) const;
+
+    private:
+        Section mSection;
+    };
+}
+
+#endif // BIBBLEVM_CORE_LINK_SECTION_H
@@ -0,0 +1,39 @@
+// Copyright 2025 JesusTouchMe
+
+#ifndef BIBBLEVM_CORE_OPERAND_LAYOUT_H
+#define BIBBLEVM_CORE_OPERAND_LAYOUT_H 1
+
+#include "BibbleVM/core/bytecode/opcodes.h"
+
+#include <cstddef>
+#include <optional>
+
+namespace bibble {
+    // How the operands following a byte opcode are encoded
+    enum class OperandLayout {
+        None,
+        ImmI8,
+        ImmI32,
+        ImmI64,
+        ImmF32,
+        IndexU8,
+        IndexI16,
+        Branch,
+        CallU32U8,
+        CallU32U16,
+        CallU16U8,
+        CallU16U16,
+        CallDyn,
+    };
+
+    // nullopt for opcodes that don't exist
+    std::optional<OperandLayout> GetOperandLayout(ByteOpcode opcode);
+
+    // Encoded size of the operands in bytes
+    size_t GetOperandSize(OperandLayout layout);
+
+    // True if execution never continues with the next instruction
+    bool IsTerminator(ByteOpcode opcode);
+}
+
+#endif // BIBBLEVM_CORE_OPERAND_LAYOUT_H
@@ -12,6 +12,8 @@ namespace bibble {
     public:
         explicit StrtabSection(Section section);
 
+        const Section& getSection() const;
+
         std::optional<std::string_view> get(u32 offset) const;
 
     private:
@@ -5,18 +5,36 @@
 
 #include "BibbleVM/core/bytecode/bytecode_reader.h"
 
+#include "BibbleVM/core/exec/dispatch.h"
+
+#include <span>
+
 namespace bibble {
     class VM;
+    struct DecodedFunction;
+
+    // A C++ function bytecode can call like any other (see BindHost for typed ones). args are the callee frame's values
+    // in place, first argument first, and the result goes to acc. It may call back into the VM, and reports errors with
+    // VM::exit
+    using HostFunction = Value(*)(VM& vm, std::span<Value> args);
+
+    constexpr u32 HostModule = 0xFFFFFFFF; // module of host functions, which don't have one
 
     struct CallableTarget {
         u32 module;
-        BytecodeReader entry;
+        BytecodeReader entry; // empty for host functions
+        HostFunction host = nullptr; // called directly instead of running bytecode if set
+        mutable const DecodedFunction* decoded = nullptr; // filled in on first call. owned by the module
+        mutable NativeEntry native = nullptr; // compiled code of decoded, if it has any. run instead of interpreting it
 
         CallableTarget(u32 module, BytecodeReader entry) : module(module), entry(std::move(entry)) {}
+        explicit CallableTarget(HostFunction host) : module(HostModule), entry(std::span<const u8>()), host(host) {}
     };
 
     // This exists to avoid headaches in the future when i add jit compiler or native functions.
-    // Everything that calls a function in the VM calls this internally.
+    // Entry point for calls made by the host. Calls between bytecode functions stay inside the interpreter loop, calls
+    // from compiled code to interpreted code nest through here (see CallNested). Host functions get the current frame's
+    // values as their arguments and are called right away
     void CallableTrampoline(const CallableTarget& target, VM& vm);
 }
 
@@ -6,15 +6,20 @@
 #include "BibbleVM/core/call/callable_target.h"
 
 namespace bibble {
+    constexpr u32 NoFunction = 0xFFFFFFFF; // id of a function that doesn't exist
+
     class Function {
+    friend class SymbolTable;
     public:
         Function(u32 module, std::string_view name, CallableTarget target);
 
+        u32 getId() const; // given by the VM it's added to, dense from 0 in the order functions were added
         u32 getModule() const;
         std::string_view getName() const;
         CallableTarget& target();
 
     private:
+        u32 mId = NoFunction;
         u32 mModule; // the module that defined this function symbol. as a handle
 
         std::string_view mName;
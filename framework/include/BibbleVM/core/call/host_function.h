@@ -0,0 +1,68 @@
+// Copyright 2025 JesusTouchMe
+
+#ifndef BIBBLEVM_CORE_HOST_FUNCTION_H
+#define BIBBLEVM_CORE_HOST_FUNCTION_H 1
+
+#include "BibbleVM/core/vm.h"
+
+#include <concepts>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace bibble {
+    namespace detail {
+        template<class T>
+        T FromValue(Value value) {
+            if constexpr (std::same_as<T, Value>) return value;
+            else if constexpr (std::same_as<T, bool>) return value.boolean();
+            else if constexpr (std::floating_point<T>) return static_cast<T>(value.floating());
+            else return static_cast<T>(value.integer());
+        }
+
+        template<class T>
+        struct HostSignature;
+
+        template<class R, class... Args>
+        struct HostSignature<R(*)(Args...)> {
+            using Result = R;
+            using Parameters = std::tuple<std::remove_cvref_t<Args>...>;
+            static constexpr bool TakesVM = false;
+        };
+
+        template<class R, class... Args>
+        struct HostSignature<R(*)(VM&, Args...)> {
+            using Result = R;
+            using Parameters = std::tuple<std::remove_cvref_t<Args>...>;
+            static constexpr bool TakesVM = true;
+        };
+    }
+
+    // HostFunction for a plain C++ function taking and returning integers, floating point values, bools or Values, and
+    // optionally the VM first. Arguments convert from the Value members their types suggest. Calls with the wrong number
+    // of arguments exit the VM with -2, like a call with too few values for a bytecode function
+    template<auto Callee>
+    Value BindHost(VM& vm, std::span<Value> args) {
+        using Signature = detail::HostSignature<decltype(Callee)>;
+        using Parameters = typename Signature::Parameters;
+
+        if (args.size() != std::tuple_size_v<Parameters>) {
+            vm.exit(-2);
+            return Value();
+        }
+
+        auto call = [&]<size_t... I>(std::index_sequence<I...>) {
+            if constexpr (Signature::TakesVM) return Callee(vm, detail::FromValue<std::tuple_element_t<I, Parameters>>(args[I])...);
+            else return Callee(detail::FromValue<std::tuple_element_t<I, Parameters>>(args[I])...);
+        };
+
+        if constexpr (std::is_void_v<typename Signature::Result>) {
+            call(std::make_index_sequence<std::tuple_size_v<Parameters>>());
+            return Value();
+        } else {
+            return Value(call(std::make_index_sequence<std::tuple_size_v<Parameters>>()));
+        }
+    }
+}
+
+#endif // BIBBLEVM_CORE_HOST_FUNCTION_H
@@ -0,0 +1,45 @@
+// Copyright 2025 JesusTouchMe
+
+#ifndef BIBBLEVM_CORE_SYMBOL_TABLE_H
+#define BIBBLEVM_CORE_SYMBOL_TABLE_H 1
+
+#include "BibbleVM/core/call/function.h"
+
+#include <vector>
+
+namespace bibble {
+    // The functions of a VM, interned by name. Each gets the next dense id when it's added, and lives in a chunk of an
+    // arena where it never moves, so pointers to it and its target stay valid.
+    //
+    // Names are found through an open-addressing table of (hash, id) slots over a flat array, looked up with the name's
+    // util::HashSymbol hash so callers that already have it (linking against a bbx link table) don't hash again. The
+    // names are only compared once the hashes match
+    class SymbolTable {
+    public:
+        // The id function got, or NoFunction if a function with the same name is already in the table
+        u32 add(Function function, u32 hash);
+
+        u32 find(std::string_view name, u32 hash) const; // NoFunction if there's none by that name
+
+        Function& get(u32 id); // id must be one add returned
+        const Function& get(u32 id) const;
+
+        size_t size() const;
+
+    private:
+        static constexpr size_t ChunkSize = 256;
+
+        struct Slot {
+            u32 hash;
+            u32 id; // NoFunction if empty
+        };
+
+        std::vector<Slot> mSlots; // power of two sized, at most 3/4 full
+        std::vector<std::vector<Function>> mChunks; // each reserved to ChunkSize up front and never grown past it
+        size_t mSize = 0;
+
+        void grow();
+    };
+}
+
+#endif // BIBBLEVM_CORE_SYMBOL_TABLE_H
@@ -3,11 +3,17 @@
 #ifndef BIBBLEVM_CORE_DISPATCH_H
 #define BIBBLEVM_CORE_DISPATCH_H 1
 
-#include "BibbleVM/core/bytecode/bytecode_reader.h"
+#include "BibbleVM/core/bytecode/opcodes.h"
+
+#include "BibbleVM/core/exec/register_code.h"
+#include "BibbleVM/core/exec/superinstruction.h"
+
+#include "BibbleVM/core/value/value.h"
 
 #include "BibbleVM/config.h"
 
 #include <array>
+#include <cstddef>
 
 #define DISPATCH_RETURN (-1)
 #define DISPATCH_SUCCESS 0
@@ -15,15 +21,123 @@
 
 namespace bibble {
     class VM;
+    struct CallableTarget;
+    struct DecodedFunction;
+    struct Instruction;
+
+    // Interpreter registers that live in the dispatch loop. acc and the stack registers are loaded from the VM when a
+    // function starts running and only written back around calls, traps and exits, so the hot loop never touches VM memory
+    struct ExecState {
+        const Instruction* pc; // next instruction to execute
+        const Instruction* code; // first instruction of the running function. branch targets are indices into this
+
+        Value acc;
+        Value* sp; // next free slot
+        Value* frame; // first local of the current frame (sb)
+        Value* stack; // stack slot 0
+        Value* limit; // one past the last stack slot
+    };
+
     using DispatchErr = int; // enum?
-    using DispatchFn = DispatchErr(*)(VM&, BytecodeReader&);
-    using DispatchTable = std::array<DispatchFn, 256>;
-    using DispatchTableExt = std::array<DispatchFn, 65536>;
+    using DispatchFn = DispatchErr(*)(VM&, ExecState&, const Instruction&);
+
+    // Machine code for a whole function. Runs from the frame state describes until the function returns
+    // (DISPATCH_RETURN) or fails, and writes acc and sp back into state before it does
+    using NativeEntry = DispatchErr(*)(VM&, ExecState&);
+
+    // Same as NativeEntry, but starts at an address inside the function's code instead of its entry. This is how a frame
+    // that's already running moves from the interpreter into compiled code (OSR)
+    using NativeResumeEntry = DispatchErr(*)(VM&, ExecState&, const void* resume);
+
+#if BIBBLEVM_THREADED_DISPATCH
+    using DispatchHandler = const void*; // label address inside DispatchThreaded
+#else
+    using DispatchHandler = DispatchFn;
+#endif
+
+    using DispatchTable = std::array<DispatchHandler, 256>;
+
+    // The extended opcode space is two-level: the high byte picks a page of 256 handlers. Pages without a single handler
+    // all point to one shared page of invalid handlers, so the table stays a few kilobytes however sparse it is
+    struct DispatchTableExt {
+        std::array<const DispatchTable*, 256> pages;
+
+        DispatchHandler operator[](u16 opcode) const {
+            return (*pages[opcode >> 8])[opcode & 0xFF];
+        }
+    };
+
+    struct DispatchTables {
+        DispatchTable dispatchTable;
+        DispatchTableExt dispatchTableExt;
+        std::array<DispatchHandler, SuperinstructionCount> superinstructions; // indexed by Superinstruction
+        std::array<DispatchHandler, 3> backEdges; // JMP, JZ and JNZ that count taken branches towards OSR
+        std::array<DispatchHandler, RegisterOpcodeCount> registerOps; // indexed by RegisterOpcode. unchecked in both tables
+        DispatchHandler invalidHandler; // every opcode without a handler is set to this. fails execution when reached
+    };
+
+    // Built on first use and shared by every interpreter in the process. The checked tables bounds check every stack
+    // access, the unchecked ones trust the bytecode. Handlers from both can be mixed freely in one instruction stream
+    const DispatchTables& GetDispatchTables(bool checked);
+
+    // The back-edge counting handler for a JMP, JZ or JNZ, or nullptr for any other opcode
+    DispatchHandler GetBackEdgeHandler(const DispatchTables& tables, u16 opcode);
+
+#if BIBBLEVM_DISPATCH_PROFILE
+    constexpr size_t DispatchProfileOpcodes = 512; // byte opcodes followed by the internal superinstruction and register opcodes
+
+    static_assert(RegisterOpcodeBase + RegisterOpcodeCount <= DispatchProfileOpcodes);
+
+    // Executed instructions by (previous opcode, opcode), keyed by Instruction::opcode. A superinstruction counts as
+    // one dispatch. Process-wide and not thread safe, it's a tuning tool
+    struct DispatchProfile {
+        u64 dispatches = 0;
+        u16 previous = 0;
+        std::array<std::array<u64, DispatchProfileOpcodes>, DispatchProfileOpcodes> pairs{};
+    };
+
+    DispatchProfile& GetDispatchProfile();
+#endif
+
+    // Anything that leaves the running code (calls, traps, exits) must see the VM in a consistent state. Spill writes
+    // acc and sp back to the VM, Reload picks up acc, sp and frame again afterwards
+    void SpillState(VM& vm, const ExecState& state);
+    void ReloadState(VM& vm, ExecState& state);
+
+    // Callee of CALL, CALL_EX, CALL_TINY or CALL_TINY_EX, through the inline cache in inst. nullptr if its CallEntry
+    // doesn't resolve
+    const CallableTarget* ResolveCallTarget(VM& vm, const Instruction& inst);
+
+    // Calls target with the top argc values as its frame and returns with state reloaded once it has returned. Unlike
+    // calls inside the dispatch loop this nests an Interpreter::execute, which is how compiled code calls functions that
+    // aren't compiled. Returns DISPATCH_RETURN if the VM exited during the call
+    DispatchErr CallNested(VM& vm, ExecState& state, const CallableTarget& target, u16 argc);
+
+    // Calls the native code of target, which decoded to function, with the top argc values as its frame. Takes only the
+    // callee's own native frame rather than a whole nested execute, which is how the dispatch loop and compiled code
+    // both enter compiled functions of any module while Interpreter::canEnterCompiled. Returns DISPATCH_RETURN if the VM
+    // exited during the call
+    DispatchErr CallCompiled(VM& vm, ExecState& state, const CallableTarget& target, const DecodedFunction& function, u16 argc);
+
+    // Same as CallNested for a callee whose native code the caller already knows, which must be of the running module.
+    // Skips resolving and decoding a target, which is how code compiled ahead of time calls itself and how compiled code
+    // calls functions that are compiled too. code is the callee's decoded instructions, for native code that looks its
+    // function up through state.code, or nullptr to leave the caller's there
+    DispatchErr CallNative(VM& vm, ExecState& state, NativeEntry native, u16 argc, const Instruction* code = nullptr);
 
-    // a world shattering 514 kilobytes of memory per active full dispatcher table
-    // TODO: optimize the above
+    // Calls the host function of target with the top argc values, which it pops, and puts its result in acc. Runs
+    // right where it's called from, bytecode and compiled code alike. Returns DISPATCH_RETURN if the VM exited during
+    // the call
+    DispatchErr CallHost(VM& vm, ExecState& state, const CallableTarget& target, u16 argc);
 
-    void InitDispatchers(const VMConfig& config, DispatchTable& dispatchTable, DispatchTableExt& dispatchTableExt);
+    // Runs pre-decoded instructions starting at state.pc until a handler returns something other than DISPATCH_SUCCESS and returns that value
+#if BIBBLEVM_THREADED_DISPATCH
+    // Direct-threaded loop (computed goto). Every handler is inlined into the loop and jumps straight to the next one
+    DispatchErr DispatchThreaded(VM& vm, ExecState& state);
+#else
+    // Plain fetch/dispatch loop with one indirect call per instruction. Used when threaded dispatch is unavailable
+    DispatchErr DispatchLoop(VM& vm, ExecState& state);
+#endif
 }
 
 #endif // BIBBLEVM_CORE_DISPATCH_H
@@ -0,0 +1,98 @@
+// Copyright 2025 JesusTouchMe
+
+#ifndef BIBBLEVM_CORE_INSTRUCTION_H
+#define BIBBLEVM_CORE_INSTRUCTION_H 1
+
+#include "BibbleVM/core/exec/dispatch.h"
+
+#include "BibbleVM/core/jit/native_code.h"
+
+#include "BibbleVM/core/value/value.h"
+
+#include <cstddef>
+#include <vector>
+
+namespace bibble {
+    struct CallableTarget;
+
+    // A fixed-width, pre-decoded instruction. Operands are already in native byte order and branch targets are
+    // instruction indices, so executing one never touches the bbx bytes it came from.
+    //
+    // Operand placement:
+    //   a:   stack index (as i32), count, trap code, data section offset of a CallEntry or branch target index
+    //   b:   argc of calls
+    //   imm: immediates of CONST*, *_IMM, HLT. float immediates are widened to double
+    //   target: inline cache of CALL, CALL_EX, CALL_TINY and CALL_TINY_EX. resolved on the first call through the
+    //           instruction and never changes after, since a CallEntry always links to the same callable
+    //   counter: taken branches left before a backward JMP, JZ or JNZ tiers its function up. only while it runs on a
+    //            back-edge handler
+    struct Instruction {
+        DispatchHandler handler;
+        u32 a = 0;
+        u16 b = 0;
+        u16 opcode = 0; // ByteOpcode this came from. kept for tooling, never used for dispatch
+        union {
+            Value imm = Value();
+            mutable const CallableTarget* target;
+            mutable u32 counter;
+        };
+    };
+
+    static_assert(sizeof(Instruction) == 24);
+
+    // Where a counting back-edge of register code goes in the stack form, for frames that leave it to enter compiled code
+    struct RegisterOrigin {
+        u32 instruction = 0; // the branch target
+        u32 height = 0; // values the frame holds there
+    };
+
+    // A function's register form, from TranslateToRegisters. Only for frames entered with exactly args values
+    struct RegisterCode {
+        std::vector<Instruction> instructions; // empty if there is none
+        std::vector<RegisterOrigin> origins; // by instruction. only filled in for counting back-edges
+        u32 entryIndex = 0;
+        u32 args = 0;
+        u32 accSlot = 0; // frame slot acc lives in, one past the most values the frame ever holds. the slot after it is scratch
+
+        bool canEnter(const Value* frame, const Value* sp, const Value* limit) const {
+            return !instructions.empty() && sp - frame == args && limit - frame > accSlot + 1;
+        }
+    };
+
+    struct DecodedFunction {
+        size_t entry; // code section offset the function was decoded from
+        u32 entryIndex; // instruction the entry offset decoded to. code before it is only reachable through branches
+        std::vector<Instruction> instructions;
+
+        bool verified = false; // stack bounds proven by VerifyFunction. runs on unchecked handlers
+        u32 minArgs = 0; // values the frame must hold on entry. only meaningful when verified
+        u32 maxGrowth = 0; // most values the function has on its stack beyond those it was entered with
+
+        // Tiering state. Like Instruction::target these are caches that fill in while the function runs, so they change
+        // through the const pointers everything else shares the function by
+        mutable u32 calls = 0; // calls so far in the function's current tier, counting towards the next one
+        mutable bool jitRefused = false; // CompileBaseline failed once already, the function stays interpreted
+        mutable bool optimizeRefused = false; // same for CompileOptimized, the function stays in baseline code
+
+        mutable NativeCode baseline; // from CompileBaseline
+        mutable NativeCode optimized; // from CompileOptimized. the baseline code stays, frames may still be running it
+        mutable NativeEntry native = nullptr; // entry point of the best code there is. null while only interpreted
+
+        mutable RegisterCode registers; // translated on the first call the interpreter runs
+        mutable bool registersRefused = false; // TranslateToRegisters failed once already, the function stays in stack form
+
+        // Best code there is, nullptr while the function is only interpreted
+        const NativeCode* nativeCode() const {
+            if (optimized.entry != nullptr) return &optimized;
+            if (baseline.entry != nullptr) return &baseline;
+            return nullptr;
+        }
+
+        // Verified functions skip their own bounds checks, so this must hold for the frame they're entered with
+        bool canEnter(const Value* frame, const Value* sp, const Value* limit) const {
+            return !verified || (sp - frame >= minArgs && limit - sp >= maxGrowth);
+        }
+    };
+}
+
+#endif // BIBBLEVM_CORE_INSTRUCTION_H
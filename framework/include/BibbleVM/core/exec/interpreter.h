@@ -3,7 +3,9 @@
 #ifndef BIBBLEVM_CORE_INTERPRETER_H
 #define BIBBLEVM_CORE_INTERPRETER_H 1
 
-#include "BibbleVM/core/exec/dispatch.h"
+#include "BibbleVM/core/call/callable_target.h"
+
+#include "BibbleVM/core/exec/instruction.h"
 
 namespace bibble {
     class VM;
@@ -12,14 +14,79 @@ namespace bibble {
         explicit Interpreter(const VMConfig& config);
 
         u32 getActiveModule() const;
+        void setActiveModule(u32 module); // only for calls and returns made inside the dispatch loop
+
+        // Pre-decodes the target on its first call. Returns nullptr if its code is malformed
+        const DecodedFunction* decode(VM& vm, const CallableTarget& target);
+
+        // Counts a call into function, which target decoded to. Compiles it once it's hot in the interpreter and
+        // optimizes it once it's hot in baseline code, for frames of argc values like this one. Points target.native at
+        // the best code the function has
+        void countCall(VM& vm, const CallableTarget& target, const DecodedFunction& function, u32 argc);
+
+        // Points state.code and state.pc at the entry of function, whose frame state was just set up for. That's the
+        // register form for verified functions entered with as many values as on their first call here, which is when
+        // they're translated, and the stack form for everything else
+        void enterCode(const DecodedFunction& function, ExecState& state);
+
+        // For a counting back-edge of register code that ran out, with state.pc already at its target. Moves the frame
+        // to the same place in the stack form, which is what compiled code takes over from
+        void leaveRegisterCode(VM& vm, ExecState& state, const Instruction& branch);
+
+        // For a back-edge counter that ran out, with state.pc already at the branch target. Compiles the running
+        // function if it isn't yet and continues the frame in compiled code from there. Returns DISPATCH_SUCCESS to keep
+        // interpreting, otherwise whatever the compiled code returned
+        DispatchErr enterCompiledLoop(VM& vm, ExecState& state, const Instruction& branch);
+
+        // Same for a back-edge counter that ran out in baseline code, which spilled its state first. Optimizes the
+        // function instead, and DISPATCH_SUCCESS means to keep going in baseline code
+        DispatchErr enterOptimizedLoop(VM& vm, ExecState& state, const Instruction& branch);
 
-        void execute(VM& vm, u32 module, BytecodeReader bytecode);
+        // Whether compiled code may be entered from here. Once half of VMConfig::nativeStackSize is taken calls interpret
+        // their callees instead, compiled or not, which takes no more of it
+        bool canEnterCompiled() const;
+
+        // Runs the target until the frame the host entered it with returns. Bytecode calls made from there are handled
+        // inside the same dispatch loop, calls out of compiled code and host functions calling back in nest another
+        // execute, which past VMConfig::nativeStackSize exits the VM with -2. Unchecked code running off the end of the
+        // stack exits it with -2 too, like a failed check would, through its guard pages
+        void execute(VM& vm, const CallableTarget& target);
+
+        // Runs native instead of interpreting the function target decodes to, from now on and for every target of it,
+        // and keeps the JIT away from it. For code compiled ahead of time (see BibbleVM-aot), which assumes the bounds
+        // VerifyFunction proved, so it's refused for functions that don't verify. false if it was refused
+        bool setNativeCode(VM& vm, const CallableTarget& target, NativeEntry native);
+
+        // Runs native from the frame state describes, which the VM must have pushed already, and returns what it returned.
+        // Takes native stack out of the same VMConfig::nativeStackSize as execute. For native code calling a function of
+        // its own module that it already knows the native code of (see CallNative)
+        DispatchErr executeNative(VM& vm, ExecState& state, NativeEntry native);
 
     private:
-        DispatchTable mDispatchTable{};
-        DispatchTableExt mDispatchTableExt{};
+        const DispatchTables& mTables; // shared by every interpreter
+        bool mSuperinstructions;
+        bool mRegisterCode;
+        bool mJit;
+        u32 mCallThreshold;
+        u32 mBackEdgeThreshold;
+        bool mOptimize;
+        u32 mOptimizeThreshold;
+        std::function<void(const TierUpEvent&)> mOnTierUp;
+
+        u32 mActiveModule = 0xFFFFFFFF;
+
+        size_t mNativeStackSize;
+        const u8* mNativeBase = nullptr; // where the outermost execute running is on the native stack
+
+        // Bytes of native stack taken since mNativeBase. Stacks grow down on everything the VM runs on
+        size_t nativeStackUsed() const;
+
+        // execute, minus the guard it runs under (see Stack::runGuarded)
+        void run(VM& vm, const CallableTarget& target);
 
-        u32 mActiveModule;
+        // Compiles function for the tier and reports it. Whether or not it worked, it's never tried again. height is what
+        // the hot frame holds at instruction, which optimized code is specialized for
+        void tierUp(VM& vm, u32 module, const DecodedFunction& function, TierUpEvent::Tier tier, TierUpEvent::Reason reason, u32 instruction, u64 height);
     };
 }
 
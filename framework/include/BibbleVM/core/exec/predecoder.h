@@ -0,0 +1,20 @@
+// Copyright 2025 JesusTouchMe
+
+#ifndef BIBBLEVM_CORE_PREDECODER_H
+#define BIBBLEVM_CORE_PREDECODER_H 1
+
+#include "BibbleVM/core/bytecode/code_section.h"
+
+#include "BibbleVM/core/exec/instruction.h"
+
+#include <optional>
+
+namespace bibble {
+    // Translates the function starting at `entry` into pre-decoded instructions. Only code reachable from the entry is
+    // translated, in code section order, so fallthrough stays a plain pc increment.
+    // Returns nullopt if reachable code is malformed: truncated operands, or branches leaving the code section or
+    // landing inside another instruction. Unknown opcodes decode to the invalid handler and fail only when executed.
+    std::optional<DecodedFunction> Predecode(const CodeSection& code, size_t entry, const DispatchTables& tables);
+}
+
+#endif // BIBBLEVM_CORE_PREDECODER_H
@@ -0,0 +1,61 @@
+// Copyright 2025 JesusTouchMe
+
+#ifndef BIBBLEVM_CORE_REGISTER_CODE_H
+#define BIBBLEVM_CORE_REGISTER_CODE_H 1
+
+#include "BibbleVM/core/exec/superinstruction.h"
+
+#include <cstddef>
+#include <optional>
+
+// Internal opcodes of the register form. SS operations read two frame slots, SI ones a slot and an immediate, S ones a
+// single slot. The J* compares branch instead of writing their result, the _BACK branches count towards OSR like the
+// stack form's, and the rest move acc and sp between a frame slot and ExecState around everything that isn't translated
+#define FOR_EACH_REGISTER_OPCODE(X) \
+    X(ENTER) X(RESUME) X(SYNC) X(MOV_SS) X(MOV_SI) \
+    X(ADD_SS) X(ADD_SI) X(SUB_SS) X(SUB_SI) X(MUL_SS) X(MUL_SI) X(DIV_SS) X(DIV_SI) \
+    X(MOD_SS) X(MOD_SI) X(AND_SS) X(AND_SI) X(OR_SS) X(OR_SI) X(XOR_SS) X(XOR_SI) \
+    X(SHL_SS) X(SHL_SI) X(SHR_SS) X(SHR_SI) \
+    X(FADD_SS) X(FADD_SI) X(FSUB_SS) X(FSUB_SI) X(FMUL_SS) X(FMUL_SI) X(FDIV_SS) X(FDIV_SI) \
+    X(NEG_S) X(NOT_S) X(FNEG_S) \
+    X(EQ_SS) X(EQ_SI) X(NE_SS) X(NE_SI) X(LT_SS) X(LT_SI) X(GT_SS) X(GT_SI) X(LE_SS) X(LE_SI) X(GE_SS) X(GE_SI) \
+    X(FEQ_SS) X(FEQ_SI) X(FNE_SS) X(FNE_SI) X(FLT_SS) X(FLT_SI) X(FGT_SS) X(FGT_SI) X(FLE_SS) X(FLE_SI) X(FGE_SS) X(FGE_SI) \
+    X(JMP) X(JZ_S) X(JNZ_S) X(JMP_BACK) X(JZ_S_BACK) X(JNZ_S_BACK) \
+    X(JEQ_SS) X(JEQ_SI) X(JNE_SS) X(JNE_SI) X(JLT_SS) X(JLT_SI) X(JGT_SS) X(JGT_SI) X(JLE_SS) X(JLE_SI) X(JGE_SS) X(JGE_SI) \
+    X(JFEQ_SS) X(JFEQ_SI) X(JFNE_SS) X(JFNE_SI) X(JFLT_SS) X(JFLT_SI) X(JFGT_SS) X(JFGT_SI) X(JFLE_SS) X(JFLE_SI) X(JFGE_SS) X(JFGE_SI) \
+    X(SYNC_CALL) X(SYNC_CALL_EX) X(SYNC_CALL_DYN) X(SYNC_CALL_TINY) X(SYNC_CALL_TINY_EX) \
+    X(RET) X(HLT) X(TRAP) X(TRAP_IF_ZERO) X(TRAP_IF_NOT_ZERO)
+
+namespace bibble {
+    struct DecodedFunction;
+    struct DispatchTables;
+    struct RegisterCode;
+
+    enum class RegisterOpcode : u16 {
+#define REGISTER_OPCODE_ENUM(name) name,
+        FOR_EACH_REGISTER_OPCODE(REGISTER_OPCODE_ENUM)
+#undef REGISTER_OPCODE_ENUM
+    };
+
+    constexpr size_t RegisterOpcodeCount = 0
+#define REGISTER_OPCODE_COUNT(name) + 1
+        FOR_EACH_REGISTER_OPCODE(REGISTER_OPCODE_COUNT)
+#undef REGISTER_OPCODE_COUNT
+    ;
+
+    // Numbered after the superinstructions in Instruction::opcode
+    constexpr u16 RegisterOpcodeBase = SuperinstructionBase + SuperinstructionCount;
+
+    // Translates a verified function into three-address code over its frame slots, for frames entered with args values.
+    // Every stack position then has a fixed slot and acc gets one of its own after the deepest position, so LOAD, STORE,
+    // PUSH_ACC, POP_ACC and the stack shuffling around arithmetic mostly disappear into the operands of the instructions
+    // that consume them. Values are only written out when something else needs them in their slot, at the end of a block
+    // and around the instructions that stay in stack form (calls, traps, RET, HLT and anything unusual), which run on
+    // their plain handlers between a SYNC and a RESUME.
+    //
+    // tables must be the unchecked tables, which hold the register handlers. Back-edges count down from backEdgeThreshold
+    // unless it's nullopt. Returns nullopt for functions it can't translate, which keep running in stack form
+    std::optional<RegisterCode> TranslateToRegisters(const DecodedFunction& function, const DispatchTables& tables, u32 args, std::optional<u32> backEdgeThreshold);
+}
+
+#endif // BIBBLEVM_CORE_REGISTER_CODE_H
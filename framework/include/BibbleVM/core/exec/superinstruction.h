@@ -0,0 +1,61 @@
+// Copyright 2025 JesusTouchMe
+
+#ifndef BIBBLEVM_CORE_SUPERINSTRUCTION_H
+#define BIBBLEVM_CORE_SUPERINSTRUCTION_H 1
+
+#include "BibbleVM/core/bytecode/opcodes.h"
+
+#include <cstddef>
+#include <span>
+
+// Sequences fused into one dispatch by FuseSuperinstructions. Every part but the last must fall through to the next
+// one, the last can be anything (branches included). Picked from dispatch pair counts of BIBBLEVM_DISPATCH_PROFILE
+// builds plus the sequences our compiler emits for locals, comparisons and argument passing
+#define FOR_EACH_SUPERINSTRUCTION(X2, X3) \
+    X3(LOAD, SUB_IMM, STORE) \
+    X3(LOAD_ST, LOAD_ST, ADD2) \
+    X2(STORE, CMP_GT0) \
+    X2(CMP_GT0, JNZ) \
+    X2(CMP_LT0, JZ) \
+    X2(CMP_LT, JNZ) \
+    X2(LOAD, ADD_ST) \
+    X2(CONST, PUSH_ACC) \
+    X2(CONST_ST, ADD_ST)
+
+namespace bibble {
+    struct DecodedFunction;
+    struct DispatchTables;
+
+    enum class Superinstruction : u16 {
+#define SUPERINSTRUCTION_ENUM2(a, b) a##_##b,
+#define SUPERINSTRUCTION_ENUM3(a, b, c) a##_##b##_##c,
+        FOR_EACH_SUPERINSTRUCTION(SUPERINSTRUCTION_ENUM2, SUPERINSTRUCTION_ENUM3)
+#undef SUPERINSTRUCTION_ENUM2
+#undef SUPERINSTRUCTION_ENUM3
+    };
+
+    constexpr size_t SuperinstructionCount = 0
+#define SUPERINSTRUCTION_COUNT2(a, b) + 1
+#define SUPERINSTRUCTION_COUNT3(a, b, c) + 1
+        FOR_EACH_SUPERINSTRUCTION(SUPERINSTRUCTION_COUNT2, SUPERINSTRUCTION_COUNT3)
+#undef SUPERINSTRUCTION_COUNT2
+#undef SUPERINSTRUCTION_COUNT3
+    ;
+
+    // Superinstructions are internal pre-decoded opcodes, numbered right after the byte opcodes in Instruction::opcode
+    constexpr u16 SuperinstructionBase = 0x100;
+
+    // The byte opcodes a superinstruction runs, in order
+    std::span<const ByteOpcode> GetSuperinstructionParts(Superinstruction superinstruction);
+
+    // The byte opcode an Instruction::opcode starts with. A superinstruction's is its first part, which is all that sets
+    // it apart from a plain instruction since the other parts follow as their own instructions
+    ByteOpcode GetLeadingOpcode(u16 opcode);
+
+    // Points the first instruction of every fusable sequence at the matching superinstruction handler from tables, which
+    // must be the tables the function's other handlers came from. The other parts stay as they are, so branches into
+    // the middle of a sequence still work and branch targets don't move
+    void FuseSuperinstructions(DecodedFunction& function, const DispatchTables& tables);
+}
+
+#endif // BIBBLEVM_CORE_SUPERINSTRUCTION_H
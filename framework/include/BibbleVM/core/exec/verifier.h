@@ -0,0 +1,31 @@
+// Copyright 2025 JesusTouchMe
+
+#ifndef BIBBLEVM_CORE_VERIFIER_H
+#define BIBBLEVM_CORE_VERIFIER_H 1
+
+#include "BibbleVM/core/bytecode/code_section.h"
+
+#include "BibbleVM/core/exec/instruction.h"
+
+#include <optional>
+#include <vector>
+
+namespace bibble {
+    // Structural checks over a whole code section, for hosts that want a module checked up front. A single linear sweep
+    // checks that every opcode exists, its operands fit in the section, and every JMP/JZ/JNZ lands on an instruction
+    // boundary. The VM itself doesn't need it: Predecode checks the same of each function it decodes, so loading a
+    // module never reads code that doesn't run
+    bool VerifyCode(const CodeSection& code);
+
+    // Stack bounds of one pre-decoded function, in time linear to its size. Every path must agree on the stack depth at
+    // each instruction and never index a local below the frame. On success the function is flagged as verified with the
+    // amount of arguments and extra stack it needs, which the interpreter checks once per call instead of checking every
+    // stack access
+    bool VerifyFunction(DecodedFunction& function);
+
+    // Stack depth before every instruction of a verified function, relative to its entry, as VerifyFunction found them.
+    // nullopt for instructions no path from the entry reaches, and for all of them if the function isn't verified
+    std::vector<std::optional<i64>> GetStackDepths(const DecodedFunction& function);
+}
+
+#endif // BIBBLEVM_CORE_VERIFIER_H
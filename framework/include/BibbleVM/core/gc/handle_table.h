@@ -0,0 +1,110 @@
+// Copyright 2025 JesusTouchMe
+
+#ifndef BIBBLEVM_CORE_GC_HANDLE_TABLE_H
+#define BIBBLEVM_CORE_GC_HANDLE_TABLE_H 1
+
+#include "BibbleVM/core/gc/object.h"
+
+#include <cstdint>
+#include <memory>
+
+namespace bibble {
+    // Where handles come from, without going through the general heap. They're handed out a page-sized slab at a time,
+    // in address order, from one range reserved up front that the OS only commits as it's used, so they stay packed
+    // together and any address can be told apart from a handle with a range check. Freed ones go on an intrusive free
+    // list with their generation bumped, which stale references to them stop matching (see resolve)
+    class HandleTable {
+    public:
+        static constexpr size_t SlabSize = 4096; // bytes
+
+        // Handles freed together, released with one splice onto the free list
+        class FreeBatch {
+        friend class HandleTable;
+        public:
+            void add(Handle* handle) {
+                handle->generation++;
+                handle->flags = Handle::Free;
+                handle->obj = reinterpret_cast<Object*>(mHead);
+
+                if (mHead == nullptr) mTail = handle;
+                mHead = handle;
+                mCount++;
+            }
+
+        private:
+            Handle* mHead = nullptr;
+            Handle* mTail = nullptr;
+            size_t mCount = 0;
+        };
+
+        HandleTable();
+        ~HandleTable();
+
+        HandleTable(const HandleTable&) = delete;
+        HandleTable& operator=(const HandleTable&) = delete;
+
+        // A handle pointing at obj, or nullptr if there's no memory left for one
+        Handle* allocate(Object* obj) {
+            Handle* handle = mFree;
+
+            if (handle != nullptr) [[likely]] {
+                mFree = reinterpret_cast<Handle*>(handle->obj);
+            } else if (mNext != mSlabEnd) {
+                handle = mNext++;
+            } else {
+                handle = allocateSlab();
+                if (handle == nullptr) return nullptr;
+            }
+
+            handle->obj = obj;
+            handle->flags = 0;
+            mLive++;
+
+            return handle;
+        }
+
+        void free(Handle* handle) {
+            FreeBatch batch;
+            batch.add(handle);
+            release(batch);
+        }
+
+        void release(FreeBatch& batch);
+
+        // The live handle value references, or nullptr if it doesn't reference one: it's not the address of one of our
+        // handles, the handle is free, or it was reused since and has another generation. For conservative scanning,
+        // so it takes anything
+        Handle* resolve(Value value) const {
+            u64 bits = value.uinteger();
+            uintptr_t address = static_cast<uintptr_t>(bits & ReferenceAddressMask);
+
+            if (address - mBegin >= mUsedBytes || address % sizeof(Handle) != 0) return nullptr;
+
+            Handle* handle = reinterpret_cast<Handle*>(address);
+            if (handle->flags & Handle::Free || handle->generation != static_cast<u8>(bits >> ReferenceGenerationShift)) return nullptr;
+
+            return handle;
+        }
+
+        size_t liveCount() const;
+        size_t slabCount() const;
+
+    private:
+        static constexpr size_t ReservedSize = size_t(256) * 1024 * 1024; // 16M handles
+
+        void* mReservation = nullptr;
+        std::unique_ptr<u8[]> mHeapReservation; // where it can't be mapped
+
+        uintptr_t mBegin = 0;
+        uintptr_t mUsedBytes = 0; // in whole slabs from mBegin
+
+        Handle* mNext = nullptr; // never handed out yet, up to the end of the last slab
+        Handle* mSlabEnd = nullptr;
+        Handle* mFree = nullptr;
+        size_t mLive = 0;
+
+        Handle* allocateSlab(); // the first handle of a new one. nullptr once the reservation is used up
+    };
+}
+
+#endif // BIBBLEVM_CORE_GC_HANDLE_TABLE_H
@@ -0,0 +1,172 @@
+// Copyright 2025 JesusTouchMe
+
+#ifndef BIBBLEVM_CORE_GC_HEAP_H
+#define BIBBLEVM_CORE_GC_HEAP_H 1
+
+#include "BibbleVM/core/gc/handle_table.h"
+#include "BibbleVM/core/gc/nursery.h"
+#include "BibbleVM/core/gc/region_heap.h"
+
+#include "BibbleVM/core/stack/stack.h"
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <vector>
+
+namespace bibble {
+    struct HeapStats {
+        u64 allocatedBytes = 0; // handed out by allocate, headers included
+        u64 minorCollections = 0;
+        u64 survivedBytes = 0; // copied within the nursery by minor collections, in total
+        u64 promotedBytes = 0; // copied into the old generation by minor collections, in total
+        u64 oldBytes = 0; // taken up in the old generation now
+        u64 handles = 0; // live now
+        u64 oldCollections = 0; // finished
+        u64 oldSteps = 0; // pauses old collections took, in total
+        u64 evacuatedBytes = 0; // copied out of fragmented regions by old collections, in total
+        u64 regions = 0; // in the old generation now
+    };
+
+    // The automatic storage manager. New objects are bump allocated in the nursery, and the ones that survive a second
+    // minor collection are promoted into the old generation, a RegionHeap.
+    // Roots are the stack slots below sp and acc, taken conservatively: any holding a reference to a live handle keeps its
+    // object alive. Host code keeps the references it holds across an allocation alive by keeping them on the stack.
+    // The old generation is collected a step at a time, each no longer than the pause budget, and run at the end of
+    // minor collections until the collection is done: marking, with stores shading what they store (see store) and a
+    // last step that scans the roots and the nursery again, sweeping, which frees the handles of unmarked objects and
+    // counts the live bytes of each region, and evacuating the live objects out of the most fragmented regions
+    class Heap {
+    public:
+        Heap(Stack& stack, Value& acc, size_t nurserySize, u32 pauseBudget);
+
+        // Handle to a new object with fieldCount zeroed fields, or nullptr if there's no memory left for it. Collects
+        // the nursery when it's full, so every reference not reachable from the roots may be stale after this, and every
+        // object may have moved
+        Handle* allocate(u32 fieldCount) {
+            size_t size = ObjectSize(fieldCount);
+
+            Object* object = size <= LargeObjectSize ? mNursery.allocate(size) : nullptr;
+            if (object == nullptr) [[unlikely]] return allocateSlow(fieldCount);
+
+            return initialize(object, fieldCount);
+        }
+
+        // The handle reference is to, or nullptr if it's not a reference or its object was collected since
+        Handle* resolve(Value reference) const {
+            return mHandles.resolve(reference);
+        }
+
+        static Value load(Handle* handle, u32 index) {
+            return handle->obj->fields()[index];
+        }
+
+        // Every store into a field goes through here, so the collector hears about old objects that may now point into
+        // the nursery, and while the old generation is being marked, about the objects stored
+        void store(Handle* handle, u32 index, Value value) {
+            Object* object = handle->obj;
+            object->fields()[index] = value;
+
+            if (!mNursery.contains(object) && !(object->flags & Object::Remembered)) [[unlikely]] remember(object);
+            if (mOldPhase == OldPhase::Mark) [[unlikely]] mark(value);
+        }
+
+        // Copies the nursery objects reachable from the roots into to-space, or into the old generation if they already
+        // survived one, points their handles at the copies and frees the handles of the rest. Then runs a step of the
+        // old generation collection, if one is going or the old generation grew enough to start one
+        void collectMinor();
+
+        // Runs a step of the old generation collection, starting one if none is going. true if that finished it
+        bool collectOldStep();
+
+        // Runs a whole old generation collection, or the rest of the one going, without a pause budget
+        void collectOld();
+
+        HeapStats stats() const;
+
+    private:
+        static constexpr size_t LargeObjectSize = 16 * 1024; // bytes. anything bigger starts out in the old generation
+        static constexpr u8 PromotionAge = 1; // minor collections an object survives in the nursery
+
+        static_assert(LargeObjectSize <= RegionHeap::LargeObjectSize, "promoted objects are bump allocated in regions");
+
+        enum class OldPhase {
+            Idle,
+            Mark,
+            Sweep,
+            Evacuate,
+        };
+
+        Stack& mStack;
+        Value& mAcc;
+
+        Nursery mNursery;
+        HandleTable mHandles;
+        RegionHeap mOld;
+
+        // references, rather than the objects, as evacuating moves old objects and sweeping frees them
+        std::vector<Value> mRemembered; // to old objects that may point into the nursery
+        std::vector<Value> mRememberedScratch; // what the last collection had in mRemembered, for its memory
+        bool mRememberedOverflow = false; // one couldn't be added, so the next collection scans the whole old generation
+
+        size_t mSurvivorBytes = 0; // at the bottom of from-space since the last collection
+
+        std::chrono::microseconds mPauseBudget;
+        size_t mOldTrigger; // old generation bytes that start the next old collection
+
+        OldPhase mOldPhase = OldPhase::Idle;
+        u16 mMark = 0; // Object::mark of the old objects the running old collection found alive
+        std::vector<Handle*> mGray; // marked old objects whose fields aren't yet
+        bool mGrayOverflow = false; // one couldn't be added, so marking scans every marked old object before it's done
+        size_t mSweepRegion = 0;
+        size_t mSweepLargeObject = 0;
+        size_t mLiveBytes = 0; // found by sweeping so far
+        std::vector<Region*> mFragmented; // swept regions to evacuate, the least live first
+        size_t mEvacuateRegion = 0; // in mFragmented
+        u8* mEvacuatePosition = nullptr;
+
+        HeapStats mStats;
+
+        Handle* initialize(Object* object, u32 fieldCount) {
+            Handle* handle = mHandles.allocate(object);
+
+            object->handle = handle;
+            object->fieldCount = fieldCount;
+            object->age = 0;
+            object->flags = 0;
+            object->mark = mMark;
+            std::fill_n(object->fields(), fieldCount, Value());
+
+            return handle;
+        }
+
+        Handle* allocateSlow(u32 fieldCount);
+
+        void remember(Object* object);
+
+        // Copies the nursery object value references out of from-space if it's still there. true if it references an
+        // object in to-space now
+        bool evacuate(Value value);
+        bool evacuateFields(Object* object); // true if any field references an object in to-space now
+
+        bool scanPromoted(size_t& region, u8*& position); // true if there were any objects left to scan
+
+        template<class F>
+        void forEachOldObject(F&& function);
+
+        // Marks the old object value references, if it's not marked yet, and adds it to mGray
+        void mark(Value value);
+        void markFields(Object* object);
+        void markRoots(); // and every object in the nursery, which aren't marked themselves
+
+        bool stepOld(std::chrono::steady_clock::time_point deadline); // true if that finished the collection
+        bool stepMark(std::chrono::steady_clock::time_point deadline); // true once everything reachable is marked
+        bool drainGray(std::chrono::steady_clock::time_point deadline); // true once mGray is empty
+        bool stepSweep(std::chrono::steady_clock::time_point deadline); // true once every region is swept
+        bool stepEvacuate(std::chrono::steady_clock::time_point deadline); // true once every fragmented region is freed
+
+        void sweepRegion(Region& region, HandleTable::FreeBatch& dead);
+    };
+}
+
+#endif // BIBBLEVM_CORE_GC_HEAP_H
@@ -0,0 +1,70 @@
+// Copyright 2025 JesusTouchMe
+
+#ifndef BIBBLEVM_CORE_GC_NURSERY_H
+#define BIBBLEVM_CORE_GC_NURSERY_H 1
+
+#include "BibbleVM/core/gc/object.h"
+
+#include <memory>
+
+namespace bibble {
+    // Where new objects go: two semi-spaces of the same size. Objects are bump allocated in the active one (from-space),
+    // and a minor collection copies the ones that survive into the other (to-space) before the two swap
+    class Nursery {
+    public:
+        explicit Nursery(size_t size); // bytes per space. Nothing is allocated until reserve
+
+        bool isReserved() const;
+        bool reserve(); // allocates both spaces. false if out of memory
+
+        // size bytes at the top of from-space, or nullptr if it's full
+        Object* allocate(size_t size) {
+            if (size > static_cast<size_t>(mEnd - mTop)) return nullptr;
+
+            Object* object = reinterpret_cast<Object*>(mTop);
+            mTop += size;
+
+            return object;
+        }
+
+        // address is inside an object allocated in from-space
+        bool contains(const void* address) const {
+            const u8* byte = static_cast<const u8*>(address);
+            return byte >= mBegin && byte < mTop;
+        }
+
+        // address is inside an object copied into to-space by this collection
+        bool isCopied(const void* address) const {
+            const u8* byte = static_cast<const u8*>(address);
+            return byte >= mToBegin && byte < mToTop;
+        }
+
+        // size bytes at the top of to-space. There's always room, as nothing is copied that wasn't in from-space
+        Object* copy(size_t size);
+
+        u8* begin() const; // of from-space
+        u8* top() const;
+        u8* toBegin() const;
+        u8* toTop() const;
+
+        size_t capacity() const; // of one space
+        size_t used() const; // of from-space
+
+        // Makes to-space, with everything copied into it, the new from-space
+        void flip();
+
+    private:
+        size_t mSize;
+
+        std::unique_ptr<u8[]> mSpaces[2];
+
+        u8* mBegin = nullptr;
+        u8* mTop = nullptr;
+        u8* mEnd = nullptr;
+
+        u8* mToBegin = nullptr;
+        u8* mToTop = nullptr;
+    };
+}
+
+#endif // BIBBLEVM_CORE_GC_NURSERY_H
@@ -0,0 +1,58 @@
+// Copyright 2025 JesusTouchMe
+
+#ifndef BIBBLEVM_CORE_GC_OBJECT_H
+#define BIBBLEVM_CORE_GC_OBJECT_H 1
+
+#include "BibbleVM/core/value/value.h"
+
+#include <cstddef>
+
+namespace bibble {
+    struct Object;
+
+    // What a reference points at. Objects move, handles don't: moving an object only points its handle somewhere else,
+    // so the references to it never need fixing up, wherever they are
+    struct Handle {
+        static constexpr u32 Free = 1 << 0; // obj is the next free handle then
+
+        Object* obj;
+        u8 generation; // bumped every time the handle is freed
+        u32 flags;
+    };
+
+    // Header of an object, followed by its fields. There are no classes yet, so every field is a Value slot and the
+    // collector takes any that holds a reference to a live handle for one, like it does with roots
+    struct Object {
+        static constexpr u8 Remembered = 1 << 0; // in the remembered set of its heap
+
+        Handle* handle; // the one pointing here. nullptr for the space an allocation that failed took up
+        u32 fieldCount;
+        u8 age; // minor collections survived
+        u8 flags;
+        u16 mark; // the old generation collection that last found it alive, while it's old
+
+        Value* fields() { return reinterpret_cast<Value*>(this + 1); }
+    };
+
+    static_assert(sizeof(Object) == 16, "fields have to stay 8 byte aligned");
+
+    constexpr size_t ObjectSize(u32 fieldCount) {
+        return sizeof(Object) + static_cast<size_t>(fieldCount) * sizeof(Value);
+    }
+
+    // A reference value holds the address of the handle, with the generation it had in the top byte, which no user
+    // space address uses
+    constexpr int ReferenceGenerationShift = 56;
+    constexpr u64 ReferenceAddressMask = (u64(1) << ReferenceGenerationShift) - 1;
+
+    inline Value MakeReference(Handle* handle) {
+        return Value(reinterpret_cast<u64>(handle) | u64(handle->generation) << ReferenceGenerationShift);
+    }
+
+    // without checking it's still the object the reference was made for, see HandleTable::resolve for that
+    inline Handle* GetReference(Value value) {
+        return reinterpret_cast<Handle*>(value.uinteger() & ReferenceAddressMask);
+    }
+}
+
+#endif // BIBBLEVM_CORE_GC_OBJECT_H
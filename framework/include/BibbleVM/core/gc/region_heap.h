@@ -0,0 +1,70 @@
+// Copyright 2025 JesusTouchMe
+
+#ifndef BIBBLEVM_CORE_GC_REGION_HEAP_H
+#define BIBBLEVM_CORE_GC_REGION_HEAP_H 1
+
+#include "BibbleVM/core/gc/object.h"
+
+#include <memory>
+#include <vector>
+
+namespace bibble {
+    // Fixed-size block of the old generation. Objects are bump allocated into it and never freed one by one: once enough
+    // of it is garbage the live ones are evacuated into another region, and the region is freed as a whole
+    struct Region {
+        std::unique_ptr<u8[]> memory;
+        u8* top; // objects are packed from the start of memory up to here
+        size_t liveBytes = 0; // as of its last sweep
+
+        u8* begin() const { return memory.get(); }
+        size_t usedBytes() const { return static_cast<size_t>(top - memory.get()); }
+    };
+
+    // Where the old generation lives: regions, and a space for objects too big to be worth moving, one allocation each
+    class RegionHeap {
+    public:
+        static constexpr size_t RegionSize = 256 * 1024;
+        static constexpr size_t LargeObjectSize = RegionSize / 4; // bytes. anything bigger goes in the large object space
+        static constexpr size_t FragmentedPercent = 50; // of a region's used bytes that are garbage before it's evacuated
+
+        RegionHeap() = default;
+
+        RegionHeap(const RegionHeap&) = delete;
+        RegionHeap& operator=(const RegionHeap&) = delete;
+
+        // size bytes at the top of the current region, in a new region if it's full, or in the large object space.
+        // nullptr if out of memory
+        Object* allocate(size_t size);
+
+        size_t regionCount() const;
+        Region& region(size_t index); // in the order they were started
+        bool isCurrent(const Region& region) const; // the one allocate bumps into. it's never evacuated
+
+        void freeRegion(Region& region);
+
+        size_t largeObjectCount() const;
+        Object* largeObject(size_t index) const;
+        void freeLargeObject(size_t index); // moves the last large object to index
+
+        size_t usedBytes() const; // by regions up to their tops and by large objects
+
+        // By the liveness its last sweep counted, so only meaningful for swept regions
+        static bool IsFragmented(const Region& region) {
+            return region.liveBytes * 100 <= region.usedBytes() * (100 - FragmentedPercent);
+        }
+
+    private:
+        static constexpr size_t MaxPooledRegions = 8; // freed regions kept for new ones instead of freeing their memory
+
+        std::vector<std::unique_ptr<Region>> mRegions;
+        std::vector<std::unique_ptr<u8[]>> mPool;
+        std::vector<std::unique_ptr<u8[]>> mLargeObjects;
+
+        Region* mCurrent = nullptr;
+        size_t mUsedBytes = 0;
+
+        bool startRegion(); // false if out of memory
+    };
+}
+
+#endif // BIBBLEVM_CORE_GC_REGION_HEAP_H
@@ -0,0 +1,21 @@
+// Copyright 2025 JesusTouchMe
+
+#ifndef BIBBLEVM_CORE_BASELINE_COMPILER_H
+#define BIBBLEVM_CORE_BASELINE_COMPILER_H 1
+
+#include "BibbleVM/core/exec/instruction.h"
+
+namespace bibble {
+    // Compiles a verified function to x86-64 machine code, one fixed template per instruction with acc, sp and the frame
+    // pinned to host registers. Stack accesses aren't bounds checked, which the verifier already proved unnecessary.
+    // Calls and traps go through the same runtime paths as the interpreter, so compiled and interpreted functions call
+    // each other freely.
+    //
+    // tables must be the tables the function's handlers came from. With countBackEdges the backward branches that have
+    // a counter installed keep counting it down and call CompiledLoopHot when it runs out. On success the code is stored
+    // in the function, with a resume entry that can start at any instruction, and true is returned. Unverified
+    // functions, and anything on a host without the JIT, are left to the interpreter
+    bool CompileBaseline(const DecodedFunction& function, const DispatchTables& tables, bool countBackEdges);
+}
+
+#endif // BIBBLEVM_CORE_BASELINE_COMPILER_H
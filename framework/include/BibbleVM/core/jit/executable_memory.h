@@ -0,0 +1,37 @@
+// Copyright 2025 JesusTouchMe
+
+#ifndef BIBBLEVM_CORE_EXECUTABLE_MEMORY_H
+#define BIBBLEVM_CORE_EXECUTABLE_MEMORY_H 1
+
+#include "BibbleVM/core/value/value.h"
+
+#include <cstddef>
+#include <optional>
+#include <span>
+
+namespace bibble {
+    // A private mapping holding finished machine code. It's filled while writable and only then made executable, so no
+    // page is ever writable and executable at once (W^X). Unmapped on destruction
+    class ExecutableMemory {
+    public:
+        ExecutableMemory() = default;
+        ExecutableMemory(ExecutableMemory&& other) noexcept;
+        ExecutableMemory& operator=(ExecutableMemory&& other) noexcept;
+        ~ExecutableMemory();
+
+        ExecutableMemory(const ExecutableMemory&) = delete;
+        ExecutableMemory& operator=(const ExecutableMemory&) = delete;
+
+        // Maps code as read + execute. nullopt if the platform doesn't allow it
+        static std::optional<ExecutableMemory> Create(std::span<const u8> code);
+
+        const void* data() const;
+        size_t size() const; // mapped bytes, a whole number of pages
+
+    private:
+        void* mMemory = nullptr;
+        size_t mSize = 0;
+    };
+}
+
+#endif // BIBBLEVM_CORE_EXECUTABLE_MEMORY_H
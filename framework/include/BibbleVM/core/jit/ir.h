@@ -0,0 +1,114 @@
+// Copyright 2025 JesusTouchMe
+
+#ifndef BIBBLEVM_CORE_IR_H
+#define BIBBLEVM_CORE_IR_H 1
+
+#include "BibbleVM/core/exec/instruction.h"
+
+#include <limits>
+#include <vector>
+
+// SSA form of a function for the optimizing compiler. Every frame slot and acc is a variable, so values only go
+// through memory where the function hands its frame to something else (calls and traps)
+namespace bibble::ir {
+    using ValueId = u32;
+    using BlockId = u32;
+
+    constexpr u32 None = std::numeric_limits<u32>::max();
+
+    enum class Op : u8 {
+        // Pure. The result only depends on the operands, so these can be folded, moved and removed freely
+        Const, // imm, floats as their bits
+        Add, Sub, Mul, Div, Mod, And, Or, Xor, Shl, Shr, // Shr is arithmetic, shift counts are masked to 6 bits
+        Neg, Not,
+        FAdd, FSub, FMul, FDiv,
+        FNeg,
+        CmpEq, CmpNe, CmpLt, CmpGt, CmpLe, CmpGe, // 0 or 1
+        FCmpEq, FCmpNe, FCmpLt, FCmpGt, FCmpLe, FCmpGe,
+        Phi, // one operand per predecessor of its block, in the same order
+
+        // Read the frame as it is in memory. Only at function entry, OSR entries and after calls and traps
+        LoadSlot, // slot
+        LoadAcc,
+
+        // Hand the frame over. Operands are every slot below slot (the frame height), then acc, and they're written to
+        // memory first. The result is acc as the callee or trap left it
+        Call, // source is the CALL instruction
+        CallDynamic, // source is the CALL_DYN instruction
+        Trap, // imm is the trap code, source the TRAP, TRAP_IF_ZERO or TRAP_IF_NOT_ZERO instruction
+
+        // Terminators, always last in their block
+        Jump, // to successor 0
+        Branch, // operand 0 is the condition. successor 0 if it's non-zero, 1 if it's zero
+        Return, // operand 0 is acc, slot the frame height
+        Halt, // operand 0 is acc, slot the frame height, imm the exit code
+        Error, // an invalid instruction was reached, fails the call. operand 0 is acc, slot the frame height
+    };
+
+    bool IsPure(Op op);
+    bool IsTerminator(Op op);
+    bool IsFrameEffect(Op op); // Call, CallDynamic and Trap
+
+    struct Inst {
+        Op op;
+        BlockId block = None;
+        std::vector<ValueId> operands;
+        i64 imm = 0;
+        u32 slot = 0;
+        const Instruction* source = nullptr;
+
+        ValueId replacement = None; // set once the value was replaced by another one. it's not in any block then
+    };
+
+    struct Block {
+        std::vector<ValueId> insts; // phis first, terminator last
+        std::vector<BlockId> preds;
+        std::vector<BlockId> succs;
+        bool removed = false;
+    };
+
+    // A loop header the function can be entered at mid-run, with the frame height it expects there
+    struct OsrEntry {
+        u32 header; // instruction index of the header in the function
+        BlockId block; // root block that loads the frame and jumps to the header
+        u32 height;
+    };
+
+    struct Graph {
+        std::vector<Inst> insts;
+        std::vector<Block> blocks;
+
+        BlockId entry = None; // root block for calls. loads the frame and jumps to the entry instruction
+        std::vector<OsrEntry> osrEntries;
+
+        u32 args = 0; // frame height on entry, the function's minArgs
+        u32 slotCount = 0; // slots any of the code touches, inlined callees included. all must be within the stack
+
+        BlockId addBlock();
+
+        ValueId append(BlockId block, Op op, std::vector<ValueId> operands = {});
+        ValueId prepend(BlockId block, Op op, std::vector<ValueId> operands = {}); // before everything, phis included
+        ValueId addConst(BlockId block, i64 value);
+
+        void addEdge(BlockId from, BlockId to);
+        void removeEdge(BlockId from, size_t succIndex); // drops the matching operand of every phi in the successor
+
+        ValueId resolve(ValueId value) const; // follows replacements
+        void replace(ValueId value, ValueId with); // every use of value sees with instead, and value leaves its block
+        void remove(ValueId value); // takes an unused value out of its block
+
+        const Inst& get(ValueId value) const { return insts[resolve(value)]; }
+        bool isConst(ValueId value) const { return get(value).op == Op::Const; }
+
+        Inst& terminator(BlockId block) { return insts[blocks[block].insts.back()]; }
+        std::vector<BlockId> roots() const; // entry, then every OSR entry
+
+        // Reachable blocks from the roots in reverse postorder. Every block comes after its dominators
+        std::vector<BlockId> reversePostorder() const;
+
+        void resolveOperands(); // points every operand past replaced values
+        void removeUnreachable(); // blocks no root reaches, and their edges
+    };
+}
+
+#endif // BIBBLEVM_CORE_IR_H
@@ -0,0 +1,25 @@
+// Copyright 2025 JesusTouchMe
+
+#ifndef BIBBLEVM_CORE_IR_BUILDER_H
+#define BIBBLEVM_CORE_IR_BUILDER_H 1
+
+#include "BibbleVM/core/jit/ir.h"
+
+#include <optional>
+
+namespace bibble {
+    class VM;
+}
+
+namespace bibble::ir {
+    // Builds the graph of a verified function from module, specialized for being entered with exactly args values on
+    // its frame, which must be at least its minArgs. That puts every stack access at a slot index known up front, so
+    // the whole frame becomes SSA values. Calls to small verified functions that don't call or trap themselves are
+    // inlined.
+    //
+    // tables must be the tables the function's handlers came from. nullopt for what the optimizing compiler doesn't
+    // take: unverified functions, PUSH_SP and anything too big
+    std::optional<Graph> BuildGraph(VM& vm, u32 module, const DecodedFunction& function, const DispatchTables& tables, u32 args);
+}
+
+#endif // BIBBLEVM_CORE_IR_BUILDER_H
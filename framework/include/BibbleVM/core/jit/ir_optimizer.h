@@ -0,0 +1,14 @@
+// Copyright 2025 JesusTouchMe
+
+#ifndef BIBBLEVM_CORE_IR_OPTIMIZER_H
+#define BIBBLEVM_CORE_IR_OPTIMIZER_H 1
+
+#include "BibbleVM/core/jit/ir.h"
+
+namespace bibble::ir {
+    // Folds constants, branches on them included, and removes trivial phis and whatever became unreachable. Then hoists
+    // loop invariant computations into preheaders, and finally removes every value nothing uses
+    void OptimizeGraph(Graph& graph);
+}
+
+#endif // BIBBLEVM_CORE_IR_OPTIMIZER_H
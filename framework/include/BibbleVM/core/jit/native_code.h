@@ -0,0 +1,34 @@
+// Copyright 2025 JesusTouchMe
+
+#ifndef BIBBLEVM_CORE_NATIVE_CODE_H
+#define BIBBLEVM_CORE_NATIVE_CODE_H 1
+
+#include "BibbleVM/core/exec/dispatch.h"
+
+#include "BibbleVM/core/jit/executable_memory.h"
+
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+namespace bibble {
+    // Machine code one of the compilers made for a function, with the entry points into it
+    struct NativeCode {
+        static constexpr u32 NoResume = std::numeric_limits<u32>::max();
+
+        ExecutableMemory memory;
+        NativeEntry entry = nullptr; // null while there's no code
+        NativeResumeEntry resume = nullptr; // DISPATCH_SUCCESS if it turned the frame away untouched, which only optimized code does
+        std::vector<u32> offsets; // where resuming at each instruction starts in memory. NoResume where it can't
+
+        bool canResume(size_t index) const {
+            return resume != nullptr && offsets[index] != NoResume;
+        }
+
+        const void* resumeAddress(size_t index) const {
+            return static_cast<const u8*>(memory.data()) + offsets[index];
+        }
+    };
+}
+
+#endif // BIBBLEVM_CORE_NATIVE_CODE_H
@@ -0,0 +1,22 @@
+// Copyright 2025 JesusTouchMe
+
+#ifndef BIBBLEVM_CORE_OPTIMIZING_COMPILER_H
+#define BIBBLEVM_CORE_OPTIMIZING_COMPILER_H 1
+
+#include "BibbleVM/core/exec/instruction.h"
+
+namespace bibble {
+    class VM;
+
+    // Compiles a function that got hot in baseline code again, through the SSA graph of ir::BuildGraph: small callees
+    // inlined, constants folded, loop invariants hoisted and values in registers picked by linear scan. The frame only
+    // goes through memory around calls and traps.
+    //
+    // The code is specialized for frames entered with as many values as the one that got hot, which had height values
+    // at instruction. Calls with any other frame go to the baseline code instead, which the function must have already,
+    // and its resume entries (one per loop header) turn them away. On success the code is stored in the function and
+    // true is returned
+    bool CompileOptimized(VM& vm, u32 module, const DecodedFunction& function, const DispatchTables& tables, u32 instruction, u64 height);
+}
+
+#endif // BIBBLEVM_CORE_OPTIMIZING_COMPILER_H
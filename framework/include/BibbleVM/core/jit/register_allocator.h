@@ -0,0 +1,44 @@
+// Copyright 2025 JesusTouchMe
+
+#ifndef BIBBLEVM_CORE_REGISTER_ALLOCATOR_H
+#define BIBBLEVM_CORE_REGISTER_ALLOCATOR_H 1
+
+#include "BibbleVM/core/jit/ir.h"
+#include "BibbleVM/core/jit/x64_assembler.h"
+
+namespace bibble::ir {
+    struct Location {
+        enum class Kind : u8 {
+            None, // not needed, the value is unused or has no result
+            Register,
+            Stack, // spill slot
+            Constant, // rematerialized wherever it's used
+        };
+
+        Kind kind = Kind::None;
+        x64::Reg reg = x64::Reg::RAX;
+        u32 slot = 0;
+
+        bool operator==(const Location& other) const = default;
+    };
+
+    struct Allocation {
+        std::vector<BlockId> order; // blocks in the order they're emitted
+        std::vector<Location> locations; // by value
+        u32 spillSlots = 0;
+    };
+
+    // The registers values can live in. RAX, RCX and RDX stay free for the code generator, R14 and R15 hold the VM and
+    // ExecState and RBP addresses spill slots. Only the callee-saved ones keep values across calls and traps
+    inline constexpr x64::Reg CalleeSavedRegisters[] = { x64::Reg::RBX, x64::Reg::R12, x64::Reg::R13 };
+    inline constexpr x64::Reg CallerSavedRegisters[] = {
+        x64::Reg::RSI, x64::Reg::RDI, x64::Reg::R8, x64::Reg::R9, x64::Reg::R10, x64::Reg::R11,
+    };
+
+    // Splits critical edges, so phi moves always have a block of their own to go in, and places every value with the
+    // linear scan of Poletto and Sarkar over lifetime intervals from a liveness analysis. An interval is spilled for
+    // its whole lifetime if it doesn't get a register
+    Allocation AllocateRegisters(Graph& graph);
+}
+
+#endif // BIBBLEVM_CORE_REGISTER_ALLOCATOR_H
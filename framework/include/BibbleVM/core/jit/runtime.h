@@ -0,0 +1,26 @@
+// Copyright 2025 JesusTouchMe
+
+#ifndef BIBBLEVM_CORE_JIT_RUNTIME_H
+#define BIBBLEVM_CORE_JIT_RUNTIME_H 1
+
+#include "BibbleVM/core/exec/instruction.h"
+
+namespace bibble {
+    class VM;
+
+    // What compiled code calls into, shared by both compilers. They take pointers to match the registers they're called
+    // with, and expect acc and sp written back into state first. The DispatchErr ones return DISPATCH_SUCCESS to carry
+    // on, anything else is for the compiled code to return as is
+
+    DispatchErr CompiledCall(VM* vm, ExecState* state, const Instruction* inst);
+    DispatchErr CompiledCallDynamic(VM* vm, ExecState* state, const Instruction* inst);
+    DispatchErr CompiledTrap(VM* vm, ExecState* state, u32 trapCode);
+    void CompiledExit(VM* vm, i64 code);
+
+    // For a back-edge counter of baseline code that ran out. Optimizes the running function if it isn't yet and
+    // continues the frame in optimized code from the branch target. Returns DISPATCH_SUCCESS to keep running baseline
+    // code, with acc and sp unchanged in state
+    DispatchErr CompiledLoopHot(VM* vm, ExecState* state, const Instruction* branch);
+}
+
+#endif // BIBBLEVM_CORE_JIT_RUNTIME_H
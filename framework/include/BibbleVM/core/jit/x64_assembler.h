@@ -0,0 +1,129 @@
+// Copyright 2025 JesusTouchMe
+
+#ifndef BIBBLEVM_CORE_X64_ASSEMBLER_H
+#define BIBBLEVM_CORE_X64_ASSEMBLER_H 1
+
+#include "BibbleVM/core/value/value.h"
+
+#include <cstddef>
+#include <vector>
+
+namespace bibble::x64 {
+    enum class Reg : u8 {
+        RAX, RCX, RDX, RBX, RSP, RBP, RSI, RDI,
+        R8, R9, R10, R11, R12, R13, R14, R15,
+    };
+
+    enum class Xmm : u8 {
+        XMM0, XMM1, XMM2, XMM3, XMM4, XMM5, XMM6, XMM7,
+    };
+
+    // Condition codes as encoded in Jcc and SETcc
+    enum class Cond : u8 {
+        O = 0x0, NO = 0x1, B = 0x2, AE = 0x3, E = 0x4, NE = 0x5, BE = 0x6, A = 0x7,
+        S = 0x8, NS = 0x9, P = 0xA, NP = 0xB, L = 0xC, GE = 0xD, LE = 0xE, G = 0xF,
+    };
+
+    // [base + disp]
+    struct Mem {
+        Reg base;
+        i32 disp = 0;
+    };
+
+    // The two-operand integer instructions sharing the 01/03/81 encodings, by their /digit
+    enum class AluOp : u8 {
+        ADD = 0, OR = 1, AND = 4, SUB = 5, XOR = 6, CMP = 7,
+    };
+
+    enum class SseOp : u8 {
+        ADDSD = 0x58, MULSD = 0x59, SUBSD = 0x5C, DIVSD = 0x5E,
+    };
+
+    // Just enough of x86-64 for the compilers. Every operand is 64 bits wide unless the name says otherwise
+    class Assembler {
+    public:
+        struct Label {
+            size_t id;
+        };
+
+        size_t getPosition() const;
+
+        Label newLabel();
+        void bind(Label label);
+        size_t getPosition(Label label) const; // must be bound
+
+        void mov(Reg dst, Reg src);
+        void mov(Reg dst, Mem src);
+        void mov(Mem dst, Reg src);
+        void mov(Reg dst, i64 imm); // picks the shortest encoding
+
+        void alu(AluOp op, Reg dst, Reg src);
+        void alu(AluOp op, Reg dst, Mem src);
+        void alu(AluOp op, Reg dst, i32 imm);
+        void alu32(AluOp op, Mem dst, i32 imm); // dword in memory
+
+        void imul(Reg dst, Reg src);
+        void imul(Reg dst, Mem src);
+        void cqo();
+        void idiv(Reg src);
+        void neg(Reg reg);
+        void neg(Mem mem);
+        void not_(Reg reg);
+        void not_(Mem mem);
+        void shlCl(Reg reg);
+        void sarCl(Reg reg);
+        void test(Reg a, Reg b);
+
+        void setcc(Cond cond, Reg dst); // low byte of RAX, RCX, RDX or RBX only
+        void movzxByte(Reg dst, Reg src); // 32-bit destination, which clears the upper half
+        void andByte(Reg dst, Reg src);
+        void orByte(Reg dst, Reg src);
+
+        void movq(Xmm dst, Reg src);
+        void movq(Reg dst, Xmm src);
+        void movsd(Xmm dst, Mem src);
+        void movsd(Mem dst, Xmm src);
+        void sse(SseOp op, Xmm dst, Xmm src);
+        void ucomisd(Xmm a, Xmm b);
+        void xorpd(Xmm dst, Xmm src);
+
+        // RAX = xmm0 <cond> xmm1 as 0 or 1, clobbering RCX. cond is the integer condition the comparison reads as (E,
+        // NE, L, LE, G or GE), and NaN compares false for everything but NE like it does in C++
+        void compareSd(Cond cond);
+
+        void push(Reg reg);
+        void pop(Reg reg);
+        void call(Reg target);
+        void ret();
+
+        void jmp(Label target);
+        void jmp(Reg target);
+        void jcc(Cond cond, Label target);
+
+        // Patches every jump. All used labels must be bound by now
+        std::vector<u8> finish();
+
+    private:
+        struct Fixup {
+            size_t rel32; // offset of the displacement, which is relative to the end of the instruction
+            size_t label;
+        };
+
+        std::vector<u8> mBytes;
+        std::vector<size_t> mLabels;
+        std::vector<Fixup> mFixups;
+
+        void byte(u8 value);
+        void dword(u32 value);
+        void qword(u64 value);
+
+        // REX prefix for a reg field and an r/m field. Emitted only when needed, unless forced for W
+        void rex(bool w, u8 reg, u8 rm);
+        void modrm(u8 reg, Reg rm);
+        void modrm(u8 reg, Mem rm);
+
+        void jump(Label target);
+    };
+}
+
+#endif // BIBBLEVM_CORE_X64_ASSEMBLER_H
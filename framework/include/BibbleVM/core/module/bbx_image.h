@@ -0,0 +1,56 @@
+// Copyright 2025 JesusTouchMe
+
+#ifndef BIBBLEVM_CORE_BBX_IMAGE_H
+#define BIBBLEVM_CORE_BBX_IMAGE_H 1
+
+#include "BibbleVM/core/value/value.h"
+
+#include <cstddef>
+#include <optional>
+#include <span>
+#include <string_view>
+
+namespace bibble {
+    // A bbx file mapped into memory. The whole file is mapped read-only and shared, so its pages come from the page cache
+    // as they're first touched and every process running it shares them. The data section, which linking patches, gets
+    // a second private copy-on-write mapping, where only the pages actually written are copied. Unmapped on destruction.
+    //
+    // The file must not be truncated or rewritten while mapped
+    class BbxImage {
+    public:
+        BbxImage() = default;
+        BbxImage(BbxImage&& other) noexcept;
+        BbxImage& operator=(BbxImage&& other) noexcept;
+        ~BbxImage();
+
+        BbxImage(const BbxImage&) = delete;
+        BbxImage& operator=(const BbxImage&) = delete;
+
+        // nullopt if the file can't be opened or mapped, or where the platform can't map files
+        static std::optional<BbxImage> Map(std::string_view path);
+
+        // Only the size bytes from offset, for a bbx file embedded in a bigger one (see VM::saveImage). file and
+        // privateBytes see just those
+        static std::optional<BbxImage> Map(std::string_view path, size_t offset, size_t size);
+
+        std::span<u8> file() const; // read-only
+
+        // Writable copy-on-write view of size bytes of the file from offset. Only the first call maps anything, the file
+        // is closed after it. Empty on failure or if size is 0
+        std::span<u8> privateBytes(size_t offset, size_t size);
+
+    private:
+        void* mFile = nullptr;
+        size_t mFileSize = 0; // of the mapping
+        size_t mOffset = 0; // where the bbx file starts in the file on disk
+        size_t mLead = 0; // bytes mapped before it, since mappings start on a page
+
+        void* mPrivate = nullptr;
+        size_t mPrivateSize = 0;
+        int mDescriptor = -1; // open until privateBytes
+
+        static std::optional<BbxImage> MapRange(std::string_view path, size_t offset, std::optional<size_t> size); // to the end of the file without size
+    };
+}
+
+#endif // BIBBLEVM_CORE_BBX_IMAGE_H
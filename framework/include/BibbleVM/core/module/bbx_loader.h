@@ -0,0 +1,35 @@
+// Copyright 2025 JesusTouchMe
+
+#ifndef BIBBLEVM_CORE_BBX_LOADER_H
+#define BIBBLEVM_CORE_BBX_LOADER_H 1
+
+#include "BibbleVM/core/module/module.h"
+
+#include <memory>
+#include <span>
+#include <string_view>
+
+namespace bibble {
+    constexpr u16 BbxVersion = 1;
+
+    // Kinds of the sections in a bbx section header table. See spec/docs/bbx-format.md
+    enum class BbxSectionKind : u32 {
+        DATA = 1,
+        STRTAB = 2,
+        CODE = 3,
+        LINK = 4,
+    };
+
+    // Module over a bbx file mapped into memory (see BbxImage), with the sections straight over the mapping. Nothing is
+    // read until it's used, so loading costs the same whatever the size of the file. Falls back to reading the whole file
+    // where files can't be mapped. nullptr if it can't be read or isn't a valid bbx file
+    std::unique_ptr<Module> LoadBbxFile(std::string_view path);
+
+    // Like LoadBbxFile, for a bbx file embedded in a bigger one as the size bytes from offset
+    std::unique_ptr<Module> LoadBbxFile(std::string_view path, size_t offset, size_t size);
+
+    // Module over a copy of a bbx file already in memory. nullptr if it isn't a valid bbx file
+    std::unique_ptr<Module> LoadBbx(std::span<const u8> bytes);
+}
+
+#endif // BIBBLEVM_CORE_BBX_LOADER_H
@@ -5,26 +5,46 @@
 
 #include "BibbleVM/core/bytecode/code_section.h"
 #include "BibbleVM/core/bytecode/data_section.h"
+#include "BibbleVM/core/bytecode/link_section.h"
 #include "BibbleVM/core/bytecode/strtab_section.h"
 
+#include "BibbleVM/core/exec/instruction.h"
+
+#include "BibbleVM/core/module/bbx_image.h"
+
 #include <memory>
+#include <unordered_map>
 
 namespace bibble {
     // This represents a loaded bbx file and holds its bytecode and parsed sections.
     class Module {
     public:
-        Module(std::unique_ptr<u8[]> bytecode, DataSection dataSection, StrtabSection strtabSection, CodeSection codeSection);
+        Module(std::unique_ptr<u8[]> bytecode, DataSection dataSection, StrtabSection strtabSection, CodeSection codeSection, LinkSection linkSection = LinkSection(Section({})));
+        Module(BbxImage image, DataSection dataSection, StrtabSection strtabSection, CodeSection codeSection, LinkSection linkSection = LinkSection(Section({}))); // sections in image
 
         DataSection& data();
         const StrtabSection& strtab() const;
         const CodeSection& code() const;
+        const LinkSection& links() const; // empty if the module doesn't list its call entries
+
+        // Pre-decoded functions by code section entry offset, shared by every CallableTarget into this module
+        const DecodedFunction* getDecodedFunction(size_t entry) const;
+        const DecodedFunction* addDecodedFunction(DecodedFunction function);
+
+        // The function whose instructions (or register form) start at code, or nullptr. Linear, for the rare paths that
+        // only have a pc
+        const DecodedFunction* findDecodedFunction(const Instruction* code) const;
 
     private:
         std::unique_ptr<u8[]> mBytecode;
+        BbxImage mImage;
 
         DataSection mDataSection;
         StrtabSection mStrtabSection;
         CodeSection mCodeSection;
+        LinkSection mLinkSection;
+
+        std::unordered_map<size_t, std::unique_ptr<DecodedFunction>> mDecodedFunctions;
     };
 }
 
@@ -6,30 +6,90 @@
 #include "BibbleVM/core/value/value.h"
 
 #include <memory>
-#include <optional>
+#include <type_traits>
+
+// whether stacks get guard pages, which unchecked code overflowing into turns into a recoverable fault (see Stack)
+#if defined(PLATFORM_LINUX) || defined(PLATFORM_MACOS)
+#define BIBBLEVM_STACK_GUARD 1
+#else
+#define BIBBLEVM_STACK_GUARD 0
+#endif
 
 namespace bibble {
-    // non-resizable lifo stack
+    struct Instruction;
+
+    // Where to resume the caller once a frame returns. A null pc marks a frame entered from the host, whose RET leaves
+    // the interpreter instead of resuming bytecode
+    struct ReturnAddress {
+        const Instruction* pc = nullptr;
+        const Instruction* code = nullptr; // instruction stream of the caller, for its branch targets
+        u32 module = 0xFFFFFFFF;
+    };
+
+    // Non-resizable lifo stack. With BIBBLEVM_STACK_GUARD its slots are a mapping of their own, which the OS only
+    // commits as they're first touched, between guard pages that fault on anything running off either end
     class Stack {
     public:
         Stack(u64 size);
+        ~Stack();
 
-        i64 sb() const;
+        Stack(const Stack&) = delete;
+        Stack& operator=(const Stack&) = delete;
+
+        i64 sb() const; // index of local 0 in the current frame
         Value& sp();
 
-        bool pushFrame(i64 minSize); // true on success
-        bool popFrame(); // true on success
+        Value* data(); // raw slots, for the interpreter to keep sp/sb as pointers while it runs
+        i64 capacity() const;
+
+        // Empty frame on top of the stack with room for at least minSize values. Used by the host before calling in
+        bool pushFrame(i64 minSize, const ReturnAddress& returnAddress = {}); // true on success
+
+        // Frame made of the top argc values of the current frame, which become its first locals where they are.
+        // Nothing is copied, the caller state goes into a separate frame record
+        bool pushCallFrame(i64 argc, const ReturnAddress& returnAddress); // true on success
 
-        bool isWithinBounds(i64 index) const; // index > sb && index < capacity
+        bool popFrame(); // true on success. discards everything from sb up
+
+        ReturnAddress returnAddress() const; // of the current frame
+
+        bool isWithinBounds(i64 index) const; // index >= sb && index < capacity
 
         Value& operator[](size_t index);
         const Value& operator[](size_t index) const;
 
+        // Calls function, or returns false if something in it touched the guard pages of this stack. The fault jumps
+        // straight back to the innermost one running, abandoning whatever was running without unwinding it, so it's for
+        // code that holds nothing needing cleanup while it touches the slots, or whose caller cleans up after it: the
+        // dispatch loop and compiled code. Host code calling back into the VM nests another. Always true without guard pages
+        template<class F>
+        bool runGuarded(F&& function) {
+            return runGuarded([](void* context) { (*static_cast<std::remove_reference_t<F>*>(context))(); }, &function);
+        }
+
     private:
-        std::unique_ptr<Value[]> mMemory;
+        // plain fields rather than a ReturnAddress so new[] really leaves the array uninitialized
+        struct Frame {
+            i64 savedBase;
+            const Instruction* returnPc;
+            const Instruction* returnCode;
+            u32 returnModule;
+        };
+
+        Value* mMemory;
         i64 mCapacity;
 
-        i64 mStackBase = -1; // index of the previous frames stack base value saved. used for stack underflow checks
+        void* mMapping = nullptr; // slots and guard pages, if the platform gave us them
+        size_t mMappingSize = 0;
+        std::unique_ptr<Value[]> mHeapMemory; // otherwise
+
+        bool runGuarded(void (*function)(void*), void* context);
+
+        std::unique_ptr<Frame[]> mFrames; // left uninitialized, so untouched pages never get committed
+        i64 mFrameCapacity;
+        i64 mFrameCount = 0;
+
+        i64 mStackBase = 0; // index of the current frames first local. used for stack underflow checks
         Value mStackPointer = 0; // SP register following the BibbleVM specification. stored as Value for simplicity
     };
 }
@@ -0,0 +1,40 @@
+// Copyright 2025 JesusTouchMe
+
+#ifndef BIBBLEVM_CORE_OUTPUT_BUFFER_H
+#define BIBBLEVM_CORE_OUTPUT_BUFFER_H 1
+
+#include "BibbleVM/core/value/value.h"
+
+#include <array>
+#include <cstdio>
+#include <string_view>
+
+namespace bibble {
+    // Where the output traps write. Text collects here and only reaches the sink when the buffer fills, on flush(), when
+    // the VM exits and when it's destroyed, so printing in a loop costs a copy rather than a syscall per trap
+    class OutputBuffer {
+    public:
+        explicit OutputBuffer(std::FILE* sink = stdout);
+        ~OutputBuffer();
+
+        OutputBuffer(const OutputBuffer&) = delete;
+        OutputBuffer& operator=(const OutputBuffer&) = delete;
+
+        void write(std::string_view text);
+        void writeChar(char c);
+        void writeInteger(i64 value);
+        void writeFloat(double value);
+
+        void flush();
+
+        std::FILE* getSink() const;
+        void setSink(std::FILE* sink); // flushes what's buffered for the old sink first. nullptr discards all output
+
+    private:
+        std::FILE* mSink;
+        size_t mSize = 0;
+        std::array<char, 8192> mBuffer;
+    };
+}
+
+#endif // BIBBLEVM_CORE_OUTPUT_BUFFER_H
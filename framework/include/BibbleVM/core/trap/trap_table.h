@@ -0,0 +1,51 @@
+// Copyright 2025 JesusTouchMe
+
+#ifndef BIBBLEVM_CORE_TRAP_TABLE_H
+#define BIBBLEVM_CORE_TRAP_TABLE_H 1
+
+#include "BibbleVM/core/value/value.h"
+
+#include <array>
+
+namespace bibble {
+    class VM;
+
+    // Runs a TRAP, TRAP_IF_ZERO or TRAP_IF_NOT_ZERO that fired with code. Sees acc and the stack through the VM like a
+    // host function. Returns false if the trap failed, which ends the running code with an error
+    using TrapHandler = bool(*)(VM& vm, u8 code);
+
+    // Codes the default tables handle. The rest are left to the host
+    enum class TrapCode : u8 {
+        PRINT_INTEGER = 0x00, // acc as an integer, then a newline
+        PRINT_FLOAT = 0x01, // acc as a double, then a newline
+        PRINT_CHAR = 0x02, // the low byte of acc
+        FLUSH = 0x03, // VM::output() to its sink
+        READ_INTEGER = 0x04, // from stdin into acc, 0 if there's nothing to read. not in the sandbox table
+    };
+
+    bool IgnoreTrap(VM& vm, u8 code); // does nothing
+    bool RefuseTrap(VM& vm, u8 code); // fails
+
+    // Handler for each of the 256 trap codes, so a trap is one indexed call whatever its code. A VM uses the one in
+    // VMConfig::traps, which can be shared between VMs, or the default table for its config
+    class TrapTable {
+    public:
+        explicit TrapTable(TrapHandler unassigned = IgnoreTrap); // every code handled by unassigned
+
+        TrapHandler get(u8 code) const;
+        void set(u8 code, TrapHandler handler); // handler can't be nullptr, use IgnoreTrap or RefuseTrap
+
+        bool invoke(VM& vm, u8 code) const {
+            return mHandlers[code](vm, code);
+        }
+
+    private:
+        std::array<TrapHandler, 256> mHandlers;
+    };
+
+    // The built-in output and input traps for hosted VMs. Sandboxed ones get the output traps only, and any code without
+    // a handler fails instead of doing nothing. Both print through VM::output()
+    const TrapTable& GetDefaultTrapTable(bool sandbox);
+}
+
+#endif // BIBBLEVM_CORE_TRAP_TABLE_H
@@ -21,6 +21,10 @@ namespace bibble {
         Value(T value)
             : mValue(value) {}
 
+        // floats keep their bits instead of being converted to the integer member like everything else
+        Value(double value) { mValue.floating = value; }
+        Value(float value) { mValue.floating = value; }
+
         Value() : mValue(0) {}
 
         i64& integer() { return mValue.integer; }
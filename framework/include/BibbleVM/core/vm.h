@@ -4,20 +4,25 @@
 #define BIBBLEVM_CORE_VM_H 1
 
 #include "BibbleVM/core/call/function.h"
+#include "BibbleVM/core/call/symbol_table.h"
 
 #include "BibbleVM/core/exec/interpreter.h"
 
+#include "BibbleVM/core/gc/heap.h"
+
 #include "BibbleVM/core/module/module.h"
 
 #include "BibbleVM/core/stack/stack.h"
 
+#include "BibbleVM/core/trap/output_buffer.h"
+#include "BibbleVM/core/trap/trap_table.h"
+
 #include "BibbleVM/util/string.h"
 
 #include "BibbleVM/config.h"
 
 #include <memory>
 #include <optional>
-#include <unordered_map>
 #include <vector>
 
 namespace bibble {
@@ -26,12 +31,35 @@ namespace bibble {
 
     class VM {
     friend std::unique_ptr<VM> CreateVM(VMConfig config);
+    friend std::unique_ptr<VM> CreateVMFromImage(std::string_view path, VMConfig config);
     public:
         Module* getModule(u32 index) const;
         Function* getFunction(std::string_view name) const;
+        Function* getFunction(std::string_view name, u32 hash) const; // hash is util::HashSymbol(name)
+        Function* getFunction(u32 id) const; // id as returned by addFunction
+
+        // The function the image the VM was created from has at address in module's code, which is what the call entries
+        // that were linked before it was saved point at. nullptr if there's none, or the VM wasn't created from an image
+        Function* getImageFunction(u32 module, u32 address) const;
 
         u32 addModule(std::unique_ptr<Module> module);
-        void addFunction(std::unique_ptr<Function> function);
+
+        // The function's id, dense from 0 in the order functions were added. NoFunction if one with the same name was
+        // already added, which exits the VM. name must outlive the VM
+        u32 addFunction(u32 module, std::string_view name, CallableTarget target);
+
+        // Links every call entry in the module's link table now rather than on first call, in one pass with the name
+        // hashes the table stores. Done by addModule when VMConfig::eagerLink is set. Entries naming functions that
+        // aren't added yet stay unlinked and are tried again on first call. true if none are left
+        bool linkModule(u32 module);
+
+        // Makes function callable from bytecode under name, like a bytecode function added with addFunction. name must
+        // outlive the VM
+        void addHostFunction(std::string_view name, HostFunction function);
+
+        // Writes every module, with its call entries linked as far as they are now, and every bytecode function to path
+        // as a VM image for CreateVMFromImage. Host functions aren't saved, they have to be added again. true on success
+        bool saveImage(std::string_view path) const;
 
         Module* currentModule();
         u32 currentModuleH();
@@ -42,12 +70,20 @@ namespace bibble {
 
         Interpreter& interpreter();
 
+        Heap& heap(); // where objects are allocated
+
         // true on success
         bool push(Value value);
         std::optional<Value> pop();
 
+        OutputBuffer& output(); // what the output traps print to
+
+        // true on success. Runs the handler the trap table has for code
         bool trap(u8 code);
 
+        const TrapTable& getTrapTable() const;
+        void setTrapHandler(u8 code, TrapHandler handler); // for this VM only, the table it was configured with stays as it is
+
         void exit(int code);
         int getExitCode() const;
         bool hasExited() const;
@@ -56,11 +92,18 @@ namespace bibble {
         VMConfig mConfig;
 
         std::vector<std::unique_ptr<Module>> mModules;
-        std::unordered_map<std::string, std::unique_ptr<Function>, util::StringHash, util::StringEq> mFunctions;
+        mutable SymbolTable mSymbols; // every added function, owned here
+        std::unique_ptr<u8[]> mImageDirectory; // of the image the VM was created from. its function names point into it
+        std::vector<u64> mImageFunctions; // module << 32 | entry of each function in the image, by id, if that's sorted
 
         Value mAccumulator;
         Stack mStack;
         Interpreter mInterpreter;
+        Heap mHeap;
+
+        const TrapTable* mTraps;
+        std::unique_ptr<TrapTable> mOwnTraps; // copy of the configured table, once a handler was set on this VM
+        OutputBuffer mOutput;
 
         int mExitCode = 0;
         bool mExited = false;
@@ -69,6 +112,11 @@ namespace bibble {
     };
 
     std::unique_ptr<VM> CreateVM(VMConfig config = {});
+
+    // A VM with the modules and functions of the image VM::saveImage wrote to path. Modules are mapped like
+    // LoadBbxFile and get the same handles they had, so the call entries that were linked stay linked, and functions
+    // keep their ids if no host functions were added between them. nullptr if the image can't be read or is invalid
+    std::unique_ptr<VM> CreateVMFromImage(std::string_view path, VMConfig config = {});
 }
 
 #endif // BIBBLEVM_CORE_VM_H
@@ -0,0 +1,31 @@
+// Copyright 2025 JesusTouchMe
+
+#ifndef BIBBLEVM_UTIL_SCOPED_VALUE_H
+#define BIBBLEVM_UTIL_SCOPED_VALUE_H 1
+
+namespace bibble::util {
+    // Sets variable to value for as long as it's in scope, and puts back what it held before however the scope is left,
+    // exceptions included
+    template<class T>
+    class ScopedValue {
+    public:
+        ScopedValue(T& variable, T value)
+            : mVariable(variable)
+            , mPrevious(variable) {
+            variable = value;
+        }
+
+        ~ScopedValue() {
+            mVariable = mPrevious;
+        }
+
+        ScopedValue(const ScopedValue&) = delete;
+        ScopedValue& operator=(const ScopedValue&) = delete;
+
+    private:
+        T& mVariable;
+        T mPrevious;
+    };
+}
+
+#endif // BIBBLEVM_UTIL_SCOPED_VALUE_H
@@ -3,9 +3,23 @@
 #ifndef BIBBLEVM_UTIL_STRING_H
 #define BIBBLEVM_UTIL_STRING_H 1
 
+#include <cstdint>
 #include <string>
+#include <string_view>
 
 namespace bibble::util {
+    // 32-bit FNV-1a. What function names are hashed with everywhere, so bbx files can store the hashes of the names
+    // they link against and the VM looks them up without hashing again
+    constexpr std::uint32_t HashSymbol(std::string_view name) {
+        std::uint32_t hash = 2166136261u;
+        for (char c : name) {
+            hash ^= static_cast<unsigned char>(c);
+            hash *= 16777619u;
+        }
+
+        return hash;
+    }
+
     struct StringHash {
         using is_transparent = void;
 
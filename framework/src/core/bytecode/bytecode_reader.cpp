@@ -22,7 +22,12 @@ namespace bibble {
     }
 
     bool BytecodeReader::skip(i64 count) {
-        if (count > getRemaining()) return false;
+        if (count < 0) {
+            if (static_cast<size_t>(-count) > mPosition) return false;
+        } else if (static_cast<size_t>(count) > getRemaining()) {
+            return false;
+        }
+
         mPosition += count;
         return true;
     }
@@ -57,7 +62,7 @@ namespace bibble {
     std::optional<u64> BytecodeReader::fetchU64() {
         if (getRemaining() < 8) return std::nullopt;
 
-        u32 value = (static_cast<u64>(mBytes[mPosition++]) << 56) |
+        u64 value = (static_cast<u64>(mBytes[mPosition++]) << 56) |
                     (static_cast<u64>(mBytes[mPosition++]) << 48) |
                     (static_cast<u64>(mBytes[mPosition++]) << 40) |
                     (static_cast<u64>(mBytes[mPosition++]) << 32) |
@@ -92,7 +97,7 @@ namespace bibble {
         if (!raw.has_value()) return std::nullopt;
 
         float value;
-        std::memcpy(&value, &raw, sizeof(value));
+        std::memcpy(&value, &raw.value(), sizeof(value));
 
         return value;
     }
@@ -104,7 +109,7 @@ namespace bibble {
         if (!raw.has_value()) return std::nullopt;
 
         double value;
-        std::memcpy(&value, &raw, sizeof(value));
+        std::memcpy(&value, &raw.value(), sizeof(value));
 
         return value;
     }
@@ -6,6 +6,14 @@ namespace bibble {
     CodeSection::CodeSection(Section section)
         : mSection(section) {}
 
+    const Section& CodeSection::getSection() const {
+        return mSection;
+    }
+
+    size_t CodeSection::getSize() const {
+        return mSection.getSize();
+    }
+
     std::optional<BytecodeReader> CodeSection::getBytecodeReader(size_t offset) const {
         if (offset >= mSection.getSize()) return std::nullopt;
 
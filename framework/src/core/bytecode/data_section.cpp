@@ -35,6 +35,10 @@ namespace bibble {
     DataSection::DataSection(Section section)
         : mSection(section) {}
 
+    const Section& DataSection::getSection() const {
+        return mSection;
+    }
+
     std::optional<i8> DataSection::getByte(u32 offset) {
         return mSection.getI8(offset);
     }
@@ -69,6 +73,10 @@ namespace bibble {
     }
 
     const CallableTarget* DataSection::getCallable(u32 offset, VM& vm) {
+        return link(offset, vm, vm.currentModuleH());
+    }
+
+    const CallableTarget* DataSection::link(u32 offset, VM& vm, u32 module, std::optional<u32> nameHash) {
         auto cached = mCallableCache.find(offset);
         if (cached != mCallableCache.end()) return cached->second;
 
@@ -78,31 +86,34 @@ namespace bibble {
         CallEntry& callEntry = callEntryOpt.value();
 
         if (callEntry.module == 0xFFFFFFFF) { // module not linked yet
-            Module* currentModule = vm.currentModule();
-            if (currentModule == nullptr) return nullptr;
+            Module* linkedModule = vm.getModule(module);
+            if (linkedModule == nullptr) return nullptr;
 
             if (callEntry.address == 0xFFFFFFFF) { // function not resolved
                 if (!callEntry.name.has_value()) return nullptr;
 
-                std::optional<std::string_view> name = resolveString(callEntry.name.value().data(), currentModule->strtab());
+                std::optional<std::string_view> name = resolveString(callEntry.name.value().data(), linkedModule->strtab());
                 if (!name.has_value()) return nullptr;
 
-                Function* function = vm.getFunction(name.value());
+                Function* function = vm.getFunction(name.value(), nameHash.value_or(util::HashSymbol(name.value())));
                 if (function == nullptr) return nullptr;
 
-                callEntry.module = function->getModule();
-                callEntry.address = static_cast<u32>(function->target().entry.getPosition()); // TODO: make this more CallableTarget-generic (e.g. machine code)
+                // host functions have no address, their entry stays unlinked and only the cache finds them
+                if (function->target().host == nullptr) {
+                    callEntry.module = function->getModule();
+                    callEntry.address = static_cast<u32>(function->target().entry.getPosition());
 
-                mSection.setCustom<CallEntry>(offset, callEntry);
+                    mSection.setCustom<CallEntry>(offset, callEntry);
+                }
 
                 CallableTarget* target = &function->target();
                 mCallableCache[offset] = target;
                 return target;
-            } else { // function is resolved and is in current module
-                std::optional<BytecodeReader> bytecode = currentModule->code().getBytecodeReader(callEntry.address);
+            } else { // function is resolved and is in this module
+                std::optional<BytecodeReader> bytecode = linkedModule->code().getBytecodeReader(callEntry.address);
                 if (!bytecode.has_value()) return nullptr;
 
-                callEntry.module = vm.currentModuleH();
+                callEntry.module = module;
 
                 mCallableTargets.push_back(std::make_unique<CallableTarget>(callEntry.module, bytecode.value()));
 
@@ -112,11 +123,35 @@ namespace bibble {
                 mCallableCache[offset] = target;
                 return target;
             }
-        } else { // this is already linked, but somehow not cached?
-            return nullptr;
+        } else { // linked by the VM this module was saved from (see VM::saveImage), whose module handles this one shares
+            // the target of the function there, like a call site linked by name gets, which the first call decodes for
+            // every other call site of it
+            Function* function = vm.getImageFunction(callEntry.module, callEntry.address);
+            if (function != nullptr) {
+                CallableTarget* target = &function->target();
+                mCallableCache[offset] = target;
+                return target;
+            }
+
+            Module* linkedModule = vm.getModule(callEntry.module);
+            if (linkedModule == nullptr) return nullptr;
+
+            std::optional<BytecodeReader> bytecode = linkedModule->code().getBytecodeReader(callEntry.address);
+            if (!bytecode.has_value()) return nullptr;
+
+            mCallableTargets.push_back(std::make_unique<CallableTarget>(callEntry.module, bytecode.value()));
+
+            CallableTarget* target = mCallableTargets.back().get();
+            mCallableCache[offset] = target;
+            return target;
         }
     }
 
+    void DataSection::reserveCallables(size_t count) {
+        mCallableCache.reserve(mCallableCache.size() + count);
+        mCallableTargets.reserve(mCallableTargets.size() + count);
+    }
+
     std::optional<std::string_view> DataSection::resolveString(const u8 bytes[8], const StrtabSection& strtab) {
         if (bytes[0] == '@' && bytes[1] == 'S' && bytes[2] == 'T' && bytes[3] == 'R') {
             u32 stringOffset = (static_cast<u32>(bytes[4]) << 24) |
@@ -0,0 +1,30 @@
+// Copyright 2025 JesusTouchMe
+
+#include "BibbleVM/core/bytecode/link_section.h"
+
+namespace bibble {
+    static constexpr size_t LinkEntrySize = 8;
+
+    std::optional<LinkEntry> LinkEntry::ReadFromSection(const Section& section, size_t offset) {
+        std::optional<u32> entryOffset = section.getU32(offset);
+        std::optional<u32> nameHash = section.getU32(offset + 4);
+        if (!entryOffset.has_value() || !nameHash.has_value()) return std::nullopt;
+
+        return LinkEntry(entryOffset.value(), nameHash.value());
+    }
+
+    LinkSection::LinkSection(Section section)
+        : mSection(section) {}
+
+    const Section& LinkSection::getSection() const {
+        return mSection;
+    }
+
+    size_t LinkSection::getCount() const {
+        return mSection.getSize() / LinkEntrySize;
+    }
+
+    std::optional<LinkEntry> LinkSection::get(size_t index) const {
+        return mSection.getCustom<LinkEntry>(index * LinkEntrySize);
+    }
+}
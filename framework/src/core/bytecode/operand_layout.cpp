@@ -0,0 +1,102 @@
+// Copyright 2025 JesusTouchMe
+
+#include "BibbleVM/core/bytecode/operand_layout.h"
+
+namespace bibble {
+    std::optional<OperandLayout> GetOperandLayout(ByteOpcode opcode) {
+        switch (opcode) {
+            case ByteOpcode::NOP:
+            case ByteOpcode::BRK:
+            case ByteOpcode::ADD: case ByteOpcode::SUB: case ByteOpcode::MUL: case ByteOpcode::DIV: case ByteOpcode::MOD:
+            case ByteOpcode::AND: case ByteOpcode::OR: case ByteOpcode::XOR: case ByteOpcode::SHL: case ByteOpcode::SHR:
+            case ByteOpcode::NEG: case ByteOpcode::NOT:
+            case ByteOpcode::ADD2: case ByteOpcode::SUB2: case ByteOpcode::MUL2: case ByteOpcode::DIV2: case ByteOpcode::MOD2:
+            case ByteOpcode::AND2: case ByteOpcode::OR2: case ByteOpcode::XOR2: case ByteOpcode::SHL2: case ByteOpcode::SHR2:
+            case ByteOpcode::ADD_ST: case ByteOpcode::SUB_ST: case ByteOpcode::MUL_ST: case ByteOpcode::DIV_ST: case ByteOpcode::MOD_ST:
+            case ByteOpcode::AND_ST: case ByteOpcode::OR_ST: case ByteOpcode::XOR_ST: case ByteOpcode::SHL_ST: case ByteOpcode::SHR_ST:
+            case ByteOpcode::NEG_ST: case ByteOpcode::NOT_ST:
+            case ByteOpcode::FADD: case ByteOpcode::FSUB: case ByteOpcode::FMUL: case ByteOpcode::FDIV:
+            case ByteOpcode::FADD2: case ByteOpcode::FSUB2: case ByteOpcode::FMUL2: case ByteOpcode::FDIV2:
+            case ByteOpcode::FADD_ST: case ByteOpcode::FSUB_ST: case ByteOpcode::FMUL_ST: case ByteOpcode::FDIV_ST:
+            case ByteOpcode::FNEG:
+            case ByteOpcode::CMP_EQ: case ByteOpcode::CMP_NE: case ByteOpcode::CMP_LT: case ByteOpcode::CMP_GT:
+            case ByteOpcode::CMP_LTE: case ByteOpcode::CMP_GTE:
+            case ByteOpcode::FCMP_EQ: case ByteOpcode::FCMP_NE: case ByteOpcode::FCMP_LT: case ByteOpcode::FCMP_GT:
+            case ByteOpcode::FCMP_LTE: case ByteOpcode::FCMP_GTE:
+            case ByteOpcode::CMP_EQ0: case ByteOpcode::CMP_NE0: case ByteOpcode::CMP_LT0: case ByteOpcode::CMP_GT0:
+            case ByteOpcode::CMP_LTE0: case ByteOpcode::CMP_GTE0:
+            case ByteOpcode::FCMP_EQ0: case ByteOpcode::FCMP_NE0: case ByteOpcode::FCMP_LT0: case ByteOpcode::FCMP_GT0:
+            case ByteOpcode::FCMP_LTE0: case ByteOpcode::FCMP_GTE0:
+            case ByteOpcode::PUSH_ACC: case ByteOpcode::PUSH_SP: case ByteOpcode::POP_ACC: case ByteOpcode::POP_SP:
+            case ByteOpcode::RET:
+                return OperandLayout::None;
+
+            case ByteOpcode::HLT:
+            case ByteOpcode::CONST:
+            case ByteOpcode::CONST_ST:
+                return OperandLayout::ImmI8;
+
+            case ByteOpcode::ADD_IMM: case ByteOpcode::SUB_IMM: case ByteOpcode::MUL_IMM: case ByteOpcode::DIV_IMM: case ByteOpcode::MOD_IMM:
+            case ByteOpcode::AND_IMM: case ByteOpcode::OR_IMM: case ByteOpcode::XOR_IMM: case ByteOpcode::SHL_IMM: case ByteOpcode::SHR_IMM:
+            case ByteOpcode::ADD_IMM_ST: case ByteOpcode::SUB_IMM_ST: case ByteOpcode::MUL_IMM_ST: case ByteOpcode::DIV_IMM_ST:
+            case ByteOpcode::MOD_IMM_ST: case ByteOpcode::AND_IMM_ST: case ByteOpcode::OR_IMM_ST: case ByteOpcode::XOR_IMM_ST:
+            case ByteOpcode::SHL_IMM_ST: case ByteOpcode::SHR_IMM_ST:
+            case ByteOpcode::CONST32:
+            case ByteOpcode::CONST32_ST:
+                return OperandLayout::ImmI32;
+
+            case ByteOpcode::CONST64:
+            case ByteOpcode::CONST64_ST:
+                return OperandLayout::ImmI64;
+
+            case ByteOpcode::FADD_IMM: case ByteOpcode::FSUB_IMM: case ByteOpcode::FMUL_IMM: case ByteOpcode::FDIV_IMM:
+            case ByteOpcode::FADD_IMM_ST: case ByteOpcode::FSUB_IMM_ST: case ByteOpcode::FMUL_IMM_ST: case ByteOpcode::FDIV_IMM_ST:
+                return OperandLayout::ImmF32;
+
+            case ByteOpcode::TRAP:
+            case ByteOpcode::TRAP_IF_ZERO:
+            case ByteOpcode::TRAP_IF_NOT_ZERO:
+            case ByteOpcode::POP_DISCARD:
+            case ByteOpcode::RESERVE:
+                return OperandLayout::IndexU8;
+
+            case ByteOpcode::LOAD: case ByteOpcode::LOAD_ST: case ByteOpcode::STORE: case ByteOpcode::STORE_ST:
+                return OperandLayout::IndexI16;
+
+            case ByteOpcode::JMP: case ByteOpcode::JZ: case ByteOpcode::JNZ:
+                return OperandLayout::Branch;
+
+            case ByteOpcode::CALL: return OperandLayout::CallU32U8;
+            case ByteOpcode::CALL_EX: return OperandLayout::CallU32U16;
+            case ByteOpcode::CALL_TINY: return OperandLayout::CallU16U8;
+            case ByteOpcode::CALL_TINY_EX: return OperandLayout::CallU16U16;
+            case ByteOpcode::CALL_DYN: return OperandLayout::CallDyn;
+        }
+
+        return std::nullopt;
+    }
+
+    size_t GetOperandSize(OperandLayout layout) {
+        switch (layout) {
+            case OperandLayout::None: return 0;
+            case OperandLayout::ImmI8: return 1;
+            case OperandLayout::ImmI32: return 4;
+            case OperandLayout::ImmI64: return 8;
+            case OperandLayout::ImmF32: return 4;
+            case OperandLayout::IndexU8: return 1;
+            case OperandLayout::IndexI16: return 2;
+            case OperandLayout::Branch: return 2;
+            case OperandLayout::CallU32U8: return 5;
+            case OperandLayout::CallU32U16: return 6;
+            case OperandLayout::CallU16U8: return 3;
+            case OperandLayout::CallU16U16: return 4;
+            case OperandLayout::CallDyn: return 2;
+        }
+
+        return 0;
+    }
+
+    bool IsTerminator(ByteOpcode opcode) {
+        return opcode == ByteOpcode::RET || opcode == ByteOpcode::HLT || opcode == ByteOpcode::JMP;
+    }
+}
@@ -64,7 +64,7 @@ namespace bibble {
         if (offset + 7 >= mBytes.size()) return std::nullopt;
 
         const u8* p = mBytes.data() + offset;
-        u32 value = (static_cast<u64>(p[0]) << 56) |
+        u64 value = (static_cast<u64>(p[0]) << 56) |
                     (static_cast<u64>(p[1]) << 48) |
                     (static_cast<u64>(p[2]) << 40) |
                     (static_cast<u64>(p[3]) << 32) |
@@ -98,7 +98,7 @@ namespace bibble {
         if (!raw.has_value()) return std::nullopt;
 
         float value;
-        std::memcpy(&value, &raw, sizeof(value));
+        std::memcpy(&value, &raw.value(), sizeof(value));
 
         return value;
     }
@@ -110,7 +110,7 @@ namespace bibble {
         if (!raw.has_value()) return std::nullopt;
 
         double value;
-        std::memcpy(&value, &raw, sizeof(value));
+        std::memcpy(&value, &raw.value(), sizeof(value));
 
         return value;
     }
@@ -6,10 +6,14 @@ namespace bibble {
     StrtabSection::StrtabSection(Section section)
         : mSection(section) {}
 
+    const Section& StrtabSection::getSection() const {
+        return mSection;
+    }
+
     std::optional<std::string_view> StrtabSection::get(u32 offset) const {
         std::optional<u16> length = mSection.getU16(offset);
         if (!length.has_value()) return std::nullopt;
 
-        return mSection.getString(offset, length.value());
+        return mSection.getString(offset + 2, length.value()); // after the length
     }
 }
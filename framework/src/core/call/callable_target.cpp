@@ -6,6 +6,17 @@
 
 namespace bibble {
     void CallableTrampoline(const CallableTarget& target, VM& vm) {
-        vm.interpreter().execute(vm, target.module, target.entry);
+        if (target.host == nullptr) {
+            vm.interpreter().execute(vm, target);
+            return;
+        }
+
+        if (vm.hasExited()) return;
+
+        Stack& stack = vm.stack();
+        std::span<Value> args(stack.data() + stack.sb(), static_cast<size_t>(stack.sp().integer() - stack.sb()));
+
+        Value result = target.host(vm, args);
+        if (!vm.hasExited()) vm.acc() = result;
     }
 }
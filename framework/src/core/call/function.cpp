@@ -8,6 +8,10 @@ namespace bibble {
         , mName(name)
         , mTarget(std::move(target)) {}
 
+    u32 Function::getId() const {
+        return mId;
+    }
+
     u32 Function::getModule() const {
         return mModule;
     }
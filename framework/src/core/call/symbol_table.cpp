@@ -0,0 +1,69 @@
+// Copyright 2025 JesusTouchMe
+
+#include "BibbleVM/core/call/symbol_table.h"
+
+namespace bibble {
+    static constexpr size_t InitialSlots = 64;
+
+    u32 SymbolTable::add(Function function, u32 hash) {
+        if (find(function.getName(), hash) != NoFunction) return NoFunction;
+
+        if ((mSize + 1) * 4 > mSlots.size() * 3) grow();
+
+        if (mChunks.empty() || mChunks.back().size() == ChunkSize) {
+            mChunks.emplace_back();
+            mChunks.back().reserve(ChunkSize);
+        }
+
+        u32 id = static_cast<u32>(mSize);
+        function.mId = id;
+        mChunks.back().push_back(std::move(function));
+
+        size_t mask = mSlots.size() - 1;
+        size_t i = hash & mask;
+        while (mSlots[i].id != NoFunction) i = (i + 1) & mask;
+
+        mSlots[i] = { hash, id };
+        mSize++;
+
+        return id;
+    }
+
+    u32 SymbolTable::find(std::string_view name, u32 hash) const {
+        if (mSlots.empty()) return NoFunction;
+
+        size_t mask = mSlots.size() - 1;
+        for (size_t i = hash & mask;; i = (i + 1) & mask) {
+            const Slot& slot = mSlots[i];
+            if (slot.id == NoFunction) return NoFunction;
+            if (slot.hash == hash && get(slot.id).getName() == name) return slot.id;
+        }
+    }
+
+    Function& SymbolTable::get(u32 id) {
+        return mChunks[id / ChunkSize][id % ChunkSize];
+    }
+
+    const Function& SymbolTable::get(u32 id) const {
+        return mChunks[id / ChunkSize][id % ChunkSize];
+    }
+
+    size_t SymbolTable::size() const {
+        return mSize;
+    }
+
+    void SymbolTable::grow() {
+        std::vector<Slot> old = std::move(mSlots);
+        mSlots.assign(old.empty() ? InitialSlots : old.size() * 2, Slot{ 0, NoFunction });
+
+        size_t mask = mSlots.size() - 1;
+        for (const Slot& slot : old) {
+            if (slot.id == NoFunction) continue;
+
+            size_t i = slot.hash & mask;
+            while (mSlots[i].id != NoFunction) i = (i + 1) & mask;
+
+            mSlots[i] = slot;
+        }
+    }
+}
@@ -1,86 +1,294 @@
 // Copyright 2025 JesusTouchMe
 
 #include "BibbleVM/core/exec/dispatch.h"
+#include "BibbleVM/core/exec/instruction.h"
 
 #include "BibbleVM/core/vm.h"
 
-#define DEFINE_DISPATCH(opcode) DispatchErr Dispatch_##opcode(VM& vm, BytecodeReader& code)
+#include <algorithm>
+
+#if defined(__GNUC__) || defined(__clang__)
+#define DISPATCH_INLINE inline __attribute__((always_inline))
+#elif defined(_MSC_VER)
+#define DISPATCH_INLINE __forceinline
+#else
+#define DISPATCH_INLINE inline
+#endif
+
+// handlers are force-inlined so the threaded loop gets its own copy of every handler body. each one is written once and
+// instantiated for both safety policies
+#define DEFINE_DISPATCH(opcode) template<class Policy> static DISPATCH_INLINE DispatchErr Dispatch_##opcode(VM& vm, ExecState& state, const Instruction& inst)
 #define DEFINE_DISPATCH_UTIL(name, ...) static DispatchErr name(VM& vm, __VA_ARGS__)
-#define REGISTER_DISPATCH(table, opcode) table[static_cast<size_t>(ByteOpcode::opcode)] = Dispatch_##opcode
-#define REGISTER_DISPATCH_EXT(table, opcode) table[static_cast<size_t>(ExtendedOpcode::opcode)] = Dispatch_##opcode
+#define REGISTER_DISPATCH(table, policy, opcode) table[static_cast<size_t>(ByteOpcode::opcode)] = Dispatch_##opcode<policy>
+#define REGISTER_DISPATCH_EXT(table, policy, opcode) table[static_cast<size_t>(ExtendedOpcode::opcode)] = Dispatch_##opcode<policy>
 
 #define DISPATCH_INTERPRETER_RETURN() return DISPATCH_RETURN
 #define DISPATCH_SUCCEED() return DISPATCH_SUCCESS
 #define DISPATCH_FAIL() do { vm.exit(-2); return DISPATCH_ERROR; } while(0)
 
+// fails if condition doesn't hold, but only under CheckedPolicy. the unchecked handlers trust the bytecode
+#define DISPATCH_CHECK(condition) do { if constexpr (Policy::Checked) { if (!(condition)) DISPATCH_FAIL(); } } while(0)
+
+#define FOR_EACH_DISPATCH(X) \
+    X(NOP) X(HLT) X(TRAP) X(TRAP_IF_ZERO) X(TRAP_IF_NOT_ZERO) X(BRK) \
+    X(ADD) X(SUB) X(MUL) X(DIV) X(MOD) X(AND) \
+    X(OR) X(XOR) X(SHL) X(SHR) X(NEG) X(NOT) \
+    X(ADD2) X(SUB2) X(MUL2) X(DIV2) X(MOD2) X(AND2) \
+    X(OR2) X(XOR2) X(SHL2) X(SHR2) X(ADD_ST) X(SUB_ST) \
+    X(MUL_ST) X(DIV_ST) X(MOD_ST) X(AND_ST) X(OR_ST) X(XOR_ST) \
+    X(SHL_ST) X(SHR_ST) X(NEG_ST) X(NOT_ST) X(ADD_IMM) X(SUB_IMM) \
+    X(MUL_IMM) X(DIV_IMM) X(MOD_IMM) X(AND_IMM) X(OR_IMM) X(XOR_IMM) \
+    X(SHL_IMM) X(SHR_IMM) X(ADD_IMM_ST) X(SUB_IMM_ST) X(MUL_IMM_ST) X(DIV_IMM_ST) \
+    X(MOD_IMM_ST) X(AND_IMM_ST) X(OR_IMM_ST) X(XOR_IMM_ST) X(SHL_IMM_ST) X(SHR_IMM_ST) \
+    X(FADD) X(FSUB) X(FMUL) X(FDIV) X(FADD2) X(FSUB2) \
+    X(FMUL2) X(FDIV2) X(FADD_ST) X(FSUB_ST) X(FMUL_ST) X(FDIV_ST) \
+    X(FNEG) X(FADD_IMM) X(FSUB_IMM) X(FMUL_IMM) X(FDIV_IMM) X(FADD_IMM_ST) \
+    X(FSUB_IMM_ST) X(FMUL_IMM_ST) X(FDIV_IMM_ST) X(CMP_EQ) X(CMP_NE) X(CMP_LT) \
+    X(CMP_GT) X(CMP_LTE) X(CMP_GTE) X(FCMP_EQ) X(FCMP_NE) X(FCMP_LT) \
+    X(FCMP_GT) X(FCMP_LTE) X(FCMP_GTE) X(CMP_EQ0) X(CMP_NE0) X(CMP_LT0) \
+    X(CMP_GT0) X(CMP_LTE0) X(CMP_GTE0) X(FCMP_EQ0) X(FCMP_NE0) X(FCMP_LT0) \
+    X(FCMP_GT0) X(FCMP_LTE0) X(FCMP_GTE0) X(PUSH_ACC) X(PUSH_SP) X(POP_ACC) \
+    X(POP_SP) X(POP_DISCARD) X(CONST) X(CONST32) X(CONST64) X(CONST_ST) \
+    X(CONST32_ST) X(CONST64_ST) X(LOAD) X(LOAD_ST) X(STORE) X(STORE_ST) \
+    X(RESERVE) X(JMP) X(JZ) X(JNZ) X(CALL) X(CALL_EX) \
+    X(CALL_DYN) X(CALL_TINY) X(CALL_TINY_EX) X(RET)
+
+// branches installed over JMP, JZ and JNZ when they jump backwards, in that order
+#define FOR_EACH_BACK_EDGE(X) \
+    X(JMP_BACK) X(JZ_BACK) X(JNZ_BACK)
+
+#if BIBBLEVM_DISPATCH_PROFILE
+#define DISPATCH_PROFILE(inst) RecordDispatch((inst).opcode)
+#else
+#define DISPATCH_PROFILE(inst) ((void) 0)
+#endif
+
 #define DISPATCH_CALL_UTIL(name, ...) if (DispatchErr _err = name(vm, __VA_ARGS__); _err != DISPATCH_SUCCESS) return _err
 
 namespace bibble {
-    template<class TargetIndexT, class ArgcT>
-    DEFINE_DISPATCH_UTIL(CallInstHelper, TargetIndexT targetIndex, ArgcT argc) { // TODO: optimize this for new stack design to avoid allocating a vector of args
-        std::vector<Value> args;
-        args.reserve(argc);
+#if BIBBLEVM_DISPATCH_PROFILE
+    DispatchProfile& GetDispatchProfile() {
+        static DispatchProfile profile;
+        return profile;
+    }
+
+    static void RecordDispatch(u16 opcode) {
+        DispatchProfile& profile = GetDispatchProfile();
+
+        profile.pairs[profile.previous][opcode]++;
+        profile.previous = opcode;
+        profile.dispatches++;
+    }
+#endif
+
+    // Sandboxed or untrusted bytecode. Every stack access is bounds checked
+    struct CheckedPolicy {
+        static constexpr bool Checked = true;
+    };
+
+    // Bytecode from a trusted compiler. Handlers skip their bounds checks, frame sized checks at calls stay. So does the
+    // one at RESERVE where the stack has no guard pages to catch it running off the end instead
+    struct UncheckedPolicy {
+        static constexpr bool Checked = false;
+    };
+
+    static DISPATCH_INLINE bool IsWithinFrame(const ExecState& state, const Value* slot) {
+        return slot >= state.frame && slot < state.limit;
+    }
 
-        for (u16 i = 0; i < argc; i++) {
-            std::optional<Value> value = vm.pop();
-            if (!value.has_value()) DISPATCH_FAIL();
+    template<class Policy>
+    static DISPATCH_INLINE bool Push(ExecState& state, Value value) {
+        if constexpr (Policy::Checked) {
+            if (!IsWithinFrame(state, state.sp)) return false;
+        }
 
-            args.push_back(value.value());
+        *state.sp++ = value;
+        return true;
+    }
+
+    template<class Policy>
+    static DISPATCH_INLINE std::optional<Value> Pop(ExecState& state) {
+        if constexpr (Policy::Checked) {
+            if (state.sp <= state.frame) return std::nullopt;
         }
 
-        const CallableTarget* target = vm.currentModule()->data().getCallable(targetIndex, vm);
-        if (target == nullptr) DISPATCH_FAIL();
+        return *--state.sp;
+    }
 
-        vm.stack().pushFrame(argc);
+    // frame only moves through Stack::pushFrame/popFrame, which the VM owns, so it's only ever reloaded
+    void SpillState(VM& vm, const ExecState& state) {
+        vm.acc() = state.acc;
+        vm.sp().integer() = state.sp - state.stack;
+    }
+
+    void ReloadState(VM& vm, ExecState& state) {
+        state.acc = vm.acc();
+        state.sp = state.stack + vm.sp().integer();
+        state.frame = state.stack + vm.stack().sb();
+    }
 
-        for (u16 i = 0; i < argc; i++) {
-            vm.push(args[i]);
+    const CallableTarget* ResolveCallTarget(VM& vm, const Instruction& inst) {
+        const CallableTarget* target = inst.target;
+
+        if (target == nullptr) [[unlikely]] {
+            target = vm.currentModule()->data().getCallable(inst.a, vm);
+            inst.target = target;
         }
 
-        CallableTrampoline(*target, vm);
+        return target;
+    }
+
+    DispatchErr CallHost(VM& vm, ExecState& state, const CallableTarget& target, u16 argc) {
+        if (state.sp - state.frame < argc) DISPATCH_FAIL();
+
+        // the arguments stay on the stack until it returns, so anything it runs in the VM goes on top of them
+        SpillState(vm, state);
+        Value result = target.host(vm, std::span<Value>(state.sp - argc, argc));
+        if (vm.hasExited()) DISPATCH_INTERPRETER_RETURN();
+
+        state.acc = result;
+        state.sp -= argc;
 
         DISPATCH_SUCCEED();
     }
 
-    DEFINE_DISPATCH(NOP) {
+    DispatchErr CallNested(VM& vm, ExecState& state, const CallableTarget& target, u16 argc) {
+        if (target.host != nullptr) return CallHost(vm, state, target, argc);
+
+        SpillState(vm, state);
+
+        // a null return pc makes the callee's RET hand control back here instead of resuming bytecode
+        if (!vm.stack().pushCallFrame(argc, {})) DISPATCH_FAIL();
+
+        CallableTrampoline(target, vm);
+        if (vm.hasExited()) DISPATCH_INTERPRETER_RETURN();
+
+        if (!vm.stack().popFrame()) DISPATCH_FAIL();
+        ReloadState(vm, state);
+
         DISPATCH_SUCCEED();
     }
 
-    DEFINE_DISPATCH(HLT) {
-        std::optional<i8> exitCode = code.fetchI8();
-        if (!exitCode.has_value()) DISPATCH_FAIL();
+    DispatchErr CallNative(VM& vm, ExecState& state, NativeEntry native, u16 argc, const Instruction* code) {
+        SpillState(vm, state);
+
+        if (!vm.stack().pushCallFrame(argc, {})) DISPATCH_FAIL();
+
+        // the callee's registers follow from ours, no need to go through the VM for them
+        ExecState callee = state;
+        callee.frame = state.sp - argc;
+        if (code != nullptr) callee.code = code;
+
+        DispatchErr err = vm.interpreter().executeNative(vm, callee, native);
+        if (vm.hasExited()) DISPATCH_INTERPRETER_RETURN();
+        if (err != DISPATCH_RETURN) return err;
 
-        vm.exit(exitCode.value());
+        if (!vm.stack().popFrame()) DISPATCH_FAIL();
+
+        state.acc = callee.acc;
+        state.sp = callee.frame;
 
         DISPATCH_SUCCEED();
     }
 
+    DispatchErr CallCompiled(VM& vm, ExecState& state, const CallableTarget& target, const DecodedFunction& function, u16 argc) {
+        if (state.sp - state.frame < argc || !function.canEnter(state.sp - argc, state.sp, state.limit)) DISPATCH_FAIL();
+
+        Interpreter& interpreter = vm.interpreter();
+
+        u32 previousModule = interpreter.getActiveModule();
+        interpreter.setActiveModule(target.module);
+
+        DispatchErr err = CallNative(vm, state, target.native, argc, function.instructions.data());
+
+        interpreter.setActiveModule(previousModule);
+
+        return err;
+    }
+
+    DEFINE_DISPATCH_UTIL(TrapHelper, ExecState& state, u8 trapCode) {
+        SpillState(vm, state);
+        if (!vm.trap(trapCode)) DISPATCH_FAIL();
+        ReloadState(vm, state);
+
+        DISPATCH_SUCCEED();
+    }
+
+    // Makes the top argc values the first locals of a new frame for target and continues in its code. The callee runs in
+    // this same loop, RET resumes us from the return address saved in its frame
+    DEFINE_DISPATCH_UTIL(EnterCallable, ExecState& state, const CallableTarget& target, u16 argc) {
+        if (target.host != nullptr) return CallHost(vm, state, target, argc);
+
+        SpillState(vm, state);
+
+        Interpreter& interpreter = vm.interpreter();
+
+        const DecodedFunction* function = interpreter.decode(vm, target);
+        if (function == nullptr) DISPATCH_FAIL();
+
+        // compiled code can't continue in this loop, it runs on the native stack and we carry on with the next
+        // instruction after. With too little of that left it's interpreted right here instead
+        interpreter.countCall(vm, target, *function, argc);
+        if (target.native != nullptr && interpreter.canEnterCompiled()) return CallCompiled(vm, state, target, *function, argc);
+
+        if (!vm.stack().pushCallFrame(argc, { state.pc, state.code, interpreter.getActiveModule() })) DISPATCH_FAIL();
+        if (!function->canEnter(state.sp - argc, state.sp, state.limit)) DISPATCH_FAIL();
+
+        interpreter.setActiveModule(target.module);
+        ReloadState(vm, state);
+        interpreter.enterCode(*function, state);
+
+        DISPATCH_SUCCEED();
+    }
+
+    DEFINE_DISPATCH_UTIL(CallInstHelper, ExecState& state, u32 targetIndex, u16 argc) {
+        const CallableTarget* target = vm.currentModule()->data().getCallable(targetIndex, vm);
+        if (target == nullptr) DISPATCH_FAIL();
+
+        return EnterCallable(vm, state, *target, argc);
+    }
+
+    // CALL with a constant CallEntry. Only the first call through inst resolves it, after that it's one load
+    DEFINE_DISPATCH_UTIL(CachedCallInstHelper, ExecState& state, const Instruction& inst) {
+        const CallableTarget* target = ResolveCallTarget(vm, inst);
+        if (target == nullptr) DISPATCH_FAIL();
+
+        return EnterCallable(vm, state, *target, inst.b);
+    }
+
+    DEFINE_DISPATCH(NOP) {
+        DISPATCH_SUCCEED();
+    }
+
+    DEFINE_DISPATCH(HLT) {
+        vm.exit(static_cast<int>(inst.imm.integer()));
+
+        DISPATCH_INTERPRETER_RETURN();
+    }
+
     DEFINE_DISPATCH(TRAP) {
-        std::optional<u8> trapCode = code.fetchU8();
-        if (!trapCode.has_value()) DISPATCH_FAIL();
+        u8 trapCode = static_cast<u8>(inst.a);
 
-        if (!vm.trap(trapCode.value())) DISPATCH_FAIL();
+        DISPATCH_CALL_UTIL(TrapHelper, state, trapCode);
 
         DISPATCH_SUCCEED();
     }
 
     DEFINE_DISPATCH(TRAP_IF_ZERO) {
-        std::optional<u8> trapCode = code.fetchU8();
-        if (!trapCode.has_value()) DISPATCH_FAIL();
+        u8 trapCode = static_cast<u8>(inst.a);
 
-        if (vm.acc().integer() == 0) {
-            if (!vm.trap(trapCode.value())) DISPATCH_FAIL();
+        if (state.acc.integer() == 0) {
+            DISPATCH_CALL_UTIL(TrapHelper, state, trapCode);
         }
 
         DISPATCH_SUCCEED();
     }
 
     DEFINE_DISPATCH(TRAP_IF_NOT_ZERO) {
-        std::optional<u8> trapCode = code.fetchU8();
-        if (!trapCode.has_value()) DISPATCH_FAIL();
+        u8 trapCode = static_cast<u8>(inst.a);
 
-        if (vm.acc().integer() != 0) {
-            if (!vm.trap(trapCode.value())) DISPATCH_FAIL();
+        if (state.acc.integer() != 0) {
+            DISPATCH_CALL_UTIL(TrapHelper, state, trapCode);
         }
 
         DISPATCH_SUCCEED();
@@ -91,1348 +299,1561 @@ namespace bibble {
     }
 
     DEFINE_DISPATCH(ADD) {
-        std::optional<Value> b = vm.pop();
+        std::optional<Value> b = Pop<Policy>(state);
         if (!b.has_value()) DISPATCH_FAIL();
 
-        vm.acc().integer() += b->integer();
+        state.acc.integer() += b->integer();
 
         DISPATCH_SUCCEED();
     }
 
     DEFINE_DISPATCH(SUB) {
-        std::optional<Value> b = vm.pop();
+        std::optional<Value> b = Pop<Policy>(state);
         if (!b.has_value()) DISPATCH_FAIL();
 
-        vm.acc().integer() -= b->integer();
+        state.acc.integer() -= b->integer();
 
         DISPATCH_SUCCEED();
     }
 
     DEFINE_DISPATCH(MUL) {
-        std::optional<Value> b = vm.pop();
+        std::optional<Value> b = Pop<Policy>(state);
         if (!b.has_value()) DISPATCH_FAIL();
 
-        vm.acc().integer() *= b->integer();
+        state.acc.integer() *= b->integer();
 
         DISPATCH_SUCCEED();
     }
 
     DEFINE_DISPATCH(DIV) {
-        std::optional<Value> b = vm.pop();
+        std::optional<Value> b = Pop<Policy>(state);
         if (!b.has_value()) DISPATCH_FAIL();
 
-        vm.acc().integer() /= b->integer();
+        state.acc.integer() /= b->integer();
 
         DISPATCH_SUCCEED();
     }
 
     DEFINE_DISPATCH(MOD) {
-        std::optional<Value> bOpt = vm.pop();
+        std::optional<Value> bOpt = Pop<Policy>(state);
         if (!bOpt.has_value()) DISPATCH_FAIL();
 
-        i64 a = vm.acc().integer();
+        i64 a = state.acc.integer();
         i64 b = bOpt->integer();
 
-        vm.acc().integer() = a - (a / b) * b;
+        state.acc.integer() = a - (a / b) * b;
 
         DISPATCH_SUCCEED();
     }
 
     DEFINE_DISPATCH(AND) {
-        std::optional<Value> b = vm.pop();
+        std::optional<Value> b = Pop<Policy>(state);
         if (!b.has_value()) DISPATCH_FAIL();
 
-        vm.acc().integer() &= b->integer();
+        state.acc.integer() &= b->integer();
 
         DISPATCH_SUCCEED();
     }
 
     DEFINE_DISPATCH(OR) {
-        std::optional<Value> b = vm.pop();
+        std::optional<Value> b = Pop<Policy>(state);
         if (!b.has_value()) DISPATCH_FAIL();
 
-        vm.acc().integer() |= b->integer();
+        state.acc.integer() |= b->integer();
 
         DISPATCH_SUCCEED();
     }
 
     DEFINE_DISPATCH(XOR) {
-        std::optional<Value> b = vm.pop();
+        std::optional<Value> b = Pop<Policy>(state);
         if (!b.has_value()) DISPATCH_FAIL();
 
-        vm.acc().integer() ^= b->integer();
+        state.acc.integer() ^= b->integer();
 
         DISPATCH_SUCCEED();
     }
 
     DEFINE_DISPATCH(SHL) {
-        std::optional<Value> b = vm.pop();
+        std::optional<Value> b = Pop<Policy>(state);
         if (!b.has_value()) DISPATCH_FAIL();
 
-        vm.acc().integer() <<= b->integer();
+        state.acc.integer() <<= b->integer();
 
         DISPATCH_SUCCEED();
     }
 
     DEFINE_DISPATCH(SHR) {
-        std::optional<Value> b = vm.pop();
+        std::optional<Value> b = Pop<Policy>(state);
         if (!b.has_value()) DISPATCH_FAIL();
 
-        vm.acc().integer() >>= b->integer();
+        state.acc.integer() >>= b->integer();
 
         DISPATCH_SUCCEED();
     }
 
     DEFINE_DISPATCH(NEG) {
-        vm.acc().integer() = -vm.acc().integer();
+        state.acc.integer() = -state.acc.integer();
 
         DISPATCH_SUCCEED();
     }
 
     DEFINE_DISPATCH(NOT) {
-        vm.acc().integer() = ~vm.acc().integer();
+        state.acc.integer() = ~state.acc.integer();
 
         DISPATCH_SUCCEED();
     }
 
     DEFINE_DISPATCH(ADD2) {
-        std::optional<Value> b = vm.pop();
-        std::optional<Value> a = vm.pop();
+        std::optional<Value> b = Pop<Policy>(state);
+        std::optional<Value> a = Pop<Policy>(state);
         if (!b.has_value() || !a.has_value()) DISPATCH_FAIL();
 
-        vm.acc().integer() = a->integer() + b->integer();
+        state.acc.integer() = a->integer() + b->integer();
 
         DISPATCH_SUCCEED();
     }
 
     DEFINE_DISPATCH(SUB2) {
-        std::optional<Value> b = vm.pop();
-        std::optional<Value> a = vm.pop();
+        std::optional<Value> b = Pop<Policy>(state);
+        std::optional<Value> a = Pop<Policy>(state);
         if (!b.has_value() || !a.has_value()) DISPATCH_FAIL();
 
-        vm.acc().integer() = a->integer() - b->integer();
+        state.acc.integer() = a->integer() - b->integer();
 
         DISPATCH_SUCCEED();
     }
 
     DEFINE_DISPATCH(MUL2) {
-        std::optional<Value> b = vm.pop();
-        std::optional<Value> a = vm.pop();
+        std::optional<Value> b = Pop<Policy>(state);
+        std::optional<Value> a = Pop<Policy>(state);
         if (!b.has_value() || !a.has_value()) DISPATCH_FAIL();
 
-        vm.acc().integer() = a->integer() * b->integer();
+        state.acc.integer() = a->integer() * b->integer();
 
         DISPATCH_SUCCEED();
     }
 
     DEFINE_DISPATCH(DIV2) {
-        std::optional<Value> b = vm.pop();
-        std::optional<Value> a = vm.pop();
+        std::optional<Value> b = Pop<Policy>(state);
+        std::optional<Value> a = Pop<Policy>(state);
         if (!b.has_value() || !a.has_value()) DISPATCH_FAIL();
 
-        vm.acc().integer() = a->integer() / b->integer();
+        state.acc.integer() = a->integer() / b->integer();
 
         DISPATCH_SUCCEED();
     }
 
     DEFINE_DISPATCH(MOD2) {
-        std::optional<Value> bOpt = vm.pop();
-        std::optional<Value> aOpt = vm.pop();
+        std::optional<Value> bOpt = Pop<Policy>(state);
+        std::optional<Value> aOpt = Pop<Policy>(state);
         if (!bOpt.has_value() || !aOpt.has_value()) DISPATCH_FAIL();
 
         i64 a = aOpt->integer();
         i64 b = bOpt->integer();
 
-        vm.acc().integer() = a - (a / b) * b;
+        state.acc.integer() = a - (a / b) * b;
 
         DISPATCH_SUCCEED();
     }
 
     DEFINE_DISPATCH(AND2) {
-        std::optional<Value> b = vm.pop();
-        std::optional<Value> a = vm.pop();
+        std::optional<Value> b = Pop<Policy>(state);
+        std::optional<Value> a = Pop<Policy>(state);
         if (!b.has_value() || !a.has_value()) DISPATCH_FAIL();
 
-        vm.acc().integer() = a->integer() & b->integer();
+        state.acc.integer() = a->integer() & b->integer();
 
         DISPATCH_SUCCEED();
     }
 
     DEFINE_DISPATCH(OR2) {
-        std::optional<Value> b = vm.pop();
-        std::optional<Value> a = vm.pop();
+        std::optional<Value> b = Pop<Policy>(state);
+        std::optional<Value> a = Pop<Policy>(state);
         if (!b.has_value() || !a.has_value()) DISPATCH_FAIL();
 
-        vm.acc().integer() = a->integer() | b->integer();
+        state.acc.integer() = a->integer() | b->integer();
 
         DISPATCH_SUCCEED();
     }
 
     DEFINE_DISPATCH(XOR2) {
-        std::optional<Value> b = vm.pop();
-        std::optional<Value> a = vm.pop();
+        std::optional<Value> b = Pop<Policy>(state);
+        std::optional<Value> a = Pop<Policy>(state);
         if (!b.has_value() || !a.has_value()) DISPATCH_FAIL();
 
-        vm.acc().integer() = a->integer() ^ b->integer();
+        state.acc.integer() = a->integer() ^ b->integer();
 
         DISPATCH_SUCCEED();
     }
 
     DEFINE_DISPATCH(SHL2) {
-        std::optional<Value> b = vm.pop();
-        std::optional<Value> a = vm.pop();
+        std::optional<Value> b = Pop<Policy>(state);
+        std::optional<Value> a = Pop<Policy>(state);
         if (!b.has_value() || !a.has_value()) DISPATCH_FAIL();
 
-        vm.acc().integer() = a->integer() << b->integer();
+        state.acc.integer() = a->integer() << b->integer();
 
         DISPATCH_SUCCEED();
     }
 
     DEFINE_DISPATCH(SHR2) {
-        std::optional<Value> b = vm.pop();
-        std::optional<Value> a = vm.pop();
+        std::optional<Value> b = Pop<Policy>(state);
+        std::optional<Value> a = Pop<Policy>(state);
         if (!b.has_value() || !a.has_value()) DISPATCH_FAIL();
 
-        vm.acc().integer() = a->integer() >> b->integer();
+        state.acc.integer() = a->integer() >> b->integer();
 
         DISPATCH_SUCCEED();
     }
 
     DEFINE_DISPATCH(ADD_ST) {
-        std::optional<Value> b = vm.pop();
-        std::optional<Value> a = vm.pop();
+        std::optional<Value> b = Pop<Policy>(state);
+        std::optional<Value> a = Pop<Policy>(state);
         if (!b.has_value() || !a.has_value()) DISPATCH_FAIL();
 
-        if (!vm.push(a->integer() + b->integer())) DISPATCH_FAIL();
+        if (!Push<Policy>(state, a->integer() + b->integer())) DISPATCH_FAIL();
 
         DISPATCH_SUCCEED();
     }
 
     DEFINE_DISPATCH(SUB_ST) {
-        std::optional<Value> b = vm.pop();
-        std::optional<Value> a = vm.pop();
+        std::optional<Value> b = Pop<Policy>(state);
+        std::optional<Value> a = Pop<Policy>(state);
         if (!b.has_value() || !a.has_value()) DISPATCH_FAIL();
 
-        if (!vm.push(a->integer() - b->integer())) DISPATCH_FAIL();
+        if (!Push<Policy>(state, a->integer() - b->integer())) DISPATCH_FAIL();
 
         DISPATCH_SUCCEED();
     }
 
     DEFINE_DISPATCH(MUL_ST) {
-        std::optional<Value> b = vm.pop();
-        std::optional<Value> a = vm.pop();
+        std::optional<Value> b = Pop<Policy>(state);
+        std::optional<Value> a = Pop<Policy>(state);
         if (!b.has_value() || !a.has_value()) DISPATCH_FAIL();
 
-        if (!vm.push(a->integer() * b->integer())) DISPATCH_FAIL();
+        if (!Push<Policy>(state, a->integer() * b->integer())) DISPATCH_FAIL();
 
         DISPATCH_SUCCEED();
     }
 
     DEFINE_DISPATCH(DIV_ST) {
-        std::optional<Value> b = vm.pop();
-        std::optional<Value> a = vm.pop();
+        std::optional<Value> b = Pop<Policy>(state);
+        std::optional<Value> a = Pop<Policy>(state);
         if (!b.has_value() || !a.has_value()) DISPATCH_FAIL();
 
-        if (!vm.push(a->integer() / b->integer())) DISPATCH_FAIL();
+        if (!Push<Policy>(state, a->integer() / b->integer())) DISPATCH_FAIL();
 
         DISPATCH_SUCCEED();
     }
 
     DEFINE_DISPATCH(MOD_ST) {
-        std::optional<Value> bOpt = vm.pop();
-        std::optional<Value> aOpt = vm.pop();
+        std::optional<Value> bOpt = Pop<Policy>(state);
+        std::optional<Value> aOpt = Pop<Policy>(state);
         if (!bOpt.has_value() || !aOpt.has_value()) DISPATCH_FAIL();
 
         i64 a = aOpt->integer();
         i64 b = bOpt->integer();
 
-        if (!vm.push(a - (a / b) * b)) DISPATCH_FAIL();
+        if (!Push<Policy>(state, a - (a / b) * b)) DISPATCH_FAIL();
 
         DISPATCH_SUCCEED();
     }
 
     DEFINE_DISPATCH(AND_ST) {
-        std::optional<Value> b = vm.pop();
-        std::optional<Value> a = vm.pop();
+        std::optional<Value> b = Pop<Policy>(state);
+        std::optional<Value> a = Pop<Policy>(state);
         if (!b.has_value() || !a.has_value()) DISPATCH_FAIL();
 
-        if (!vm.push(a->integer() & b->integer())) DISPATCH_FAIL();
+        if (!Push<Policy>(state, a->integer() & b->integer())) DISPATCH_FAIL();
 
         DISPATCH_SUCCEED();
     }
 
     DEFINE_DISPATCH(OR_ST) {
-        std::optional<Value> b = vm.pop();
-        std::optional<Value> a = vm.pop();
+        std::optional<Value> b = Pop<Policy>(state);
+        std::optional<Value> a = Pop<Policy>(state);
         if (!b.has_value() || !a.has_value()) DISPATCH_FAIL();
 
-        if (!vm.push(a->integer() | b->integer())) DISPATCH_FAIL();
+        if (!Push<Policy>(state, a->integer() | b->integer())) DISPATCH_FAIL();
 
         DISPATCH_SUCCEED();
     }
 
     DEFINE_DISPATCH(XOR_ST) {
-        std::optional<Value> b = vm.pop();
-        std::optional<Value> a = vm.pop();
+        std::optional<Value> b = Pop<Policy>(state);
+        std::optional<Value> a = Pop<Policy>(state);
         if (!b.has_value() || !a.has_value()) DISPATCH_FAIL();
 
-        if (!vm.push(a->integer() ^ b->integer())) DISPATCH_FAIL();
+        if (!Push<Policy>(state, a->integer() ^ b->integer())) DISPATCH_FAIL();
 
         DISPATCH_SUCCEED();
     }
 
     DEFINE_DISPATCH(SHL_ST) {
-        std::optional<Value> b = vm.pop();
-        std::optional<Value> a = vm.pop();
+        std::optional<Value> b = Pop<Policy>(state);
+        std::optional<Value> a = Pop<Policy>(state);
         if (!b.has_value() || !a.has_value()) DISPATCH_FAIL();
 
-        if (!vm.push(a->integer() << b->integer())) DISPATCH_FAIL();
+        if (!Push<Policy>(state, a->integer() << b->integer())) DISPATCH_FAIL();
 
         DISPATCH_SUCCEED();
     }
 
     DEFINE_DISPATCH(SHR_ST) {
-        std::optional<Value> b = vm.pop();
-        std::optional<Value> a = vm.pop();
+        std::optional<Value> b = Pop<Policy>(state);
+        std::optional<Value> a = Pop<Policy>(state);
         if (!b.has_value() || !a.has_value()) DISPATCH_FAIL();
 
-        if (!vm.push(a->integer() >> b->integer())) DISPATCH_FAIL();
+        if (!Push<Policy>(state, a->integer() >> b->integer())) DISPATCH_FAIL();
 
         DISPATCH_SUCCEED();
     }
 
     DEFINE_DISPATCH(NEG_ST) {
-        i64 index = vm.sp().integer() - 1;
-        Stack& stack = vm.stack();
-
-        if (!stack.isWithinBounds(index)) DISPATCH_FAIL();
+        Value* top = state.sp - 1;
+        DISPATCH_CHECK(IsWithinFrame(state, top));
 
-        stack[index].integer() = -stack[index].integer();
+        top->integer() = -top->integer();
 
         DISPATCH_SUCCEED();
     }
 
     DEFINE_DISPATCH(NOT_ST) {
-        i64 index = vm.sp().integer() - 1;
-        Stack& stack = vm.stack();
-
-        if (!stack.isWithinBounds(index)) DISPATCH_FAIL();
+        Value* top = state.sp - 1;
+        DISPATCH_CHECK(IsWithinFrame(state, top));
 
-        stack[index].integer() = ~stack[index].integer();
+        top->integer() = ~top->integer();
 
         DISPATCH_SUCCEED();
     }
 
     DEFINE_DISPATCH(ADD_IMM) {
-        std::optional<i32> value = code.fetchI32();
-        if (!value.has_value()) DISPATCH_FAIL();
+        i64 value = inst.imm.integer();
 
-        vm.acc().integer() += value.value();
+        state.acc.integer() += value;
 
         DISPATCH_SUCCEED();
     }
 
     DEFINE_DISPATCH(SUB_IMM) {
-        std::optional<i32> value = code.fetchI32();
-        if (!value.has_value()) DISPATCH_FAIL();
+        i64 value = inst.imm.integer();
 
-        vm.acc().integer() -= value.value();
+        state.acc.integer() -= value;
 
         DISPATCH_SUCCEED();
     }
 
     DEFINE_DISPATCH(MUL_IMM) {
-        std::optional<i32> value = code.fetchI32();
-        if (!value.has_value()) DISPATCH_FAIL();
+        i64 value = inst.imm.integer();
 
-        vm.acc().integer() *= value.value();
+        state.acc.integer() *= value;
 
         DISPATCH_SUCCEED();
     }
 
     DEFINE_DISPATCH(DIV_IMM) {
-        std::optional<i32> value = code.fetchI32();
-        if (!value.has_value()) DISPATCH_FAIL();
+        i64 value = inst.imm.integer();
 
-        vm.acc().integer() /= value.value();
+        state.acc.integer() /= value;
 
         DISPATCH_SUCCEED();
     }
 
     DEFINE_DISPATCH(MOD_IMM) {
-        std::optional<i32> value = code.fetchI32();
-        if (!value.has_value()) DISPATCH_FAIL();
+        i64 value = inst.imm.integer();
 
-        i64 a = vm.acc().integer();
-        i64 b = value.value();
+        i64 a = state.acc.integer();
+        i64 b = value;
 
-        vm.acc().integer() = a - (a / b) * b;
+        state.acc.integer() = a - (a / b) * b;
 
         DISPATCH_SUCCEED();
     }
 
     DEFINE_DISPATCH(AND_IMM) {
-        std::optional<i32> value = code.fetchI32();
-        if (!value.has_value()) DISPATCH_FAIL();
+        i64 value = inst.imm.integer();
 
-        vm.acc().integer() &= value.value();
+        state.acc.integer() &= value;
 
         DISPATCH_SUCCEED();
     }
 
     DEFINE_DISPATCH(OR_IMM) {
-        std::optional<i32> value = code.fetchI32();
-        if (!value.has_value()) DISPATCH_FAIL();
+        i64 value = inst.imm.integer();
 
-        vm.acc().integer() |= value.value();
+        state.acc.integer() |= value;
 
         DISPATCH_SUCCEED();
     }
 
     DEFINE_DISPATCH(XOR_IMM) {
-        std::optional<i32> value = code.fetchI32();
-        if (!value.has_value()) DISPATCH_FAIL();
+        i64 value = inst.imm.integer();
 
-        vm.acc().integer() ^= value.value();
+        state.acc.integer() ^= value;
 
         DISPATCH_SUCCEED();
     }
 
     DEFINE_DISPATCH(SHL_IMM) {
-        std::optional<i32> value = code.fetchI32();
-        if (!value.has_value()) DISPATCH_FAIL();
+        i64 value = inst.imm.integer();
 
-        vm.acc().integer() <<= value.value();
+        state.acc.integer() <<= value;
 
         DISPATCH_SUCCEED();
     }
 
     DEFINE_DISPATCH(SHR_IMM) {
-        std::optional<i32> value = code.fetchI32();
-        if (!value.has_value()) DISPATCH_FAIL();
+        i64 value = inst.imm.integer();
 
-        vm.acc().integer() >>= value.value();
+        state.acc.integer() >>= value;
 
         DISPATCH_SUCCEED();
     }
 
     DEFINE_DISPATCH(ADD_IMM_ST) {
-        std::optional<i32> value = code.fetchI32();
-        if (!value.has_value()) DISPATCH_FAIL();
-
-        i64 index = vm.sp().integer() - 1;
-        Stack& stack = vm.stack();
+        i64 value = inst.imm.integer();
 
-        if (!stack.isWithinBounds(index)) DISPATCH_FAIL();
+        Value* top = state.sp - 1;
+        DISPATCH_CHECK(IsWithinFrame(state, top));
 
-        stack[index].integer() += value.value();
+        top->integer() += value;
 
         DISPATCH_SUCCEED();
     }
 
     DEFINE_DISPATCH(SUB_IMM_ST) {
-        std::optional<i32> value = code.fetchI32();
-        if (!value.has_value()) DISPATCH_FAIL();
-
-        i64 index = vm.sp().integer() - 1;
-        Stack& stack = vm.stack();
+        i64 value = inst.imm.integer();
 
-        if (!stack.isWithinBounds(index)) DISPATCH_FAIL();
+        Value* top = state.sp - 1;
+        DISPATCH_CHECK(IsWithinFrame(state, top));
 
-        stack[index].integer() -= value.value();
+        top->integer() -= value;
 
         DISPATCH_SUCCEED();
     }
 
     DEFINE_DISPATCH(MUL_IMM_ST) {
-        std::optional<i32> value = code.fetchI32();
-        if (!value.has_value()) DISPATCH_FAIL();
+        i64 value = inst.imm.integer();
 
-        i64 index = vm.sp().integer() - 1;
-        Stack& stack = vm.stack();
+        Value* top = state.sp - 1;
+        DISPATCH_CHECK(IsWithinFrame(state, top));
 
-        if (!stack.isWithinBounds(index)) DISPATCH_FAIL();
-
-        stack[index].integer() *= value.value();
+        top->integer() *= value;
 
         DISPATCH_SUCCEED();
     }
 
     DEFINE_DISPATCH(DIV_IMM_ST) {
-        std::optional<i32> value = code.fetchI32();
-        if (!value.has_value()) DISPATCH_FAIL();
+        i64 value = inst.imm.integer();
 
-        i64 index = vm.sp().integer() - 1;
-        Stack& stack = vm.stack();
+        Value* top = state.sp - 1;
+        DISPATCH_CHECK(IsWithinFrame(state, top));
 
-        if (!stack.isWithinBounds(index)) DISPATCH_FAIL();
-
-        stack[index].integer() /= value.value();
+        top->integer() /= value;
 
         DISPATCH_SUCCEED();
     }
 
     DEFINE_DISPATCH(MOD_IMM_ST) {
-        std::optional<i32> value = code.fetchI32();
-        if (!value.has_value()) DISPATCH_FAIL();
+        i64 value = inst.imm.integer();
 
-        i64 index = vm.sp().integer() - 1;
-        Stack& stack = vm.stack();
-
-        if (!stack.isWithinBounds(index)) DISPATCH_FAIL();
+        Value* top = state.sp - 1;
+        DISPATCH_CHECK(IsWithinFrame(state, top));
 
-        i64 a = stack[index].integer();
-        i64 b = value.value();
+        i64 a = top->integer();
+        i64 b = value;
 
-        stack[index].integer() = a - (a / b) * b;
+        top->integer() = a - (a / b) * b;
 
         DISPATCH_SUCCEED();
     }
 
     DEFINE_DISPATCH(AND_IMM_ST) {
-        std::optional<i32> value = code.fetchI32();
-        if (!value.has_value()) DISPATCH_FAIL();
-
-        i64 index = vm.sp().integer() - 1;
-        Stack& stack = vm.stack();
+        i64 value = inst.imm.integer();
 
-        if (!stack.isWithinBounds(index)) DISPATCH_FAIL();
+        Value* top = state.sp - 1;
+        DISPATCH_CHECK(IsWithinFrame(state, top));
 
-        stack[index].integer() &= value.value();
+        top->integer() &= value;
 
         DISPATCH_SUCCEED();
     }
 
     DEFINE_DISPATCH(OR_IMM_ST) {
-        std::optional<i32> value = code.fetchI32();
-        if (!value.has_value()) DISPATCH_FAIL();
-
-        i64 index = vm.sp().integer() - 1;
-        Stack& stack = vm.stack();
+        i64 value = inst.imm.integer();
 
-        if (!stack.isWithinBounds(index)) DISPATCH_FAIL();
+        Value* top = state.sp - 1;
+        DISPATCH_CHECK(IsWithinFrame(state, top));
 
-        stack[index].integer() |= value.value();
+        top->integer() |= value;
 
         DISPATCH_SUCCEED();
     }
 
     DEFINE_DISPATCH(XOR_IMM_ST) {
-        std::optional<i32> value = code.fetchI32();
-        if (!value.has_value()) DISPATCH_FAIL();
+        i64 value = inst.imm.integer();
 
-        i64 index = vm.sp().integer() - 1;
-        Stack& stack = vm.stack();
+        Value* top = state.sp - 1;
+        DISPATCH_CHECK(IsWithinFrame(state, top));
 
-        if (!stack.isWithinBounds(index)) DISPATCH_FAIL();
-
-        stack[index].integer() ^= value.value();
+        top->integer() ^= value;
 
         DISPATCH_SUCCEED();
     }
 
     DEFINE_DISPATCH(SHL_IMM_ST) {
-        std::optional<i32> value = code.fetchI32();
-        if (!value.has_value()) DISPATCH_FAIL();
-
-        i64 index = vm.sp().integer() - 1;
-        Stack& stack = vm.stack();
+        i64 value = inst.imm.integer();
 
-        if (!stack.isWithinBounds(index)) DISPATCH_FAIL();
+        Value* top = state.sp - 1;
+        DISPATCH_CHECK(IsWithinFrame(state, top));
 
-        stack[index].integer() <<= value.value();
+        top->integer() <<= value;
 
         DISPATCH_SUCCEED();
     }
 
     DEFINE_DISPATCH(SHR_IMM_ST) {
-        std::optional<i32> value = code.fetchI32();
-        if (!value.has_value()) DISPATCH_FAIL();
-
-        i64 index = vm.sp().integer() - 1;
-        Stack& stack = vm.stack();
+        i64 value = inst.imm.integer();
 
-        if (!stack.isWithinBounds(index)) DISPATCH_FAIL();
+        Value* top = state.sp - 1;
+        DISPATCH_CHECK(IsWithinFrame(state, top));
 
-        stack[index].integer() >>= value.value();
+        top->integer() >>= value;
 
         DISPATCH_SUCCEED();
     }
 
     DEFINE_DISPATCH(FADD) {
-        std::optional<Value> s0f = vm.pop();
+        std::optional<Value> s0f = Pop<Policy>(state);
         if (!s0f.has_value()) DISPATCH_FAIL();
 
-        vm.acc().floating() += s0f->floating();
+        state.acc.floating() += s0f->floating();
 
         DISPATCH_SUCCEED();
     }
 
     DEFINE_DISPATCH(FSUB) {
-        std::optional<Value> s0f = vm.pop();
+        std::optional<Value> s0f = Pop<Policy>(state);
         if (!s0f.has_value()) DISPATCH_FAIL();
 
-        vm.acc().floating() -= s0f->floating();
+        state.acc.floating() -= s0f->floating();
 
         DISPATCH_SUCCEED();
     }
 
     DEFINE_DISPATCH(FMUL) {
-        std::optional<Value> s0f = vm.pop();
+        std::optional<Value> s0f = Pop<Policy>(state);
         if (!s0f.has_value()) DISPATCH_FAIL();
 
-        vm.acc().floating() *= s0f->floating();
+        state.acc.floating() *= s0f->floating();
 
         DISPATCH_SUCCEED();
     }
 
     DEFINE_DISPATCH(FDIV) {
-        std::optional<Value> s0f = vm.pop();
+        std::optional<Value> s0f = Pop<Policy>(state);
         if (!s0f.has_value()) DISPATCH_FAIL();
 
-        vm.acc().floating() /= s0f->floating();
+        state.acc.floating() /= s0f->floating();
 
         DISPATCH_SUCCEED();
     }
 
     DEFINE_DISPATCH(FADD2) {
-        std::optional<Value> s0f = vm.pop();
-        std::optional<Value> s1f = vm.pop();
+        std::optional<Value> s0f = Pop<Policy>(state);
+        std::optional<Value> s1f = Pop<Policy>(state);
         if (!s0f.has_value() || !s1f.has_value()) DISPATCH_FAIL();
 
-        vm.acc().floating() = s1f->floating() + s0f->floating();
+        state.acc.floating() = s1f->floating() + s0f->floating();
 
         DISPATCH_SUCCEED();
     }
 
     DEFINE_DISPATCH(FSUB2) {
-        std::optional<Value> s0f = vm.pop();
-        std::optional<Value> s1f = vm.pop();
+        std::optional<Value> s0f = Pop<Policy>(state);
+        std::optional<Value> s1f = Pop<Policy>(state);
         if (!s0f.has_value() || !s1f.has_value()) DISPATCH_FAIL();
 
-        vm.acc().floating() = s1f->floating() - s0f->floating();
+        state.acc.floating() = s1f->floating() - s0f->floating();
 
         DISPATCH_SUCCEED();
     }
 
     DEFINE_DISPATCH(FMUL2) {
-        std::optional<Value> s0f = vm.pop();
-        std::optional<Value> s1f = vm.pop();
+        std::optional<Value> s0f = Pop<Policy>(state);
+        std::optional<Value> s1f = Pop<Policy>(state);
         if (!s0f.has_value() || !s1f.has_value()) DISPATCH_FAIL();
 
-        vm.acc().floating() = s1f->floating() * s0f->floating();
+        state.acc.floating() = s1f->floating() * s0f->floating();
 
         DISPATCH_SUCCEED();
     }
 
     DEFINE_DISPATCH(FDIV2) {
-        std::optional<Value> s0f = vm.pop();
-        std::optional<Value> s1f = vm.pop();
+        std::optional<Value> s0f = Pop<Policy>(state);
+        std::optional<Value> s1f = Pop<Policy>(state);
         if (!s0f.has_value() || !s1f.has_value()) DISPATCH_FAIL();
 
-        vm.acc().floating() = s1f->floating() / s0f->floating();
+        state.acc.floating() = s1f->floating() / s0f->floating();
 
         DISPATCH_SUCCEED();
     }
 
     DEFINE_DISPATCH(FADD_ST) {
-        std::optional<Value> s0f = vm.pop();
-        std::optional<Value> s1f = vm.pop();
+        std::optional<Value> s0f = Pop<Policy>(state);
+        std::optional<Value> s1f = Pop<Policy>(state);
         if (!s0f.has_value() || !s1f.has_value()) DISPATCH_FAIL();
 
-        if (!vm.push(s1f->floating() + s0f->floating())) DISPATCH_FAIL();
+        if (!Push<Policy>(state, s1f->floating() + s0f->floating())) DISPATCH_FAIL();
 
         DISPATCH_SUCCEED();
     }
 
     DEFINE_DISPATCH(FSUB_ST) {
-        std::optional<Value> s0f = vm.pop();
-        std::optional<Value> s1f = vm.pop();
+        std::optional<Value> s0f = Pop<Policy>(state);
+        std::optional<Value> s1f = Pop<Policy>(state);
         if (!s0f.has_value() || !s1f.has_value()) DISPATCH_FAIL();
 
-        if (!vm.push(s1f->floating() - s0f->floating())) DISPATCH_FAIL();
+        if (!Push<Policy>(state, s1f->floating() - s0f->floating())) DISPATCH_FAIL();
 
         DISPATCH_SUCCEED();
     }
 
     DEFINE_DISPATCH(FMUL_ST) {
-        std::optional<Value> s0f = vm.pop();
-        std::optional<Value> s1f = vm.pop();
+        std::optional<Value> s0f = Pop<Policy>(state);
+        std::optional<Value> s1f = Pop<Policy>(state);
         if (!s0f.has_value() || !s1f.has_value()) DISPATCH_FAIL();
 
-        if (!vm.push(s1f->floating() * s0f->floating())) DISPATCH_FAIL();
+        if (!Push<Policy>(state, s1f->floating() * s0f->floating())) DISPATCH_FAIL();
 
         DISPATCH_SUCCEED();
     }
 
     DEFINE_DISPATCH(FDIV_ST) {
-        std::optional<Value> s0f = vm.pop();
-        std::optional<Value> s1f = vm.pop();
+        std::optional<Value> s0f = Pop<Policy>(state);
+        std::optional<Value> s1f = Pop<Policy>(state);
         if (!s0f.has_value() || !s1f.has_value()) DISPATCH_FAIL();
 
-        if (!vm.push(s1f->floating() / s0f->floating())) DISPATCH_FAIL();
+        if (!Push<Policy>(state, s1f->floating() / s0f->floating())) DISPATCH_FAIL();
 
         DISPATCH_SUCCEED();
     }
 
     DEFINE_DISPATCH(FNEG) {
-        vm.acc().floating() = -vm.acc().floating();
+        state.acc.floating() = -state.acc.floating();
 
         DISPATCH_SUCCEED();
     }
 
     DEFINE_DISPATCH(FADD_IMM) {
-        std::optional<float> value = code.fetchFloat();
-        if (!value.has_value()) DISPATCH_FAIL();
+        double value = inst.imm.floating();
 
-        vm.acc().floating() += value.value();
+        state.acc.floating() += value;
 
         DISPATCH_SUCCEED();
     }
 
     DEFINE_DISPATCH(FSUB_IMM) {
-        std::optional<float> value = code.fetchFloat();
-        if (!value.has_value()) DISPATCH_FAIL();
+        double value = inst.imm.floating();
 
-        vm.acc().floating() -= value.value();
+        state.acc.floating() -= value;
 
         DISPATCH_SUCCEED();
     }
 
     DEFINE_DISPATCH(FMUL_IMM) {
-        std::optional<float> value = code.fetchFloat();
-        if (!value.has_value()) DISPATCH_FAIL();
+        double value = inst.imm.floating();
 
-        vm.acc().floating() *= value.value();
+        state.acc.floating() *= value;
 
         DISPATCH_SUCCEED();
     }
 
     DEFINE_DISPATCH(FDIV_IMM) {
-        std::optional<float> value = code.fetchFloat();
-        if (!value.has_value()) DISPATCH_FAIL();
+        double value = inst.imm.floating();
 
-        vm.acc().floating() /= value.value();
+        state.acc.floating() /= value;
 
         DISPATCH_SUCCEED();
     }
 
     DEFINE_DISPATCH(FADD_IMM_ST) {
-        std::optional<float> value = code.fetchFloat();
-        if (!value.has_value()) DISPATCH_FAIL();
-
-        i64 index = vm.sp().integer() - 1;
-        Stack& stack = vm.stack();
+        double value = inst.imm.floating();
 
-        if (!stack.isWithinBounds(index)) DISPATCH_FAIL();
+        Value* top = state.sp - 1;
+        DISPATCH_CHECK(IsWithinFrame(state, top));
 
-        stack[index].floating() += value.value();
+        top->floating() += value;
 
         DISPATCH_SUCCEED();
     }
 
     DEFINE_DISPATCH(FSUB_IMM_ST) {
-        std::optional<float> value = code.fetchFloat();
-        if (!value.has_value()) DISPATCH_FAIL();
-
-        i64 index = vm.sp().integer() - 1;
-        Stack& stack = vm.stack();
+        double value = inst.imm.floating();
 
-        if (!stack.isWithinBounds(index)) DISPATCH_FAIL();
+        Value* top = state.sp - 1;
+        DISPATCH_CHECK(IsWithinFrame(state, top));
 
-        stack[index].floating() -= value.value();
+        top->floating() -= value;
 
         DISPATCH_SUCCEED();
     }
 
     DEFINE_DISPATCH(FMUL_IMM_ST) {
-        std::optional<float> value = code.fetchFloat();
-        if (!value.has_value()) DISPATCH_FAIL();
+        double value = inst.imm.floating();
 
-        i64 index = vm.sp().integer() - 1;
-        Stack& stack = vm.stack();
+        Value* top = state.sp - 1;
+        DISPATCH_CHECK(IsWithinFrame(state, top));
 
-        if (!stack.isWithinBounds(index)) DISPATCH_FAIL();
-
-        stack[index].floating() *= value.value();
+        top->floating() *= value;
 
         DISPATCH_SUCCEED();
     }
 
     DEFINE_DISPATCH(FDIV_IMM_ST) {
-        std::optional<float> value = code.fetchFloat();
-        if (!value.has_value()) DISPATCH_FAIL();
-
-        i64 index = vm.sp().integer() - 1;
-        Stack& stack = vm.stack();
+        double value = inst.imm.floating();
 
-        if (!stack.isWithinBounds(index)) DISPATCH_FAIL();
+        Value* top = state.sp - 1;
+        DISPATCH_CHECK(IsWithinFrame(state, top));
 
-        stack[index].floating() /= value.value();
+        top->floating() /= value;
 
         DISPATCH_SUCCEED();
     }
 
     DEFINE_DISPATCH(CMP_EQ) {
-        std::optional<Value> s0 = vm.pop();
+        std::optional<Value> s0 = Pop<Policy>(state);
         if (!s0.has_value()) DISPATCH_FAIL();
 
-        vm.acc().boolean() = vm.acc().integer() == s0->integer();
+        state.acc.boolean() = state.acc.integer() == s0->integer();
 
         DISPATCH_SUCCEED();
     }
 
     DEFINE_DISPATCH(CMP_NE) {
-        std::optional<Value> s0 = vm.pop();
+        std::optional<Value> s0 = Pop<Policy>(state);
         if (!s0.has_value()) DISPATCH_FAIL();
 
-        vm.acc().boolean() = vm.acc().integer() != s0->integer();
+        state.acc.boolean() = state.acc.integer() != s0->integer();
 
         DISPATCH_SUCCEED();
     }
 
     DEFINE_DISPATCH(CMP_LT) {
-        std::optional<Value> s0 = vm.pop();
+        std::optional<Value> s0 = Pop<Policy>(state);
         if (!s0.has_value()) DISPATCH_FAIL();
 
-        vm.acc().boolean() = vm.acc().integer() < s0->integer();
+        state.acc.boolean() = state.acc.integer() < s0->integer();
 
         DISPATCH_SUCCEED();
     }
 
     DEFINE_DISPATCH(CMP_GT) {
-        std::optional<Value> s0 = vm.pop();
+        std::optional<Value> s0 = Pop<Policy>(state);
         if (!s0.has_value()) DISPATCH_FAIL();
 
-        vm.acc().boolean() = vm.acc().integer() > s0->integer();
+        state.acc.boolean() = state.acc.integer() > s0->integer();
 
         DISPATCH_SUCCEED();
     }
 
     DEFINE_DISPATCH(CMP_LTE) {
-        std::optional<Value> s0 = vm.pop();
+        std::optional<Value> s0 = Pop<Policy>(state);
         if (!s0.has_value()) DISPATCH_FAIL();
 
-        vm.acc().boolean() = vm.acc().integer() <= s0->integer();
+        state.acc.boolean() = state.acc.integer() <= s0->integer();
 
         DISPATCH_SUCCEED();
     }
 
     DEFINE_DISPATCH(CMP_GTE) {
-        std::optional<Value> s0 = vm.pop();
+        std::optional<Value> s0 = Pop<Policy>(state);
         if (!s0.has_value()) DISPATCH_FAIL();
 
-        vm.acc().boolean() = vm.acc().integer() >= s0->integer();
+        state.acc.boolean() = state.acc.integer() >= s0->integer();
 
         DISPATCH_SUCCEED();
     }
 
     DEFINE_DISPATCH(FCMP_EQ) {
-        std::optional<Value> s0 = vm.pop();
+        std::optional<Value> s0 = Pop<Policy>(state);
         if (!s0.has_value()) DISPATCH_FAIL();
 
-        vm.acc().boolean() = vm.acc().floating() == s0->floating();
+        state.acc.boolean() = state.acc.floating() == s0->floating();
 
         DISPATCH_SUCCEED();
     }
 
     DEFINE_DISPATCH(FCMP_NE) {
-        std::optional<Value> s0 = vm.pop();
+        std::optional<Value> s0 = Pop<Policy>(state);
         if (!s0.has_value()) DISPATCH_FAIL();
 
-        vm.acc().boolean() = vm.acc().floating() != s0->floating();
+        state.acc.boolean() = state.acc.floating() != s0->floating();
 
         DISPATCH_SUCCEED();
     }
 
     DEFINE_DISPATCH(FCMP_LT) {
-        std::optional<Value> s0 = vm.pop();
+        std::optional<Value> s0 = Pop<Policy>(state);
         if (!s0.has_value()) DISPATCH_FAIL();
 
-        vm.acc().boolean() = vm.acc().floating() < s0->floating();
+        state.acc.boolean() = state.acc.floating() < s0->floating();
 
         DISPATCH_SUCCEED();
     }
 
     DEFINE_DISPATCH(FCMP_GT) {
-        std::optional<Value> s0 = vm.pop();
+        std::optional<Value> s0 = Pop<Policy>(state);
         if (!s0.has_value()) DISPATCH_FAIL();
 
-        vm.acc().boolean() = vm.acc().floating() > s0->floating();
+        state.acc.boolean() = state.acc.floating() > s0->floating();
 
         DISPATCH_SUCCEED();
     }
 
     DEFINE_DISPATCH(FCMP_LTE) {
-        std::optional<Value> s0 = vm.pop();
+        std::optional<Value> s0 = Pop<Policy>(state);
         if (!s0.has_value()) DISPATCH_FAIL();
 
-        vm.acc().boolean() = vm.acc().floating() <= s0->floating();
+        state.acc.boolean() = state.acc.floating() <= s0->floating();
 
         DISPATCH_SUCCEED();
     }
 
     DEFINE_DISPATCH(FCMP_GTE) {
-        std::optional<Value> s0 = vm.pop();
+        std::optional<Value> s0 = Pop<Policy>(state);
         if (!s0.has_value()) DISPATCH_FAIL();
 
-        vm.acc().boolean() = vm.acc().floating() >= s0->floating();
+        state.acc.boolean() = state.acc.floating() >= s0->floating();
 
         DISPATCH_SUCCEED();
     }
 
     DEFINE_DISPATCH(CMP_EQ0) {
-        vm.acc().boolean() = vm.acc().integer() == 0;
+        state.acc.boolean() = state.acc.integer() == 0;
 
         DISPATCH_SUCCEED();
     }
 
     DEFINE_DISPATCH(CMP_NE0) {
-        vm.acc().boolean() = vm.acc().integer() != 0;
+        state.acc.boolean() = state.acc.integer() != 0;
 
         DISPATCH_SUCCEED();
     }
 
     DEFINE_DISPATCH(CMP_LT0) {
-        vm.acc().boolean() = vm.acc().integer() < 0;
+        state.acc.boolean() = state.acc.integer() < 0;
 
         DISPATCH_SUCCEED();
     }
 
     DEFINE_DISPATCH(CMP_GT0) {
-        vm.acc().boolean() = vm.acc().integer() > 0;
+        state.acc.boolean() = state.acc.integer() > 0;
 
         DISPATCH_SUCCEED();
     }
 
     DEFINE_DISPATCH(CMP_LTE0) {
-        vm.acc().boolean() = vm.acc().integer() <= 0;
+        state.acc.boolean() = state.acc.integer() <= 0;
 
         DISPATCH_SUCCEED();
     }
 
     DEFINE_DISPATCH(CMP_GTE0) {
-        vm.acc().boolean() = vm.acc().integer() >= 0;
+        state.acc.boolean() = state.acc.integer() >= 0;
 
         DISPATCH_SUCCEED();
     }
 
     DEFINE_DISPATCH(FCMP_EQ0) {
-        vm.acc().boolean() = vm.acc().floating() == 0;
+        state.acc.boolean() = state.acc.floating() == 0;
 
         DISPATCH_SUCCEED();
     }
 
     DEFINE_DISPATCH(FCMP_NE0) {
-        vm.acc().boolean() = vm.acc().floating() != 0;
+        state.acc.boolean() = state.acc.floating() != 0;
 
         DISPATCH_SUCCEED();
     }
 
     DEFINE_DISPATCH(FCMP_LT0) {
-        vm.acc().boolean() = vm.acc().floating() < 0;
+        state.acc.boolean() = state.acc.floating() < 0;
 
         DISPATCH_SUCCEED();
     }
 
     DEFINE_DISPATCH(FCMP_GT0) {
-        vm.acc().boolean() = vm.acc().floating() > 0;
+        state.acc.boolean() = state.acc.floating() > 0;
 
         DISPATCH_SUCCEED();
     }
 
     DEFINE_DISPATCH(FCMP_LTE0) {
-        vm.acc().boolean() = vm.acc().floating() <= 0;
+        state.acc.boolean() = state.acc.floating() <= 0;
 
         DISPATCH_SUCCEED();
     }
 
     DEFINE_DISPATCH(FCMP_GTE0) {
-        vm.acc().boolean() = vm.acc().floating() >= 0;
+        state.acc.boolean() = state.acc.floating() >= 0;
 
         DISPATCH_SUCCEED();
     }
 
     DEFINE_DISPATCH(PUSH_ACC) {
-        if (!vm.push(vm.acc())) DISPATCH_FAIL();
+        if (!Push<Policy>(state, state.acc)) DISPATCH_FAIL();
 
         DISPATCH_SUCCEED();
     }
 
     DEFINE_DISPATCH(PUSH_SP) {
-        if (!vm.push(vm.sp())) DISPATCH_FAIL();
+        if (!Push<Policy>(state, Value(static_cast<i64>(state.sp - state.stack)))) DISPATCH_FAIL();
 
         DISPATCH_SUCCEED();
     }
 
     DEFINE_DISPATCH(POP_ACC) {
-        std::optional<Value> value = vm.pop();
+        std::optional<Value> value = Pop<Policy>(state);
         if (!value.has_value()) DISPATCH_FAIL();
 
-        vm.acc() = value.value();
+        state.acc = value.value();
 
         DISPATCH_SUCCEED();
     }
 
     DEFINE_DISPATCH(POP_SP) {
-        std::optional<Value> value = vm.pop();
+        std::optional<Value> value = Pop<Policy>(state);
         if (!value.has_value()) DISPATCH_FAIL();
 
-        vm.sp() = value.value();
+        i64 index = value->integer();
+        DISPATCH_CHECK(index >= state.frame - state.stack && index <= state.limit - state.stack);
+
+        state.sp = state.stack + index;
 
         DISPATCH_SUCCEED();
     }
 
     DEFINE_DISPATCH(POP_DISCARD) {
-        std::optional<u8> count = code.fetchU8();
-        if (!count.has_value()) DISPATCH_FAIL();
+        u32 count = inst.a;
 
-        if (count.value() > vm.sp().integer()) DISPATCH_FAIL();
+        DISPATCH_CHECK(count <= state.sp - state.frame);
 
-        vm.sp().integer() -= count.value();
+        state.sp -= count;
 
         DISPATCH_SUCCEED();
     }
 
     DEFINE_DISPATCH(CONST) {
-        std::optional<i8> value = code.fetchI8();
-        if (!value.has_value()) DISPATCH_FAIL();
+        i64 value = inst.imm.integer();
 
-        vm.acc().integer() = static_cast<i64>(value.value());
+        state.acc.integer() = value;
 
         DISPATCH_SUCCEED();
     }
 
     DEFINE_DISPATCH(CONST32) {
-        std::optional<i32> value = code.fetchI32();
-        if (!value.has_value()) DISPATCH_FAIL();
+        i64 value = inst.imm.integer();
 
-        vm.acc().integer() = static_cast<i64>(value.value());
+        state.acc.integer() = value;
 
         DISPATCH_SUCCEED();
     }
 
     DEFINE_DISPATCH(CONST64) {
-        std::optional<i64> value = code.fetchI64();
-        if (!value.has_value()) DISPATCH_FAIL();
+        i64 value = inst.imm.integer();
 
-        vm.acc().integer() = value.value();
+        state.acc.integer() = value;
 
         DISPATCH_SUCCEED();
     }
 
     DEFINE_DISPATCH(CONST_ST) {
-        std::optional<i8> value = code.fetchI8();
-        if (!value.has_value()) DISPATCH_FAIL();
+        i64 value = inst.imm.integer();
 
-        vm.push(value.value());
+        if (!Push<Policy>(state, value)) DISPATCH_FAIL();
 
         DISPATCH_SUCCEED();
     }
 
     DEFINE_DISPATCH(CONST32_ST) {
-        std::optional<i32> value = code.fetchI32();
-        if (!value.has_value()) DISPATCH_FAIL();
+        i64 value = inst.imm.integer();
 
-        vm.push(value.value());
+        if (!Push<Policy>(state, value)) DISPATCH_FAIL();
 
         DISPATCH_SUCCEED();
     }
 
     DEFINE_DISPATCH(CONST64_ST) {
-        std::optional<i64> value = code.fetchI64();
-        if (!value.has_value()) DISPATCH_FAIL();
+        i64 value = inst.imm.integer();
 
-        vm.push(value.value());
+        if (!Push<Policy>(state, value)) DISPATCH_FAIL();
 
         DISPATCH_SUCCEED();
     }
 
     DEFINE_DISPATCH(LOAD) {
-        std::optional<i16> indexOpt = code.fetchI16();
-        if (!indexOpt.has_value()) DISPATCH_FAIL();
+        Value* slot = state.frame + static_cast<i32>(inst.a);
+        DISPATCH_CHECK(IsWithinFrame(state, slot));
 
-        Stack& stack = vm.stack();
-        i64 index = indexOpt.value() + stack.sb() + 1;
+        state.acc = *slot;
 
-        if (!stack.isWithinBounds(index)) DISPATCH_FAIL();
+        DISPATCH_SUCCEED();
+    }
 
-        vm.acc() = stack[index];
+    DEFINE_DISPATCH(LOAD_ST) {
+        Value* slot = state.frame + static_cast<i32>(inst.a);
+        DISPATCH_CHECK(IsWithinFrame(state, slot));
+
+        if (!Push<Policy>(state, *slot)) DISPATCH_FAIL();
 
         DISPATCH_SUCCEED();
     }
 
-    DEFINE_DISPATCH(LOAD_ST) {
-        std::optional<i16> indexOpt = code.fetchI16();
-        if (!indexOpt.has_value()) DISPATCH_FAIL();
+    DEFINE_DISPATCH(STORE) {
+        Value* slot = state.frame + static_cast<i32>(inst.a);
+        DISPATCH_CHECK(IsWithinFrame(state, slot));
 
-        Stack& stack = vm.stack();
-        i64 index = indexOpt.value() + stack.sb() + 1;
+        *slot = state.acc;
+
+        DISPATCH_SUCCEED();
+    }
+
+    DEFINE_DISPATCH(STORE_ST) {
+        Value* slot = state.frame + static_cast<i32>(inst.a);
+        DISPATCH_CHECK(IsWithinFrame(state, slot));
 
-        if (!stack.isWithinBounds(index)) DISPATCH_FAIL();
+        std::optional<Value> value = Pop<Policy>(state);
+        if (!value.has_value()) DISPATCH_FAIL();
 
-        if (!vm.push(stack[index])) DISPATCH_FAIL();
+        *slot = value.value();
 
         DISPATCH_SUCCEED();
     }
 
-    DEFINE_DISPATCH(STORE) {
-        std::optional<i16> indexOpt = code.fetchI16();
-        if (!indexOpt.has_value()) DISPATCH_FAIL();
+    DEFINE_DISPATCH(RESERVE) {
+        u32 count = inst.a;
 
-        Stack& stack = vm.stack();
-        i64 index = indexOpt.value() + stack.sb() + 1;
+        if constexpr (Policy::Checked || !BIBBLEVM_STACK_GUARD) {
+            if (count >= state.limit - state.sp) DISPATCH_FAIL();
+        }
 
-        if (!stack.isWithinBounds(index)) DISPATCH_FAIL();
+        state.sp += count;
 
-        stack[index] = vm.acc();
+        // nothing else has to touch the slots, so this does. It's what runs into the guard pages if there wasn't room
+        if constexpr (!Policy::Checked && BIBBLEVM_STACK_GUARD) {
+            if (count != 0) static_cast<void>(*reinterpret_cast<volatile const u8*>(state.sp - 1));
+        }
 
         DISPATCH_SUCCEED();
     }
 
-    DEFINE_DISPATCH(STORE_ST) {
-        std::optional<i16> indexOpt = code.fetchI16();
-        if (!indexOpt.has_value()) DISPATCH_FAIL();
+    DEFINE_DISPATCH(JMP) {
+        state.pc = state.code + inst.a;
+
+        DISPATCH_SUCCEED();
+    }
+
+    DEFINE_DISPATCH(JZ) {
+        if (!state.acc.boolean()) state.pc = state.code + inst.a;
+
+        DISPATCH_SUCCEED();
+    }
 
+    DEFINE_DISPATCH(JNZ) {
+        if (state.acc.boolean()) state.pc = state.code + inst.a;
+
+        DISPATCH_SUCCEED();
+    }
+
+    DEFINE_DISPATCH(CALL) {
+        DISPATCH_CALL_UTIL(CachedCallInstHelper, state, inst);
+        DISPATCH_SUCCEED();
+    }
+
+    DEFINE_DISPATCH(CALL_EX) {
+        DISPATCH_CALL_UTIL(CachedCallInstHelper, state, inst);
+        DISPATCH_SUCCEED();
+    }
+
+    DEFINE_DISPATCH(CALL_DYN) {
+        DISPATCH_CALL_UTIL(CallInstHelper, state, static_cast<u32>(state.acc.integer()), inst.b);
+        DISPATCH_SUCCEED();
+    }
+
+    DEFINE_DISPATCH(CALL_TINY) {
+        DISPATCH_CALL_UTIL(CachedCallInstHelper, state, inst);
+        DISPATCH_SUCCEED();
+    }
+
+    DEFINE_DISPATCH(CALL_TINY_EX) {
+        DISPATCH_CALL_UTIL(CachedCallInstHelper, state, inst);
+        DISPATCH_SUCCEED();
+    }
+
+    DEFINE_DISPATCH(RET) {
         Stack& stack = vm.stack();
-        i64 index = indexOpt.value() + stack.sb() + 1;
 
-        if (!stack.isWithinBounds(index)) DISPATCH_FAIL();
+        ReturnAddress returnAddress = stack.returnAddress();
+        if (returnAddress.pc == nullptr) DISPATCH_INTERPRETER_RETURN(); // host frame, the host pops it
 
-        std::optional<Value> value = vm.pop();
-        if (!value.has_value()) DISPATCH_FAIL();
+        if (!stack.popFrame()) DISPATCH_FAIL();
 
-        stack[index] = value.value();
+        vm.interpreter().setActiveModule(returnAddress.module);
+        state.pc = returnAddress.pc;
+        state.code = returnAddress.code;
+        state.sp = state.stack + stack.sp().integer();
+        state.frame = state.stack + stack.sb();
 
         DISPATCH_SUCCEED();
     }
 
-    DEFINE_DISPATCH(RESERVE) {
-        std::optional<u8> count = code.fetchU8();
-        if (!count.has_value()) DISPATCH_FAIL();
+    // Takes a backward branch and counts it. Once the loop has gone around often enough its function is compiled and the
+    // frame continues in compiled code from the loop header. If that runs the function to its RET, the RET is finished
+    // here, as if the interpreter had executed it
+    template<class Policy>
+    static DISPATCH_INLINE DispatchErr TakeBackEdge(VM& vm, ExecState& state, const Instruction& inst) {
+        state.pc = state.code + inst.a;
+        if (--inst.counter != 0) [[likely]] DISPATCH_SUCCEED();
+
+        DispatchErr err = vm.interpreter().enterCompiledLoop(vm, state, inst);
+        if (err == DISPATCH_RETURN && !vm.hasExited()) return Dispatch_RET<Policy>(vm, state, inst);
 
-        i64 newSp = vm.sp().integer() + count.value();
-        if (!vm.stack().isWithinBounds(newSp)) DISPATCH_FAIL();
+        return err;
+    }
+
+    DEFINE_DISPATCH(JMP_BACK) {
+        return TakeBackEdge<Policy>(vm, state, inst);
+    }
 
-        vm.sp().integer() = newSp;
+    DEFINE_DISPATCH(JZ_BACK) {
+        if (!state.acc.boolean()) return TakeBackEdge<Policy>(vm, state, inst);
 
         DISPATCH_SUCCEED();
     }
 
-    DEFINE_DISPATCH(JMP) {
-        std::optional<i16> branch = code.fetchI16();
-        if (!branch.has_value()) DISPATCH_FAIL();
+    DEFINE_DISPATCH(JNZ_BACK) {
+        if (state.acc.boolean()) return TakeBackEdge<Policy>(vm, state, inst);
+
+        DISPATCH_SUCCEED();
+    }
+
+    DEFINE_DISPATCH(INVALID) {
+        return DISPATCH_ERROR;
+    }
+
+    // A superinstruction runs its parts back to back with the operands of their own instructions, which follow it in the
+    // stream. Only the last part may move pc, so pc is stepped past the others before it runs
+#define DEFINE_SUPERINSTRUCTION2(a, b) \
+    DEFINE_DISPATCH(a##_##b) { \
+        if (DispatchErr _err = Dispatch_##a<Policy>(vm, state, inst); _err != DISPATCH_SUCCESS) return _err; \
+        state.pc += 1; \
+        return Dispatch_##b<Policy>(vm, state, (&inst)[1]); \
+    }
+
+#define DEFINE_SUPERINSTRUCTION3(a, b, c) \
+    DEFINE_DISPATCH(a##_##b##_##c) { \
+        if (DispatchErr _err = Dispatch_##a<Policy>(vm, state, inst); _err != DISPATCH_SUCCESS) return _err; \
+        if (DispatchErr _err = Dispatch_##b<Policy>(vm, state, (&inst)[1]); _err != DISPATCH_SUCCESS) return _err; \
+        state.pc += 2; \
+        return Dispatch_##c<Policy>(vm, state, (&inst)[2]); \
+    }
+
+    FOR_EACH_SUPERINSTRUCTION(DEFINE_SUPERINSTRUCTION2, DEFINE_SUPERINSTRUCTION3)
+
+    // Register form handlers (register_code.h). Only verified functions are translated, and their frame is checked once
+    // when they're entered, so these are only ever instantiated unchecked. Operands: a is the destination slot or branch
+    // target, b the first source slot, imm the second source slot (SS) or the immediate (SI)
+#define REGISTER_SLOT(index) state.frame[static_cast<size_t>(index)]
+
+    // Stack form handlers expect acc and sp in state, register code keeps acc in accSlot and never moves sp
+    static DISPATCH_INLINE void SyncRegisters(ExecState& state, u64 accSlot, u64 height) {
+        state.acc = REGISTER_SLOT(accSlot);
+        state.sp = state.frame + height;
+    }
 
-        code.skip(branch.value());
+    DEFINE_DISPATCH(R_ENTER) {
+        REGISTER_SLOT(inst.a) = state.acc;
 
         DISPATCH_SUCCEED();
     }
 
-    DEFINE_DISPATCH(JZ) {
-        std::optional<i16> branch = code.fetchI16();
-        if (!branch.has_value()) DISPATCH_FAIL();
+    DEFINE_DISPATCH(R_RESUME) {
+        REGISTER_SLOT(inst.a) = state.acc;
 
-        if (!vm.acc().boolean()) code.skip(branch.value());
+        DISPATCH_SUCCEED();
+    }
+
+    // Followed by a stack form instruction, which runs as it is
+    DEFINE_DISPATCH(R_SYNC) {
+        SyncRegisters(state, inst.a, inst.b);
 
         DISPATCH_SUCCEED();
     }
 
-    DEFINE_DISPATCH(JNZ) {
-        std::optional<i16> branch = code.fetchI16();
-        if (!branch.has_value()) DISPATCH_FAIL();
+    DEFINE_DISPATCH(R_MOV_SS) {
+        REGISTER_SLOT(inst.a) = REGISTER_SLOT(inst.b);
 
-        if (vm.acc().boolean()) code.skip(branch.value());
+        DISPATCH_SUCCEED();
+    }
+
+    DEFINE_DISPATCH(R_MOV_SI) {
+        REGISTER_SLOT(inst.a) = inst.imm;
 
         DISPATCH_SUCCEED();
     }
 
-    DEFINE_DISPATCH(CALL) {
-        std::optional<u32> targetIndexOpt = code.fetchU32();
-        std::optional<u8> argcOpt = code.fetchU8();
+#define DEFINE_REGISTER_BINARY(name, type, op) \
+    DEFINE_DISPATCH(R_##name##_SS) { \
+        REGISTER_SLOT(inst.a).type() = REGISTER_SLOT(inst.b).type() op REGISTER_SLOT(inst.imm.integer()).type(); \
+        DISPATCH_SUCCEED(); \
+    } \
+    DEFINE_DISPATCH(R_##name##_SI) { \
+        REGISTER_SLOT(inst.a).type() = REGISTER_SLOT(inst.b).type() op inst.imm.type(); \
+        DISPATCH_SUCCEED(); \
+    }
 
-        if (!targetIndexOpt.has_value()) DISPATCH_FAIL();
-        if (!argcOpt.has_value()) DISPATCH_FAIL();
+    DEFINE_REGISTER_BINARY(ADD, integer, +)
+    DEFINE_REGISTER_BINARY(SUB, integer, -)
+    DEFINE_REGISTER_BINARY(MUL, integer, *)
+    DEFINE_REGISTER_BINARY(DIV, integer, /)
+    DEFINE_REGISTER_BINARY(AND, integer, &)
+    DEFINE_REGISTER_BINARY(OR, integer, |)
+    DEFINE_REGISTER_BINARY(XOR, integer, ^)
+    DEFINE_REGISTER_BINARY(SHL, integer, <<)
+    DEFINE_REGISTER_BINARY(SHR, integer, >>)
+    DEFINE_REGISTER_BINARY(FADD, floating, +)
+    DEFINE_REGISTER_BINARY(FSUB, floating, -)
+    DEFINE_REGISTER_BINARY(FMUL, floating, *)
+    DEFINE_REGISTER_BINARY(FDIV, floating, /)
+
+    DEFINE_DISPATCH(R_MOD_SS) {
+        i64 a = REGISTER_SLOT(inst.b).integer();
+        i64 b = REGISTER_SLOT(inst.imm.integer()).integer();
+
+        REGISTER_SLOT(inst.a).integer() = a - (a / b) * b;
 
-        DISPATCH_CALL_UTIL(CallInstHelper, targetIndexOpt.value(), argcOpt.value());
         DISPATCH_SUCCEED();
     }
 
-    DEFINE_DISPATCH(CALL_EX) {
-        std::optional<u32> targetIndexOpt = code.fetchU32();
-        std::optional<u16> argcOpt = code.fetchU16();
+    DEFINE_DISPATCH(R_MOD_SI) {
+        i64 a = REGISTER_SLOT(inst.b).integer();
+        i64 b = inst.imm.integer();
 
-        if (!targetIndexOpt.has_value()) DISPATCH_FAIL();
-        if (!argcOpt.has_value()) DISPATCH_FAIL();
+        REGISTER_SLOT(inst.a).integer() = a - (a / b) * b;
 
-        DISPATCH_CALL_UTIL(CallInstHelper, targetIndexOpt.value(), argcOpt.value());
         DISPATCH_SUCCEED();
     }
 
-    DEFINE_DISPATCH(CALL_DYN) {
-        std::optional<u16> argcOpt = code.fetchU16();
+#define DEFINE_REGISTER_UNARY(name, type, op) \
+    DEFINE_DISPATCH(R_##name##_S) { \
+        REGISTER_SLOT(inst.a).type() = op REGISTER_SLOT(inst.b).type(); \
+        DISPATCH_SUCCEED(); \
+    }
+
+    DEFINE_REGISTER_UNARY(NEG, integer, -)
+    DEFINE_REGISTER_UNARY(NOT, integer, ~)
+    DEFINE_REGISTER_UNARY(FNEG, floating, -)
+
+    // Every compare writes its result like the stack form does, or branches to a on it
+#define DEFINE_REGISTER_COMPARE(name, type, op) \
+    DEFINE_DISPATCH(R_##name##_SS) { \
+        REGISTER_SLOT(inst.a).boolean() = REGISTER_SLOT(inst.b).type() op REGISTER_SLOT(inst.imm.integer()).type(); \
+        DISPATCH_SUCCEED(); \
+    } \
+    DEFINE_DISPATCH(R_##name##_SI) { \
+        REGISTER_SLOT(inst.a).boolean() = REGISTER_SLOT(inst.b).type() op inst.imm.type(); \
+        DISPATCH_SUCCEED(); \
+    } \
+    DEFINE_DISPATCH(R_J##name##_SS) { \
+        if (REGISTER_SLOT(inst.b).type() op REGISTER_SLOT(inst.imm.integer()).type()) state.pc = state.code + inst.a; \
+        DISPATCH_SUCCEED(); \
+    } \
+    DEFINE_DISPATCH(R_J##name##_SI) { \
+        if (REGISTER_SLOT(inst.b).type() op inst.imm.type()) state.pc = state.code + inst.a; \
+        DISPATCH_SUCCEED(); \
+    }
+
+    DEFINE_REGISTER_COMPARE(EQ, integer, ==)
+    DEFINE_REGISTER_COMPARE(NE, integer, !=)
+    DEFINE_REGISTER_COMPARE(LT, integer, <)
+    DEFINE_REGISTER_COMPARE(GT, integer, >)
+    DEFINE_REGISTER_COMPARE(LE, integer, <=)
+    DEFINE_REGISTER_COMPARE(GE, integer, >=)
+    DEFINE_REGISTER_COMPARE(FEQ, floating, ==)
+    DEFINE_REGISTER_COMPARE(FNE, floating, !=)
+    DEFINE_REGISTER_COMPARE(FLT, floating, <)
+    DEFINE_REGISTER_COMPARE(FGT, floating, >)
+    DEFINE_REGISTER_COMPARE(FLE, floating, <=)
+    DEFINE_REGISTER_COMPARE(FGE, floating, >=)
 
-        if (!argcOpt.has_value()) DISPATCH_FAIL();
+    DEFINE_DISPATCH(R_JMP) {
+        state.pc = state.code + inst.a;
 
-        DISPATCH_CALL_UTIL(CallInstHelper, vm.acc().integer(), argcOpt.value());
         DISPATCH_SUCCEED();
     }
 
-    DEFINE_DISPATCH(CALL_TINY) {
-        std::optional<u16> targetIndexOpt = code.fetchU16();
-        std::optional<u8> argcOpt = code.fetchU8();
+    DEFINE_DISPATCH(R_JZ_S) {
+        if (!REGISTER_SLOT(inst.b).boolean()) state.pc = state.code + inst.a;
 
-        if (!targetIndexOpt.has_value()) DISPATCH_FAIL();
-        if (!argcOpt.has_value()) DISPATCH_FAIL();
+        DISPATCH_SUCCEED();
+    }
+
+    DEFINE_DISPATCH(R_JNZ_S) {
+        if (REGISTER_SLOT(inst.b).boolean()) state.pc = state.code + inst.a;
 
-        DISPATCH_CALL_UTIL(CallInstHelper, targetIndexOpt.value(), argcOpt.value());
         DISPATCH_SUCCEED();
     }
 
-    DEFINE_DISPATCH(CALL_TINY_EX) {
-        std::optional<u16> targetIndexOpt = code.fetchU16();
-        std::optional<u16> argcOpt = code.fetchU16();
+    // TakeBackEdge for register code. Compiled code is made from the stack form, so the frame goes back to that at the
+    // same loop header before it's handed over, and keeps running there if the compiler turns it down
+    template<class Policy>
+    static DISPATCH_INLINE DispatchErr TakeRegisterBackEdge(VM& vm, ExecState& state, const Instruction& inst) {
+        state.pc = state.code + inst.a;
+        if (--inst.counter != 0) [[likely]] DISPATCH_SUCCEED();
 
-        if (!targetIndexOpt.has_value()) DISPATCH_FAIL();
-        if (!argcOpt.has_value()) DISPATCH_FAIL();
+        vm.interpreter().leaveRegisterCode(vm, state, inst);
+
+        DispatchErr err = vm.interpreter().enterCompiledLoop(vm, state, inst);
+        if (err == DISPATCH_RETURN && !vm.hasExited()) return Dispatch_RET<Policy>(vm, state, inst);
+
+        return err;
+    }
+
+    DEFINE_DISPATCH(R_JMP_BACK) {
+        return TakeRegisterBackEdge<Policy>(vm, state, inst);
+    }
+
+    DEFINE_DISPATCH(R_JZ_S_BACK) {
+        if (!REGISTER_SLOT(inst.b).boolean()) return TakeRegisterBackEdge<Policy>(vm, state, inst);
 
-        DISPATCH_CALL_UTIL(CallInstHelper, targetIndexOpt.value(), argcOpt.value());
         DISPATCH_SUCCEED();
     }
 
-    DEFINE_DISPATCH(RET) {
-        DISPATCH_INTERPRETER_RETURN();
+    DEFINE_DISPATCH(R_JNZ_S_BACK) {
+        if (REGISTER_SLOT(inst.b).boolean()) return TakeRegisterBackEdge<Policy>(vm, state, inst);
+
+        DISPATCH_SUCCEED();
     }
 
-    void InitDispatchers(const VMConfig& config, DispatchTable& dispatchTable, DispatchTableExt& dispatchTableExt) {
-        REGISTER_DISPATCH(dispatchTable, NOP);
-        REGISTER_DISPATCH(dispatchTable, HLT);
-        REGISTER_DISPATCH(dispatchTable, TRAP);
-        REGISTER_DISPATCH(dispatchTable, TRAP_IF_ZERO);
-        REGISTER_DISPATCH(dispatchTable, TRAP_IF_NOT_ZERO);
-        REGISTER_DISPATCH(dispatchTable, BRK);
-        REGISTER_DISPATCH(dispatchTable, ADD);
-        REGISTER_DISPATCH(dispatchTable, SUB);
-        REGISTER_DISPATCH(dispatchTable, MUL);
-        REGISTER_DISPATCH(dispatchTable, DIV);
-        REGISTER_DISPATCH(dispatchTable, MOD);
-        REGISTER_DISPATCH(dispatchTable, AND);
-        REGISTER_DISPATCH(dispatchTable, OR);
-        REGISTER_DISPATCH(dispatchTable, XOR);
-        REGISTER_DISPATCH(dispatchTable, SHL);
-        REGISTER_DISPATCH(dispatchTable, SHR);
-        REGISTER_DISPATCH(dispatchTable, NEG);
-        REGISTER_DISPATCH(dispatchTable, NOT);
-        REGISTER_DISPATCH(dispatchTable, ADD2);
-        REGISTER_DISPATCH(dispatchTable, SUB2);
-        REGISTER_DISPATCH(dispatchTable, MUL2);
-        REGISTER_DISPATCH(dispatchTable, DIV2);
-        REGISTER_DISPATCH(dispatchTable, MOD2);
-        REGISTER_DISPATCH(dispatchTable, AND2);
-        REGISTER_DISPATCH(dispatchTable, OR2);
-        REGISTER_DISPATCH(dispatchTable, XOR2);
-        REGISTER_DISPATCH(dispatchTable, SHL2);
-        REGISTER_DISPATCH(dispatchTable, SHR2);
-        REGISTER_DISPATCH(dispatchTable, ADD_ST);
-        REGISTER_DISPATCH(dispatchTable, SUB_ST);
-        REGISTER_DISPATCH(dispatchTable, MUL_ST);
-        REGISTER_DISPATCH(dispatchTable, DIV_ST);
-        REGISTER_DISPATCH(dispatchTable, MOD_ST);
-        REGISTER_DISPATCH(dispatchTable, AND_ST);
-        REGISTER_DISPATCH(dispatchTable, OR_ST);
-        REGISTER_DISPATCH(dispatchTable, XOR_ST);
-        REGISTER_DISPATCH(dispatchTable, SHL_ST);
-        REGISTER_DISPATCH(dispatchTable, SHR_ST);
-        REGISTER_DISPATCH(dispatchTable, NEG_ST);
-        REGISTER_DISPATCH(dispatchTable, NOT_ST);
-        REGISTER_DISPATCH(dispatchTable, ADD_IMM);
-        REGISTER_DISPATCH(dispatchTable, SUB_IMM);
-        REGISTER_DISPATCH(dispatchTable, MUL_IMM);
-        REGISTER_DISPATCH(dispatchTable, DIV_IMM);
-        REGISTER_DISPATCH(dispatchTable, MOD_IMM);
-        REGISTER_DISPATCH(dispatchTable, AND_IMM);
-        REGISTER_DISPATCH(dispatchTable, OR_IMM);
-        REGISTER_DISPATCH(dispatchTable, XOR_IMM);
-        REGISTER_DISPATCH(dispatchTable, SHL_IMM);
-        REGISTER_DISPATCH(dispatchTable, SHR_IMM);
-        REGISTER_DISPATCH(dispatchTable, ADD_IMM_ST);
-        REGISTER_DISPATCH(dispatchTable, SUB_IMM_ST);
-        REGISTER_DISPATCH(dispatchTable, MUL_IMM_ST);
-        REGISTER_DISPATCH(dispatchTable, DIV_IMM_ST);
-        REGISTER_DISPATCH(dispatchTable, MOD_IMM_ST);
-        REGISTER_DISPATCH(dispatchTable, AND_IMM_ST);
-        REGISTER_DISPATCH(dispatchTable, OR_IMM_ST);
-        REGISTER_DISPATCH(dispatchTable, XOR_IMM_ST);
-        REGISTER_DISPATCH(dispatchTable, SHL_IMM_ST);
-        REGISTER_DISPATCH(dispatchTable, SHR_IMM_ST);
-        REGISTER_DISPATCH(dispatchTable, FADD);
-        REGISTER_DISPATCH(dispatchTable, FSUB);
-        REGISTER_DISPATCH(dispatchTable, FMUL);
-        REGISTER_DISPATCH(dispatchTable, FDIV);
-        REGISTER_DISPATCH(dispatchTable, FADD2);
-        REGISTER_DISPATCH(dispatchTable, FSUB2);
-        REGISTER_DISPATCH(dispatchTable, FMUL2);
-        REGISTER_DISPATCH(dispatchTable, FDIV2);
-        REGISTER_DISPATCH(dispatchTable, FADD_ST);
-        REGISTER_DISPATCH(dispatchTable, FSUB_ST);
-        REGISTER_DISPATCH(dispatchTable, FMUL_ST);
-        REGISTER_DISPATCH(dispatchTable, FDIV_ST);
-        REGISTER_DISPATCH(dispatchTable, FNEG);
-        REGISTER_DISPATCH(dispatchTable, FADD_IMM);
-        REGISTER_DISPATCH(dispatchTable, FSUB_IMM);
-        REGISTER_DISPATCH(dispatchTable, FMUL_IMM);
-        REGISTER_DISPATCH(dispatchTable, FDIV_IMM);
-        REGISTER_DISPATCH(dispatchTable, FADD_IMM_ST);
-        REGISTER_DISPATCH(dispatchTable, FSUB_IMM_ST);
-        REGISTER_DISPATCH(dispatchTable, FMUL_IMM_ST);
-        REGISTER_DISPATCH(dispatchTable, FDIV_IMM_ST);
-        REGISTER_DISPATCH(dispatchTable, CMP_EQ);
-        REGISTER_DISPATCH(dispatchTable, CMP_NE);
-        REGISTER_DISPATCH(dispatchTable, CMP_LT);
-        REGISTER_DISPATCH(dispatchTable, CMP_GT);
-        REGISTER_DISPATCH(dispatchTable, CMP_LTE);
-        REGISTER_DISPATCH(dispatchTable, CMP_GTE);
-        REGISTER_DISPATCH(dispatchTable, FCMP_EQ);
-        REGISTER_DISPATCH(dispatchTable, FCMP_NE);
-        REGISTER_DISPATCH(dispatchTable, FCMP_LT);
-        REGISTER_DISPATCH(dispatchTable, FCMP_GT);
-        REGISTER_DISPATCH(dispatchTable, FCMP_LTE);
-        REGISTER_DISPATCH(dispatchTable, FCMP_GTE);
-        REGISTER_DISPATCH(dispatchTable, CMP_EQ0);
-        REGISTER_DISPATCH(dispatchTable, CMP_NE0);
-        REGISTER_DISPATCH(dispatchTable, CMP_LT0);
-        REGISTER_DISPATCH(dispatchTable, CMP_GT0);
-        REGISTER_DISPATCH(dispatchTable, CMP_LTE0);
-        REGISTER_DISPATCH(dispatchTable, CMP_GTE0);
-        REGISTER_DISPATCH(dispatchTable, FCMP_EQ0);
-        REGISTER_DISPATCH(dispatchTable, FCMP_NE0);
-        REGISTER_DISPATCH(dispatchTable, FCMP_LT0);
-        REGISTER_DISPATCH(dispatchTable, FCMP_GT0);
-        REGISTER_DISPATCH(dispatchTable, FCMP_LTE0);
-        REGISTER_DISPATCH(dispatchTable, FCMP_GTE0);
-        REGISTER_DISPATCH(dispatchTable, PUSH_ACC);
-        REGISTER_DISPATCH(dispatchTable, PUSH_SP);
-        REGISTER_DISPATCH(dispatchTable, POP_ACC);
-        REGISTER_DISPATCH(dispatchTable, POP_SP);
-        REGISTER_DISPATCH(dispatchTable, POP_DISCARD);
-        REGISTER_DISPATCH(dispatchTable, CONST);
-        REGISTER_DISPATCH(dispatchTable, CONST32);
-        REGISTER_DISPATCH(dispatchTable, CONST64);
-        REGISTER_DISPATCH(dispatchTable, CONST_ST);
-        REGISTER_DISPATCH(dispatchTable, CONST32_ST);
-        REGISTER_DISPATCH(dispatchTable, CONST64_ST);
-        REGISTER_DISPATCH(dispatchTable, LOAD);
-        REGISTER_DISPATCH(dispatchTable, LOAD_ST);
-        REGISTER_DISPATCH(dispatchTable, STORE);
-        REGISTER_DISPATCH(dispatchTable, STORE_ST);
-        REGISTER_DISPATCH(dispatchTable, RESERVE);
-        REGISTER_DISPATCH(dispatchTable, JMP);
-        REGISTER_DISPATCH(dispatchTable, JZ);
-        REGISTER_DISPATCH(dispatchTable, JNZ);
-        REGISTER_DISPATCH(dispatchTable, CALL);
-        REGISTER_DISPATCH(dispatchTable, CALL_EX);
-        REGISTER_DISPATCH(dispatchTable, CALL_DYN);
-        REGISTER_DISPATCH(dispatchTable, CALL_TINY);
-        REGISTER_DISPATCH(dispatchTable, CALL_TINY_EX);
-        REGISTER_DISPATCH(dispatchTable, RET);
+    // Calls run with the operands of the plain call instruction that follows, like the last part of a superinstruction.
+    // The callee returns to the instruction after that, which picks acc up again if anything reads it
+#define DEFINE_REGISTER_CALL(opcode) \
+    DEFINE_DISPATCH(R_SYNC_##opcode) { \
+        SyncRegisters(state, inst.a, inst.b); \
+        state.pc += 1; \
+        return Dispatch_##opcode<Policy>(vm, state, (&inst)[1]); \
+    }
+
+    DEFINE_REGISTER_CALL(CALL)
+    DEFINE_REGISTER_CALL(CALL_EX)
+    DEFINE_REGISTER_CALL(CALL_DYN)
+    DEFINE_REGISTER_CALL(CALL_TINY)
+    DEFINE_REGISTER_CALL(CALL_TINY_EX)
+
+    DEFINE_DISPATCH(R_RET) {
+        SyncRegisters(state, inst.a, inst.b);
+
+        return Dispatch_RET<Policy>(vm, state, inst);
+    }
+
+    // imm is the exit code, like HLT's
+    DEFINE_DISPATCH(R_HLT) {
+        SyncRegisters(state, inst.a, inst.b);
+
+        return Dispatch_HLT<Policy>(vm, state, inst);
+    }
+
+    // a is the trap code, like the stack form's, which moves accSlot to imm. Traps may change acc, so it's written back
+#define DEFINE_REGISTER_TRAP(opcode) \
+    DEFINE_DISPATCH(R_##opcode) { \
+        SyncRegisters(state, inst.imm.uinteger(), inst.b); \
+        if (DispatchErr _err = Dispatch_##opcode<Policy>(vm, state, inst); _err != DISPATCH_SUCCESS) return _err; \
+        REGISTER_SLOT(inst.imm.uinteger()) = state.acc; \
+        DISPATCH_SUCCEED(); \
+    }
+
+    DEFINE_REGISTER_TRAP(TRAP)
+    DEFINE_REGISTER_TRAP(TRAP_IF_ZERO)
+    DEFINE_REGISTER_TRAP(TRAP_IF_NOT_ZERO)
+
+    static constexpr ByteOpcode DispatchOpcodes[] = {
+#define X(opcode) ByteOpcode::opcode,
+        FOR_EACH_DISPATCH(X)
+#undef X
+    };
+
+#if BIBBLEVM_THREADED_DISPATCH
+#define THREADED_LABEL_CHECKED(opcode) &&ThreadedChecked_##opcode,
+#define THREADED_LABEL_UNCHECKED(opcode) &&ThreadedUnchecked_##opcode,
+#define THREADED_LABEL_CHECKED2(a, b) THREADED_LABEL_CHECKED(a##_##b)
+#define THREADED_LABEL_CHECKED3(a, b, c) THREADED_LABEL_CHECKED(a##_##b##_##c)
+#define THREADED_LABEL_UNCHECKED2(a, b) THREADED_LABEL_UNCHECKED(a##_##b)
+#define THREADED_LABEL_UNCHECKED3(a, b, c) THREADED_LABEL_UNCHECKED(a##_##b##_##c)
+#define THREADED_LABEL_REGISTER(name) THREADED_LABEL_UNCHECKED(R_##name)
+
+#define THREADED_NEXT() \
+    do { \
+        inst = state.pc++; \
+        DISPATCH_PROFILE(*inst); \
+        goto *inst->handler; \
+    } while (0)
+
+#define THREADED_HANDLER(prefix, policy, opcode) \
+    prefix##opcode: { \
+        if (DispatchErr _err = Dispatch_##opcode<policy>(vm, state, *inst); _err != DISPATCH_SUCCESS) return _err; \
+        THREADED_NEXT(); \
+    }
+
+#define THREADED_HANDLER_CHECKED(opcode) THREADED_HANDLER(ThreadedChecked_, CheckedPolicy, opcode)
+#define THREADED_HANDLER_UNCHECKED(opcode) THREADED_HANDLER(ThreadedUnchecked_, UncheckedPolicy, opcode)
+#define THREADED_HANDLER_CHECKED2(a, b) THREADED_HANDLER_CHECKED(a##_##b)
+#define THREADED_HANDLER_CHECKED3(a, b, c) THREADED_HANDLER_CHECKED(a##_##b##_##c)
+#define THREADED_HANDLER_UNCHECKED2(a, b) THREADED_HANDLER_UNCHECKED(a##_##b)
+#define THREADED_HANDLER_UNCHECKED3(a, b, c) THREADED_HANDLER_UNCHECKED(a##_##b##_##c)
+#define THREADED_HANDLER_REGISTER(name) THREADED_HANDLER_UNCHECKED(R_##name)
+
+    // Label addresses only exist inside this function, so BuildDispatchTables calls it with exportLabels set to copy
+    // them out. They're written as the invalid handler, both policies in FOR_EACH_DISPATCH order, then both policies in
+    // FOR_EACH_SUPERINSTRUCTION order, then both in FOR_EACH_BACK_EDGE order, then the unchecked register handlers in
+    // FOR_EACH_REGISTER_OPCODE order. Everything lives in this one loop, so checked, unchecked and register code can call
+    // each other without leaving it
+    static DispatchErr RunThreaded(VM* vmPtr, ExecState* statePtr, DispatchHandler* exportLabels) {
+        static const DispatchHandler labels[] = {
+            &&ThreadedChecked_INVALID,
+            FOR_EACH_DISPATCH(THREADED_LABEL_CHECKED)
+            FOR_EACH_DISPATCH(THREADED_LABEL_UNCHECKED)
+            FOR_EACH_SUPERINSTRUCTION(THREADED_LABEL_CHECKED2, THREADED_LABEL_CHECKED3)
+            FOR_EACH_SUPERINSTRUCTION(THREADED_LABEL_UNCHECKED2, THREADED_LABEL_UNCHECKED3)
+            FOR_EACH_BACK_EDGE(THREADED_LABEL_CHECKED)
+            FOR_EACH_BACK_EDGE(THREADED_LABEL_UNCHECKED)
+            FOR_EACH_REGISTER_OPCODE(THREADED_LABEL_REGISTER)
+        };
+
+        if (exportLabels != nullptr) {
+            std::copy(std::begin(labels), std::end(labels), exportLabels);
+            return DISPATCH_SUCCESS;
+        }
+
+        VM& vm = *vmPtr;
+        ExecState& state = *statePtr;
+        const Instruction* inst;
+
+        THREADED_NEXT();
+
+        FOR_EACH_DISPATCH(THREADED_HANDLER_CHECKED)
+        FOR_EACH_DISPATCH(THREADED_HANDLER_UNCHECKED)
+        FOR_EACH_SUPERINSTRUCTION(THREADED_HANDLER_CHECKED2, THREADED_HANDLER_CHECKED3)
+        FOR_EACH_SUPERINSTRUCTION(THREADED_HANDLER_UNCHECKED2, THREADED_HANDLER_UNCHECKED3)
+        FOR_EACH_BACK_EDGE(THREADED_HANDLER_CHECKED)
+        FOR_EACH_BACK_EDGE(THREADED_HANDLER_UNCHECKED)
+        FOR_EACH_REGISTER_OPCODE(THREADED_HANDLER_REGISTER)
+        THREADED_HANDLER_CHECKED(INVALID)
+    }
+
+    DispatchErr DispatchThreaded(VM& vm, ExecState& state) {
+        return RunThreaded(&vm, &state, nullptr);
+    }
+
+    static DispatchTables BuildDispatchTables(bool checked) {
+        constexpr size_t OpcodeCount = std::size(DispatchOpcodes);
+
+        constexpr size_t BackEdgeCount = std::tuple_size_v<decltype(DispatchTables::backEdges)>;
+
+        std::array<DispatchHandler, 1 + OpcodeCount * 2 + SuperinstructionCount * 2 + BackEdgeCount * 2 + RegisterOpcodeCount> labels;
+        RunThreaded(nullptr, nullptr, labels.data());
+
+        const DispatchHandler* handlers = labels.data() + 1 + (checked ? 0 : OpcodeCount);
+        const DispatchHandler* superinstructions = labels.data() + 1 + OpcodeCount * 2 + (checked ? 0 : SuperinstructionCount);
+        const DispatchHandler* backEdges = labels.data() + 1 + OpcodeCount * 2 + SuperinstructionCount * 2 + (checked ? 0 : BackEdgeCount);
+        const DispatchHandler* registerOps = labels.data() + 1 + OpcodeCount * 2 + SuperinstructionCount * 2 + BackEdgeCount * 2;
+
+        DispatchTables tables;
+        tables.invalidHandler = labels[0];
+        tables.dispatchTable.fill(tables.invalidHandler);
+
+        for (size_t i = 0; i < std::size(DispatchOpcodes); i++) {
+            tables.dispatchTable[static_cast<size_t>(DispatchOpcodes[i])] = handlers[i];
+        }
+
+        std::copy(superinstructions, superinstructions + SuperinstructionCount, tables.superinstructions.begin());
+        std::copy(backEdges, backEdges + BackEdgeCount, tables.backEdges.begin());
+        std::copy(registerOps, registerOps + RegisterOpcodeCount, tables.registerOps.begin());
+
+        return tables;
+    }
+#else
+    DispatchErr DispatchLoop(VM& vm, ExecState& state) {
+        while (true) {
+            const Instruction& inst = *state.pc++;
+            DISPATCH_PROFILE(inst);
+
+            DispatchErr err = inst.handler(vm, state, inst);
+            if (err != DISPATCH_SUCCESS) return err;
+        }
+    }
+
+    template<class Policy>
+    static void RegisterDispatchers(DispatchTables& tables) {
+        DispatchTable& dispatchTable = tables.dispatchTable;
+#define X(opcode) REGISTER_DISPATCH(dispatchTable, Policy, opcode);
+        FOR_EACH_DISPATCH(X)
+#undef X
+
+        size_t superinstruction = 0;
+#define X2(a, b) tables.superinstructions[superinstruction++] = Dispatch_##a##_##b<Policy>;
+#define X3(a, b, c) tables.superinstructions[superinstruction++] = Dispatch_##a##_##b##_##c<Policy>;
+        FOR_EACH_SUPERINSTRUCTION(X2, X3)
+#undef X2
+#undef X3
+
+        size_t backEdge = 0;
+#define X(name) tables.backEdges[backEdge++] = Dispatch_##name<Policy>;
+        FOR_EACH_BACK_EDGE(X)
+#undef X
+
+        size_t registerOp = 0;
+#define X(name) tables.registerOps[registerOp++] = Dispatch_R_##name<UncheckedPolicy>;
+        FOR_EACH_REGISTER_OPCODE(X)
+#undef X
+    }
+
+    static DispatchTables BuildDispatchTables(bool checked) {
+        DispatchTables tables;
+        tables.invalidHandler = Dispatch_INVALID<CheckedPolicy>;
+        tables.dispatchTable.fill(tables.invalidHandler);
+
+        if (checked) RegisterDispatchers<CheckedPolicy>(tables);
+        else RegisterDispatchers<UncheckedPolicy>(tables);
+
+        return tables;
+    }
+#endif
+
+    static DispatchTables BuildAllDispatchTables(bool checked) {
+        static DispatchTable invalidPage;
+
+        DispatchTables tables = BuildDispatchTables(checked);
+
+        // no extended opcode has a handler yet, so every page is the invalid one
+        invalidPage.fill(tables.invalidHandler);
+        tables.dispatchTableExt.pages.fill(&invalidPage);
+
+        return tables;
+    }
+
+    const DispatchTables& GetDispatchTables(bool checked) {
+        static const DispatchTables checkedTables = BuildAllDispatchTables(true);
+        static const DispatchTables uncheckedTables = BuildAllDispatchTables(false);
+
+        return checked ? checkedTables : uncheckedTables;
+    }
+
+    DispatchHandler GetBackEdgeHandler(const DispatchTables& tables, u16 opcode) {
+        if (opcode == static_cast<u16>(ByteOpcode::JMP)) return tables.backEdges[0];
+        if (opcode == static_cast<u16>(ByteOpcode::JZ)) return tables.backEdges[1];
+        if (opcode == static_cast<u16>(ByteOpcode::JNZ)) return tables.backEdges[2];
+
+        return nullptr;
     }
 }
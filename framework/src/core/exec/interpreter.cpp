@@ -1,58 +1,344 @@
 // Copyright 2025 JesusTouchMe
 
 #include "BibbleVM/core/exec/interpreter.h"
+#include "BibbleVM/core/exec/predecoder.h"
+#include "BibbleVM/core/exec/register_code.h"
+#include "BibbleVM/core/exec/superinstruction.h"
+#include "BibbleVM/core/exec/verifier.h"
+
+#include "BibbleVM/core/jit/baseline_compiler.h"
+#include "BibbleVM/core/jit/optimizing_compiler.h"
 
 #include "BibbleVM/core/vm.h"
 
+#include "BibbleVM/util/scoped_value.h"
+
+#include <algorithm>
+#include <limits>
+
 namespace bibble {
-    template<class... Ts>
-    struct overloaded : Ts... { using Ts::operator()...; };
+    // Points every backward JMP, JZ and JNZ at its counting handler. Branch targets are instruction indices in code
+    // order, so a negative offset in the bytecode is a target at or before the branch itself
+    static void InstallBackEdgeCounters(DecodedFunction& function, const DispatchTables& tables, u32 threshold) {
+        for (size_t i = 0; i < function.instructions.size(); i++) {
+            Instruction& instruction = function.instructions[i];
+            if (instruction.handler == tables.invalidHandler || instruction.a > i) continue;
 
-    template<class... Ts>
-    overloaded(Ts...) -> overloaded<Ts...>;
+            DispatchHandler handler = GetBackEdgeHandler(tables, instruction.opcode);
+            if (handler == nullptr) continue;
 
-    Interpreter::Interpreter(const VMConfig& config) {
-        InitDispatchers(config, mDispatchTable, mDispatchTableExt);
+            instruction.handler = handler;
+            instruction.counter = std::max<u32>(threshold, 1);
+        }
     }
 
+    Interpreter::Interpreter(const VMConfig& config)
+        : mTables(GetDispatchTables(config.sandbox || !config.trustBytecode))
+        , mSuperinstructions(config.superinstructions)
+        , mRegisterCode(config.registerCode)
+        , mJit(config.jit && BIBBLEVM_JIT)
+        , mCallThreshold(config.jitCallThreshold)
+        , mBackEdgeThreshold(config.jitBackEdgeThreshold)
+        , mOptimize(config.jitOptimize)
+        , mOptimizeThreshold(config.jitOptimizeThreshold)
+        , mOnTierUp(config.onTierUp)
+        , mNativeStackSize(config.nativeStackSize) {}
+
     u32 Interpreter::getActiveModule() const {
         return mActiveModule;
     }
 
-    void Interpreter::execute(VM& vm, u32 module, BytecodeReader bytecode) {
+    void Interpreter::setActiveModule(u32 module) {
         mActiveModule = module;
-        while (true) {
-            if (vm.hasExited()) {
-                return;
-            }
+    }
+
+    const DecodedFunction* Interpreter::decode(VM& vm, const CallableTarget& target) {
+        if (target.decoded != nullptr) return target.decoded;
+        if (target.host != nullptr) return nullptr; // no bytecode to decode
+
+        Module* module = vm.getModule(target.module);
+        if (module == nullptr) return nullptr;
+
+        size_t entry = target.entry.getPosition();
+
+        const DecodedFunction* function = module->getDecodedFunction(entry);
+        if (function == nullptr) {
+            std::optional<DecodedFunction> decoded = Predecode(module->code(), entry, mTables);
+            if (!decoded.has_value()) return nullptr;
+
+            const DispatchTables* tables = &mTables;
 
-            std::optional<std::variant<ByteOpcode, ExtendedOpcode>> opcode = bytecode.fetchOpcode();
-            if (!opcode.has_value()) {
-                vm.exit(-1);
-                return;
+            // Predecode already checked its operands and branches, this is the rest of what unchecked handlers assume
+            if (VerifyFunction(decoded.value())) {
+                // proven in bounds, so the per-instruction checks can go whatever this VM was configured with
+                tables = &GetDispatchTables(false);
+
+                for (Instruction& instruction : decoded->instructions) {
+                    if (instruction.handler == mTables.invalidHandler) continue;
+                    instruction.handler = tables->dispatchTable[instruction.opcode];
+                }
             }
 
-            DispatchFn dispatch = nullptr;
+            // only verified functions can be compiled, so only they count their loops. before fusion, which leaves the
+            // counting branches alone
+            if (mJit && decoded->verified) InstallBackEdgeCounters(decoded.value(), *tables, mBackEdgeThreshold);
+
+            // after verification, which works on the plain opcodes
+            if (mSuperinstructions) FuseSuperinstructions(decoded.value(), *tables);
+
+            function = module->addDecodedFunction(std::move(decoded.value()));
+        }
+
+        target.decoded = function;
+        target.native = function->native;
+        return function;
+    }
 
-            std::visit(overloaded {
-                        [this, &dispatch](ByteOpcode arg) { dispatch = mDispatchTable[static_cast<size_t>(arg)]; },
-                        [this, &dispatch](ExtendedOpcode arg) { dispatch = mDispatchTableExt[static_cast<size_t>(arg)]; }
-                    }, opcode.value());
+    void Interpreter::countCall(VM& vm, const CallableTarget& target, const DecodedFunction& function, u32 argc) {
+        if (mJit && function.verified) {
+            if (function.native == nullptr && !function.jitRefused && ++function.calls >= mCallThreshold) {
+                tierUp(vm, target.module, function, TierUpEvent::Tier::Baseline, TierUpEvent::Reason::Calls, function.entryIndex, argc);
+            }
 
-            if (dispatch == nullptr) {
-                vm.exit(-1);
-                return;
+            // on the same call if the threshold is 0
+            if (function.native != nullptr && mOptimize && function.optimized.entry == nullptr && !function.optimizeRefused
+                && ++function.calls >= mOptimizeThreshold) {
+                tierUp(vm, target.module, function, TierUpEvent::Tier::Optimized, TierUpEvent::Reason::Calls, function.entryIndex, argc);
             }
+        }
+
+        // null if it was just refused
+        target.native = function.native;
+    }
+
+    void Interpreter::enterCode(const DecodedFunction& function, ExecState& state) {
+        state.code = function.instructions.data();
+        state.pc = state.code + function.entryIndex;
+
+        if (!mRegisterCode || !function.verified) return;
+
+        if (function.registers.instructions.empty() && !function.registersRefused) {
+            // only while interpreted, so this is where back-edges count towards compiling the function
+            std::optional<u32> backEdgeThreshold;
+            if (mJit) backEdgeThreshold = mBackEdgeThreshold;
+
+            std::optional<RegisterCode> registers = TranslateToRegisters(function, GetDispatchTables(false), static_cast<u32>(state.sp - state.frame), backEdgeThreshold);
+            if (registers.has_value()) function.registers = std::move(registers.value());
+            else function.registersRefused = true;
+        }
+
+        const RegisterCode& registers = function.registers;
+        if (!registers.canEnter(state.frame, state.sp, state.limit)) return;
+
+        state.code = registers.instructions.data();
+        state.pc = state.code + registers.entryIndex;
+    }
+
+    void Interpreter::leaveRegisterCode(VM& vm, ExecState& state, const Instruction& branch) {
+        const DecodedFunction* function = vm.getModule(mActiveModule)->findDecodedFunction(state.code);
+        const RegisterCode& registers = function->registers;
+        const RegisterOrigin& origin = registers.origins[static_cast<size_t>(&branch - state.code)];
+
+        // every value is in its slot at a block boundary, acc too if the stack form reads it from there
+        state.acc = state.frame[registers.accSlot];
+        state.sp = state.frame + origin.height;
+        state.code = function->instructions.data();
+        state.pc = state.code + origin.instruction;
+    }
+
+    DispatchErr Interpreter::enterCompiledLoop(VM& vm, ExecState& state, const Instruction& branch) {
+        const DecodedFunction* function = vm.getModule(mActiveModule)->findDecodedFunction(state.code);
+        u32 header = static_cast<u32>(state.pc - state.code);
+
+        if (function->native == nullptr && !function->jitRefused) {
+            tierUp(vm, mActiveModule, *function, TierUpEvent::Tier::Baseline, TierUpEvent::Reason::BackEdges, header, static_cast<u64>(state.sp - state.frame));
+        }
+
+        const NativeCode* code = function->nativeCode();
+        if (code == nullptr) {
+            branch.counter = std::numeric_limits<u32>::max(); // as good as never again
+            return DISPATCH_SUCCESS;
+        }
+
+        // baseline code counts down the same counter towards the optimizing tier
+        branch.counter = std::max<u32>(mOptimize ? mOptimizeThreshold : mBackEdgeThreshold, 1);
+        if (!canEnterCompiled()) return DISPATCH_SUCCESS; // the interpreter doesn't need native stack to keep going
+
+        // optimized code can only resume at loop headers, which this is, and turns away frames it wasn't made for
+        DispatchErr err = DISPATCH_SUCCESS;
+        if (code->canResume(header)) err = code->resume(vm, state, code->resumeAddress(header));
+        if (err == DISPATCH_SUCCESS && code != &function->baseline) {
+            err = function->baseline.resume(vm, state, function->baseline.resumeAddress(header));
+        }
+
+        return err;
+    }
+
+    DispatchErr Interpreter::enterOptimizedLoop(VM& vm, ExecState& state, const Instruction& branch) {
+        const DecodedFunction* function = vm.getModule(mActiveModule)->findDecodedFunction(state.code);
+        u32 header = branch.a; // compiled code doesn't keep state.pc
+
+        if (function->optimized.entry == nullptr && !function->optimizeRefused) {
+            tierUp(vm, mActiveModule, *function, TierUpEvent::Tier::Optimized, TierUpEvent::Reason::BackEdges, header, static_cast<u64>(state.sp - state.frame));
+        }
+
+        const NativeCode& code = function->optimized;
+        if (code.entry == nullptr || !code.canResume(header)) {
+            branch.counter = std::numeric_limits<u32>::max();
+            return DISPATCH_SUCCESS;
+        }
+
+        branch.counter = std::max<u32>(mOptimizeThreshold, 1);
+        if (!canEnterCompiled()) return DISPATCH_SUCCESS;
+
+        // DISPATCH_SUCCESS if it turned the frame away, which leaves it to the baseline code that's running it
+        return code.resume(vm, state, code.resumeAddress(header));
+    }
+
+    void Interpreter::tierUp(VM& vm, u32 module, const DecodedFunction& function, TierUpEvent::Tier tier, TierUpEvent::Reason reason, u32 instruction, u64 height) {
+        bool compiled;
+
+        if (tier == TierUpEvent::Tier::Baseline) {
+            // only verified functions are tiered, and they always run on the unchecked handlers
+            const DispatchTables& tables = GetDispatchTables(false);
 
-            DispatchErr err = dispatch(vm, bytecode);
-            if (err == DISPATCH_SUCCESS) {
-                continue;
-            } else if (err == DISPATCH_RETURN) {
-                return;
-            } else {
-                vm.exit(-1);
-                return;
+            compiled = CompileBaseline(function, tables, mOptimize);
+            if (!compiled) function.jitRefused = true;
+
+            // the baseline code counts the same back-edges towards the optimizing tier, from the start
+            if (compiled && mOptimize) {
+                for (const Instruction& branch : function.instructions) {
+                    if (branch.handler == GetBackEdgeHandler(tables, branch.opcode)) {
+                        branch.counter = std::max<u32>(mOptimizeThreshold, 1);
+                    }
+                }
             }
+
+            function.calls = 0; // from here on they count towards the optimizing tier
+        } else {
+            compiled = CompileOptimized(vm, module, function, GetDispatchTables(false), instruction, height);
+            if (!compiled) function.optimizeRefused = true;
+        }
+
+        if (mOnTierUp) {
+            mOnTierUp(TierUpEvent{
+                .reason = reason,
+                .tier = tier,
+                .module = module,
+                .entry = function.entry,
+                .instruction = instruction,
+                .compiled = compiled,
+            });
+        }
+    }
+
+    void Interpreter::execute(VM& vm, const CallableTarget& target) {
+        // the outermost one is where the native stack nested calls take is counted from
+        u8 base;
+        util::ScopedValue<const u8*> nativeBase(mNativeBase, mNativeBase != nullptr ? mNativeBase : &base);
+
+        // each gets a guard of its own, as there may be host frames between it and the one it's nested in, which a fault
+        // caught there would skip without unwinding them
+        u32 previousModule = mActiveModule;
+
+        if (!vm.stack().runGuarded([&] { run(vm, target); })) {
+            // something ran into the guard pages. Whatever it was is abandoned where it was, like a failed bounds check,
+            // and whoever called this unwinds like usual from here on
+            mActiveModule = previousModule;
+            vm.exit(-2);
+        }
+    }
+
+    void Interpreter::run(VM& vm, const CallableTarget& target) {
+        if (vm.hasExited()) return;
+
+        const DecodedFunction* function = decode(vm, target);
+        if (function == nullptr) {
+            vm.exit(-1);
+            return;
+        }
+
+        const Instruction* code = function->instructions.data();
+        Stack& stack = vm.stack();
+        Value* slots = stack.data();
+
+        if (!function->canEnter(slots + stack.sb(), slots + stack.sp().integer(), slots + stack.capacity())) {
+            vm.exit(-2);
+            return;
+        }
+
+        if (nativeStackUsed() > mNativeStackSize) {
+            vm.exit(-2);
+            return;
         }
+
+        util::ScopedValue<u32> module(mActiveModule, target.module);
+
+        ExecState state = {
+            .pc = code + function->entryIndex,
+            .code = code,
+            .acc = vm.acc(),
+            .sp = slots + stack.sp().integer(),
+            .frame = slots + stack.sb(),
+            .stack = slots,
+            .limit = slots + stack.capacity(),
+        };
+
+        // every call that runs compiled code comes through here, so this is where those count towards optimizing it
+        countCall(vm, target, *function, static_cast<u32>(state.sp - state.frame));
+
+        DispatchErr err;
+
+        // past the point where compiled code may run, its function is interpreted like it was never compiled
+        if (target.native != nullptr && canEnterCompiled()) {
+            err = target.native(vm, state);
+        } else {
+            enterCode(*function, state);
+
+#if BIBBLEVM_THREADED_DISPATCH
+            err = DispatchThreaded(vm, state);
+#else
+            err = DispatchLoop(vm, state);
+#endif
+        }
+
+        vm.acc() = state.acc;
+        stack.sp().integer() = state.sp - slots;
+
+        if (err == DISPATCH_ERROR) {
+            vm.exit(-1);
+        }
+    }
+
+    bool Interpreter::setNativeCode(VM& vm, const CallableTarget& target, NativeEntry native) {
+        const DecodedFunction* function = decode(vm, target);
+        if (function == nullptr || !function->verified) return false;
+
+        function->native = native;
+        function->jitRefused = true;
+        function->optimizeRefused = true;
+
+        target.native = native;
+        return true;
+    }
+
+    DispatchErr Interpreter::executeNative(VM& vm, ExecState& state, NativeEntry native) {
+        if (nativeStackUsed() > mNativeStackSize) {
+            vm.exit(-2);
+            return DISPATCH_ERROR;
+        }
+
+        return native(vm, state);
+    }
+
+    bool Interpreter::canEnterCompiled() const {
+        return nativeStackUsed() < mNativeStackSize / 2;
+    }
+
+    size_t Interpreter::nativeStackUsed() const {
+        if (mNativeBase == nullptr) return 0;
+
+        u8 top;
+        return static_cast<size_t>(reinterpret_cast<uintptr_t>(mNativeBase) - reinterpret_cast<uintptr_t>(&top));
     }
 }
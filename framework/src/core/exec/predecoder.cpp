@@ -0,0 +1,230 @@
+// Copyright 2025 JesusTouchMe
+
+#include "BibbleVM/core/exec/predecoder.h"
+
+#include "BibbleVM/core/bytecode/operand_layout.h"
+
+#include <algorithm>
+#include <unordered_map>
+
+namespace bibble {
+    struct RawInstruction {
+        size_t offset;
+        size_t length;
+        Instruction instruction;
+        bool fallsThrough;
+        std::optional<size_t> branchTarget; // code section offset
+    };
+
+    // Reads operands into the instruction. Returns false if they're cut off by the end of the code section
+    static bool ReadOperands(BytecodeReader& reader, OperandLayout layout, RawInstruction& raw) {
+        Instruction& instruction = raw.instruction;
+
+        switch (layout) {
+            case OperandLayout::None:
+                return true;
+
+            case OperandLayout::ImmI8: {
+                std::optional<i8> value = reader.fetchI8();
+                if (!value.has_value()) return false;
+                instruction.imm = static_cast<i64>(value.value());
+                return true;
+            }
+
+            case OperandLayout::ImmI32: {
+                std::optional<i32> value = reader.fetchI32();
+                if (!value.has_value()) return false;
+                instruction.imm = static_cast<i64>(value.value());
+                return true;
+            }
+
+            case OperandLayout::ImmI64: {
+                std::optional<i64> value = reader.fetchI64();
+                if (!value.has_value()) return false;
+                instruction.imm = value.value();
+                return true;
+            }
+
+            case OperandLayout::ImmF32: {
+                std::optional<float> value = reader.fetchFloat();
+                if (!value.has_value()) return false;
+                instruction.imm = static_cast<double>(value.value());
+                return true;
+            }
+
+            case OperandLayout::IndexU8: {
+                std::optional<u8> value = reader.fetchU8();
+                if (!value.has_value()) return false;
+                instruction.a = value.value();
+                return true;
+            }
+
+            case OperandLayout::IndexI16: {
+                std::optional<i16> value = reader.fetchI16();
+                if (!value.has_value()) return false;
+                instruction.a = static_cast<u32>(static_cast<i32>(value.value()));
+                return true;
+            }
+
+            case OperandLayout::Branch: {
+                std::optional<i16> branch = reader.fetchI16();
+                if (!branch.has_value()) return false;
+
+                i64 target = static_cast<i64>(reader.getPosition()) + branch.value();
+                if (target < 0 || target > static_cast<i64>(reader.getSize())) return false;
+
+                raw.branchTarget = static_cast<size_t>(target);
+                return true;
+            }
+
+            case OperandLayout::CallU32U8: {
+                std::optional<u32> target = reader.fetchU32();
+                std::optional<u8> argc = reader.fetchU8();
+                if (!target.has_value() || !argc.has_value()) return false;
+                instruction.a = target.value();
+                instruction.b = argc.value();
+                instruction.target = nullptr;
+                return true;
+            }
+
+            case OperandLayout::CallU32U16: {
+                std::optional<u32> target = reader.fetchU32();
+                std::optional<u16> argc = reader.fetchU16();
+                if (!target.has_value() || !argc.has_value()) return false;
+                instruction.a = target.value();
+                instruction.b = argc.value();
+                instruction.target = nullptr;
+                return true;
+            }
+
+            case OperandLayout::CallU16U8: {
+                std::optional<u16> target = reader.fetchU16();
+                std::optional<u8> argc = reader.fetchU8();
+                if (!target.has_value() || !argc.has_value()) return false;
+                instruction.a = target.value();
+                instruction.b = argc.value();
+                instruction.target = nullptr;
+                return true;
+            }
+
+            case OperandLayout::CallU16U16: {
+                std::optional<u16> target = reader.fetchU16();
+                std::optional<u16> argc = reader.fetchU16();
+                if (!target.has_value() || !argc.has_value()) return false;
+                instruction.a = target.value();
+                instruction.b = argc.value();
+                instruction.target = nullptr;
+                return true;
+            }
+
+            case OperandLayout::CallDyn: {
+                std::optional<u16> argc = reader.fetchU16();
+                if (!argc.has_value()) return false;
+                instruction.b = argc.value();
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    static std::optional<RawInstruction> DecodeAt(const CodeSection& code, size_t offset, const DispatchTables& tables) {
+        std::optional<BytecodeReader> readerOpt = code.getBytecodeReader(offset);
+        if (!readerOpt.has_value()) return std::nullopt;
+
+        BytecodeReader& reader = readerOpt.value();
+
+        RawInstruction raw = { offset, 0, { tables.invalidHandler }, false, std::nullopt };
+
+        std::optional<u8> opcodeByte = reader.fetchU8();
+        if (!opcodeByte.has_value()) return std::nullopt;
+
+        if (opcodeByte.value() == 0xFF) {
+            // no extended opcode defines its operands yet, so nothing after one can be decoded
+            std::optional<u16> extendedOpcode = reader.fetchU16();
+            if (!extendedOpcode.has_value()) return std::nullopt;
+
+            raw.instruction.handler = tables.dispatchTableExt[extendedOpcode.value()];
+            raw.instruction.opcode = opcodeByte.value();
+
+            raw.length = reader.getPosition() - offset;
+            return raw;
+        }
+
+        ByteOpcode opcode = static_cast<ByteOpcode>(opcodeByte.value());
+        raw.instruction.opcode = opcodeByte.value();
+
+        std::optional<OperandLayout> layout = GetOperandLayout(opcode);
+        if (!layout.has_value()) { // unknown opcode, fails when executed
+            raw.length = 1;
+            return raw;
+        }
+
+        if (!ReadOperands(reader, layout.value(), raw)) return std::nullopt;
+
+        raw.instruction.handler = tables.dispatchTable[opcodeByte.value()];
+        raw.length = reader.getPosition() - offset;
+        raw.fallsThrough = !IsTerminator(opcode);
+
+        return raw;
+    }
+
+    std::optional<DecodedFunction> Predecode(const CodeSection& code, size_t entry, const DispatchTables& tables) {
+        size_t codeSize = code.getSize();
+        if (entry >= codeSize) return std::nullopt;
+
+        std::vector<RawInstruction> raws;
+        std::unordered_map<size_t, size_t> indices; // code offset -> index into raws
+        std::vector<size_t> worklist = { entry };
+
+        while (!worklist.empty()) {
+            size_t offset = worklist.back();
+            worklist.pop_back();
+
+            if (indices.contains(offset)) continue;
+
+            std::optional<RawInstruction> raw = DecodeAt(code, offset, tables);
+            if (!raw.has_value()) return std::nullopt;
+
+            indices.emplace(offset, raws.size());
+            raws.push_back(raw.value());
+
+            // a successor at exactly codeSize runs off the end and is mapped to the trailing invalid instruction
+            if (raw->branchTarget.has_value() && raw->branchTarget.value() < codeSize) {
+                worklist.push_back(raw->branchTarget.value());
+            }
+
+            if (raw->fallsThrough && offset + raw->length < codeSize) {
+                worklist.push_back(offset + raw->length);
+            }
+        }
+
+        std::sort(raws.begin(), raws.end(), [](const RawInstruction& a, const RawInstruction& b) { return a.offset < b.offset; });
+
+        for (size_t i = 0; i < raws.size(); i++) {
+            if (i + 1 < raws.size() && raws[i].offset + raws[i].length > raws[i + 1].offset) {
+                return std::nullopt; // something branches into the middle of an instruction
+            }
+
+            indices[raws[i].offset] = i;
+        }
+
+        DecodedFunction function;
+        function.entry = entry;
+        function.entryIndex = static_cast<u32>(indices[entry]);
+        function.instructions.reserve(raws.size() + 1);
+
+        for (RawInstruction& raw : raws) {
+            if (raw.branchTarget.has_value()) {
+                size_t target = raw.branchTarget.value();
+                raw.instruction.a = static_cast<u32>(target == codeSize ? raws.size() : indices[target]);
+            }
+
+            function.instructions.push_back(raw.instruction);
+        }
+
+        function.instructions.push_back({ tables.invalidHandler });
+
+        return function;
+    }
+}
@@ -0,0 +1,794 @@
+// Copyright 2025 JesusTouchMe
+
+#include "BibbleVM/core/exec/register_code.h"
+#include "BibbleVM/core/exec/dispatch.h"
+#include "BibbleVM/core/exec/instruction.h"
+#include "BibbleVM/core/exec/verifier.h"
+
+#include "BibbleVM/core/bytecode/operand_layout.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace bibble {
+    // Operations the translation holds back until something needs their result
+    enum class Operation : u8 {
+        Add, Sub, Mul, Div, Mod, And, Or, Xor, Shl, Shr,
+        FAdd, FSub, FMul, FDiv,
+        Eq, Ne, Lt, Gt, Le, Ge,
+        FEq, FNe, FLt, FGt, FLe, FGe,
+        Neg, Not, FNeg,
+    };
+
+    struct OperationInfo {
+        RegisterOpcode ss; // the S form for unary operations
+        RegisterOpcode si;
+        bool unary = false;
+        std::optional<Operation> swapped; // gives the same result with its operands the other way around
+        std::optional<RegisterOpcode> branchSS; // compares only. branches if the compare is true
+        std::optional<RegisterOpcode> branchSI;
+        std::optional<Operation> inverse; // true exactly when this is false. not for float compares, which NaN breaks
+    };
+
+    static OperationInfo GetOperationInfo(Operation operation) {
+        using enum RegisterOpcode;
+
+        switch (operation) {
+            case Operation::Add: return { ADD_SS, ADD_SI, false, Operation::Add };
+            case Operation::Sub: return { SUB_SS, SUB_SI };
+            case Operation::Mul: return { MUL_SS, MUL_SI, false, Operation::Mul };
+            case Operation::Div: return { DIV_SS, DIV_SI };
+            case Operation::Mod: return { MOD_SS, MOD_SI };
+            case Operation::And: return { AND_SS, AND_SI, false, Operation::And };
+            case Operation::Or: return { OR_SS, OR_SI, false, Operation::Or };
+            case Operation::Xor: return { XOR_SS, XOR_SI, false, Operation::Xor };
+            case Operation::Shl: return { SHL_SS, SHL_SI };
+            case Operation::Shr: return { SHR_SS, SHR_SI };
+
+            case Operation::FAdd: return { FADD_SS, FADD_SI, false, Operation::FAdd };
+            case Operation::FSub: return { FSUB_SS, FSUB_SI };
+            case Operation::FMul: return { FMUL_SS, FMUL_SI, false, Operation::FMul };
+            case Operation::FDiv: return { FDIV_SS, FDIV_SI };
+
+            case Operation::Eq: return { EQ_SS, EQ_SI, false, Operation::Eq, JEQ_SS, JEQ_SI, Operation::Ne };
+            case Operation::Ne: return { NE_SS, NE_SI, false, Operation::Ne, JNE_SS, JNE_SI, Operation::Eq };
+            case Operation::Lt: return { LT_SS, LT_SI, false, Operation::Gt, JLT_SS, JLT_SI, Operation::Ge };
+            case Operation::Gt: return { GT_SS, GT_SI, false, Operation::Lt, JGT_SS, JGT_SI, Operation::Le };
+            case Operation::Le: return { LE_SS, LE_SI, false, Operation::Ge, JLE_SS, JLE_SI, Operation::Gt };
+            case Operation::Ge: return { GE_SS, GE_SI, false, Operation::Le, JGE_SS, JGE_SI, Operation::Lt };
+
+            case Operation::FEq: return { FEQ_SS, FEQ_SI, false, Operation::FEq, JFEQ_SS, JFEQ_SI };
+            case Operation::FNe: return { FNE_SS, FNE_SI, false, Operation::FNe, JFNE_SS, JFNE_SI };
+            case Operation::FLt: return { FLT_SS, FLT_SI, false, Operation::FGt, JFLT_SS, JFLT_SI };
+            case Operation::FGt: return { FGT_SS, FGT_SI, false, Operation::FLt, JFGT_SS, JFGT_SI };
+            case Operation::FLe: return { FLE_SS, FLE_SI, false, Operation::FGe, JFLE_SS, JFLE_SI };
+            case Operation::FGe: return { FGE_SS, FGE_SI, false, Operation::FLe, JFGE_SS, JFGE_SI };
+
+            case Operation::Neg: return { NEG_S, NEG_S, true };
+            case Operation::Not: return { NOT_S, NOT_S, true };
+            case Operation::FNeg: return { FNEG_S, FNEG_S, true };
+        }
+
+        return {};
+    }
+
+    // The operation of the stack form's arithmetic and compares, whichever operands they take
+    static std::optional<Operation> GetOperation(ByteOpcode opcode) {
+        switch (opcode) {
+            case ByteOpcode::ADD: case ByteOpcode::ADD2: case ByteOpcode::ADD_ST: case ByteOpcode::ADD_IMM: case ByteOpcode::ADD_IMM_ST: return Operation::Add;
+            case ByteOpcode::SUB: case ByteOpcode::SUB2: case ByteOpcode::SUB_ST: case ByteOpcode::SUB_IMM: case ByteOpcode::SUB_IMM_ST: return Operation::Sub;
+            case ByteOpcode::MUL: case ByteOpcode::MUL2: case ByteOpcode::MUL_ST: case ByteOpcode::MUL_IMM: case ByteOpcode::MUL_IMM_ST: return Operation::Mul;
+            case ByteOpcode::DIV: case ByteOpcode::DIV2: case ByteOpcode::DIV_ST: case ByteOpcode::DIV_IMM: case ByteOpcode::DIV_IMM_ST: return Operation::Div;
+            case ByteOpcode::MOD: case ByteOpcode::MOD2: case ByteOpcode::MOD_ST: case ByteOpcode::MOD_IMM: case ByteOpcode::MOD_IMM_ST: return Operation::Mod;
+            case ByteOpcode::AND: case ByteOpcode::AND2: case ByteOpcode::AND_ST: case ByteOpcode::AND_IMM: case ByteOpcode::AND_IMM_ST: return Operation::And;
+            case ByteOpcode::OR: case ByteOpcode::OR2: case ByteOpcode::OR_ST: case ByteOpcode::OR_IMM: case ByteOpcode::OR_IMM_ST: return Operation::Or;
+            case ByteOpcode::XOR: case ByteOpcode::XOR2: case ByteOpcode::XOR_ST: case ByteOpcode::XOR_IMM: case ByteOpcode::XOR_IMM_ST: return Operation::Xor;
+            case ByteOpcode::SHL: case ByteOpcode::SHL2: case ByteOpcode::SHL_ST: case ByteOpcode::SHL_IMM: case ByteOpcode::SHL_IMM_ST: return Operation::Shl;
+            case ByteOpcode::SHR: case ByteOpcode::SHR2: case ByteOpcode::SHR_ST: case ByteOpcode::SHR_IMM: case ByteOpcode::SHR_IMM_ST: return Operation::Shr;
+            case ByteOpcode::NEG: case ByteOpcode::NEG_ST: return Operation::Neg;
+            case ByteOpcode::NOT: case ByteOpcode::NOT_ST: return Operation::Not;
+
+            case ByteOpcode::FADD: case ByteOpcode::FADD2: case ByteOpcode::FADD_ST: case ByteOpcode::FADD_IMM: case ByteOpcode::FADD_IMM_ST: return Operation::FAdd;
+            case ByteOpcode::FSUB: case ByteOpcode::FSUB2: case ByteOpcode::FSUB_ST: case ByteOpcode::FSUB_IMM: case ByteOpcode::FSUB_IMM_ST: return Operation::FSub;
+            case ByteOpcode::FMUL: case ByteOpcode::FMUL2: case ByteOpcode::FMUL_ST: case ByteOpcode::FMUL_IMM: case ByteOpcode::FMUL_IMM_ST: return Operation::FMul;
+            case ByteOpcode::FDIV: case ByteOpcode::FDIV2: case ByteOpcode::FDIV_ST: case ByteOpcode::FDIV_IMM: case ByteOpcode::FDIV_IMM_ST: return Operation::FDiv;
+            case ByteOpcode::FNEG: return Operation::FNeg;
+
+            case ByteOpcode::CMP_EQ: case ByteOpcode::CMP_EQ0: return Operation::Eq;
+            case ByteOpcode::CMP_NE: case ByteOpcode::CMP_NE0: return Operation::Ne;
+            case ByteOpcode::CMP_LT: case ByteOpcode::CMP_LT0: return Operation::Lt;
+            case ByteOpcode::CMP_GT: case ByteOpcode::CMP_GT0: return Operation::Gt;
+            case ByteOpcode::CMP_LTE: case ByteOpcode::CMP_LTE0: return Operation::Le;
+            case ByteOpcode::CMP_GTE: case ByteOpcode::CMP_GTE0: return Operation::Ge;
+            case ByteOpcode::FCMP_EQ: case ByteOpcode::FCMP_EQ0: return Operation::FEq;
+            case ByteOpcode::FCMP_NE: case ByteOpcode::FCMP_NE0: return Operation::FNe;
+            case ByteOpcode::FCMP_LT: case ByteOpcode::FCMP_LT0: return Operation::FLt;
+            case ByteOpcode::FCMP_GT: case ByteOpcode::FCMP_GT0: return Operation::FGt;
+            case ByteOpcode::FCMP_LTE: case ByteOpcode::FCMP_LTE0: return Operation::FLe;
+            case ByteOpcode::FCMP_GTE: case ByteOpcode::FCMP_GTE0: return Operation::FGe;
+
+            default:
+                return std::nullopt;
+        }
+    }
+
+    // How an instruction uses acc, for the liveness that lets dead acc values go unwritten
+    enum class AccEffect {
+        None,
+        Read, // and maybe writes it
+        Write, // without reading it first
+    };
+
+    static AccEffect GetAccEffect(ByteOpcode opcode) {
+        switch (opcode) {
+            case ByteOpcode::ADD2: case ByteOpcode::SUB2: case ByteOpcode::MUL2: case ByteOpcode::DIV2: case ByteOpcode::MOD2:
+            case ByteOpcode::AND2: case ByteOpcode::OR2: case ByteOpcode::XOR2: case ByteOpcode::SHL2: case ByteOpcode::SHR2:
+            case ByteOpcode::FADD2: case ByteOpcode::FSUB2: case ByteOpcode::FMUL2: case ByteOpcode::FDIV2:
+            case ByteOpcode::POP_ACC: case ByteOpcode::LOAD:
+            case ByteOpcode::CONST: case ByteOpcode::CONST32: case ByteOpcode::CONST64:
+                return AccEffect::Write;
+
+            case ByteOpcode::ADD_ST: case ByteOpcode::SUB_ST: case ByteOpcode::MUL_ST: case ByteOpcode::DIV_ST: case ByteOpcode::MOD_ST:
+            case ByteOpcode::AND_ST: case ByteOpcode::OR_ST: case ByteOpcode::XOR_ST: case ByteOpcode::SHL_ST: case ByteOpcode::SHR_ST:
+            case ByteOpcode::FADD_ST: case ByteOpcode::FSUB_ST: case ByteOpcode::FMUL_ST: case ByteOpcode::FDIV_ST:
+            case ByteOpcode::NEG_ST: case ByteOpcode::NOT_ST:
+            case ByteOpcode::ADD_IMM_ST: case ByteOpcode::SUB_IMM_ST: case ByteOpcode::MUL_IMM_ST: case ByteOpcode::DIV_IMM_ST:
+            case ByteOpcode::MOD_IMM_ST: case ByteOpcode::AND_IMM_ST: case ByteOpcode::OR_IMM_ST: case ByteOpcode::XOR_IMM_ST:
+            case ByteOpcode::SHL_IMM_ST: case ByteOpcode::SHR_IMM_ST:
+            case ByteOpcode::FADD_IMM_ST: case ByteOpcode::FSUB_IMM_ST: case ByteOpcode::FMUL_IMM_ST: case ByteOpcode::FDIV_IMM_ST:
+            case ByteOpcode::CONST_ST: case ByteOpcode::CONST32_ST: case ByteOpcode::CONST64_ST:
+            case ByteOpcode::LOAD_ST: case ByteOpcode::STORE_ST:
+            case ByteOpcode::POP_DISCARD: case ByteOpcode::RESERVE:
+            case ByteOpcode::NOP: case ByteOpcode::BRK: case ByteOpcode::JMP:
+                return AccEffect::None;
+
+            default:
+                return AccEffect::Read; // calls and traps see acc too
+        }
+    }
+
+    // A plain value: a frame slot as it is in memory right now, or an immediate
+    struct Operand {
+        bool immediate = false;
+        u32 slot = 0;
+        Value imm;
+    };
+
+    // What a stack position or acc holds. An operand, or an operation on operands that hasn't been emitted yet
+    struct Symbol {
+        std::optional<Operation> operation;
+        Operand x; // always a slot for operations
+        Operand y; // binary operations only
+    };
+
+    static Symbol SlotSymbol(u32 slot) {
+        return { std::nullopt, { false, slot, Value() }, {} };
+    }
+
+    static Symbol ImmediateSymbol(Value imm) {
+        return { std::nullopt, { true, 0, imm }, {} };
+    }
+
+    static bool ReadsSlot(const Symbol& symbol, u32 slot) {
+        if (!symbol.x.immediate && symbol.x.slot == slot) return true;
+        if (!symbol.operation.has_value() || GetOperationInfo(symbol.operation.value()).unary) return false;
+
+        return !symbol.y.immediate && symbol.y.slot == slot;
+    }
+
+    // Symbolic execution of the stack form, one block at a time. Holders are the stack positions below the current height
+    // and acc, and each has a home: its own slot, or accSlot for acc. At every block boundary each holder is in its home,
+    // in between they may hold anything a Symbol can describe
+    class RegisterTranslator {
+    public:
+        RegisterTranslator(const DecodedFunction& function, const DispatchTables& tables, u32 args, std::optional<u32> backEdgeThreshold)
+            : mFunction(function)
+            , mTables(tables)
+            , mArgs(args)
+            , mBackEdgeThreshold(backEdgeThreshold) {}
+
+        std::optional<RegisterCode> run() {
+            const std::vector<Instruction>& instructions = mFunction.instructions;
+
+            if (!mFunction.verified || mArgs < mFunction.minArgs) return std::nullopt;
+
+            // heights and source slots go in b, the scratch slot included
+            u64 accSlot = u64(mArgs) + mFunction.maxGrowth;
+            if (accSlot + 1 > std::numeric_limits<u16>::max()) return std::nullopt;
+
+            mAccSlot = static_cast<u32>(accSlot);
+            mDepths = GetStackDepths(mFunction);
+
+            // an entry prologue can't be fallen into
+            u32 entry = mFunction.entryIndex;
+            if (entry > 0 && mDepths[entry - 1].has_value() && fallsThrough(entry - 1)) return std::nullopt;
+
+            findLeaders();
+            computeLiveness();
+
+            mSymbols.assign(mAccSlot + 1, Symbol());
+            mWriting.assign(mAccSlot + 2, false);
+            mIndices.assign(instructions.size(), 0);
+
+            mCode.args = mArgs;
+            mCode.accSlot = mAccSlot;
+
+            for (size_t index = 0; index < instructions.size() && !mFailed; index++) {
+                if (!mDepths[index].has_value()) continue;
+
+                if (mLeaders[index]) startBlock(index);
+                translate(index);
+
+                // a block that falls into the next one leaves everything in its home
+                if (index + 1 < instructions.size() && mLeaders[index + 1] && fallsThrough(index)) flush(mLive[index + 1]);
+            }
+
+            if (mFailed) return std::nullopt;
+
+            for (const auto& [branch, target] : mBranches) {
+                mCode.instructions[branch].a = mIndices[target];
+            }
+
+            return std::move(mCode);
+        }
+
+    private:
+        static constexpr u32 NoHolder = std::numeric_limits<u32>::max();
+
+        const DecodedFunction& mFunction;
+        const DispatchTables& mTables;
+        u32 mArgs;
+        std::optional<u32> mBackEdgeThreshold;
+
+        u32 mAccSlot = 0;
+        std::vector<std::optional<i64>> mDepths;
+        std::vector<bool> mLeaders;
+        std::vector<bool> mLive; // acc is read before it's written again, from before each instruction on
+        std::vector<bool> mExposed; // slots some RESERVE hands back with whatever they held. by slot
+
+        RegisterCode mCode;
+        std::vector<u32> mIndices; // register instruction each instruction's block starts at
+        std::vector<std::pair<size_t, u32>> mBranches; // register branches and the instruction they go to
+
+        std::vector<Symbol> mSymbols; // by home
+        u32 mHeight = 0;
+        std::vector<bool> mWriting; // slots being written, to catch holders that need each other's slots. scratch included
+        bool mFailed = false;
+
+        ByteOpcode opcodeAt(size_t index) const {
+            return GetLeadingOpcode(mFunction.instructions[index].opcode);
+        }
+
+        bool isInvalid(size_t index) const {
+            return mFunction.instructions[index].handler == mTables.invalidHandler;
+        }
+
+        bool isBranch(size_t index) const {
+            return !isInvalid(index) && GetOperandLayout(opcodeAt(index)) == OperandLayout::Branch;
+        }
+
+        bool fallsThrough(size_t index) const {
+            return isInvalid(index) || !IsTerminator(opcodeAt(index));
+        }
+
+        u32 heightAt(size_t index) const {
+            return static_cast<u32>(mArgs + mDepths[index].value());
+        }
+
+        void findLeaders() {
+            const std::vector<Instruction>& instructions = mFunction.instructions;
+
+            mLeaders.assign(instructions.size(), false);
+            mExposed.assign(mAccSlot + 1, false);
+            mLeaders[mFunction.entryIndex] = true;
+
+            for (size_t index = 0; index < instructions.size(); index++) {
+                if (!mDepths[index].has_value()) continue;
+
+                if (isBranch(index)) {
+                    mLeaders[instructions[index].a] = true;
+                    if (index + 1 < instructions.size()) mLeaders[index + 1] = true;
+                } else if (!fallsThrough(index) && index + 1 < instructions.size()) {
+                    mLeaders[index + 1] = true;
+                }
+
+                if (!isInvalid(index) && opcodeAt(index) == ByteOpcode::RESERVE) {
+                    u32 height = heightAt(index);
+                    for (u32 slot = height; slot < height + instructions[index].a; slot++) mExposed[slot] = true;
+                }
+            }
+        }
+
+        void computeLiveness() {
+            const std::vector<Instruction>& instructions = mFunction.instructions;
+            mLive.assign(instructions.size(), false);
+
+            bool changed = true;
+            while (changed) {
+                changed = false;
+
+                for (size_t index = instructions.size(); index-- > 0;) {
+                    AccEffect effect = isInvalid(index) ? AccEffect::Read : GetAccEffect(opcodeAt(index));
+
+                    bool out = false;
+                    if (isBranch(index)) out = mLive[instructions[index].a];
+                    if (fallsThrough(index) && index + 1 < instructions.size()) out = out || mLive[index + 1];
+
+                    bool live = effect == AccEffect::Read || (effect == AccEffect::None && out);
+                    if (live != mLive[index]) {
+                        mLive[index] = live;
+                        changed = true;
+                    }
+                }
+            }
+        }
+
+        bool liveAfter(size_t index) const {
+            return index + 1 < mLive.size() && mLive[index + 1];
+        }
+
+        size_t emit(RegisterOpcode opcode, u32 a = 0, u32 b = 0, Value imm = Value()) {
+            Instruction instruction;
+            instruction.handler = mTables.registerOps[static_cast<size_t>(opcode)];
+            instruction.a = a;
+            instruction.b = static_cast<u16>(b);
+            instruction.opcode = static_cast<u16>(RegisterOpcodeBase + static_cast<u16>(opcode));
+            instruction.imm = imm;
+
+            mCode.instructions.push_back(instruction);
+            mCode.origins.emplace_back();
+
+            return mCode.instructions.size() - 1;
+        }
+
+        // A stack form instruction that runs as it is, on its plain handler
+        void emitPlain(size_t index) {
+            Instruction instruction = mFunction.instructions[index];
+            if (!isInvalid(index)) instruction.handler = mTables.dispatchTable[static_cast<size_t>(opcodeAt(index))];
+            instruction.opcode = static_cast<u16>(opcodeAt(index));
+
+            mCode.instructions.push_back(instruction);
+            mCode.origins.emplace_back();
+        }
+
+        void emitBranch(RegisterOpcode opcode, u32 target, u32 b = 0, Value imm = Value()) {
+            mBranches.emplace_back(emit(opcode, 0, b, imm), target);
+        }
+
+        // JMP, JZ_S or JNZ_S to target, counting if it goes backwards and back-edges are counted
+        void emitBranchOnSlot(RegisterOpcode opcode, RegisterOpcode counting, size_t index, u32 slot) {
+            u32 target = mFunction.instructions[index].a;
+
+            if (!mBackEdgeThreshold.has_value() || target > index) {
+                emitBranch(opcode, target, slot);
+                return;
+            }
+
+            size_t branch = mCode.instructions.size();
+            emitBranch(counting, target, slot);
+
+            mCode.instructions[branch].counter = std::max<u32>(mBackEdgeThreshold.value(), 1);
+            mCode.origins[branch] = { target, heightAt(target) };
+        }
+
+        void emitSymbol(u32 slot, const Symbol& symbol) {
+            if (!symbol.operation.has_value()) {
+                if (symbol.x.immediate) emit(RegisterOpcode::MOV_SI, slot, 0, symbol.x.imm);
+                else if (symbol.x.slot != slot) emit(RegisterOpcode::MOV_SS, slot, symbol.x.slot);
+                return;
+            }
+
+            OperationInfo info = GetOperationInfo(symbol.operation.value());
+
+            if (info.unary) emit(info.ss, slot, symbol.x.slot);
+            else if (symbol.y.immediate) emit(info.si, slot, symbol.x.slot, symbol.y.imm);
+            else emit(info.ss, slot, symbol.x.slot, Value(static_cast<i64>(symbol.y.slot)));
+        }
+
+        bool isHome(u32 holder) const {
+            const Symbol& symbol = mSymbols[holder];
+            return !symbol.operation.has_value() && !symbol.x.immediate && symbol.x.slot == holder;
+        }
+
+        // Before slot is written, everything that still reads the old value from it gets it into its own home. The holder
+        // of slot and except are left alone, they're what's being written
+        void clobber(u32 slot, u32 except) {
+            mWriting[slot] = true;
+
+            auto check = [&](u32 holder) {
+                if (holder == slot || holder == except || !ReadsSlot(mSymbols[holder], slot)) return;
+
+                // its home is being written further up, so the two need each other's slots
+                if (mWriting[holder]) spill(slot);
+                else materialize(holder);
+            };
+
+            for (u32 holder = 0; holder < mHeight; holder++) check(holder);
+            check(mAccSlot);
+
+            mWriting[slot] = false;
+        }
+
+        // Breaks a cycle by moving slot's value to the scratch slot and pointing everything that reads it there
+        void spill(u32 slot) {
+            u32 scratch = mAccSlot + 1;
+            if (slot == scratch || mWriting[scratch]) {
+                mFailed = true; // cycles through the scratch slot itself are left to the stack form
+                return;
+            }
+
+            clobber(scratch, NoHolder);
+            emit(RegisterOpcode::MOV_SS, scratch, slot);
+
+            auto rename = [&](Operand& operand) {
+                if (!operand.immediate && operand.slot == slot) operand.slot = scratch;
+            };
+
+            for (u32 holder = 0; holder < mHeight; holder++) {
+                rename(mSymbols[holder].x);
+                if (mSymbols[holder].operation.has_value()) rename(mSymbols[holder].y);
+            }
+
+            rename(mSymbols[mAccSlot].x);
+            if (mSymbols[mAccSlot].operation.has_value()) rename(mSymbols[mAccSlot].y);
+        }
+
+        void materialize(u32 holder) {
+            if (isHome(holder)) return;
+
+            clobber(holder, NoHolder);
+
+            emitSymbol(holder, mSymbols[holder]);
+            mSymbols[holder] = SlotSymbol(holder);
+        }
+
+        // Operations only take operands
+        void makeOperand(u32 holder) {
+            if (mSymbols[holder].operation.has_value()) materialize(holder);
+        }
+
+        // And some of them only take slots
+        void makeSlot(u32 holder) {
+            makeOperand(holder);
+            if (mSymbols[holder].x.immediate) materialize(holder);
+        }
+
+        Symbol binary(Operation operation, u32 left, u32 right) {
+            makeOperand(left);
+            makeOperand(right);
+
+            Operand x = mSymbols[left].x;
+            Operand y = mSymbols[right].x;
+
+            if (x.immediate) {
+                std::optional<Operation> swapped = GetOperationInfo(operation).swapped;
+                if (!y.immediate && swapped.has_value()) return { swapped, y, x };
+
+                materialize(left);
+                x = mSymbols[left].x;
+                y = mSymbols[right].x; // if it was reading left's slot, it's just been moved out of it
+            }
+
+            return { operation, x, y };
+        }
+
+        Symbol binary(Operation operation, u32 left, Value imm) {
+            makeSlot(left);
+            return { operation, mSymbols[left].x, { true, 0, imm } };
+        }
+
+        Symbol unary(Operation operation, u32 holder) {
+            makeSlot(holder);
+            return { operation, mSymbols[holder].x, {} };
+        }
+
+        void push(const Symbol& symbol) {
+            mSymbols[mHeight] = symbol;
+            mHeight++;
+        }
+
+        // The top count positions are about to be popped. If a RESERVE can hand one back later it must hold its value by then
+        void settle(u32 count) {
+            for (u32 holder = mHeight - count; holder < mHeight; holder++) {
+                if (mExposed[holder]) materialize(holder);
+            }
+        }
+
+        // STORE and STORE_ST. Operations are done straight into the local
+        void store(u32 slot, u32 source) {
+            if (slot == source) {
+                materialize(slot);
+                return;
+            }
+
+            mSymbols[slot] = SlotSymbol(slot); // overwritten, nothing needs the old value moved out
+            clobber(slot, source);
+
+            Symbol value = mSymbols[source];
+            emitSymbol(slot, value);
+
+            if (value.operation.has_value()) mSymbols[source] = SlotSymbol(slot);
+        }
+
+        // Everything in its home. acc only if it's read later
+        void flush(bool accLive) {
+            for (u32 holder = 0; holder < mHeight; holder++) materialize(holder);
+            if (accLive) materialize(mAccSlot);
+        }
+
+        void startBlock(size_t index) {
+            mHeight = heightAt(index);
+            for (u32 holder = 0; holder < mHeight; holder++) mSymbols[holder] = SlotSymbol(holder);
+            mSymbols[mAccSlot] = SlotSymbol(mAccSlot);
+
+            if (index == mFunction.entryIndex) {
+                mCode.entryIndex = static_cast<u32>(mCode.instructions.size());
+                if (mLive[index]) emit(RegisterOpcode::ENTER, mAccSlot);
+            }
+
+            mIndices[index] = static_cast<u32>(mCode.instructions.size());
+        }
+
+        // JZ and JNZ. Compares that aren't needed as values where the branch goes branch on their own, and acc is only
+        // written out after them if the fall through path reads it
+        void translateConditional(size_t index, bool jumpIfZero) {
+            u32 target = mFunction.instructions[index].a;
+            bool counting = mBackEdgeThreshold.has_value() && target <= index;
+
+            for (u32 holder = 0; holder < mHeight; holder++) materialize(holder);
+            if (mLive[target]) materialize(mAccSlot);
+
+            const Symbol condition = mSymbols[mAccSlot];
+            bool fused = false;
+
+            if (condition.operation.has_value() && !counting) {
+                OperationInfo info = GetOperationInfo(condition.operation.value());
+                std::optional<Operation> operation = jumpIfZero ? info.inverse : condition.operation;
+
+                if (info.branchSS.has_value() && operation.has_value()) {
+                    OperationInfo branch = GetOperationInfo(operation.value());
+
+                    if (condition.y.immediate) emitBranch(branch.branchSI.value(), target, condition.x.slot, condition.y.imm);
+                    else emitBranch(branch.branchSS.value(), target, condition.x.slot, Value(static_cast<i64>(condition.y.slot)));
+
+                    fused = true;
+                }
+            }
+
+            if (!fused && !condition.operation.has_value() && condition.x.immediate && !counting) {
+                if (condition.x.imm.boolean() != jumpIfZero) emitBranch(RegisterOpcode::JMP, target);
+                fused = true;
+            }
+
+            if (!fused) {
+                makeSlot(mAccSlot);
+
+                u32 slot = mSymbols[mAccSlot].x.slot;
+                if (jumpIfZero) emitBranchOnSlot(RegisterOpcode::JZ_S, RegisterOpcode::JZ_S_BACK, index, slot);
+                else emitBranchOnSlot(RegisterOpcode::JNZ_S, RegisterOpcode::JNZ_S_BACK, index, slot);
+            }
+
+            if (liveAfter(index)) materialize(mAccSlot);
+        }
+
+        // Anything that stays in stack form. SYNC hands it acc and sp, and RESUME takes acc back if it's read later
+        void translatePlain(size_t index) {
+            flush(true);
+            emit(RegisterOpcode::SYNC, mAccSlot, mHeight);
+            emitPlain(index);
+
+            if (!fallsThrough(index) || index + 1 >= mDepths.size() || !mDepths[index + 1].has_value()) return;
+
+            mHeight = heightAt(index + 1);
+            for (u32 holder = 0; holder < mHeight; holder++) mSymbols[holder] = SlotSymbol(holder);
+            mSymbols[mAccSlot] = SlotSymbol(mAccSlot);
+
+            if (liveAfter(index)) emit(RegisterOpcode::RESUME, mAccSlot);
+        }
+
+        void translateCall(size_t index, RegisterOpcode opcode) {
+            const Instruction& instruction = mFunction.instructions[index];
+
+            flush(true);
+            emit(opcode, mAccSlot, mHeight);
+            emitPlain(index);
+
+            // the arguments went to the callee. RET comes back to whatever follows
+            mHeight -= instruction.b;
+            mSymbols[mAccSlot] = SlotSymbol(mAccSlot);
+
+            if (liveAfter(index)) emit(RegisterOpcode::RESUME, mAccSlot);
+        }
+
+        void translate(size_t index) {
+            const Instruction& instruction = mFunction.instructions[index];
+
+            if (isInvalid(index)) {
+                translatePlain(index);
+                return;
+            }
+
+            ByteOpcode opcode = opcodeAt(index);
+            u32 top = mHeight - 1;
+            u32 local = instruction.a;
+
+            switch (opcode) {
+                case ByteOpcode::ADD: case ByteOpcode::SUB: case ByteOpcode::MUL: case ByteOpcode::DIV: case ByteOpcode::MOD:
+                case ByteOpcode::AND: case ByteOpcode::OR: case ByteOpcode::XOR: case ByteOpcode::SHL: case ByteOpcode::SHR:
+                case ByteOpcode::FADD: case ByteOpcode::FSUB: case ByteOpcode::FMUL: case ByteOpcode::FDIV:
+                case ByteOpcode::CMP_EQ: case ByteOpcode::CMP_NE: case ByteOpcode::CMP_LT: case ByteOpcode::CMP_GT:
+                case ByteOpcode::CMP_LTE: case ByteOpcode::CMP_GTE:
+                case ByteOpcode::FCMP_EQ: case ByteOpcode::FCMP_NE: case ByteOpcode::FCMP_LT: case ByteOpcode::FCMP_GT:
+                case ByteOpcode::FCMP_LTE: case ByteOpcode::FCMP_GTE: {
+                    settle(1);
+                    Symbol result = binary(GetOperation(opcode).value(), mAccSlot, top);
+                    mHeight--;
+                    mSymbols[mAccSlot] = result;
+                    return;
+                }
+
+                case ByteOpcode::ADD2: case ByteOpcode::SUB2: case ByteOpcode::MUL2: case ByteOpcode::DIV2: case ByteOpcode::MOD2:
+                case ByteOpcode::AND2: case ByteOpcode::OR2: case ByteOpcode::XOR2: case ByteOpcode::SHL2: case ByteOpcode::SHR2:
+                case ByteOpcode::FADD2: case ByteOpcode::FSUB2: case ByteOpcode::FMUL2: case ByteOpcode::FDIV2: {
+                    settle(2);
+                    Symbol result = binary(GetOperation(opcode).value(), top - 1, top);
+                    mHeight -= 2;
+                    mSymbols[mAccSlot] = result;
+                    return;
+                }
+
+                case ByteOpcode::ADD_ST: case ByteOpcode::SUB_ST: case ByteOpcode::MUL_ST: case ByteOpcode::DIV_ST: case ByteOpcode::MOD_ST:
+                case ByteOpcode::AND_ST: case ByteOpcode::OR_ST: case ByteOpcode::XOR_ST: case ByteOpcode::SHL_ST: case ByteOpcode::SHR_ST:
+                case ByteOpcode::FADD_ST: case ByteOpcode::FSUB_ST: case ByteOpcode::FMUL_ST: case ByteOpcode::FDIV_ST: {
+                    settle(2);
+                    Symbol result = binary(GetOperation(opcode).value(), top - 1, top);
+                    mHeight -= 2;
+                    push(result);
+                    return;
+                }
+
+                case ByteOpcode::ADD_IMM: case ByteOpcode::SUB_IMM: case ByteOpcode::MUL_IMM: case ByteOpcode::DIV_IMM: case ByteOpcode::MOD_IMM:
+                case ByteOpcode::AND_IMM: case ByteOpcode::OR_IMM: case ByteOpcode::XOR_IMM: case ByteOpcode::SHL_IMM: case ByteOpcode::SHR_IMM:
+                case ByteOpcode::FADD_IMM: case ByteOpcode::FSUB_IMM: case ByteOpcode::FMUL_IMM: case ByteOpcode::FDIV_IMM:
+                    mSymbols[mAccSlot] = binary(GetOperation(opcode).value(), mAccSlot, instruction.imm);
+                    return;
+
+                case ByteOpcode::ADD_IMM_ST: case ByteOpcode::SUB_IMM_ST: case ByteOpcode::MUL_IMM_ST: case ByteOpcode::DIV_IMM_ST:
+                case ByteOpcode::MOD_IMM_ST: case ByteOpcode::AND_IMM_ST: case ByteOpcode::OR_IMM_ST: case ByteOpcode::XOR_IMM_ST:
+                case ByteOpcode::SHL_IMM_ST: case ByteOpcode::SHR_IMM_ST:
+                case ByteOpcode::FADD_IMM_ST: case ByteOpcode::FSUB_IMM_ST: case ByteOpcode::FMUL_IMM_ST: case ByteOpcode::FDIV_IMM_ST:
+                    mSymbols[top] = binary(GetOperation(opcode).value(), top, instruction.imm);
+                    return;
+
+                case ByteOpcode::CMP_EQ0: case ByteOpcode::CMP_NE0: case ByteOpcode::CMP_LT0: case ByteOpcode::CMP_GT0:
+                case ByteOpcode::CMP_LTE0: case ByteOpcode::CMP_GTE0:
+                    mSymbols[mAccSlot] = binary(GetOperation(opcode).value(), mAccSlot, Value(static_cast<i64>(0)));
+                    return;
+
+                case ByteOpcode::FCMP_EQ0: case ByteOpcode::FCMP_NE0: case ByteOpcode::FCMP_LT0: case ByteOpcode::FCMP_GT0:
+                case ByteOpcode::FCMP_LTE0: case ByteOpcode::FCMP_GTE0:
+                    mSymbols[mAccSlot] = binary(GetOperation(opcode).value(), mAccSlot, Value(0.0));
+                    return;
+
+                case ByteOpcode::NEG: case ByteOpcode::NOT: case ByteOpcode::FNEG:
+                    mSymbols[mAccSlot] = unary(GetOperation(opcode).value(), mAccSlot);
+                    return;
+
+                case ByteOpcode::NEG_ST: case ByteOpcode::NOT_ST:
+                    mSymbols[top] = unary(GetOperation(opcode).value(), top);
+                    return;
+
+                case ByteOpcode::PUSH_ACC:
+                    push(mSymbols[mAccSlot]);
+
+                    // computed once, into the stack, rather than once for each copy
+                    if (mSymbols[top + 1].operation.has_value()) {
+                        materialize(top + 1);
+                        mSymbols[mAccSlot] = mSymbols[top + 1];
+                    }
+
+                    return;
+
+                case ByteOpcode::POP_ACC:
+                    settle(1);
+                    mSymbols[mAccSlot] = mSymbols[top];
+                    mHeight--;
+                    return;
+
+                case ByteOpcode::POP_DISCARD:
+                    settle(instruction.a);
+                    mHeight -= instruction.a;
+                    return;
+
+                case ByteOpcode::RESERVE:
+                    for (u32 holder = mHeight; holder < mHeight + instruction.a; holder++) mSymbols[holder] = SlotSymbol(holder);
+                    mHeight += instruction.a;
+                    return;
+
+                case ByteOpcode::CONST: case ByteOpcode::CONST32: case ByteOpcode::CONST64:
+                    mSymbols[mAccSlot] = ImmediateSymbol(instruction.imm);
+                    return;
+
+                case ByteOpcode::CONST_ST: case ByteOpcode::CONST32_ST: case ByteOpcode::CONST64_ST:
+                    push(ImmediateSymbol(instruction.imm));
+                    return;
+
+                case ByteOpcode::LOAD:
+                    makeOperand(local);
+                    mSymbols[mAccSlot] = mSymbols[local];
+                    return;
+
+                case ByteOpcode::LOAD_ST:
+                    makeOperand(local);
+                    push(mSymbols[local]);
+                    return;
+
+                case ByteOpcode::STORE:
+                    store(local, mAccSlot);
+                    return;
+
+                case ByteOpcode::STORE_ST:
+                    settle(1);
+                    store(local, top);
+                    mHeight--;
+                    return;
+
+                case ByteOpcode::NOP:
+                case ByteOpcode::BRK:
+                    return;
+
+                case ByteOpcode::JMP:
+                    flush(mLive[instruction.a]);
+                    emitBranchOnSlot(RegisterOpcode::JMP, RegisterOpcode::JMP_BACK, index, 0);
+                    return;
+
+                case ByteOpcode::JZ:
+                    translateConditional(index, true);
+                    return;
+
+                case ByteOpcode::JNZ:
+                    translateConditional(index, false);
+                    return;
+
+                case ByteOpcode::CALL: translateCall(index, RegisterOpcode::SYNC_CALL); return;
+                case ByteOpcode::CALL_EX: translateCall(index, RegisterOpcode::SYNC_CALL_EX); return;
+                case ByteOpcode::CALL_DYN: translateCall(index, RegisterOpcode::SYNC_CALL_DYN); return;
+                case ByteOpcode::CALL_TINY: translateCall(index, RegisterOpcode::SYNC_CALL_TINY); return;
+                case ByteOpcode::CALL_TINY_EX: translateCall(index, RegisterOpcode::SYNC_CALL_TINY_EX); return;
+
+                case ByteOpcode::RET:
+                    flush(true); // a host frame's values stay where the host can see them
+                    emit(RegisterOpcode::RET, mAccSlot, mHeight);
+                    return;
+
+                case ByteOpcode::HLT:
+                    flush(true);
+                    emit(RegisterOpcode::HLT, mAccSlot, mHeight, instruction.imm);
+                    return;
+
+                case ByteOpcode::TRAP:
+                case ByteOpcode::TRAP_IF_ZERO:
+                case ByteOpcode::TRAP_IF_NOT_ZERO: {
+                    RegisterOpcode trap = RegisterOpcode::TRAP;
+                    if (opcode == ByteOpcode::TRAP_IF_ZERO) trap = RegisterOpcode::TRAP_IF_ZERO;
+                    if (opcode == ByteOpcode::TRAP_IF_NOT_ZERO) trap = RegisterOpcode::TRAP_IF_NOT_ZERO;
+
+                    flush(true);
+                    emit(trap, instruction.a, mHeight, Value(static_cast<i64>(mAccSlot)));
+
+                    // whatever the trap did to the stack, it's in memory
+                    mSymbols[mAccSlot] = SlotSymbol(mAccSlot);
+                    return;
+                }
+
+                default:
+                    translatePlain(index);
+                    return;
+            }
+        }
+    };
+
+    std::optional<RegisterCode> TranslateToRegisters(const DecodedFunction& function, const DispatchTables& tables, u32 args, std::optional<u32> backEdgeThreshold) {
+        return RegisterTranslator(function, tables, args, backEdgeThreshold).run();
+    }
+}
@@ -0,0 +1,74 @@
+// Copyright 2025 JesusTouchMe
+
+#include "BibbleVM/core/exec/superinstruction.h"
+#include "BibbleVM/core/exec/instruction.h"
+
+#include <array>
+#include <optional>
+
+namespace bibble {
+    struct SuperinstructionPattern {
+        std::array<ByteOpcode, 3> parts;
+        size_t length;
+    };
+
+    static constexpr SuperinstructionPattern Patterns[] = {
+#define SUPERINSTRUCTION_PATTERN2(a, b) { { ByteOpcode::a, ByteOpcode::b }, 2 },
+#define SUPERINSTRUCTION_PATTERN3(a, b, c) { { ByteOpcode::a, ByteOpcode::b, ByteOpcode::c }, 3 },
+        FOR_EACH_SUPERINSTRUCTION(SUPERINSTRUCTION_PATTERN2, SUPERINSTRUCTION_PATTERN3)
+#undef SUPERINSTRUCTION_PATTERN2
+#undef SUPERINSTRUCTION_PATTERN3
+    };
+
+    static_assert(std::size(Patterns) == SuperinstructionCount);
+
+    std::span<const ByteOpcode> GetSuperinstructionParts(Superinstruction superinstruction) {
+        const SuperinstructionPattern& pattern = Patterns[static_cast<size_t>(superinstruction)];
+        return { pattern.parts.data(), pattern.length };
+    }
+
+    ByteOpcode GetLeadingOpcode(u16 opcode) {
+        if (opcode < SuperinstructionBase) return static_cast<ByteOpcode>(opcode);
+        return GetSuperinstructionParts(static_cast<Superinstruction>(opcode - SuperinstructionBase)).front();
+    }
+
+    static bool Matches(const std::vector<Instruction>& instructions, size_t index, const SuperinstructionPattern& pattern, const DispatchTables& tables) {
+        if (index + pattern.length > instructions.size()) return false;
+
+        for (size_t i = 0; i < pattern.length; i++) {
+            const Instruction& instruction = instructions[index + i];
+            if (instruction.opcode != static_cast<u16>(pattern.parts[i])) return false;
+
+            // only plain handlers. the trailing sentinel has the invalid one and must keep failing, and back-edge
+            // counters would stop counting inside a superinstruction
+            if (instruction.handler != tables.dispatchTable[instruction.opcode]) return false;
+        }
+
+        return true;
+    }
+
+    // Longest match first
+    static std::optional<size_t> FindSuperinstruction(const std::vector<Instruction>& instructions, size_t index, const DispatchTables& tables) {
+        std::optional<size_t> best;
+
+        for (size_t i = 0; i < SuperinstructionCount; i++) {
+            if (best.has_value() && Patterns[i].length <= Patterns[best.value()].length) continue;
+            if (Matches(instructions, index, Patterns[i], tables)) best = i;
+        }
+
+        return best;
+    }
+
+    void FuseSuperinstructions(DecodedFunction& function, const DispatchTables& tables) {
+        std::vector<Instruction>& instructions = function.instructions;
+
+        // instructions are in code order and every part but the last falls through, so a sequence is always consecutive
+        for (size_t index = 0; index < instructions.size(); index++) {
+            std::optional<size_t> superinstruction = FindSuperinstruction(instructions, index, tables);
+            if (!superinstruction.has_value()) continue;
+
+            instructions[index].handler = tables.superinstructions[superinstruction.value()];
+            instructions[index].opcode = static_cast<u16>(SuperinstructionBase + superinstruction.value());
+        }
+    }
+}
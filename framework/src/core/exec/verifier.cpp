@@ -0,0 +1,215 @@
+// Copyright 2025 JesusTouchMe
+
+#include "BibbleVM/core/exec/verifier.h"
+#include "BibbleVM/core/exec/superinstruction.h"
+
+#include "BibbleVM/core/bytecode/operand_layout.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace bibble {
+    bool VerifyCode(const CodeSection& code) {
+        size_t codeSize = code.getSize();
+        if (codeSize == 0) return true;
+
+        std::optional<BytecodeReader> readerOpt = code.getBytecodeReader(0);
+        if (!readerOpt.has_value()) return false;
+
+        BytecodeReader& reader = readerOpt.value();
+
+        std::vector<bool> boundaries(codeSize + 1, false); // codeSize itself is where the last instruction ends
+        std::vector<size_t> branchTargets;
+
+        while (reader.getRemaining() > 0) {
+            boundaries[reader.getPosition()] = true;
+
+            std::optional<u8> opcodeByte = reader.fetchU8();
+            if (!opcodeByte.has_value()) return false;
+
+            if (opcodeByte.value() == 0xFF) { // no extended opcode has operands yet
+                if (!reader.skip(2)) return false;
+                continue;
+            }
+
+            std::optional<OperandLayout> layout = GetOperandLayout(static_cast<ByteOpcode>(opcodeByte.value()));
+            if (!layout.has_value()) return false; // can't know where the next instruction starts
+
+            if (layout.value() == OperandLayout::Branch) {
+                std::optional<i16> branch = reader.fetchI16();
+                if (!branch.has_value()) return false;
+
+                i64 target = static_cast<i64>(reader.getPosition()) + branch.value();
+                if (target < 0 || target >= static_cast<i64>(codeSize)) return false;
+
+                branchTargets.push_back(static_cast<size_t>(target));
+                continue;
+            }
+
+            if (!reader.skip(static_cast<i64>(GetOperandSize(layout.value())))) return false;
+        }
+
+        return std::all_of(branchTargets.begin(), branchTargets.end(), [&boundaries](size_t target) {
+            return boundaries[target];
+        });
+    }
+
+    // What an instruction needs from and does to the operand stack
+    struct StackEffect {
+        i64 pops = 0; // values it needs on the stack
+        i64 pushes = 0; // values it leaves in their place
+        std::optional<i64> local; // local index it reads or writes, checked against the depth before the instruction
+    };
+
+    // nullopt if the effect can't be known statically
+    static std::optional<StackEffect> GetStackEffect(ByteOpcode opcode, const Instruction& instruction) {
+        i64 index = static_cast<i32>(instruction.a);
+
+        switch (opcode) {
+            case ByteOpcode::ADD: case ByteOpcode::SUB: case ByteOpcode::MUL: case ByteOpcode::DIV: case ByteOpcode::MOD:
+            case ByteOpcode::AND: case ByteOpcode::OR: case ByteOpcode::XOR: case ByteOpcode::SHL: case ByteOpcode::SHR:
+            case ByteOpcode::FADD: case ByteOpcode::FSUB: case ByteOpcode::FMUL: case ByteOpcode::FDIV:
+            case ByteOpcode::CMP_EQ: case ByteOpcode::CMP_NE: case ByteOpcode::CMP_LT: case ByteOpcode::CMP_GT:
+            case ByteOpcode::CMP_LTE: case ByteOpcode::CMP_GTE:
+            case ByteOpcode::FCMP_EQ: case ByteOpcode::FCMP_NE: case ByteOpcode::FCMP_LT: case ByteOpcode::FCMP_GT:
+            case ByteOpcode::FCMP_LTE: case ByteOpcode::FCMP_GTE:
+            case ByteOpcode::POP_ACC:
+                return StackEffect{ 1, 0 };
+
+            case ByteOpcode::ADD2: case ByteOpcode::SUB2: case ByteOpcode::MUL2: case ByteOpcode::DIV2: case ByteOpcode::MOD2:
+            case ByteOpcode::AND2: case ByteOpcode::OR2: case ByteOpcode::XOR2: case ByteOpcode::SHL2: case ByteOpcode::SHR2:
+            case ByteOpcode::FADD2: case ByteOpcode::FSUB2: case ByteOpcode::FMUL2: case ByteOpcode::FDIV2:
+                return StackEffect{ 2, 0 };
+
+            case ByteOpcode::ADD_ST: case ByteOpcode::SUB_ST: case ByteOpcode::MUL_ST: case ByteOpcode::DIV_ST: case ByteOpcode::MOD_ST:
+            case ByteOpcode::AND_ST: case ByteOpcode::OR_ST: case ByteOpcode::XOR_ST: case ByteOpcode::SHL_ST: case ByteOpcode::SHR_ST:
+            case ByteOpcode::FADD_ST: case ByteOpcode::FSUB_ST: case ByteOpcode::FMUL_ST: case ByteOpcode::FDIV_ST:
+                return StackEffect{ 2, 1 };
+
+            case ByteOpcode::NEG_ST: case ByteOpcode::NOT_ST:
+            case ByteOpcode::ADD_IMM_ST: case ByteOpcode::SUB_IMM_ST: case ByteOpcode::MUL_IMM_ST: case ByteOpcode::DIV_IMM_ST:
+            case ByteOpcode::MOD_IMM_ST: case ByteOpcode::AND_IMM_ST: case ByteOpcode::OR_IMM_ST: case ByteOpcode::XOR_IMM_ST:
+            case ByteOpcode::SHL_IMM_ST: case ByteOpcode::SHR_IMM_ST:
+            case ByteOpcode::FADD_IMM_ST: case ByteOpcode::FSUB_IMM_ST: case ByteOpcode::FMUL_IMM_ST: case ByteOpcode::FDIV_IMM_ST:
+                return StackEffect{ 1, 1 }; // modifies the top in place
+
+            case ByteOpcode::PUSH_ACC: case ByteOpcode::PUSH_SP:
+            case ByteOpcode::CONST_ST: case ByteOpcode::CONST32_ST: case ByteOpcode::CONST64_ST:
+                return StackEffect{ 0, 1 };
+
+            case ByteOpcode::POP_DISCARD:
+                return StackEffect{ instruction.a, 0 };
+
+            case ByteOpcode::RESERVE:
+                return StackEffect{ 0, instruction.a };
+
+            case ByteOpcode::LOAD: case ByteOpcode::STORE:
+                if (index < 0) return std::nullopt; // would reach below the frame
+                return StackEffect{ 0, 0, index };
+
+            case ByteOpcode::LOAD_ST:
+                if (index < 0) return std::nullopt;
+                return StackEffect{ 0, 1, index };
+
+            case ByteOpcode::STORE_ST:
+                if (index < 0) return std::nullopt;
+                return StackEffect{ 1, 0, index };
+
+            case ByteOpcode::CALL: case ByteOpcode::CALL_EX: case ByteOpcode::CALL_DYN:
+            case ByteOpcode::CALL_TINY: case ByteOpcode::CALL_TINY_EX:
+                return StackEffect{ instruction.b, 0 }; // the arguments become the callee's frame, which RET discards
+
+            case ByteOpcode::POP_SP:
+                return std::nullopt; // sp comes from the stack
+
+            default:
+                return StackEffect{}; // acc only
+        }
+    }
+
+    static constexpr i64 Unvisited = std::numeric_limits<i64>::min();
+
+    // Fills depths with the stack depth before each instruction, relative to entry, and finds how far below and above
+    // that the function reaches. Superinstructions count as their first part, so this works before and after fusion
+    static bool WalkStackDepths(const DecodedFunction& function, std::vector<i64>& depths, i64& minArgs, i64& maxGrowth) {
+        const std::vector<Instruction>& instructions = function.instructions;
+        size_t sentinel = instructions.size() - 1; // trailing invalid instruction, fails when reached
+
+        depths.assign(instructions.size(), Unvisited);
+        std::vector<size_t> worklist = { function.entryIndex };
+        depths[function.entryIndex] = 0;
+
+        minArgs = 0;
+        maxGrowth = 0;
+
+        auto flowTo = [&depths, &worklist](size_t index, i64 depth) {
+            if (depths[index] == Unvisited) {
+                depths[index] = depth;
+                worklist.push_back(index);
+                return true;
+            }
+
+            return depths[index] == depth; // every path into an instruction must agree on the depth
+        };
+
+        while (!worklist.empty()) {
+            size_t index = worklist.back();
+            worklist.pop_back();
+
+            if (index == sentinel) continue;
+
+            const Instruction& instruction = instructions[index];
+            i64 depth = depths[index];
+
+            ByteOpcode opcode = GetLeadingOpcode(instruction.opcode);
+
+            std::optional<OperandLayout> layout = GetOperandLayout(opcode);
+            if (!layout.has_value()) continue; // invalid or extended, fails when reached
+
+            std::optional<StackEffect> effect = GetStackEffect(opcode, instruction);
+            if (!effect.has_value()) return false;
+
+            // entered with minArgs values, the stack holds minArgs + depth here
+            minArgs = std::max(minArgs, effect->pops - depth);
+            if (effect->local.has_value()) minArgs = std::max(minArgs, effect->local.value() + 1 - depth);
+
+            i64 next = depth - effect->pops + effect->pushes;
+            maxGrowth = std::max(maxGrowth, next);
+
+            if (layout.value() == OperandLayout::Branch && !flowTo(instruction.a, next)) return false;
+            if (!IsTerminator(opcode) && !flowTo(index + 1, next)) return false;
+        }
+
+        return true;
+    }
+
+    bool VerifyFunction(DecodedFunction& function) {
+        std::vector<i64> depths;
+        i64 minArgs;
+        i64 maxGrowth;
+
+        if (!WalkStackDepths(function, depths, minArgs, maxGrowth)) return false;
+        if (minArgs > std::numeric_limits<u16>::max()) return false; // no call can pass that many
+
+        function.verified = true;
+        function.minArgs = static_cast<u32>(minArgs);
+        function.maxGrowth = static_cast<u32>(maxGrowth);
+
+        return true;
+    }
+
+    std::vector<std::optional<i64>> GetStackDepths(const DecodedFunction& function) {
+        std::vector<i64> depths;
+        i64 minArgs;
+        i64 maxGrowth;
+
+        std::vector<std::optional<i64>> result(function.instructions.size());
+        if (!function.verified || !WalkStackDepths(function, depths, minArgs, maxGrowth)) return result;
+
+        for (size_t i = 0; i < depths.size(); i++) {
+            if (depths[i] != Unvisited) result[i] = depths[i];
+        }
+
+        return result;
+    }
+}
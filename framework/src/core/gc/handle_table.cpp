@@ -0,0 +1,79 @@
+// Copyright 2025 JesusTouchMe
+
+#include "BibbleVM/core/gc/handle_table.h"
+
+#include <cstring>
+
+#if defined(PLATFORM_LINUX) || defined(PLATFORM_MACOS)
+#include <sys/mman.h>
+#endif
+
+namespace bibble {
+    static_assert(sizeof(Handle) == 16 && HandleTable::SlabSize % sizeof(Handle) == 0, "slabs hold whole handles");
+
+    // what's reserved where the range can't be mapped, as all of it is allocated right away there
+    static constexpr size_t HeapReservedSize = 16 * 1024 * 1024;
+
+    HandleTable::HandleTable() = default;
+
+    HandleTable::~HandleTable() {
+#if defined(PLATFORM_LINUX) || defined(PLATFORM_MACOS)
+        if (mReservation != nullptr) munmap(mReservation, ReservedSize);
+#endif
+    }
+
+    void HandleTable::release(FreeBatch& batch) {
+        if (batch.mHead == nullptr) return;
+
+        batch.mTail->obj = reinterpret_cast<Object*>(mFree);
+        mFree = batch.mHead;
+        mLive -= batch.mCount;
+
+        batch = FreeBatch();
+    }
+
+    size_t HandleTable::liveCount() const {
+        return mLive;
+    }
+
+    size_t HandleTable::slabCount() const {
+        return mUsedBytes / SlabSize;
+    }
+
+    Handle* HandleTable::allocateSlab() {
+        size_t reservedSize = ReservedSize;
+
+        if (mBegin == 0) {
+#if defined(PLATFORM_LINUX) || defined(PLATFORM_MACOS)
+            void* reservation = mmap(nullptr, ReservedSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+            if (reservation != MAP_FAILED) {
+                mReservation = reservation;
+                mBegin = reinterpret_cast<uintptr_t>(reservation);
+            }
+#endif
+
+            if (mBegin == 0) {
+                try {
+                    mHeapReservation = std::make_unique_for_overwrite<u8[]>(HeapReservedSize);
+                } catch (...) {
+                    return nullptr;
+                }
+
+                mBegin = reinterpret_cast<uintptr_t>(mHeapReservation.get());
+            }
+        }
+
+        if (mHeapReservation != nullptr) reservedSize = HeapReservedSize;
+        if (mUsedBytes == reservedSize) return nullptr;
+
+        Handle* slab = reinterpret_cast<Handle*>(mBegin + mUsedBytes);
+        mUsedBytes += SlabSize;
+
+        mNext = slab + 1;
+        mSlabEnd = slab + SlabSize / sizeof(Handle);
+
+        std::memset(slab, 0, SlabSize); // generation 0. mapped pages already are, the heap reservation isn't
+
+        return slab;
+    }
+}
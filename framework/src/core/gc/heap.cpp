@@ -0,0 +1,471 @@
+// Copyright 2025 JesusTouchMe
+
+#include "BibbleVM/core/gc/heap.h"
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+namespace bibble {
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr size_t MinNurserySize = 64 * 1024;
+    static constexpr size_t MinOldTrigger = 8 * 1024 * 1024; // bytes. the old generation is collected again once it's twice what the last collection found alive, or this
+    static constexpr size_t ObjectsPerClockCheck = 64; // between looking at the deadline
+
+    Heap::Heap(Stack& stack, Value& acc, size_t nurserySize, u32 pauseBudget)
+        : mStack(stack)
+        , mAcc(acc)
+        , mNursery(std::max(nurserySize, MinNurserySize))
+        , mPauseBudget(pauseBudget)
+        , mOldTrigger(MinOldTrigger) {}
+
+    void Heap::collectMinor() {
+        if (!mNursery.isReserved()) return; // nothing was allocated yet
+
+        mStats.allocatedBytes += mNursery.used() - mSurvivorBytes;
+
+        // promoted objects are scanned from where the old generation ends now, like to-space is. they're always
+        // allocated in the last region
+        size_t region = mOld.regionCount() == 0 ? 0 : mOld.regionCount() - 1;
+        u8* position = mOld.regionCount() == 0 ? nullptr : mOld.region(region).top;
+
+        Value* slots = mStack.data();
+        i64 sp = std::clamp<i64>(mStack.sp().integer(), 0, mStack.capacity());
+        for (i64 i = 0; i < sp; i++) evacuate(slots[i]);
+
+        evacuate(mAcc);
+
+        // old objects only stay remembered while they still point into the nursery
+        std::swap(mRemembered, mRememberedScratch);
+        mRemembered.clear();
+
+        if (mRememberedOverflow) {
+            mRememberedOverflow = false;
+            forEachOldObject([this](Object* object) {
+                object->flags &= ~Object::Remembered;
+                if (evacuateFields(object)) remember(object);
+            });
+        } else {
+            for (Value reference : mRememberedScratch) {
+                Handle* handle = mHandles.resolve(reference);
+                if (handle == nullptr) continue; // swept since
+
+                Object* object = handle->obj;
+                object->flags &= ~Object::Remembered;
+                if (evacuateFields(object)) remember(object);
+            }
+        }
+
+        // Cheney's scan over to-space, and the same over the promoted objects, until neither copies anything new
+        u8* scan = mNursery.toBegin();
+        bool scanned;
+        do {
+            scanned = false;
+
+            while (scan < mNursery.toTop()) {
+                Object* object = reinterpret_cast<Object*>(scan);
+                scan += ObjectSize(object->fieldCount);
+
+                evacuateFields(object);
+                scanned = true;
+            }
+
+            if (scanPromoted(region, position)) scanned = true;
+        } while (scanned);
+
+        // whatever is left in from-space is garbage
+        HandleTable::FreeBatch dead;
+        for (u8* byte = mNursery.begin(); byte < mNursery.top();) {
+            Object* object = reinterpret_cast<Object*>(byte);
+            byte += ObjectSize(object->fieldCount);
+
+            if (object->handle != nullptr && object->handle->obj == object) dead.add(object->handle);
+        }
+
+        mHandles.release(dead);
+
+        mSurvivorBytes = mNursery.toTop() - mNursery.toBegin();
+
+        mStats.minorCollections++;
+        mStats.survivedBytes += mSurvivorBytes;
+
+        mNursery.flip();
+
+        if (mOldPhase != OldPhase::Idle || mOld.usedBytes() >= mOldTrigger) collectOldStep();
+    }
+
+    bool Heap::collectOldStep() {
+        return stepOld(Clock::now() + mPauseBudget);
+    }
+
+    void Heap::collectOld() {
+        while (!stepOld(Clock::time_point::max())) {}
+    }
+
+    HeapStats Heap::stats() const {
+        HeapStats stats = mStats;
+        stats.allocatedBytes += mNursery.used() - mSurvivorBytes;
+        stats.oldBytes = mOld.usedBytes();
+        stats.handles = mHandles.liveCount();
+        stats.regions = mOld.regionCount();
+
+        return stats;
+    }
+
+    Handle* Heap::allocateSlow(u32 fieldCount) {
+        size_t size = ObjectSize(fieldCount);
+        Object* object = nullptr;
+
+        if (size <= LargeObjectSize) {
+            if (!mNursery.isReserved() && !mNursery.reserve()) return nullptr;
+
+            object = mNursery.allocate(size);
+            if (object == nullptr) {
+                collectMinor();
+                object = mNursery.allocate(size);
+            }
+        }
+
+        // too big for the nursery, or it's still full of survivors after collecting it
+        if (object == nullptr) {
+            object = mOld.allocate(size);
+            if (object == nullptr) return nullptr;
+
+            mStats.allocatedBytes += size;
+        }
+
+        return initialize(object, fieldCount);
+    }
+
+    void Heap::remember(Object* object) {
+        object->flags |= Object::Remembered;
+
+        try {
+            mRemembered.push_back(MakeReference(object->handle));
+        } catch (...) {
+            mRememberedOverflow = true;
+        }
+    }
+
+    bool Heap::evacuate(Value value) {
+        Handle* handle = mHandles.resolve(value);
+        if (handle == nullptr) return false;
+
+        Object* object = handle->obj;
+        if (!mNursery.contains(object)) return mNursery.isCopied(object);
+
+        size_t size = ObjectSize(object->fieldCount);
+
+        // to-space always has room for it, so running out of memory for the old generation only delays promotion
+        Object* copy = object->age >= PromotionAge ? mOld.allocate(size) : nullptr;
+        if (copy == nullptr) {
+            copy = mNursery.copy(size);
+            std::memcpy(copy, object, size);
+        } else {
+            std::memcpy(copy, object, size);
+            copy->mark = mMark;
+            mStats.promotedBytes += size;
+
+            // its fields may hold the only references to old objects the marking hasn't reached
+            if (mOldPhase == OldPhase::Mark) {
+                try {
+                    mGray.push_back(handle);
+                } catch (...) {
+                    mGrayOverflow = true;
+                }
+            }
+        }
+
+        if (copy->age != 0xFF) copy->age++;
+
+        handle->obj = copy;
+
+        return mNursery.isCopied(copy);
+    }
+
+    bool Heap::evacuateFields(Object* object) {
+        bool young = false;
+
+        Value* fields = object->fields();
+        for (u32 i = 0; i < object->fieldCount; i++) {
+            if (evacuate(fields[i])) young = true;
+        }
+
+        return young;
+    }
+
+    bool Heap::scanPromoted(size_t& region, u8*& position) {
+        bool scanned = false;
+
+        // by index, as evacuating can add regions
+        while (region < mOld.regionCount()) {
+            if (position == nullptr) position = mOld.region(region).begin();
+
+            while (position < mOld.region(region).top) {
+                Object* object = reinterpret_cast<Object*>(position);
+                position += ObjectSize(object->fieldCount);
+
+                if (evacuateFields(object) && !(object->flags & Object::Remembered)) remember(object);
+                scanned = true;
+            }
+
+            if (region + 1 == mOld.regionCount()) break;
+
+            region++;
+            position = nullptr;
+        }
+
+        return scanned;
+    }
+
+    template<class F>
+    void Heap::forEachOldObject(F&& function) {
+        // by index, as function may promote objects, which can add regions. objects that were evacuated or swept since
+        // are skipped by their handle not pointing at them anymore
+        for (size_t i = 0; i < mOld.regionCount(); i++) {
+            for (u8* byte = mOld.region(i).begin(); byte < mOld.region(i).top;) {
+                Object* object = reinterpret_cast<Object*>(byte);
+                byte += ObjectSize(object->fieldCount);
+
+                if (object->handle != nullptr && object->handle->obj == object) function(object);
+            }
+        }
+
+        for (size_t i = 0; i < mOld.largeObjectCount(); i++) {
+            Object* object = mOld.largeObject(i);
+            if (object->handle != nullptr && object->handle->obj == object) function(object);
+        }
+    }
+
+    void Heap::mark(Value value) {
+        Handle* handle = mHandles.resolve(value);
+        if (handle == nullptr) return;
+
+        Object* object = handle->obj;
+        if (object->mark == mMark || mNursery.contains(object)) return;
+
+        object->mark = mMark;
+
+        try {
+            mGray.push_back(handle);
+        } catch (...) {
+            mGrayOverflow = true;
+        }
+    }
+
+    void Heap::markFields(Object* object) {
+        Value* fields = object->fields();
+        for (u32 i = 0; i < object->fieldCount; i++) mark(fields[i]);
+    }
+
+    void Heap::markRoots() {
+        Value* slots = mStack.data();
+        i64 sp = std::clamp<i64>(mStack.sp().integer(), 0, mStack.capacity());
+        for (i64 i = 0; i < sp; i++) mark(slots[i]);
+
+        mark(mAcc);
+
+        // young objects aren't marked or swept, so any of them may be what keeps an old object alive
+        if (!mNursery.isReserved()) return;
+
+        for (u8* byte = mNursery.begin(); byte < mNursery.top();) {
+            Object* object = reinterpret_cast<Object*>(byte);
+            byte += ObjectSize(object->fieldCount);
+
+            markFields(object);
+        }
+    }
+
+    bool Heap::stepOld(std::chrono::steady_clock::time_point deadline) {
+        mStats.oldSteps++;
+
+        while (true) {
+            switch (mOldPhase) {
+                case OldPhase::Idle:
+                    mMark++;
+                    mOldPhase = OldPhase::Mark;
+                    markRoots();
+                    break;
+
+                case OldPhase::Mark:
+                    if (!stepMark(deadline)) return false;
+
+                    mOldPhase = OldPhase::Sweep;
+                    mSweepRegion = 0;
+                    mSweepLargeObject = 0;
+                    mLiveBytes = 0;
+                    mFragmented.clear();
+                    break;
+
+                case OldPhase::Sweep:
+                    if (!stepSweep(deadline)) return false;
+
+                    // the least live first, as those free a region for the least copying
+                    std::sort(mFragmented.begin(), mFragmented.end(), [](const Region* a, const Region* b) {
+                        return a->liveBytes < b->liveBytes;
+                    });
+
+                    mOldPhase = OldPhase::Evacuate;
+                    mEvacuateRegion = 0;
+                    mEvacuatePosition = nullptr;
+                    break;
+
+                case OldPhase::Evacuate:
+                    if (!stepEvacuate(deadline)) return false;
+
+                    mOldPhase = OldPhase::Idle;
+                    mFragmented.clear();
+                    mOldTrigger = std::max(MinOldTrigger, mLiveBytes * 2);
+                    mStats.oldCollections++;
+                    return true;
+            }
+
+            if (Clock::now() >= deadline) return false;
+        }
+    }
+
+    bool Heap::stepMark(std::chrono::steady_clock::time_point deadline) {
+        bool scanning = !mGray.empty() || mGrayOverflow;
+
+        if (!drainGray(deadline)) return false;
+        if (scanning && Clock::now() >= deadline) return false; // the last scan of the roots gets a step of its own then
+
+        // what the roots and the nursery hold changed without going through store, so they're scanned again, and what
+        // that finds is marked without a deadline. once it's done, everything reachable is marked
+        markRoots();
+        drainGray(Clock::time_point::max());
+
+        return true;
+    }
+
+    bool Heap::drainGray(std::chrono::steady_clock::time_point deadline) {
+        size_t scanned = 0;
+
+        while (true) {
+            while (!mGray.empty()) {
+                if (++scanned % ObjectsPerClockCheck == 0 && Clock::now() >= deadline) return false;
+
+                Handle* handle = mGray.back();
+                mGray.pop_back();
+
+                markFields(handle->obj);
+            }
+
+            if (!mGrayOverflow) return true;
+
+            // some marked objects never made it into mGray, so every one is scanned again
+            mGrayOverflow = false;
+            forEachOldObject([this](Object* object) {
+                if (object->mark == mMark) markFields(object);
+            });
+        }
+    }
+
+    bool Heap::stepSweep(std::chrono::steady_clock::time_point deadline) {
+        HandleTable::FreeBatch dead;
+        bool done = true;
+
+        while (mSweepRegion < mOld.regionCount()) {
+            Region& region = mOld.region(mSweepRegion);
+            sweepRegion(region, dead);
+            mLiveBytes += region.liveBytes;
+
+            if (!mOld.isCurrent(region) && region.liveBytes == 0) {
+                mOld.freeRegion(region); // the next one moves to mSweepRegion
+            } else {
+                if (!mOld.isCurrent(region) && RegionHeap::IsFragmented(region)) {
+                    try {
+                        mFragmented.push_back(&region);
+                    } catch (...) {
+                        // it's left as it is until the next collection
+                    }
+                }
+
+                mSweepRegion++;
+            }
+
+            if (Clock::now() >= deadline) {
+                done = false;
+                break;
+            }
+        }
+
+        for (size_t swept = 0; done && mSweepLargeObject < mOld.largeObjectCount(); swept++) {
+            if (swept % ObjectsPerClockCheck == ObjectsPerClockCheck - 1 && Clock::now() >= deadline) {
+                done = false;
+                break;
+            }
+
+            Object* object = mOld.largeObject(mSweepLargeObject);
+            bool owned = object->handle != nullptr && object->handle->obj == object;
+
+            if (owned && object->mark == mMark) {
+                mLiveBytes += ObjectSize(object->fieldCount);
+                mSweepLargeObject++;
+                continue;
+            }
+
+            if (owned) dead.add(object->handle);
+            mOld.freeLargeObject(mSweepLargeObject); // the last one moves to mSweepLargeObject
+        }
+
+        mHandles.release(dead);
+
+        return done;
+    }
+
+    bool Heap::stepEvacuate(std::chrono::steady_clock::time_point deadline) {
+        size_t scanned = 0;
+
+        while (mEvacuateRegion < mFragmented.size()) {
+            Region& region = *mFragmented[mEvacuateRegion];
+            if (mEvacuatePosition == nullptr) mEvacuatePosition = region.begin();
+
+            while (mEvacuatePosition < region.top) {
+                if (++scanned % ObjectsPerClockCheck == 0 && Clock::now() >= deadline) return false;
+
+                Object* object = reinterpret_cast<Object*>(mEvacuatePosition);
+                size_t size = ObjectSize(object->fieldCount);
+
+                if (object->handle != nullptr && object->handle->obj == object) {
+                    // into the current region, which is never one being evacuated
+                    Object* copy = mOld.allocate(size);
+                    if (copy == nullptr) return true; // what's left stays where it is until the next collection
+
+                    std::memcpy(copy, object, size);
+                    object->handle->obj = copy;
+
+                    mStats.evacuatedBytes += size;
+                }
+
+                mEvacuatePosition += size;
+            }
+
+            mOld.freeRegion(region);
+
+            mEvacuateRegion++;
+            mEvacuatePosition = nullptr;
+        }
+
+        return true;
+    }
+
+    void Heap::sweepRegion(Region& region, HandleTable::FreeBatch& dead) {
+        size_t live = 0;
+
+        for (u8* byte = region.begin(); byte < region.top;) {
+            Object* object = reinterpret_cast<Object*>(byte);
+            size_t size = ObjectSize(object->fieldCount);
+            byte += size;
+
+            // the space of an allocation that failed, or an object that was evacuated
+            if (object->handle == nullptr || object->handle->obj != object) continue;
+
+            if (object->mark == mMark) live += size;
+            else dead.add(object->handle);
+        }
+
+        region.liveBytes = live;
+    }
+}
@@ -0,0 +1,73 @@
+// Copyright 2025 JesusTouchMe
+
+#include "BibbleVM/core/gc/nursery.h"
+
+#include <utility>
+
+namespace bibble {
+    Nursery::Nursery(size_t size)
+        : mSize(size / sizeof(Value) * sizeof(Value)) {}
+
+    bool Nursery::isReserved() const {
+        return mBegin != nullptr;
+    }
+
+    bool Nursery::reserve() {
+        try {
+            // left uninitialized, allocation clears what it hands out
+            mSpaces[0] = std::make_unique_for_overwrite<u8[]>(mSize);
+            mSpaces[1] = std::make_unique_for_overwrite<u8[]>(mSize);
+        } catch (...) {
+            mSpaces[0].reset();
+            return false;
+        }
+
+        mBegin = mSpaces[0].get();
+        mTop = mBegin;
+        mEnd = mBegin + mSize;
+
+        mToBegin = mSpaces[1].get();
+        mToTop = mToBegin;
+
+        return true;
+    }
+
+    Object* Nursery::copy(size_t size) {
+        Object* object = reinterpret_cast<Object*>(mToTop);
+        mToTop += size;
+
+        return object;
+    }
+
+    u8* Nursery::begin() const {
+        return mBegin;
+    }
+
+    u8* Nursery::top() const {
+        return mTop;
+    }
+
+    u8* Nursery::toBegin() const {
+        return mToBegin;
+    }
+
+    u8* Nursery::toTop() const {
+        return mToTop;
+    }
+
+    size_t Nursery::capacity() const {
+        return mSize;
+    }
+
+    size_t Nursery::used() const {
+        return mTop - mBegin;
+    }
+
+    void Nursery::flip() {
+        std::swap(mBegin, mToBegin);
+
+        mTop = mToTop;
+        mEnd = mBegin + mSize;
+        mToTop = mToBegin;
+    }
+}
@@ -0,0 +1,101 @@
+// Copyright 2025 JesusTouchMe
+
+#include "BibbleVM/core/gc/region_heap.h"
+
+#include <algorithm>
+
+namespace bibble {
+    Object* RegionHeap::allocate(size_t size) {
+        if (size > LargeObjectSize) {
+            try {
+                mLargeObjects.push_back(std::make_unique_for_overwrite<u8[]>(size));
+            } catch (...) {
+                return nullptr;
+            }
+
+            mUsedBytes += size;
+            return reinterpret_cast<Object*>(mLargeObjects.back().get());
+        }
+
+        if (mCurrent == nullptr || size > static_cast<size_t>(mCurrent->begin() + RegionSize - mCurrent->top)) {
+            if (!startRegion()) return nullptr;
+        }
+
+        Object* object = reinterpret_cast<Object*>(mCurrent->top);
+        mCurrent->top += size;
+        mUsedBytes += size;
+
+        return object;
+    }
+
+    size_t RegionHeap::regionCount() const {
+        return mRegions.size();
+    }
+
+    Region& RegionHeap::region(size_t index) {
+        return *mRegions[index];
+    }
+
+    bool RegionHeap::isCurrent(const Region& region) const {
+        return &region == mCurrent;
+    }
+
+    void RegionHeap::freeRegion(Region& region) {
+        auto it = std::find_if(mRegions.begin(), mRegions.end(), [&region](const std::unique_ptr<Region>& other) {
+            return other.get() == &region;
+        });
+
+        if (&region == mCurrent) mCurrent = nullptr;
+        mUsedBytes -= region.usedBytes();
+
+        if (mPool.size() < MaxPooledRegions) {
+            try {
+                mPool.push_back(std::move(region.memory));
+            } catch (...) {
+                // it's freed with the region then
+            }
+        }
+
+        mRegions.erase(it);
+    }
+
+    size_t RegionHeap::largeObjectCount() const {
+        return mLargeObjects.size();
+    }
+
+    Object* RegionHeap::largeObject(size_t index) const {
+        return reinterpret_cast<Object*>(mLargeObjects[index].get());
+    }
+
+    void RegionHeap::freeLargeObject(size_t index) {
+        mUsedBytes -= ObjectSize(largeObject(index)->fieldCount);
+
+        mLargeObjects[index] = std::move(mLargeObjects.back());
+        mLargeObjects.pop_back();
+    }
+
+    size_t RegionHeap::usedBytes() const {
+        return mUsedBytes;
+    }
+
+    bool RegionHeap::startRegion() {
+        try {
+            auto region = std::make_unique<Region>();
+
+            if (!mPool.empty()) {
+                region->memory = std::move(mPool.back());
+                mPool.pop_back();
+            } else {
+                region->memory = std::make_unique_for_overwrite<u8[]>(RegionSize);
+            }
+
+            region->top = region->memory.get();
+            mRegions.push_back(std::move(region));
+        } catch (...) {
+            return false;
+        }
+
+        mCurrent = mRegions.back().get();
+        return true;
+    }
+}
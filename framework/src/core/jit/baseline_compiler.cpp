@@ -0,0 +1,664 @@
+// Copyright 2025 JesusTouchMe
+
+#include "BibbleVM/core/jit/baseline_compiler.h"
+
+#include "BibbleVM/core/bytecode/operand_layout.h"
+
+#include "BibbleVM/core/exec/superinstruction.h"
+
+#include "BibbleVM/core/vm.h"
+
+#if BIBBLEVM_JIT
+#include "BibbleVM/core/jit/runtime.h"
+#include "BibbleVM/core/jit/x64_assembler.h"
+
+#include <bit>
+#include <cstddef>
+#include <limits>
+#endif
+
+namespace bibble {
+#if BIBBLEVM_JIT
+    using x64::AluOp;
+    using x64::Cond;
+    using x64::Mem;
+    using x64::Reg;
+    using x64::SseOp;
+    using x64::Xmm;
+
+    // Pinned for the whole function. All callee-saved in the System V ABI, so they survive calls into the runtime
+    constexpr Reg AccReg = Reg::RBX;
+    constexpr Reg SpReg = Reg::R12;
+    constexpr Reg FrameReg = Reg::R13;
+    constexpr Reg VmReg = Reg::R14;
+    constexpr Reg StateReg = Reg::R15;
+
+    constexpr i32 AccOffset = offsetof(ExecState, acc);
+    constexpr i32 SpOffset = offsetof(ExecState, sp);
+    constexpr i32 FrameOffset = offsetof(ExecState, frame);
+    constexpr i32 StackOffset = offsetof(ExecState, stack);
+    constexpr i32 LimitOffset = offsetof(ExecState, limit);
+
+    constexpr i32 SlotSize = sizeof(Value);
+
+    enum class IntOp {
+        Add, Sub, Mul, Div, Mod, And, Or, Xor, Shl, Shr,
+    };
+
+    struct CompiledCode {
+        std::vector<u8> code;
+        size_t resumeOffset; // of the NativeResumeEntry
+        std::vector<u32> offsets; // of every instruction
+    };
+
+    class BaselineCompiler {
+    public:
+        BaselineCompiler(const DecodedFunction& function, const DispatchTables& tables, bool countBackEdges)
+            : mFunction(function)
+            , mTables(tables)
+            , mCountBackEdges(countBackEdges) {}
+
+        std::optional<CompiledCode> compile() {
+            const std::vector<Instruction>& instructions = mFunction.instructions;
+
+            mLabels.reserve(instructions.size());
+            for (size_t i = 0; i < instructions.size(); i++) {
+                mLabels.push_back(mAsm.newLabel());
+            }
+
+            mFail = mAsm.newLabel();
+            mExit = mAsm.newLabel();
+
+            prologue();
+            if (mFunction.entryIndex != 0) mAsm.jmp(mLabels[mFunction.entryIndex]);
+
+            // the trailing sentinel is invalid, so nothing falls off the end
+            for (size_t i = 0; i < instructions.size(); i++) {
+                mAsm.bind(mLabels[i]);
+                if (!compileInstruction(instructions[i])) return std::nullopt;
+            }
+
+            mAsm.bind(mFail);
+            mAsm.mov(Reg::RDI, VmReg);
+            mAsm.mov(Reg::RSI, -2);
+            callRuntime(reinterpret_cast<const void*>(&CompiledExit));
+            mAsm.mov(Reg::RAX, DISPATCH_ERROR);
+
+            mAsm.bind(mExit);
+            epilogue();
+
+            // same frame setup as the entry, then straight to the instruction the caller picked. the labels are all
+            // there already, so everything after it is shared
+            size_t resumeOffset = mAsm.getPosition();
+            prologue();
+            mAsm.jmp(Reg::RDX);
+
+            std::vector<u32> offsets;
+            offsets.reserve(instructions.size());
+            for (x64::Assembler::Label label : mLabels) {
+                offsets.push_back(static_cast<u32>(mAsm.getPosition(label)));
+            }
+
+            return CompiledCode{ mAsm.finish(), resumeOffset, std::move(offsets) };
+        }
+
+    private:
+        const DecodedFunction& mFunction;
+        const DispatchTables& mTables;
+        bool mCountBackEdges;
+
+        x64::Assembler mAsm;
+        std::vector<x64::Assembler::Label> mLabels; // one per instruction
+        x64::Assembler::Label mFail; // exits the VM with -2 like DISPATCH_FAIL
+        x64::Assembler::Label mExit; // returns eax
+
+        void prologue() {
+            mAsm.push(Reg::RBP);
+            mAsm.mov(Reg::RBP, Reg::RSP);
+            mAsm.push(AccReg);
+            mAsm.push(SpReg);
+            mAsm.push(FrameReg);
+            mAsm.push(VmReg);
+            mAsm.push(StateReg);
+            mAsm.alu(AluOp::SUB, Reg::RSP, 8); // calls need rsp 16-byte aligned
+
+            mAsm.mov(VmReg, Reg::RDI);
+            mAsm.mov(StateReg, Reg::RSI);
+            reload();
+        }
+
+        void epilogue() {
+            spill();
+
+            mAsm.alu(AluOp::ADD, Reg::RSP, 8);
+            mAsm.pop(StateReg);
+            mAsm.pop(VmReg);
+            mAsm.pop(FrameReg);
+            mAsm.pop(SpReg);
+            mAsm.pop(AccReg);
+            mAsm.pop(Reg::RBP);
+            mAsm.ret();
+        }
+
+        void spill() {
+            mAsm.mov(Mem{ StateReg, AccOffset }, AccReg);
+            mAsm.mov(Mem{ StateReg, SpOffset }, SpReg);
+        }
+
+        void reload() {
+            mAsm.mov(AccReg, Mem{ StateReg, AccOffset });
+            mAsm.mov(SpReg, Mem{ StateReg, SpOffset });
+            mAsm.mov(FrameReg, Mem{ StateReg, FrameOffset });
+        }
+
+        void callRuntime(const void* function) {
+            mAsm.mov(Reg::RAX, static_cast<i64>(reinterpret_cast<uintptr_t>(function)));
+            mAsm.call(Reg::RAX);
+        }
+
+        // Calls a DispatchErr returning runtime function with (vm, state, arg) and leaves with its result unless it's
+        // DISPATCH_SUCCESS. State is spilled around it and reloaded after either way, since the runtime can finish the
+        // frame on its own
+        void callRuntimeChecked(const void* function, i64 argument) {
+            spill();
+            mAsm.mov(Reg::RDI, VmReg);
+            mAsm.mov(Reg::RSI, StateReg);
+            mAsm.mov(Reg::RDX, argument);
+            callRuntime(function);
+            mAsm.test(Reg::RAX, Reg::RAX); // DispatchErr is an int, but the upper half is never looked at after this
+            reload(); // leaves the flags alone
+            mAsm.jcc(Cond::NE, mExit);
+        }
+
+        bool isCountedBackEdge(const Instruction& inst) const {
+            DispatchHandler handler = GetBackEdgeHandler(mTables, inst.opcode);
+            return mCountBackEdges && handler != nullptr && inst.handler == handler;
+        }
+
+        // Counts down the same counter the interpreter's back-edge handlers use, towards the optimizing tier. The
+        // instruction never moves, so its address is a constant here
+        void countBackEdge(const Instruction& inst) {
+            x64::Assembler::Label notHot = mAsm.newLabel();
+
+            mAsm.mov(Reg::RAX, static_cast<i64>(reinterpret_cast<uintptr_t>(&inst.counter)));
+            mAsm.alu32(AluOp::SUB, Mem{ Reg::RAX }, 1);
+            mAsm.jcc(Cond::NE, notHot);
+            callRuntimeChecked(reinterpret_cast<const void*>(&CompiledLoopHot), static_cast<i64>(reinterpret_cast<uintptr_t>(&inst)));
+            mAsm.bind(notHot);
+        }
+
+        // JZ and JNZ. Taken if acc <cond> 0
+        void branch(const Instruction& inst, Cond taken, Cond notTaken) {
+            mAsm.test(AccReg, AccReg);
+
+            if (!isCountedBackEdge(inst)) {
+                mAsm.jcc(taken, mLabels[inst.a]);
+                return;
+            }
+
+            x64::Assembler::Label fallThrough = mAsm.newLabel();
+            mAsm.jcc(notTaken, fallThrough);
+            countBackEdge(inst);
+            mAsm.jmp(mLabels[inst.a]);
+            mAsm.bind(fallThrough);
+        }
+
+        void leave(DispatchErr err) {
+            mAsm.mov(Reg::RAX, err);
+            mAsm.jmp(mExit);
+        }
+
+        static Mem top(i32 index = 0) { // index 0 is the top value, 1 the one below it
+            return { SpReg, -(index + 1) * SlotSize };
+        }
+
+        Mem local(const Instruction& inst) const {
+            return { FrameReg, static_cast<i32>(inst.a) * SlotSize };
+        }
+
+        void push(Reg value) {
+            mAsm.mov(Mem{ SpReg }, value);
+            mAsm.alu(AluOp::ADD, SpReg, SlotSize);
+        }
+
+        void drop(i32 count) {
+            mAsm.alu(AluOp::SUB, SpReg, count * SlotSize);
+        }
+
+        // dst op= rcx. dst can't be rax, rcx or rdx, which division and shifts use
+        void intOp(IntOp op, Reg dst) {
+            switch (op) {
+                case IntOp::Add: mAsm.alu(AluOp::ADD, dst, Reg::RCX); break;
+                case IntOp::Sub: mAsm.alu(AluOp::SUB, dst, Reg::RCX); break;
+                case IntOp::And: mAsm.alu(AluOp::AND, dst, Reg::RCX); break;
+                case IntOp::Or: mAsm.alu(AluOp::OR, dst, Reg::RCX); break;
+                case IntOp::Xor: mAsm.alu(AluOp::XOR, dst, Reg::RCX); break;
+                case IntOp::Mul: mAsm.imul(dst, Reg::RCX); break;
+                case IntOp::Shl: mAsm.shlCl(dst); break;
+                case IntOp::Shr: mAsm.sarCl(dst); break;
+
+                case IntOp::Div:
+                case IntOp::Mod:
+                    mAsm.mov(Reg::RAX, dst);
+                    mAsm.cqo();
+                    mAsm.idiv(Reg::RCX);
+                    mAsm.mov(dst, op == IntOp::Div ? Reg::RAX : Reg::RDX);
+                    break;
+            }
+        }
+
+        // acc = acc op pop()
+        void intPop(IntOp op) {
+            drop(1);
+            mAsm.mov(Reg::RCX, Mem{ SpReg });
+            intOp(op, AccReg);
+        }
+
+        // b = pop(), a = pop(), acc = a op b
+        void intPop2(IntOp op) {
+            drop(2);
+            mAsm.mov(AccReg, Mem{ SpReg });
+            mAsm.mov(Reg::RCX, Mem{ SpReg, SlotSize });
+            intOp(op, AccReg);
+        }
+
+        // b = pop(), a = pop(), push(a op b)
+        void intStack(IntOp op) {
+            drop(1);
+            mAsm.mov(Reg::RSI, top());
+            mAsm.mov(Reg::RCX, Mem{ SpReg });
+            intOp(op, Reg::RSI);
+            mAsm.mov(top(), Reg::RSI);
+        }
+
+        void intImm(IntOp op, i64 value) {
+            mAsm.mov(Reg::RCX, value);
+            intOp(op, AccReg);
+        }
+
+        void intImmStack(IntOp op, i64 value) {
+            mAsm.mov(Reg::RSI, top());
+            mAsm.mov(Reg::RCX, value);
+            intOp(op, Reg::RSI);
+            mAsm.mov(top(), Reg::RSI);
+        }
+
+        // xmm0 op= xmm1
+        void floatOp(SseOp op) {
+            mAsm.sse(op, Xmm::XMM0, Xmm::XMM1);
+        }
+
+        void floatPop(SseOp op) {
+            drop(1);
+            mAsm.movq(Xmm::XMM0, AccReg);
+            mAsm.movsd(Xmm::XMM1, Mem{ SpReg });
+            floatOp(op);
+            mAsm.movq(AccReg, Xmm::XMM0);
+        }
+
+        void floatPop2(SseOp op) {
+            drop(2);
+            mAsm.movsd(Xmm::XMM0, Mem{ SpReg });
+            mAsm.movsd(Xmm::XMM1, Mem{ SpReg, SlotSize });
+            floatOp(op);
+            mAsm.movq(AccReg, Xmm::XMM0);
+        }
+
+        void floatStack(SseOp op) {
+            drop(1);
+            mAsm.movsd(Xmm::XMM0, top());
+            mAsm.movsd(Xmm::XMM1, Mem{ SpReg });
+            floatOp(op);
+            mAsm.movsd(top(), Xmm::XMM0);
+        }
+
+        void floatImm(SseOp op, double value) {
+            mAsm.movq(Xmm::XMM0, AccReg);
+            mAsm.mov(Reg::RAX, std::bit_cast<i64>(value));
+            mAsm.movq(Xmm::XMM1, Reg::RAX);
+            floatOp(op);
+            mAsm.movq(AccReg, Xmm::XMM0);
+        }
+
+        void floatImmStack(SseOp op, double value) {
+            mAsm.movsd(Xmm::XMM0, top());
+            mAsm.mov(Reg::RAX, std::bit_cast<i64>(value));
+            mAsm.movq(Xmm::XMM1, Reg::RAX);
+            floatOp(op);
+            mAsm.movsd(top(), Xmm::XMM0);
+        }
+
+        // acc = acc <cond> rcx, as 0 or 1
+        void intCompare(Cond cond) {
+            mAsm.alu(AluOp::CMP, AccReg, Reg::RCX);
+            mAsm.setcc(cond, Reg::RAX);
+            mAsm.movzxByte(AccReg, Reg::RAX);
+        }
+
+        // acc = xmm0 <cond> xmm1, as 0 or 1
+        void floatCompare(Cond cond) {
+            mAsm.compareSd(cond);
+            mAsm.mov(AccReg, Reg::RAX);
+        }
+
+        void intComparePop(Cond cond) {
+            drop(1);
+            mAsm.mov(Reg::RCX, Mem{ SpReg });
+            intCompare(cond);
+        }
+
+        void intCompareZero(Cond cond) {
+            mAsm.test(AccReg, AccReg);
+            mAsm.setcc(cond, Reg::RAX);
+            mAsm.movzxByte(AccReg, Reg::RAX);
+        }
+
+        void floatComparePop(Cond cond) {
+            drop(1);
+            mAsm.movq(Xmm::XMM0, AccReg);
+            mAsm.movsd(Xmm::XMM1, Mem{ SpReg });
+            floatCompare(cond);
+        }
+
+        void floatCompareZero(Cond cond) {
+            mAsm.movq(Xmm::XMM0, AccReg);
+            mAsm.xorpd(Xmm::XMM1, Xmm::XMM1);
+            floatCompare(cond);
+        }
+
+        void trap(u8 trapCode) {
+            callRuntimeChecked(reinterpret_cast<const void*>(&CompiledTrap), trapCode);
+        }
+
+        // Superinstructions are compiled as their first part. The rest follow as their own instructions anyway
+        static std::optional<ByteOpcode> GetOpcode(const Instruction& inst) {
+            ByteOpcode opcode = GetLeadingOpcode(inst.opcode);
+            if (!GetOperandLayout(opcode).has_value()) return std::nullopt;
+
+            return opcode;
+        }
+
+        // false if inst can't be compiled, which leaves the whole function to the interpreter
+        bool compileInstruction(const Instruction& inst) {
+            std::optional<ByteOpcode> opcodeOpt = GetOpcode(inst);
+            if (inst.handler == mTables.invalidHandler || !opcodeOpt.has_value()) {
+                leave(DISPATCH_ERROR);
+                return true;
+            }
+
+            i64 imm = inst.imm.integer();
+            double fimm = inst.imm.floating();
+
+            switch (opcodeOpt.value()) {
+                case ByteOpcode::NOP:
+                case ByteOpcode::BRK:
+                    return true;
+
+                case ByteOpcode::HLT:
+                    mAsm.mov(Reg::RDI, VmReg);
+                    mAsm.mov(Reg::RSI, imm);
+                    callRuntime(reinterpret_cast<const void*>(&CompiledExit));
+                    leave(DISPATCH_RETURN);
+                    return true;
+
+                case ByteOpcode::TRAP:
+                    trap(static_cast<u8>(inst.a));
+                    return true;
+
+                case ByteOpcode::TRAP_IF_ZERO:
+                case ByteOpcode::TRAP_IF_NOT_ZERO: {
+                    x64::Assembler::Label skip = mAsm.newLabel();
+                    mAsm.test(AccReg, AccReg);
+                    mAsm.jcc(opcodeOpt.value() == ByteOpcode::TRAP_IF_ZERO ? Cond::NE : Cond::E, skip);
+                    trap(static_cast<u8>(inst.a));
+                    mAsm.bind(skip);
+                    return true;
+                }
+
+                case ByteOpcode::ADD: intPop(IntOp::Add); return true;
+                case ByteOpcode::SUB: intPop(IntOp::Sub); return true;
+                case ByteOpcode::MUL: intPop(IntOp::Mul); return true;
+                case ByteOpcode::DIV: intPop(IntOp::Div); return true;
+                case ByteOpcode::MOD: intPop(IntOp::Mod); return true;
+                case ByteOpcode::AND: intPop(IntOp::And); return true;
+                case ByteOpcode::OR: intPop(IntOp::Or); return true;
+                case ByteOpcode::XOR: intPop(IntOp::Xor); return true;
+                case ByteOpcode::SHL: intPop(IntOp::Shl); return true;
+                case ByteOpcode::SHR: intPop(IntOp::Shr); return true;
+                case ByteOpcode::NEG: mAsm.neg(AccReg); return true;
+                case ByteOpcode::NOT: mAsm.not_(AccReg); return true;
+
+                case ByteOpcode::ADD2: intPop2(IntOp::Add); return true;
+                case ByteOpcode::SUB2: intPop2(IntOp::Sub); return true;
+                case ByteOpcode::MUL2: intPop2(IntOp::Mul); return true;
+                case ByteOpcode::DIV2: intPop2(IntOp::Div); return true;
+                case ByteOpcode::MOD2: intPop2(IntOp::Mod); return true;
+                case ByteOpcode::AND2: intPop2(IntOp::And); return true;
+                case ByteOpcode::OR2: intPop2(IntOp::Or); return true;
+                case ByteOpcode::XOR2: intPop2(IntOp::Xor); return true;
+                case ByteOpcode::SHL2: intPop2(IntOp::Shl); return true;
+                case ByteOpcode::SHR2: intPop2(IntOp::Shr); return true;
+
+                case ByteOpcode::ADD_ST: intStack(IntOp::Add); return true;
+                case ByteOpcode::SUB_ST: intStack(IntOp::Sub); return true;
+                case ByteOpcode::MUL_ST: intStack(IntOp::Mul); return true;
+                case ByteOpcode::DIV_ST: intStack(IntOp::Div); return true;
+                case ByteOpcode::MOD_ST: intStack(IntOp::Mod); return true;
+                case ByteOpcode::AND_ST: intStack(IntOp::And); return true;
+                case ByteOpcode::OR_ST: intStack(IntOp::Or); return true;
+                case ByteOpcode::XOR_ST: intStack(IntOp::Xor); return true;
+                case ByteOpcode::SHL_ST: intStack(IntOp::Shl); return true;
+                case ByteOpcode::SHR_ST: intStack(IntOp::Shr); return true;
+                case ByteOpcode::NEG_ST: mAsm.neg(top()); return true;
+                case ByteOpcode::NOT_ST: mAsm.not_(top()); return true;
+
+                case ByteOpcode::ADD_IMM: intImm(IntOp::Add, imm); return true;
+                case ByteOpcode::SUB_IMM: intImm(IntOp::Sub, imm); return true;
+                case ByteOpcode::MUL_IMM: intImm(IntOp::Mul, imm); return true;
+                case ByteOpcode::DIV_IMM: intImm(IntOp::Div, imm); return true;
+                case ByteOpcode::MOD_IMM: intImm(IntOp::Mod, imm); return true;
+                case ByteOpcode::AND_IMM: intImm(IntOp::And, imm); return true;
+                case ByteOpcode::OR_IMM: intImm(IntOp::Or, imm); return true;
+                case ByteOpcode::XOR_IMM: intImm(IntOp::Xor, imm); return true;
+                case ByteOpcode::SHL_IMM: intImm(IntOp::Shl, imm); return true;
+                case ByteOpcode::SHR_IMM: intImm(IntOp::Shr, imm); return true;
+
+                case ByteOpcode::ADD_IMM_ST: intImmStack(IntOp::Add, imm); return true;
+                case ByteOpcode::SUB_IMM_ST: intImmStack(IntOp::Sub, imm); return true;
+                case ByteOpcode::MUL_IMM_ST: intImmStack(IntOp::Mul, imm); return true;
+                case ByteOpcode::DIV_IMM_ST: intImmStack(IntOp::Div, imm); return true;
+                case ByteOpcode::MOD_IMM_ST: intImmStack(IntOp::Mod, imm); return true;
+                case ByteOpcode::AND_IMM_ST: intImmStack(IntOp::And, imm); return true;
+                case ByteOpcode::OR_IMM_ST: intImmStack(IntOp::Or, imm); return true;
+                case ByteOpcode::XOR_IMM_ST: intImmStack(IntOp::Xor, imm); return true;
+                case ByteOpcode::SHL_IMM_ST: intImmStack(IntOp::Shl, imm); return true;
+                case ByteOpcode::SHR_IMM_ST: intImmStack(IntOp::Shr, imm); return true;
+
+                case ByteOpcode::FADD: floatPop(SseOp::ADDSD); return true;
+                case ByteOpcode::FSUB: floatPop(SseOp::SUBSD); return true;
+                case ByteOpcode::FMUL: floatPop(SseOp::MULSD); return true;
+                case ByteOpcode::FDIV: floatPop(SseOp::DIVSD); return true;
+                case ByteOpcode::FADD2: floatPop2(SseOp::ADDSD); return true;
+                case ByteOpcode::FSUB2: floatPop2(SseOp::SUBSD); return true;
+                case ByteOpcode::FMUL2: floatPop2(SseOp::MULSD); return true;
+                case ByteOpcode::FDIV2: floatPop2(SseOp::DIVSD); return true;
+                case ByteOpcode::FADD_ST: floatStack(SseOp::ADDSD); return true;
+                case ByteOpcode::FSUB_ST: floatStack(SseOp::SUBSD); return true;
+                case ByteOpcode::FMUL_ST: floatStack(SseOp::MULSD); return true;
+                case ByteOpcode::FDIV_ST: floatStack(SseOp::DIVSD); return true;
+
+                case ByteOpcode::FNEG:
+                    mAsm.mov(Reg::RAX, std::numeric_limits<i64>::min()); // sign bit
+                    mAsm.alu(AluOp::XOR, AccReg, Reg::RAX);
+                    return true;
+
+                case ByteOpcode::FADD_IMM: floatImm(SseOp::ADDSD, fimm); return true;
+                case ByteOpcode::FSUB_IMM: floatImm(SseOp::SUBSD, fimm); return true;
+                case ByteOpcode::FMUL_IMM: floatImm(SseOp::MULSD, fimm); return true;
+                case ByteOpcode::FDIV_IMM: floatImm(SseOp::DIVSD, fimm); return true;
+                case ByteOpcode::FADD_IMM_ST: floatImmStack(SseOp::ADDSD, fimm); return true;
+                case ByteOpcode::FSUB_IMM_ST: floatImmStack(SseOp::SUBSD, fimm); return true;
+                case ByteOpcode::FMUL_IMM_ST: floatImmStack(SseOp::MULSD, fimm); return true;
+                case ByteOpcode::FDIV_IMM_ST: floatImmStack(SseOp::DIVSD, fimm); return true;
+
+                case ByteOpcode::CMP_EQ: intComparePop(Cond::E); return true;
+                case ByteOpcode::CMP_NE: intComparePop(Cond::NE); return true;
+                case ByteOpcode::CMP_LT: intComparePop(Cond::L); return true;
+                case ByteOpcode::CMP_GT: intComparePop(Cond::G); return true;
+                case ByteOpcode::CMP_LTE: intComparePop(Cond::LE); return true;
+                case ByteOpcode::CMP_GTE: intComparePop(Cond::GE); return true;
+                case ByteOpcode::FCMP_EQ: floatComparePop(Cond::E); return true;
+                case ByteOpcode::FCMP_NE: floatComparePop(Cond::NE); return true;
+                case ByteOpcode::FCMP_LT: floatComparePop(Cond::L); return true;
+                case ByteOpcode::FCMP_GT: floatComparePop(Cond::G); return true;
+                case ByteOpcode::FCMP_LTE: floatComparePop(Cond::LE); return true;
+                case ByteOpcode::FCMP_GTE: floatComparePop(Cond::GE); return true;
+
+                case ByteOpcode::CMP_EQ0: intCompareZero(Cond::E); return true;
+                case ByteOpcode::CMP_NE0: intCompareZero(Cond::NE); return true;
+                case ByteOpcode::CMP_LT0: intCompareZero(Cond::L); return true;
+                case ByteOpcode::CMP_GT0: intCompareZero(Cond::G); return true;
+                case ByteOpcode::CMP_LTE0: intCompareZero(Cond::LE); return true;
+                case ByteOpcode::CMP_GTE0: intCompareZero(Cond::GE); return true;
+                case ByteOpcode::FCMP_EQ0: floatCompareZero(Cond::E); return true;
+                case ByteOpcode::FCMP_NE0: floatCompareZero(Cond::NE); return true;
+                case ByteOpcode::FCMP_LT0: floatCompareZero(Cond::L); return true;
+                case ByteOpcode::FCMP_GT0: floatCompareZero(Cond::G); return true;
+                case ByteOpcode::FCMP_LTE0: floatCompareZero(Cond::LE); return true;
+                case ByteOpcode::FCMP_GTE0: floatCompareZero(Cond::GE); return true;
+
+                case ByteOpcode::PUSH_ACC:
+                    push(AccReg);
+                    return true;
+
+                case ByteOpcode::PUSH_SP: // as a slot index
+                    mAsm.mov(Reg::RAX, SpReg);
+                    mAsm.mov(Reg::RCX, Mem{ StateReg, StackOffset });
+                    mAsm.alu(AluOp::SUB, Reg::RAX, Reg::RCX);
+                    mAsm.mov(Reg::RCX, 3);
+                    mAsm.sarCl(Reg::RAX);
+                    push(Reg::RAX);
+                    return true;
+
+                case ByteOpcode::POP_ACC:
+                    drop(1);
+                    mAsm.mov(AccReg, Mem{ SpReg });
+                    return true;
+
+                case ByteOpcode::POP_DISCARD:
+                    if (inst.a > std::numeric_limits<i32>::max() / SlotSize) return false;
+                    drop(static_cast<i32>(inst.a));
+                    return true;
+
+                case ByteOpcode::CONST:
+                case ByteOpcode::CONST32:
+                case ByteOpcode::CONST64:
+                    mAsm.mov(AccReg, imm);
+                    return true;
+
+                case ByteOpcode::CONST_ST:
+                case ByteOpcode::CONST32_ST:
+                case ByteOpcode::CONST64_ST:
+                    mAsm.mov(Reg::RAX, imm);
+                    push(Reg::RAX);
+                    return true;
+
+                case ByteOpcode::LOAD:
+                    mAsm.mov(AccReg, local(inst));
+                    return true;
+
+                case ByteOpcode::LOAD_ST:
+                    mAsm.mov(Reg::RAX, local(inst));
+                    push(Reg::RAX);
+                    return true;
+
+                case ByteOpcode::STORE:
+                    mAsm.mov(local(inst), AccReg);
+                    return true;
+
+                case ByteOpcode::STORE_ST:
+                    drop(1);
+                    mAsm.mov(Reg::RAX, Mem{ SpReg });
+                    mAsm.mov(local(inst), Reg::RAX);
+                    return true;
+
+                case ByteOpcode::RESERVE: // checked against the stack end or probed like the unchecked handler
+                    if (inst.a > std::numeric_limits<i32>::max() / SlotSize) return false;
+#if BIBBLEVM_STACK_GUARD
+                    mAsm.alu(AluOp::ADD, SpReg, static_cast<i32>(inst.a) * SlotSize);
+                    if (inst.a != 0) mAsm.mov(Reg::RAX, Mem{ SpReg, -SlotSize });
+#else
+                    mAsm.mov(Reg::RAX, Mem{ StateReg, LimitOffset });
+                    mAsm.alu(AluOp::SUB, Reg::RAX, SpReg);
+                    mAsm.alu(AluOp::CMP, Reg::RAX, static_cast<i32>(inst.a) * SlotSize);
+                    mAsm.jcc(Cond::BE, mFail);
+                    mAsm.alu(AluOp::ADD, SpReg, static_cast<i32>(inst.a) * SlotSize);
+#endif
+                    return true;
+
+                case ByteOpcode::JMP:
+                    if (isCountedBackEdge(inst)) countBackEdge(inst);
+                    mAsm.jmp(mLabels[inst.a]);
+                    return true;
+
+                case ByteOpcode::JZ:
+                    branch(inst, Cond::E, Cond::NE);
+                    return true;
+
+                case ByteOpcode::JNZ:
+                    branch(inst, Cond::NE, Cond::E);
+                    return true;
+
+                case ByteOpcode::CALL:
+                case ByteOpcode::CALL_EX:
+                case ByteOpcode::CALL_TINY:
+                case ByteOpcode::CALL_TINY_EX:
+                    // the instruction stays where it is once the function is stored in its module, so its inline
+                    // cache can be used from here too
+                    callRuntimeChecked(reinterpret_cast<const void*>(&CompiledCall), static_cast<i64>(reinterpret_cast<uintptr_t>(&inst)));
+                    return true;
+
+                case ByteOpcode::CALL_DYN:
+                    callRuntimeChecked(reinterpret_cast<const void*>(&CompiledCallDynamic), static_cast<i64>(reinterpret_cast<uintptr_t>(&inst)));
+                    return true;
+
+                case ByteOpcode::RET: // the caller pops the frame, whether it's the host, the interpreter or compiled code
+                    leave(DISPATCH_RETURN);
+                    return true;
+
+                default: // POP_SP never passes the verifier
+                    return false;
+            }
+        }
+    };
+#endif
+
+    bool CompileBaseline(const DecodedFunction& function, const DispatchTables& tables, bool countBackEdges) {
+#if BIBBLEVM_JIT
+        if (!function.verified) return false;
+
+        std::optional<CompiledCode> compiled = BaselineCompiler(function, tables, countBackEdges).compile();
+        if (!compiled.has_value()) return false;
+
+        std::optional<ExecutableMemory> memory = ExecutableMemory::Create(compiled->code);
+        if (!memory.has_value()) return false;
+
+        void* base = const_cast<void*>(memory->data());
+
+        NativeCode& native = function.baseline;
+        native.memory = std::move(memory.value());
+        native.offsets = std::move(compiled->offsets);
+        native.entry = reinterpret_cast<NativeEntry>(base);
+        native.resume = reinterpret_cast<NativeResumeEntry>(static_cast<u8*>(base) + compiled->resumeOffset);
+
+        function.native = native.entry;
+
+        return true;
+#else
+        (void) function;
+        (void) tables;
+        (void) countBackEdges;
+        return false;
+#endif
+    }
+}
@@ -0,0 +1,65 @@
+// Copyright 2025 JesusTouchMe
+
+#include "BibbleVM/core/jit/executable_memory.h"
+
+#include <cstring>
+#include <utility>
+
+#if BIBBLEVM_JIT
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace bibble {
+    ExecutableMemory::ExecutableMemory(ExecutableMemory&& other) noexcept
+        : mMemory(std::exchange(other.mMemory, nullptr))
+        , mSize(std::exchange(other.mSize, 0)) {}
+
+    ExecutableMemory& ExecutableMemory::operator=(ExecutableMemory&& other) noexcept {
+        if (this != &other) {
+            ExecutableMemory old(std::move(*this));
+            mMemory = std::exchange(other.mMemory, nullptr);
+            mSize = std::exchange(other.mSize, 0);
+        }
+
+        return *this;
+    }
+
+    ExecutableMemory::~ExecutableMemory() {
+#if BIBBLEVM_JIT
+        if (mMemory != nullptr) munmap(mMemory, mSize);
+#endif
+    }
+
+    std::optional<ExecutableMemory> ExecutableMemory::Create(std::span<const u8> code) {
+#if BIBBLEVM_JIT
+        if (code.empty()) return std::nullopt;
+
+        size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        size_t size = (code.size() + pageSize - 1) / pageSize * pageSize;
+
+        void* memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (memory == MAP_FAILED) return std::nullopt;
+
+        ExecutableMemory result;
+        result.mMemory = memory;
+        result.mSize = size;
+
+        std::memcpy(memory, code.data(), code.size());
+        if (mprotect(memory, size, PROT_READ | PROT_EXEC) != 0) return std::nullopt;
+
+        return result;
+#else
+        (void) code;
+        return std::nullopt;
+#endif
+    }
+
+    const void* ExecutableMemory::data() const {
+        return mMemory;
+    }
+
+    size_t ExecutableMemory::size() const {
+        return mSize;
+    }
+}
@@ -0,0 +1,161 @@
+// Copyright 2025 JesusTouchMe
+
+#include "BibbleVM/core/jit/ir.h"
+
+#include <algorithm>
+
+namespace bibble::ir {
+    bool IsPure(Op op) {
+        return op <= Op::Phi;
+    }
+
+    bool IsTerminator(Op op) {
+        return op >= Op::Jump;
+    }
+
+    bool IsFrameEffect(Op op) {
+        return op == Op::Call || op == Op::CallDynamic || op == Op::Trap;
+    }
+
+    BlockId Graph::addBlock() {
+        blocks.emplace_back();
+        return static_cast<BlockId>(blocks.size() - 1);
+    }
+
+    ValueId Graph::append(BlockId block, Op op, std::vector<ValueId> operands) {
+        ValueId value = static_cast<ValueId>(insts.size());
+        insts.push_back(Inst{ .op = op, .block = block, .operands = std::move(operands) });
+        blocks[block].insts.push_back(value);
+        return value;
+    }
+
+    ValueId Graph::prepend(BlockId block, Op op, std::vector<ValueId> operands) {
+        ValueId value = static_cast<ValueId>(insts.size());
+        insts.push_back(Inst{ .op = op, .block = block, .operands = std::move(operands) });
+        blocks[block].insts.insert(blocks[block].insts.begin(), value);
+        return value;
+    }
+
+    ValueId Graph::addConst(BlockId block, i64 value) {
+        ValueId constant = append(block, Op::Const);
+        insts[constant].imm = value;
+        return constant;
+    }
+
+    void Graph::addEdge(BlockId from, BlockId to) {
+        blocks[from].succs.push_back(to);
+        blocks[to].preds.push_back(from);
+    }
+
+    void Graph::removeEdge(BlockId from, size_t succIndex) {
+        BlockId to = blocks[from].succs[succIndex];
+        blocks[from].succs.erase(blocks[from].succs.begin() + static_cast<std::ptrdiff_t>(succIndex));
+
+        std::vector<BlockId>& preds = blocks[to].preds;
+        size_t predIndex = static_cast<size_t>(std::find(preds.begin(), preds.end(), from) - preds.begin());
+        preds.erase(preds.begin() + static_cast<std::ptrdiff_t>(predIndex));
+
+        for (ValueId value : blocks[to].insts) {
+            Inst& inst = insts[value];
+            if (inst.op != Op::Phi) break;
+
+            inst.operands.erase(inst.operands.begin() + static_cast<std::ptrdiff_t>(predIndex));
+        }
+    }
+
+    ValueId Graph::resolve(ValueId value) const {
+        while (insts[value].replacement != None) {
+            value = insts[value].replacement;
+        }
+
+        return value;
+    }
+
+    void Graph::replace(ValueId value, ValueId with) {
+        with = resolve(with);
+        if (with == value) return;
+
+        remove(value);
+        insts[value].replacement = with;
+    }
+
+    void Graph::remove(ValueId value) {
+        Inst& inst = insts[value];
+        if (inst.block == None) return;
+
+        std::vector<ValueId>& blockInsts = blocks[inst.block].insts;
+        blockInsts.erase(std::find(blockInsts.begin(), blockInsts.end(), value));
+        inst.block = None;
+    }
+
+    std::vector<BlockId> Graph::roots() const {
+        std::vector<BlockId> result = { entry };
+        for (const OsrEntry& osrEntry : osrEntries) {
+            result.push_back(osrEntry.block);
+        }
+
+        return result;
+    }
+
+    std::vector<BlockId> Graph::reversePostorder() const {
+        std::vector<BlockId> postorder;
+        std::vector<bool> visited(blocks.size(), false);
+        std::vector<std::pair<BlockId, size_t>> stack; // block, next successor to visit
+
+        for (BlockId root : roots()) {
+            if (visited[root]) continue;
+
+            visited[root] = true;
+            stack.emplace_back(root, 0);
+
+            while (!stack.empty()) {
+                auto& [block, next] = stack.back();
+
+                if (next < blocks[block].succs.size()) {
+                    BlockId succ = blocks[block].succs[next++];
+                    if (!visited[succ]) {
+                        visited[succ] = true;
+                        stack.emplace_back(succ, 0);
+                    }
+                } else {
+                    postorder.push_back(block);
+                    stack.pop_back();
+                }
+            }
+        }
+
+        std::reverse(postorder.begin(), postorder.end());
+        return postorder;
+    }
+
+    void Graph::resolveOperands() {
+        for (Inst& inst : insts) {
+            if (inst.block == None) continue;
+
+            for (ValueId& operand : inst.operands) {
+                operand = resolve(operand);
+            }
+        }
+    }
+
+    void Graph::removeUnreachable() {
+        std::vector<bool> reachable(blocks.size(), false);
+        for (BlockId block : reversePostorder()) {
+            reachable[block] = true;
+        }
+
+        for (BlockId block = 0; block < blocks.size(); block++) {
+            if (reachable[block] || blocks[block].removed) continue;
+
+            while (!blocks[block].succs.empty()) {
+                removeEdge(block, blocks[block].succs.size() - 1);
+            }
+
+            for (ValueId value : std::vector<ValueId>(blocks[block].insts)) {
+                remove(value);
+            }
+
+            blocks[block].removed = true;
+        }
+    }
+}
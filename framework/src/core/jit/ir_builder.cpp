@@ -0,0 +1,675 @@
+// Copyright 2025 JesusTouchMe
+
+#include "BibbleVM/core/jit/ir_builder.h"
+
+#include "BibbleVM/core/bytecode/operand_layout.h"
+
+#include "BibbleVM/core/exec/verifier.h"
+
+#include "BibbleVM/core/vm.h"
+
+#include <algorithm>
+#include <bit>
+#include <unordered_map>
+
+namespace bibble::ir {
+    static constexpr size_t MaxInstructions = 8192; // inlined callees included
+    static constexpr u32 MaxSlots = 4096; // every one is stored to memory around each call
+    static constexpr size_t MaxInlineSize = 48; // instructions of an inlined callee, its trailing sentinel included
+
+    static bool IsBranch(ByteOpcode opcode) {
+        return opcode == ByteOpcode::JMP || opcode == ByteOpcode::JZ || opcode == ByteOpcode::JNZ;
+    }
+
+    static bool IsStaticCall(ByteOpcode opcode) {
+        return opcode == ByteOpcode::CALL || opcode == ByteOpcode::CALL_EX || opcode == ByteOpcode::CALL_TINY
+            || opcode == ByteOpcode::CALL_TINY_EX;
+    }
+
+    // Builds the graph with the SSA construction of Braun et al., "Simple and Efficient Construction of Static Single
+    // Assignment Form". Every block and edge is known before any block is filled, so blocks are filled in reverse
+    // postorder and sealed as soon as their last predecessor is
+    class GraphBuilder {
+    public:
+        GraphBuilder(VM& vm, u32 module, const DispatchTables& tables)
+            : mVm(vm)
+            , mModule(module)
+            , mTables(tables) {}
+
+        std::optional<Graph> build(const DecodedFunction& function, u32 args) {
+            if (!function.verified || args < function.minArgs) return std::nullopt;
+
+            mGraph.args = args;
+            mGraph.entry = newBlock(None, 0);
+
+            std::optional<u32> outer = addInstance(function, 0, args, None);
+            if (!outer.has_value()) return std::nullopt;
+            if (mGraph.slotCount > MaxSlots) return std::nullopt;
+
+            const Instance& instance = mInstances[outer.value()];
+            mGraph.addEdge(mGraph.entry, instance.blocks[function.entryIndex]);
+
+            // every loop header the interpreter or baseline code can hand a running frame over at
+            std::vector<bool> isHeader(function.instructions.size(), false);
+            for (size_t i = 0; i < function.instructions.size(); i++) {
+                const Instruction& inst = function.instructions[i];
+                if (!instance.depths[i].has_value() || !isValid(inst)) continue;
+                if (!IsBranch(GetLeadingOpcode(inst.opcode)) || inst.a > i || isHeader[inst.a]) continue;
+
+                isHeader[inst.a] = true;
+
+                BlockId block = newBlock(None, 0);
+                mGraph.addEdge(block, instance.blocks[inst.a]);
+                mGraph.osrEntries.push_back({ inst.a, block, static_cast<u32>(args + instance.depths[inst.a].value()) });
+            }
+
+            // dead code would keep blocks from ever being sealed
+            mGraph.removeUnreachable();
+
+            mDefs.resize(mGraph.blocks.size());
+            mSealed.assign(mGraph.blocks.size(), false);
+            mFilled.assign(mGraph.blocks.size(), false);
+            mIncompletePhis.resize(mGraph.blocks.size());
+
+            for (BlockId root : mGraph.roots()) {
+                seal(root);
+            }
+
+            for (BlockId block : mGraph.reversePostorder()) {
+                fill(block);
+                mFilled[block] = true;
+
+                for (BlockId succ : mGraph.blocks[block].succs) {
+                    const std::vector<BlockId>& preds = mGraph.blocks[succ].preds;
+                    bool ready = std::all_of(preds.begin(), preds.end(), [this](BlockId pred) { return mFilled[pred]; });
+                    if (ready && !mSealed[succ]) seal(succ);
+                }
+            }
+
+            mGraph.resolveOperands();
+            return std::move(mGraph);
+        }
+
+    private:
+        // One copy of a function's code in the graph. The function being compiled, or a callee inlined into it
+        struct Instance {
+            const DecodedFunction* function;
+            u32 base; // slot its frame starts at
+            u32 args; // frame height it's entered with
+            std::vector<std::optional<i64>> depths;
+            std::vector<BlockId> blocks; // starting at each instruction. None inside a block or where nothing reaches
+            BlockId continuation; // the caller's block after the call, which RET jumps to. None for the outer function
+        };
+
+        // The instructions a block runs. Root blocks have none
+        struct BlockSource {
+            u32 instance;
+            u32 start;
+            u32 end; // exclusive
+            bool inlinedCall = false; // ends in a call that was inlined, so it jumps to the callee's entry
+        };
+
+        VM& mVm;
+        u32 mModule;
+        const DispatchTables& mTables;
+
+        Graph mGraph;
+        std::vector<Instance> mInstances;
+        std::vector<BlockSource> mSources; // by block
+        size_t mInstructionCount = 0;
+
+        // Variable 0 is acc, variable 1 + s is slot s
+        std::vector<std::unordered_map<u32, ValueId>> mDefs; // by block
+        std::vector<bool> mSealed;
+        std::vector<bool> mFilled;
+        std::vector<std::vector<std::pair<u32, ValueId>>> mIncompletePhis;
+
+        // The block being filled and where it is in its instance
+        BlockId mBlock = None;
+        u32 mBase = 0;
+        u32 mArgs = 0;
+        i64 mDepth = 0;
+
+        BlockId newBlock(u32 instance, u32 start) {
+            mSources.push_back({ instance, start, start });
+            return mGraph.addBlock();
+        }
+
+        bool isValid(const Instruction& inst) const {
+            return inst.handler != mTables.invalidHandler && GetOperandLayout(GetLeadingOpcode(inst.opcode)).has_value();
+        }
+
+        // The function a call goes to if it can be inlined, nullptr if not
+        const DecodedFunction* getInlinee(const Instruction& inst) {
+            const CallableTarget* target = inst.target;
+
+            // getCallable resolves names against the active module, so leave calls nothing resolved yet alone unless
+            // that's the one we're compiling for
+            if (target == nullptr && mVm.currentModuleH() == mModule) target = ResolveCallTarget(mVm, inst);
+            if (target == nullptr) return nullptr;
+
+            const DecodedFunction* callee = mVm.interpreter().decode(mVm, *target);
+            if (callee == nullptr || !callee->verified || callee->minArgs > inst.b) return nullptr;
+            if (callee->instructions.size() > MaxInlineSize) return nullptr;
+
+            for (const Instruction& calleeInst : callee->instructions) {
+                if (!isValid(calleeInst)) continue;
+
+                ByteOpcode opcode = GetLeadingOpcode(calleeInst.opcode);
+                switch (opcode) {
+                    case ByteOpcode::CALL: case ByteOpcode::CALL_EX: case ByteOpcode::CALL_DYN:
+                    case ByteOpcode::CALL_TINY: case ByteOpcode::CALL_TINY_EX:
+                    case ByteOpcode::TRAP: case ByteOpcode::TRAP_IF_ZERO: case ByteOpcode::TRAP_IF_NOT_ZERO:
+                    case ByteOpcode::PUSH_SP: case ByteOpcode::POP_SP:
+                        return nullptr;
+                    default:
+                        break;
+                }
+            }
+
+            return callee;
+        }
+
+        // Splits function into blocks and links them, inlining callees on the way. Returns the instance's index
+        std::optional<u32> addInstance(const DecodedFunction& function, u32 base, u32 args, BlockId continuation) {
+            const std::vector<Instruction>& instructions = function.instructions;
+            size_t count = instructions.size();
+
+            mInstructionCount += count;
+            if (mInstructionCount > MaxInstructions) return std::nullopt;
+
+            u32 index = static_cast<u32>(mInstances.size());
+            mInstances.push_back({ &function, base, args, GetStackDepths(function), std::vector<BlockId>(count, None), continuation });
+            mGraph.slotCount = std::max(mGraph.slotCount, base + args + function.maxGrowth);
+
+            std::vector<std::optional<i64>> depths = mInstances[index].depths;
+            std::vector<bool> leaders(count, false);
+            std::unordered_map<size_t, const DecodedFunction*> inlinees;
+
+            leaders[function.entryIndex] = true;
+
+            for (size_t i = 0; i < count; i++) {
+                const Instruction& inst = instructions[i];
+                if (!depths[i].has_value() || !isValid(inst)) continue;
+
+                ByteOpcode opcode = GetLeadingOpcode(inst.opcode);
+                if (opcode == ByteOpcode::PUSH_SP || opcode == ByteOpcode::POP_SP) return std::nullopt;
+
+                if (IsBranch(opcode)) {
+                    leaders[inst.a] = true;
+                    leaders[i + 1] = true; // the trailing sentinel is never a branch, so there's always a next one
+                } else if (continuation == None && IsStaticCall(opcode)) {
+                    const DecodedFunction* inlinee = getInlinee(inst);
+                    if (inlinee == nullptr) continue;
+
+                    inlinees[i] = inlinee;
+                    leaders[i + 1] = true;
+                }
+            }
+
+            for (size_t i = 0; i < count; i++) {
+                if (leaders[i] && depths[i].has_value()) mInstances[index].blocks[i] = newBlock(index, static_cast<u32>(i));
+            }
+
+            for (size_t start = 0; start < count; start++) {
+                BlockId block = mInstances[index].blocks[start];
+                if (block == None) continue;
+
+                size_t i = start;
+                while (true) {
+                    const Instruction& inst = instructions[i];
+                    if (!isValid(inst)) break;
+
+                    ByteOpcode opcode = GetLeadingOpcode(inst.opcode);
+                    const std::vector<BlockId>& blocks = mInstances[index].blocks;
+
+                    if (opcode == ByteOpcode::JMP) {
+                        mGraph.addEdge(block, blocks[inst.a]);
+                        break;
+                    }
+
+                    if (opcode == ByteOpcode::JZ) { // Branch goes to successor 0 if acc is non-zero
+                        mGraph.addEdge(block, blocks[i + 1]);
+                        mGraph.addEdge(block, blocks[inst.a]);
+                        break;
+                    }
+
+                    if (opcode == ByteOpcode::JNZ) {
+                        mGraph.addEdge(block, blocks[inst.a]);
+                        mGraph.addEdge(block, blocks[i + 1]);
+                        break;
+                    }
+
+                    if (opcode == ByteOpcode::RET) {
+                        if (continuation != None) mGraph.addEdge(block, continuation);
+                        break;
+                    }
+
+                    if (opcode == ByteOpcode::HLT) break;
+
+                    auto inlinee = inlinees.find(i);
+                    if (inlinee != inlinees.end()) {
+                        u32 calleeBase = static_cast<u32>(base + args + depths[i].value() - inst.b);
+
+                        std::optional<u32> callee = addInstance(*inlinee->second, calleeBase, inst.b, blocks[i + 1]);
+                        if (!callee.has_value()) return std::nullopt;
+
+                        const Instance& calleeInstance = mInstances[callee.value()];
+                        mGraph.addEdge(block, calleeInstance.blocks[calleeInstance.function->entryIndex]);
+                        mSources[block].inlinedCall = true;
+                        break;
+                    }
+
+                    if (leaders[i + 1]) {
+                        mGraph.addEdge(block, blocks[i + 1]);
+                        break;
+                    }
+
+                    i++;
+                }
+
+                mSources[block].end = static_cast<u32>(i + 1);
+            }
+
+            return index;
+        }
+
+        ValueId readVariable(BlockId block, u32 variable) {
+            auto def = mDefs[block].find(variable);
+            if (def != mDefs[block].end()) return mGraph.resolve(def->second);
+
+            const std::vector<BlockId>& preds = mGraph.blocks[block].preds;
+            ValueId value;
+
+            if (!mSealed[block]) {
+                value = mGraph.prepend(block, Op::Phi);
+                mIncompletePhis[block].emplace_back(variable, value);
+            } else if (preds.empty()) { // a root, where the frame is still in memory
+                value = mGraph.prepend(block, variable == 0 ? Op::LoadAcc : Op::LoadSlot);
+                mGraph.insts[value].slot = variable - 1;
+            } else if (preds.size() == 1) {
+                value = readVariable(preds.front(), variable);
+            } else {
+                value = mGraph.prepend(block, Op::Phi);
+                mDefs[block][variable] = value; // breaks cycles through loops
+                value = addPhiOperands(variable, value);
+            }
+
+            mDefs[block][variable] = value;
+            return value;
+        }
+
+        ValueId addPhiOperands(u32 variable, ValueId phi) {
+            BlockId block = mGraph.insts[phi].block;
+
+            // preds and the phi can't move from under us, reads only ever add to other blocks and to insts
+            for (size_t i = 0; i < mGraph.blocks[block].preds.size(); i++) {
+                ValueId operand = readVariable(mGraph.blocks[block].preds[i], variable);
+                mGraph.insts[phi].operands.push_back(operand);
+            }
+
+            return removeTrivialPhi(phi);
+        }
+
+        ValueId removeTrivialPhi(ValueId phi) {
+            ValueId same = None;
+
+            for (ValueId operand : mGraph.insts[phi].operands) {
+                operand = mGraph.resolve(operand);
+                if (operand == same || operand == phi) continue;
+                if (same != None) return phi; // merges at least two values
+
+                same = operand;
+            }
+
+            if (same == None) return phi; // only reachable from itself, never happens for anything a root reaches
+
+            mGraph.replace(phi, same);
+            return same;
+        }
+
+        void seal(BlockId block) {
+            // reading through a loop back into this block can add more
+            for (size_t i = 0; i < mIncompletePhis[block].size(); i++) {
+                auto [variable, phi] = mIncompletePhis[block][i];
+                addPhiOperands(variable, phi);
+            }
+
+            mIncompletePhis[block].clear();
+            mSealed[block] = true;
+        }
+
+        ValueId read(u32 variable) {
+            return readVariable(mBlock, variable);
+        }
+
+        void write(u32 variable, ValueId value) {
+            mDefs[mBlock][variable] = value;
+        }
+
+        u32 local(const Instruction& inst) const {
+            return 1 + mBase + inst.a;
+        }
+
+        u32 height() const {
+            return static_cast<u32>(mBase + mArgs + mDepth);
+        }
+
+        void push(ValueId value) {
+            write(1 + height(), value);
+            mDepth++;
+        }
+
+        ValueId pop() {
+            mDepth--;
+            return read(1 + height());
+        }
+
+        ValueId constant(i64 value) {
+            return mGraph.addConst(mBlock, value);
+        }
+
+        ValueId constant(double value) {
+            return constant(std::bit_cast<i64>(value));
+        }
+
+        ValueId op(Op op, std::vector<ValueId> operands) {
+            return mGraph.append(mBlock, op, std::move(operands));
+        }
+
+        // acc = acc op pop()
+        void binaryPop(Op binary) {
+            ValueId b = pop();
+            write(0, op(binary, { read(0), b }));
+        }
+
+        // b = pop(), a = pop(), acc = a op b
+        void binaryPop2(Op binary) {
+            ValueId b = pop();
+            ValueId a = pop();
+            write(0, op(binary, { a, b }));
+        }
+
+        // b = pop(), a = pop(), push(a op b)
+        void binaryStack(Op binary) {
+            ValueId b = pop();
+            ValueId a = pop();
+            push(op(binary, { a, b }));
+        }
+
+        void binaryImm(Op binary, ValueId imm) {
+            write(0, op(binary, { read(0), imm }));
+        }
+
+        void binaryImmStack(Op binary, ValueId imm) {
+            ValueId a = pop();
+            push(op(binary, { a, imm }));
+        }
+
+        // Writes the frame to memory for op, which is given every slot below the current height and acc. acc is what
+        // it leaves there afterwards
+        ValueId frameEffect(Op effect, const Instruction& inst) {
+            u32 frameHeight = height();
+
+            std::vector<ValueId> operands;
+            operands.reserve(frameHeight + 1);
+
+            for (u32 slot = 0; slot < frameHeight; slot++) {
+                operands.push_back(read(1 + slot));
+            }
+
+            operands.push_back(read(0));
+
+            ValueId value = op(effect, std::move(operands));
+            mGraph.insts[value].slot = frameHeight;
+            mGraph.insts[value].source = &inst;
+
+            return value;
+        }
+
+        // Slots from first on may have changed in memory. Unused reloads are removed again later
+        void reloadSlots(u32 first) {
+            for (u32 slot = first; slot < mGraph.slotCount; slot++) {
+                ValueId value = op(Op::LoadSlot, {});
+                mGraph.insts[value].slot = slot;
+                write(1 + slot, value);
+            }
+        }
+
+        void call(Op effect, const Instruction& inst) {
+            ValueId result = frameEffect(effect, inst);
+            mDepth -= inst.b; // the arguments were the callee's frame, which it discards
+            write(0, result);
+            reloadSlots(height());
+        }
+
+        void terminate(Op terminator, std::vector<ValueId> operands = {}) {
+            ValueId value = op(terminator, std::move(operands));
+            mGraph.insts[value].slot = height();
+        }
+
+        void fill(BlockId block) {
+            mBlock = block;
+
+            const BlockSource& source = mSources[block];
+            if (source.instance == None) { // a root, which just jumps to where it enters
+                terminate(Op::Jump);
+                return;
+            }
+
+            const Instance& instance = mInstances[source.instance];
+            mBase = instance.base;
+            mArgs = instance.args;
+            mDepth = instance.depths[source.start].value();
+
+            for (u32 i = source.start; i < source.end; i++) {
+                translate(instance, i);
+            }
+
+            // fell through into the next block
+            if (mGraph.blocks[block].insts.empty() || !IsTerminator(mGraph.terminator(block).op)) terminate(Op::Jump);
+        }
+
+        void translate(const Instance& instance, u32 index) {
+            const Instruction& inst = instance.function->instructions[index];
+
+            if (!isValid(inst)) {
+                terminate(Op::Error, { read(0) });
+                return;
+            }
+
+            i64 imm = inst.imm.integer();
+            double fimm = inst.imm.floating();
+
+            switch (GetLeadingOpcode(inst.opcode)) {
+                case ByteOpcode::NOP:
+                case ByteOpcode::BRK:
+                    return;
+
+                case ByteOpcode::HLT: {
+                    terminate(Op::Halt, { read(0) });
+                    mGraph.terminator(mBlock).imm = imm;
+                    return;
+                }
+
+                case ByteOpcode::TRAP:
+                case ByteOpcode::TRAP_IF_ZERO:
+                case ByteOpcode::TRAP_IF_NOT_ZERO: {
+                    ValueId trap = frameEffect(Op::Trap, inst);
+                    mGraph.insts[trap].imm = static_cast<u8>(inst.a);
+                    write(0, trap);
+                    reloadSlots(0); // a trap can do anything to the stack
+                    return;
+                }
+
+                case ByteOpcode::ADD: binaryPop(Op::Add); return;
+                case ByteOpcode::SUB: binaryPop(Op::Sub); return;
+                case ByteOpcode::MUL: binaryPop(Op::Mul); return;
+                case ByteOpcode::DIV: binaryPop(Op::Div); return;
+                case ByteOpcode::MOD: binaryPop(Op::Mod); return;
+                case ByteOpcode::AND: binaryPop(Op::And); return;
+                case ByteOpcode::OR: binaryPop(Op::Or); return;
+                case ByteOpcode::XOR: binaryPop(Op::Xor); return;
+                case ByteOpcode::SHL: binaryPop(Op::Shl); return;
+                case ByteOpcode::SHR: binaryPop(Op::Shr); return;
+                case ByteOpcode::NEG: write(0, op(Op::Neg, { read(0) })); return;
+                case ByteOpcode::NOT: write(0, op(Op::Not, { read(0) })); return;
+
+                case ByteOpcode::ADD2: binaryPop2(Op::Add); return;
+                case ByteOpcode::SUB2: binaryPop2(Op::Sub); return;
+                case ByteOpcode::MUL2: binaryPop2(Op::Mul); return;
+                case ByteOpcode::DIV2: binaryPop2(Op::Div); return;
+                case ByteOpcode::MOD2: binaryPop2(Op::Mod); return;
+                case ByteOpcode::AND2: binaryPop2(Op::And); return;
+                case ByteOpcode::OR2: binaryPop2(Op::Or); return;
+                case ByteOpcode::XOR2: binaryPop2(Op::Xor); return;
+                case ByteOpcode::SHL2: binaryPop2(Op::Shl); return;
+                case ByteOpcode::SHR2: binaryPop2(Op::Shr); return;
+
+                case ByteOpcode::ADD_ST: binaryStack(Op::Add); return;
+                case ByteOpcode::SUB_ST: binaryStack(Op::Sub); return;
+                case ByteOpcode::MUL_ST: binaryStack(Op::Mul); return;
+                case ByteOpcode::DIV_ST: binaryStack(Op::Div); return;
+                case ByteOpcode::MOD_ST: binaryStack(Op::Mod); return;
+                case ByteOpcode::AND_ST: binaryStack(Op::And); return;
+                case ByteOpcode::OR_ST: binaryStack(Op::Or); return;
+                case ByteOpcode::XOR_ST: binaryStack(Op::Xor); return;
+                case ByteOpcode::SHL_ST: binaryStack(Op::Shl); return;
+                case ByteOpcode::SHR_ST: binaryStack(Op::Shr); return;
+                case ByteOpcode::NEG_ST: push(op(Op::Neg, { pop() })); return;
+                case ByteOpcode::NOT_ST: push(op(Op::Not, { pop() })); return;
+
+                case ByteOpcode::ADD_IMM: binaryImm(Op::Add, constant(imm)); return;
+                case ByteOpcode::SUB_IMM: binaryImm(Op::Sub, constant(imm)); return;
+                case ByteOpcode::MUL_IMM: binaryImm(Op::Mul, constant(imm)); return;
+                case ByteOpcode::DIV_IMM: binaryImm(Op::Div, constant(imm)); return;
+                case ByteOpcode::MOD_IMM: binaryImm(Op::Mod, constant(imm)); return;
+                case ByteOpcode::AND_IMM: binaryImm(Op::And, constant(imm)); return;
+                case ByteOpcode::OR_IMM: binaryImm(Op::Or, constant(imm)); return;
+                case ByteOpcode::XOR_IMM: binaryImm(Op::Xor, constant(imm)); return;
+                case ByteOpcode::SHL_IMM: binaryImm(Op::Shl, constant(imm)); return;
+                case ByteOpcode::SHR_IMM: binaryImm(Op::Shr, constant(imm)); return;
+
+                case ByteOpcode::ADD_IMM_ST: binaryImmStack(Op::Add, constant(imm)); return;
+                case ByteOpcode::SUB_IMM_ST: binaryImmStack(Op::Sub, constant(imm)); return;
+                case ByteOpcode::MUL_IMM_ST: binaryImmStack(Op::Mul, constant(imm)); return;
+                case ByteOpcode::DIV_IMM_ST: binaryImmStack(Op::Div, constant(imm)); return;
+                case ByteOpcode::MOD_IMM_ST: binaryImmStack(Op::Mod, constant(imm)); return;
+                case ByteOpcode::AND_IMM_ST: binaryImmStack(Op::And, constant(imm)); return;
+                case ByteOpcode::OR_IMM_ST: binaryImmStack(Op::Or, constant(imm)); return;
+                case ByteOpcode::XOR_IMM_ST: binaryImmStack(Op::Xor, constant(imm)); return;
+                case ByteOpcode::SHL_IMM_ST: binaryImmStack(Op::Shl, constant(imm)); return;
+                case ByteOpcode::SHR_IMM_ST: binaryImmStack(Op::Shr, constant(imm)); return;
+
+                case ByteOpcode::FADD: binaryPop(Op::FAdd); return;
+                case ByteOpcode::FSUB: binaryPop(Op::FSub); return;
+                case ByteOpcode::FMUL: binaryPop(Op::FMul); return;
+                case ByteOpcode::FDIV: binaryPop(Op::FDiv); return;
+                case ByteOpcode::FADD2: binaryPop2(Op::FAdd); return;
+                case ByteOpcode::FSUB2: binaryPop2(Op::FSub); return;
+                case ByteOpcode::FMUL2: binaryPop2(Op::FMul); return;
+                case ByteOpcode::FDIV2: binaryPop2(Op::FDiv); return;
+                case ByteOpcode::FADD_ST: binaryStack(Op::FAdd); return;
+                case ByteOpcode::FSUB_ST: binaryStack(Op::FSub); return;
+                case ByteOpcode::FMUL_ST: binaryStack(Op::FMul); return;
+                case ByteOpcode::FDIV_ST: binaryStack(Op::FDiv); return;
+                case ByteOpcode::FNEG: write(0, op(Op::FNeg, { read(0) })); return;
+
+                case ByteOpcode::FADD_IMM: binaryImm(Op::FAdd, constant(fimm)); return;
+                case ByteOpcode::FSUB_IMM: binaryImm(Op::FSub, constant(fimm)); return;
+                case ByteOpcode::FMUL_IMM: binaryImm(Op::FMul, constant(fimm)); return;
+                case ByteOpcode::FDIV_IMM: binaryImm(Op::FDiv, constant(fimm)); return;
+                case ByteOpcode::FADD_IMM_ST: binaryImmStack(Op::FAdd, constant(fimm)); return;
+                case ByteOpcode::FSUB_IMM_ST: binaryImmStack(Op::FSub, constant(fimm)); return;
+                case ByteOpcode::FMUL_IMM_ST: binaryImmStack(Op::FMul, constant(fimm)); return;
+                case ByteOpcode::FDIV_IMM_ST: binaryImmStack(Op::FDiv, constant(fimm)); return;
+
+                case ByteOpcode::CMP_EQ: binaryPop(Op::CmpEq); return;
+                case ByteOpcode::CMP_NE: binaryPop(Op::CmpNe); return;
+                case ByteOpcode::CMP_LT: binaryPop(Op::CmpLt); return;
+                case ByteOpcode::CMP_GT: binaryPop(Op::CmpGt); return;
+                case ByteOpcode::CMP_LTE: binaryPop(Op::CmpLe); return;
+                case ByteOpcode::CMP_GTE: binaryPop(Op::CmpGe); return;
+                case ByteOpcode::FCMP_EQ: binaryPop(Op::FCmpEq); return;
+                case ByteOpcode::FCMP_NE: binaryPop(Op::FCmpNe); return;
+                case ByteOpcode::FCMP_LT: binaryPop(Op::FCmpLt); return;
+                case ByteOpcode::FCMP_GT: binaryPop(Op::FCmpGt); return;
+                case ByteOpcode::FCMP_LTE: binaryPop(Op::FCmpLe); return;
+                case ByteOpcode::FCMP_GTE: binaryPop(Op::FCmpGe); return;
+
+                case ByteOpcode::CMP_EQ0: binaryImm(Op::CmpEq, constant(i64(0))); return;
+                case ByteOpcode::CMP_NE0: binaryImm(Op::CmpNe, constant(i64(0))); return;
+                case ByteOpcode::CMP_LT0: binaryImm(Op::CmpLt, constant(i64(0))); return;
+                case ByteOpcode::CMP_GT0: binaryImm(Op::CmpGt, constant(i64(0))); return;
+                case ByteOpcode::CMP_LTE0: binaryImm(Op::CmpLe, constant(i64(0))); return;
+                case ByteOpcode::CMP_GTE0: binaryImm(Op::CmpGe, constant(i64(0))); return;
+                case ByteOpcode::FCMP_EQ0: binaryImm(Op::FCmpEq, constant(0.0)); return;
+                case ByteOpcode::FCMP_NE0: binaryImm(Op::FCmpNe, constant(0.0)); return;
+                case ByteOpcode::FCMP_LT0: binaryImm(Op::FCmpLt, constant(0.0)); return;
+                case ByteOpcode::FCMP_GT0: binaryImm(Op::FCmpGt, constant(0.0)); return;
+                case ByteOpcode::FCMP_LTE0: binaryImm(Op::FCmpLe, constant(0.0)); return;
+                case ByteOpcode::FCMP_GTE0: binaryImm(Op::FCmpGe, constant(0.0)); return;
+
+                case ByteOpcode::PUSH_ACC: push(read(0)); return;
+                case ByteOpcode::POP_ACC: write(0, pop()); return;
+                case ByteOpcode::POP_DISCARD: mDepth -= inst.a; return;
+                case ByteOpcode::RESERVE: mDepth += inst.a; return; // the slots keep whatever they held, like in memory
+
+                case ByteOpcode::CONST:
+                case ByteOpcode::CONST32:
+                case ByteOpcode::CONST64:
+                    write(0, constant(imm));
+                    return;
+
+                case ByteOpcode::CONST_ST:
+                case ByteOpcode::CONST32_ST:
+                case ByteOpcode::CONST64_ST:
+                    push(constant(imm));
+                    return;
+
+                case ByteOpcode::LOAD: write(0, read(local(inst))); return;
+                case ByteOpcode::LOAD_ST: push(read(local(inst))); return;
+                case ByteOpcode::STORE: write(local(inst), read(0)); return;
+                case ByteOpcode::STORE_ST: write(local(inst), pop()); return;
+
+                case ByteOpcode::JMP:
+                    terminate(Op::Jump);
+                    return;
+
+                case ByteOpcode::JZ:
+                case ByteOpcode::JNZ:
+                    terminate(Op::Branch, { read(0) });
+                    return;
+
+                case ByteOpcode::CALL:
+                case ByteOpcode::CALL_EX:
+                case ByteOpcode::CALL_TINY:
+                case ByteOpcode::CALL_TINY_EX:
+                    if (index + 1 == mSources[mBlock].end && mSources[mBlock].inlinedCall) {
+                        terminate(Op::Jump); // the callee takes the arguments from here on
+                        return;
+                    }
+
+                    call(Op::Call, inst);
+                    return;
+
+                case ByteOpcode::CALL_DYN:
+                    call(Op::CallDynamic, inst);
+                    return;
+
+                case ByteOpcode::RET:
+                    if (instance.continuation != None) terminate(Op::Jump);
+                    else terminate(Op::Return, { read(0) });
+                    return;
+
+                default: // PUSH_SP and POP_SP, which never get this far
+                    terminate(Op::Error, { read(0) });
+                    return;
+            }
+        }
+    };
+
+    std::optional<Graph> BuildGraph(VM& vm, u32 module, const DecodedFunction& function, const DispatchTables& tables, u32 args) {
+        return GraphBuilder(vm, module, tables).build(function, args);
+    }
+}
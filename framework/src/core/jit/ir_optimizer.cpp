@@ -0,0 +1,487 @@
+// Copyright 2025 JesusTouchMe
+
+#include "BibbleVM/core/jit/ir_optimizer.h"
+
+#include <algorithm>
+#include <bit>
+#include <limits>
+#include <optional>
+
+namespace bibble::ir {
+    // Same results as the interpreter, including for overflow. Division by 0 and MIN / -1 trap in the interpreter, so
+    // they're left for the machine code to do the same
+    static std::optional<i64> FoldBinary(Op op, i64 a, i64 b) {
+        u64 ua = static_cast<u64>(a);
+        u64 ub = static_cast<u64>(b);
+        double fa = std::bit_cast<double>(a);
+        double fb = std::bit_cast<double>(b);
+
+        switch (op) {
+            case Op::Add: return static_cast<i64>(ua + ub);
+            case Op::Sub: return static_cast<i64>(ua - ub);
+            case Op::Mul: return static_cast<i64>(ua * ub);
+            case Op::And: return a & b;
+            case Op::Or: return a | b;
+            case Op::Xor: return a ^ b;
+            case Op::Shl: return static_cast<i64>(ua << (b & 63));
+            case Op::Shr: return a >> (b & 63);
+
+            case Op::Div:
+            case Op::Mod:
+                if (b == 0 || (a == std::numeric_limits<i64>::min() && b == -1)) return std::nullopt;
+                return op == Op::Div ? a / b : a % b;
+
+            case Op::FAdd: return std::bit_cast<i64>(fa + fb);
+            case Op::FSub: return std::bit_cast<i64>(fa - fb);
+            case Op::FMul: return std::bit_cast<i64>(fa * fb);
+            case Op::FDiv: return std::bit_cast<i64>(fa / fb);
+
+            case Op::CmpEq: return a == b;
+            case Op::CmpNe: return a != b;
+            case Op::CmpLt: return a < b;
+            case Op::CmpGt: return a > b;
+            case Op::CmpLe: return a <= b;
+            case Op::CmpGe: return a >= b;
+            case Op::FCmpEq: return fa == fb;
+            case Op::FCmpNe: return fa != fb;
+            case Op::FCmpLt: return fa < fb;
+            case Op::FCmpGt: return fa > fb;
+            case Op::FCmpLe: return fa <= fb;
+            case Op::FCmpGe: return fa >= fb;
+
+            default: return std::nullopt;
+        }
+    }
+
+    static std::optional<i64> FoldUnary(Op op, i64 a) {
+        switch (op) {
+            case Op::Neg: return static_cast<i64>(0 - static_cast<u64>(a));
+            case Op::Not: return ~a;
+            case Op::FNeg: return a ^ std::numeric_limits<i64>::min();
+            default: return std::nullopt;
+        }
+    }
+
+    // x op c where the result is just x. Integer only, x + 0.0 isn't x for x = -0.0
+    static bool IsIdentity(Op op, i64 c) {
+        switch (op) {
+            case Op::Add: case Op::Sub: case Op::Or: case Op::Xor: case Op::Shl: case Op::Shr:
+                return c == 0;
+            case Op::Mul: case Op::Div:
+                return c == 1;
+            default:
+                return false;
+        }
+    }
+
+    class GraphOptimizer {
+    public:
+        explicit GraphOptimizer(Graph& graph)
+            : mGraph(graph) {}
+
+        void run() {
+            while (simplify()) {}
+            removeDeadValues();
+
+            hoistLoopInvariants();
+            removeDeadValues();
+        }
+
+    private:
+        Graph& mGraph;
+
+        i64 constant(ValueId value) const {
+            return mGraph.get(value).imm;
+        }
+
+        void makeConst(ValueId value, i64 result) {
+            Inst& inst = mGraph.insts[value];
+            inst.op = Op::Const;
+            inst.imm = result;
+            inst.operands.clear();
+        }
+
+        // One pass of folding over every block. Returns whether anything changed
+        bool simplify() {
+            bool changed = false;
+            bool branchesFolded = false;
+
+            for (BlockId block : mGraph.reversePostorder()) {
+                for (ValueId value : std::vector<ValueId>(mGraph.blocks[block].insts)) {
+                    if (mGraph.insts[value].block == None) continue; // replaced by an earlier one
+
+                    for (ValueId& operand : mGraph.insts[value].operands) {
+                        operand = mGraph.resolve(operand);
+                    }
+
+                    const Inst& inst = mGraph.insts[value];
+
+                    if (inst.op == Op::Phi) {
+                        changed |= simplifyPhi(value);
+                    } else if (inst.op == Op::Branch) {
+                        bool folded = simplifyBranch(block);
+                        changed |= folded;
+                        branchesFolded |= folded;
+                    } else if (IsPure(inst.op) && inst.op != Op::Const) {
+                        changed |= simplifyPure(value);
+                    }
+                }
+            }
+
+            if (branchesFolded) mGraph.removeUnreachable();
+            return changed;
+        }
+
+        bool simplifyPhi(ValueId phi) {
+            ValueId same = None;
+
+            for (ValueId operand : mGraph.insts[phi].operands) {
+                operand = mGraph.resolve(operand);
+                if (operand == same || operand == phi) continue;
+                if (same != None) return false;
+
+                same = operand;
+            }
+
+            if (same == None) return false;
+
+            mGraph.replace(phi, same);
+            return true;
+        }
+
+        bool simplifyBranch(BlockId block) {
+            Inst& branch = mGraph.terminator(block);
+            Block& blockRef = mGraph.blocks[block];
+
+            size_t dropped;
+            if (blockRef.succs[0] == blockRef.succs[1]) {
+                dropped = 1;
+            } else if (mGraph.isConst(branch.operands[0])) {
+                dropped = constant(branch.operands[0]) != 0 ? 1 : 0;
+            } else {
+                return false;
+            }
+
+            branch.op = Op::Jump;
+            branch.operands.clear();
+            mGraph.removeEdge(block, dropped);
+
+            return true;
+        }
+
+        bool simplifyPure(ValueId value) {
+            const Inst& inst = mGraph.insts[value];
+
+            if (inst.operands.size() == 1) {
+                if (!mGraph.isConst(inst.operands[0])) return false;
+
+                std::optional<i64> result = FoldUnary(inst.op, constant(inst.operands[0]));
+                if (!result.has_value()) return false;
+
+                makeConst(value, result.value());
+                return true;
+            }
+
+            ValueId a = inst.operands[0];
+            ValueId b = inst.operands[1];
+            bool aConst = mGraph.isConst(a);
+            bool bConst = mGraph.isConst(b);
+
+            if (aConst && bConst) {
+                std::optional<i64> result = FoldBinary(inst.op, constant(a), constant(b));
+                if (!result.has_value()) return false;
+
+                makeConst(value, result.value());
+                return true;
+            }
+
+            if (bConst && IsIdentity(inst.op, constant(b))) {
+                mGraph.replace(value, a);
+                return true;
+            }
+
+            bool commutative = inst.op == Op::Add || inst.op == Op::Mul || inst.op == Op::Or || inst.op == Op::Xor;
+            if (aConst && commutative && IsIdentity(inst.op, constant(a))) {
+                mGraph.replace(value, b);
+                return true;
+            }
+
+            if ((aConst && constant(a) == 0 && (inst.op == Op::Mul || inst.op == Op::And))
+                || (bConst && constant(b) == 0 && (inst.op == Op::Mul || inst.op == Op::And))) {
+                makeConst(value, 0);
+                return true;
+            }
+
+            return false;
+        }
+
+        void removeDeadValues() {
+            mGraph.resolveOperands();
+
+            std::vector<bool> live(mGraph.insts.size(), false);
+            std::vector<ValueId> worklist;
+
+            for (const Block& block : mGraph.blocks) {
+                if (block.removed) continue;
+
+                for (ValueId value : block.insts) {
+                    Op op = mGraph.insts[value].op;
+                    if (!IsTerminator(op) && !IsFrameEffect(op)) continue;
+
+                    live[value] = true;
+                    worklist.push_back(value);
+                }
+            }
+
+            while (!worklist.empty()) {
+                ValueId value = worklist.back();
+                worklist.pop_back();
+
+                for (ValueId operand : mGraph.insts[value].operands) {
+                    if (live[operand]) continue;
+
+                    live[operand] = true;
+                    worklist.push_back(operand);
+                }
+            }
+
+            for (Block& block : mGraph.blocks) {
+                std::erase_if(block.insts, [this, &live](ValueId value) {
+                    if (live[value]) return false;
+
+                    mGraph.insts[value].block = None;
+                    return true;
+                });
+            }
+        }
+
+        // Immediate dominators by RPO number, with the roots under a virtual root numbered 0. From Cooper, Harvey and
+        // Kennedy, "A Simple, Fast Dominance Algorithm"
+        struct Dominators {
+            std::vector<u32> number; // RPO number of each block, 0 if unreachable
+            std::vector<u32> idom; // by RPO number
+        };
+
+        Dominators computeDominators() const {
+            std::vector<BlockId> rpo = mGraph.reversePostorder();
+            std::vector<BlockId> roots = mGraph.roots();
+
+            Dominators dominators;
+            dominators.number.assign(mGraph.blocks.size(), 0);
+            dominators.idom.assign(rpo.size() + 1, None);
+            dominators.idom[0] = 0;
+
+            for (size_t i = 0; i < rpo.size(); i++) {
+                dominators.number[rpo[i]] = static_cast<u32>(i + 1);
+            }
+
+            auto intersect = [&dominators](u32 a, u32 b) {
+                while (a != b) {
+                    while (a > b) a = dominators.idom[a];
+                    while (b > a) b = dominators.idom[b];
+                }
+
+                return a;
+            };
+
+            bool changed = true;
+            while (changed) {
+                changed = false;
+
+                for (size_t i = 0; i < rpo.size(); i++) {
+                    BlockId block = rpo[i];
+                    u32 newIdom = None;
+
+                    if (std::find(roots.begin(), roots.end(), block) != roots.end()) {
+                        newIdom = 0;
+                    } else {
+                        for (BlockId pred : mGraph.blocks[block].preds) {
+                            u32 predNumber = dominators.number[pred];
+                            if (dominators.idom[predNumber] == None) continue;
+
+                            newIdom = newIdom == None ? predNumber : intersect(predNumber, newIdom);
+                        }
+                    }
+
+                    if (dominators.idom[i + 1] != newIdom) {
+                        dominators.idom[i + 1] = newIdom;
+                        changed = true;
+                    }
+                }
+            }
+
+            return dominators;
+        }
+
+        static bool Dominates(const Dominators& dominators, BlockId a, BlockId b) {
+            u32 numberA = dominators.number[a];
+            u32 numberB = dominators.number[b];
+
+            while (numberB > numberA) {
+                numberB = dominators.idom[numberB];
+            }
+
+            return numberA == numberB;
+        }
+
+        struct Loop {
+            BlockId header;
+            std::vector<bool> body; // by block. blocks added later are outside unless resized in
+            size_t size;
+
+            bool contains(BlockId block) const {
+                return block < body.size() && body[block];
+            }
+        };
+
+        // Natural loops, one per header with every back-edge into it merged, innermost first
+        std::vector<Loop> findLoops() const {
+            Dominators dominators = computeDominators();
+            std::vector<Loop> loops;
+
+            for (BlockId header : mGraph.reversePostorder()) {
+                Loop loop{ header, std::vector<bool>(mGraph.blocks.size(), false), 1 };
+                loop.body[header] = true;
+
+                std::vector<BlockId> worklist;
+                for (BlockId pred : mGraph.blocks[header].preds) {
+                    if (Dominates(dominators, header, pred)) worklist.push_back(pred);
+                }
+
+                if (worklist.empty()) continue;
+
+                while (!worklist.empty()) {
+                    BlockId block = worklist.back();
+                    worklist.pop_back();
+
+                    if (loop.body[block]) continue;
+
+                    loop.body[block] = true;
+                    loop.size++;
+
+                    for (BlockId pred : mGraph.blocks[block].preds) {
+                        worklist.push_back(pred);
+                    }
+                }
+
+                loops.push_back(std::move(loop));
+            }
+
+            std::stable_sort(loops.begin(), loops.end(), [](const Loop& a, const Loop& b) {
+                return a.size < b.size;
+            });
+
+            return loops;
+        }
+
+        // A block that's the only way into the loop from outside, ending right before the header. Made if the loop
+        // doesn't have one, merging the phi operands coming from outside into it
+        BlockId makePreheader(Loop& loop, std::vector<Loop>& loops) {
+            BlockId header = loop.header;
+
+            std::vector<size_t> outside; // pred indices
+            for (size_t i = 0; i < mGraph.blocks[header].preds.size(); i++) {
+                if (!loop.contains(mGraph.blocks[header].preds[i])) outside.push_back(i);
+            }
+
+            if (outside.size() == 1) {
+                BlockId pred = mGraph.blocks[header].preds[outside.front()];
+                if (mGraph.blocks[pred].succs.size() == 1) return pred;
+            }
+
+            BlockId preheader = mGraph.addBlock();
+
+            for (ValueId value : std::vector<ValueId>(mGraph.blocks[header].insts)) {
+                if (mGraph.insts[value].op != Op::Phi) break;
+
+                std::vector<ValueId> outsideOperands;
+                std::vector<ValueId> insideOperands;
+                for (size_t i = 0; i < mGraph.insts[value].operands.size(); i++) {
+                    bool isOutside = std::find(outside.begin(), outside.end(), i) != outside.end();
+                    (isOutside ? outsideOperands : insideOperands).push_back(mGraph.insts[value].operands[i]);
+                }
+
+                ValueId merged = outsideOperands.front();
+                if (outsideOperands.size() > 1) merged = mGraph.append(preheader, Op::Phi, outsideOperands);
+
+                insideOperands.push_back(merged);
+                mGraph.insts[value].operands = std::move(insideOperands);
+            }
+
+            std::vector<BlockId> insidePreds;
+            for (size_t i = 0; i < mGraph.blocks[header].preds.size(); i++) {
+                BlockId pred = mGraph.blocks[header].preds[i];
+
+                if (std::find(outside.begin(), outside.end(), i) == outside.end()) {
+                    insidePreds.push_back(pred);
+                    continue;
+                }
+
+                // one edge each, even if a block branches to the header both ways
+                std::vector<BlockId>& succs = mGraph.blocks[pred].succs;
+                *std::find(succs.begin(), succs.end(), header) = preheader;
+                mGraph.blocks[preheader].preds.push_back(pred);
+            }
+
+            insidePreds.push_back(preheader);
+            mGraph.blocks[header].preds = std::move(insidePreds);
+            mGraph.blocks[preheader].succs.push_back(header);
+            mGraph.append(preheader, Op::Jump);
+
+            for (Loop& other : loops) {
+                other.body.resize(mGraph.blocks.size(), false);
+                if (&other != &loop && other.contains(header)) other.body[preheader] = true;
+            }
+
+            return preheader;
+        }
+
+        bool isInvariant(const Loop& loop, ValueId value) const {
+            const Inst& inst = mGraph.get(value);
+            return inst.op == Op::Const || !loop.contains(inst.block);
+        }
+
+        bool canHoist(const Loop& loop, ValueId value) const {
+            const Inst& inst = mGraph.insts[value];
+            if (!IsPure(inst.op) || inst.op == Op::Phi || inst.op == Op::Const) return false; // constants are free anyway
+
+            // executed whether or not the loop would have, so nothing that can trap
+            if (inst.op == Op::Div || inst.op == Op::Mod) {
+                const Inst& divisor = mGraph.get(inst.operands[1]);
+                if (divisor.op != Op::Const || divisor.imm == 0 || divisor.imm == -1) return false;
+            }
+
+            return std::all_of(inst.operands.begin(), inst.operands.end(), [this, &loop](ValueId operand) {
+                return isInvariant(loop, operand);
+            });
+        }
+
+        void hoistLoopInvariants() {
+            mGraph.resolveOperands();
+
+            std::vector<Loop> loops = findLoops();
+
+            for (Loop& loop : loops) {
+                BlockId preheader = makePreheader(loop, loops);
+
+                for (BlockId block : mGraph.reversePostorder()) { // operands before their uses
+                    if (!loop.contains(block)) continue;
+
+                    for (ValueId value : std::vector<ValueId>(mGraph.blocks[block].insts)) {
+                        if (!canHoist(loop, value)) continue;
+
+                        mGraph.remove(value);
+
+                        std::vector<ValueId>& preheaderInsts = mGraph.blocks[preheader].insts;
+                        preheaderInsts.insert(preheaderInsts.end() - 1, value);
+                        mGraph.insts[value].block = preheader;
+                    }
+                }
+            }
+        }
+    };
+
+    void OptimizeGraph(Graph& graph) {
+        GraphOptimizer(graph).run();
+    }
+}
@@ -0,0 +1,697 @@
+// Copyright 2025 JesusTouchMe
+
+#include "BibbleVM/core/jit/optimizing_compiler.h"
+
+#include "BibbleVM/core/vm.h"
+
+#if BIBBLEVM_JIT
+#include "BibbleVM/core/exec/verifier.h"
+
+#include "BibbleVM/core/jit/ir_builder.h"
+#include "BibbleVM/core/jit/ir_optimizer.h"
+#include "BibbleVM/core/jit/register_allocator.h"
+#include "BibbleVM/core/jit/runtime.h"
+#include "BibbleVM/core/jit/x64_assembler.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+#endif
+
+namespace bibble {
+#if BIBBLEVM_JIT
+    using ir::BlockId;
+    using ir::Inst;
+    using ir::Location;
+    using ir::Op;
+    using ir::ValueId;
+    using x64::AluOp;
+    using x64::Cond;
+    using x64::Mem;
+    using x64::Reg;
+    using x64::SseOp;
+    using x64::Xmm;
+
+    // Pinned for the whole function, like in baseline code. RBP addresses the spill slots
+    constexpr Reg VmReg = Reg::R14;
+    constexpr Reg StateReg = Reg::R15;
+
+    constexpr i32 AccOffset = offsetof(ExecState, acc);
+    constexpr i32 SpOffset = offsetof(ExecState, sp);
+    constexpr i32 FrameOffset = offsetof(ExecState, frame);
+    constexpr i32 LimitOffset = offsetof(ExecState, limit);
+
+    constexpr i32 SlotSize = sizeof(Value);
+    constexpr i32 SavedRegistersSize = 5 * 8; // below the saved RBP
+
+    struct OptimizedCode {
+        std::vector<u8> code;
+        size_t resumeOffset; // of the NativeResumeEntry
+        std::vector<u32> offsets; // of the resume stub of every loop header, NoResume for everything else
+    };
+
+    static Cond Invert(Cond cond) {
+        return static_cast<Cond>(static_cast<u8>(cond) ^ 1); // conditions come in pairs differing in the lowest bit
+    }
+
+    static std::optional<Cond> GetIntCondition(Op op) {
+        switch (op) {
+            case Op::CmpEq: return Cond::E;
+            case Op::CmpNe: return Cond::NE;
+            case Op::CmpLt: return Cond::L;
+            case Op::CmpGt: return Cond::G;
+            case Op::CmpLe: return Cond::LE;
+            case Op::CmpGe: return Cond::GE;
+            default: return std::nullopt;
+        }
+    }
+
+    static std::optional<Cond> GetFloatCondition(Op op) {
+        switch (op) {
+            case Op::FCmpEq: return Cond::E;
+            case Op::FCmpNe: return Cond::NE;
+            case Op::FCmpLt: return Cond::L;
+            case Op::FCmpGt: return Cond::G;
+            case Op::FCmpLe: return Cond::LE;
+            case Op::FCmpGe: return Cond::GE;
+            default: return std::nullopt;
+        }
+    }
+
+    class OptimizingCompiler {
+    public:
+        OptimizingCompiler(const DecodedFunction& function, const ir::Graph& graph, const ir::Allocation& allocation)
+            : mFunction(function)
+            , mGraph(graph)
+            , mAllocation(allocation) {}
+
+        std::optional<OptimizedCode> compile() {
+            if (static_cast<u64>(mGraph.slotCount) * SlotSize > std::numeric_limits<i32>::max()) return std::nullopt;
+
+            u32 spillSlots = mAllocation.spillSlots;
+            if (spillSlots % 2 == 0) spillSlots++; // keeps calls 16-byte aligned with the 5 saved registers
+            mFrameSize = static_cast<i32>(spillSlots) * 8;
+
+            mLabels.reserve(mGraph.blocks.size());
+            for (size_t i = 0; i < mGraph.blocks.size(); i++) {
+                mLabels.push_back(mAsm.newLabel());
+            }
+
+            mExit = mAsm.newLabel();
+            countUses();
+
+            // entry. frames it wasn't made for run the baseline code, which is entered as if it was called directly
+            x64::Assembler::Label entryRejected = mAsm.newLabel();
+            guard(mGraph.args, entryRejected);
+            prologue();
+            mAsm.jmp(mLabels[mGraph.entry]);
+
+            mAsm.bind(entryRejected);
+            mAsm.mov(Reg::RAX, static_cast<i64>(reinterpret_cast<uintptr_t>(mFunction.baseline.entry)));
+            mAsm.jmp(Reg::RAX);
+
+            size_t resumeOffset = mAsm.getPosition();
+            mAsm.jmp(Reg::RDX);
+
+            std::vector<u32> offsets(mFunction.instructions.size(), NativeCode::NoResume);
+            for (const ir::OsrEntry& osrEntry : mGraph.osrEntries) {
+                if (mGraph.blocks[osrEntry.block].removed) continue;
+
+                x64::Assembler::Label rejected = mAsm.newLabel();
+                offsets[osrEntry.header] = static_cast<u32>(mAsm.getPosition());
+
+                guard(osrEntry.height, rejected);
+                prologue();
+                mAsm.jmp(mLabels[osrEntry.block]);
+
+                mAsm.bind(rejected); // nothing touched yet, the frame stays where it's running
+                mAsm.mov(Reg::RAX, DISPATCH_SUCCESS);
+                mAsm.ret();
+            }
+
+            for (size_t i = 0; i < mAllocation.order.size(); i++) {
+                mNext = i + 1 < mAllocation.order.size() ? mAllocation.order[i + 1] : ir::None;
+                compileBlock(mAllocation.order[i]);
+            }
+
+            mAsm.bind(mExit);
+            epilogue();
+
+            return OptimizedCode{ mAsm.finish(), resumeOffset, std::move(offsets) };
+        }
+
+    private:
+        const DecodedFunction& mFunction;
+        const ir::Graph& mGraph;
+        const ir::Allocation& mAllocation;
+
+        x64::Assembler mAsm;
+        std::vector<x64::Assembler::Label> mLabels; // by block
+        x64::Assembler::Label mExit; // returns eax. acc and sp must be in state already if it matters
+        i32 mFrameSize = 0;
+        BlockId mNext = ir::None; // emitted right after the current block, so jumps to it can be left out
+        std::vector<u32> mUses; // by value
+
+        void countUses() {
+            mUses.assign(mGraph.insts.size(), 0);
+
+            for (BlockId block : mAllocation.order) {
+                for (ValueId value : mGraph.blocks[block].insts) {
+                    for (ValueId operand : mGraph.insts[value].operands) {
+                        mUses[operand]++;
+                    }
+                }
+            }
+        }
+
+        // Jumps to rejected unless the frame in state (rsi) holds exactly height values and has room for every slot
+        // the code touches
+        void guard(u32 height, x64::Assembler::Label rejected) {
+            mAsm.mov(Reg::RAX, Mem{ Reg::RSI, SpOffset });
+            mAsm.alu(AluOp::SUB, Reg::RAX, Mem{ Reg::RSI, FrameOffset });
+            mAsm.alu(AluOp::CMP, Reg::RAX, static_cast<i32>(height) * SlotSize);
+            mAsm.jcc(Cond::NE, rejected);
+
+            mAsm.mov(Reg::RAX, Mem{ Reg::RSI, LimitOffset });
+            mAsm.alu(AluOp::SUB, Reg::RAX, Mem{ Reg::RSI, FrameOffset });
+            mAsm.alu(AluOp::CMP, Reg::RAX, static_cast<i32>(mGraph.slotCount) * SlotSize);
+            mAsm.jcc(Cond::B, rejected);
+        }
+
+        void prologue() {
+            mAsm.push(Reg::RBP);
+            mAsm.mov(Reg::RBP, Reg::RSP);
+            mAsm.push(Reg::RBX);
+            mAsm.push(Reg::R12);
+            mAsm.push(Reg::R13);
+            mAsm.push(VmReg);
+            mAsm.push(StateReg);
+            mAsm.alu(AluOp::SUB, Reg::RSP, mFrameSize);
+
+            mAsm.mov(VmReg, Reg::RDI);
+            mAsm.mov(StateReg, Reg::RSI);
+        }
+
+        void epilogue() {
+            mAsm.alu(AluOp::ADD, Reg::RSP, mFrameSize);
+            mAsm.pop(StateReg);
+            mAsm.pop(VmReg);
+            mAsm.pop(Reg::R13);
+            mAsm.pop(Reg::R12);
+            mAsm.pop(Reg::RBX);
+            mAsm.pop(Reg::RBP);
+            mAsm.ret();
+        }
+
+        const Location& location(ValueId value) const {
+            return mAllocation.locations[value];
+        }
+
+        static Mem SpillSlot(u32 slot) {
+            return { Reg::RBP, -SavedRegistersSize - static_cast<i32>(slot + 1) * 8 };
+        }
+
+        void load(Reg dst, ValueId value) {
+            const Location& from = location(value);
+
+            switch (from.kind) {
+                case Location::Kind::Register:
+                    if (from.reg != dst) mAsm.mov(dst, from.reg);
+                    break;
+                case Location::Kind::Stack:
+                    mAsm.mov(dst, SpillSlot(from.slot));
+                    break;
+                case Location::Kind::Constant:
+                    mAsm.mov(dst, mGraph.insts[value].imm);
+                    break;
+                case Location::Kind::None:
+                    break;
+            }
+        }
+
+        void store(ValueId value, Reg src) {
+            const Location& to = location(value);
+
+            if (to.kind == Location::Kind::Register && to.reg != src) mAsm.mov(to.reg, src);
+            else if (to.kind == Location::Kind::Stack) mAsm.mov(SpillSlot(to.slot), src);
+        }
+
+        // Where to compute value: its own register if it has one that isn't clobbered by reading avoid, RAX otherwise
+        Reg workRegister(ValueId value, ValueId avoid = ir::None) const {
+            const Location& to = location(value);
+            if (to.kind != Location::Kind::Register) return Reg::RAX;
+
+            if (avoid != ir::None && location(avoid).kind == Location::Kind::Register && location(avoid).reg == to.reg) {
+                return Reg::RAX;
+            }
+
+            return to.reg;
+        }
+
+        void loadFloat(Xmm dst, ValueId value) {
+            const Location& from = location(value);
+
+            if (from.kind == Location::Kind::Register) {
+                mAsm.movq(dst, from.reg);
+            } else if (from.kind == Location::Kind::Stack) {
+                mAsm.movsd(dst, SpillSlot(from.slot));
+            } else {
+                mAsm.mov(Reg::RAX, mGraph.insts[value].imm);
+                mAsm.movq(dst, Reg::RAX);
+            }
+        }
+
+        void storeFloat(ValueId value, Xmm src) {
+            const Location& to = location(value);
+
+            if (to.kind == Location::Kind::Register) mAsm.movq(to.reg, src);
+            else if (to.kind == Location::Kind::Stack) mAsm.movsd(SpillSlot(to.slot), src);
+        }
+
+        // dst op= value, for the ALU ops with a memory form
+        void aluOperand(AluOp op, Reg dst, ValueId value) {
+            const Location& from = location(value);
+            i64 imm = mGraph.insts[value].imm;
+
+            if (from.kind == Location::Kind::Register) {
+                mAsm.alu(op, dst, from.reg);
+            } else if (from.kind == Location::Kind::Stack) {
+                mAsm.alu(op, dst, SpillSlot(from.slot));
+            } else if (imm >= std::numeric_limits<i32>::min() && imm <= std::numeric_limits<i32>::max()) {
+                mAsm.alu(op, dst, static_cast<i32>(imm));
+            } else {
+                mAsm.mov(Reg::RCX, imm);
+                mAsm.alu(op, dst, Reg::RCX);
+            }
+        }
+
+        void binary(ValueId value, const Inst& inst) {
+            ValueId a = inst.operands[0];
+            ValueId b = inst.operands[1];
+
+            switch (inst.op) {
+                case Op::Add:
+                case Op::Sub:
+                case Op::And:
+                case Op::Or:
+                case Op::Xor: {
+                    AluOp op = inst.op == Op::Add ? AluOp::ADD
+                        : inst.op == Op::Sub ? AluOp::SUB
+                        : inst.op == Op::And ? AluOp::AND
+                        : inst.op == Op::Or ? AluOp::OR
+                        : AluOp::XOR;
+
+                    Reg work = workRegister(value, b);
+                    load(work, a);
+                    aluOperand(op, work, b);
+                    store(value, work);
+                    return;
+                }
+
+                case Op::Mul: {
+                    Reg work = workRegister(value, b);
+                    load(work, a);
+
+                    const Location& from = location(b);
+                    if (from.kind == Location::Kind::Register) {
+                        mAsm.imul(work, from.reg);
+                    } else if (from.kind == Location::Kind::Stack) {
+                        mAsm.imul(work, SpillSlot(from.slot));
+                    } else {
+                        load(Reg::RCX, b);
+                        mAsm.imul(work, Reg::RCX);
+                    }
+
+                    store(value, work);
+                    return;
+                }
+
+                case Op::Div:
+                case Op::Mod:
+                    load(Reg::RCX, b);
+                    load(Reg::RAX, a);
+                    mAsm.cqo();
+                    mAsm.idiv(Reg::RCX);
+                    store(value, inst.op == Op::Div ? Reg::RAX : Reg::RDX);
+                    return;
+
+                case Op::Shl:
+                case Op::Shr: {
+                    Reg work = workRegister(value); // never RCX
+                    load(Reg::RCX, b);
+                    load(work, a);
+                    if (inst.op == Op::Shl) mAsm.shlCl(work);
+                    else mAsm.sarCl(work);
+                    store(value, work);
+                    return;
+                }
+
+                case Op::FAdd:
+                case Op::FSub:
+                case Op::FMul:
+                case Op::FDiv: {
+                    SseOp op = inst.op == Op::FAdd ? SseOp::ADDSD
+                        : inst.op == Op::FSub ? SseOp::SUBSD
+                        : inst.op == Op::FMul ? SseOp::MULSD
+                        : SseOp::DIVSD;
+
+                    loadFloat(Xmm::XMM0, a);
+                    loadFloat(Xmm::XMM1, b);
+                    mAsm.sse(op, Xmm::XMM0, Xmm::XMM1);
+                    storeFloat(value, Xmm::XMM0);
+                    return;
+                }
+
+                default:
+                    break;
+            }
+
+            if (std::optional<Cond> cond = GetIntCondition(inst.op)) {
+                load(Reg::RAX, a);
+                aluOperand(AluOp::CMP, Reg::RAX, b);
+                mAsm.setcc(cond.value(), Reg::RAX);
+                mAsm.movzxByte(Reg::RAX, Reg::RAX);
+                store(value, Reg::RAX);
+                return;
+            }
+
+            if (std::optional<Cond> cond = GetFloatCondition(inst.op)) {
+                loadFloat(Xmm::XMM0, a);
+                loadFloat(Xmm::XMM1, b);
+                mAsm.compareSd(cond.value());
+                store(value, Reg::RAX);
+            }
+        }
+
+        void unary(ValueId value, const Inst& inst) {
+            Reg work = workRegister(value);
+            load(work, inst.operands[0]);
+
+            if (inst.op == Op::Neg) {
+                mAsm.neg(work);
+            } else if (inst.op == Op::Not) {
+                mAsm.not_(work);
+            } else { // FNeg
+                mAsm.mov(Reg::RCX, std::numeric_limits<i64>::min()); // sign bit
+                mAsm.alu(AluOp::XOR, work, Reg::RCX);
+            }
+
+            store(value, work);
+        }
+
+        // Stores acc and sets sp to the frame height. RCX is left holding the frame
+        void writeBack(ValueId acc, u32 height) {
+            load(Reg::RAX, acc);
+            mAsm.mov(Mem{ StateReg, AccOffset }, Reg::RAX);
+
+            mAsm.mov(Reg::RCX, Mem{ StateReg, FrameOffset });
+            mAsm.mov(Reg::RAX, Reg::RCX);
+            mAsm.alu(AluOp::ADD, Reg::RAX, static_cast<i32>(height) * SlotSize);
+            mAsm.mov(Mem{ StateReg, SpOffset }, Reg::RAX);
+        }
+
+        void callRuntime(const void* function) {
+            mAsm.mov(Reg::RAX, static_cast<i64>(reinterpret_cast<uintptr_t>(function)));
+            mAsm.call(Reg::RAX);
+        }
+
+        void frameEffect(ValueId value, const Inst& inst) {
+            u32 height = inst.slot;
+
+            writeBack(inst.operands[height], height);
+            for (u32 slot = 0; slot < height; slot++) {
+                const Location& from = location(inst.operands[slot]);
+                Mem to{ Reg::RCX, static_cast<i32>(slot) * SlotSize };
+
+                if (from.kind == Location::Kind::Register) {
+                    mAsm.mov(to, from.reg);
+                } else {
+                    load(Reg::RAX, inst.operands[slot]);
+                    mAsm.mov(to, Reg::RAX);
+                }
+            }
+
+            x64::Assembler::Label skip = mAsm.newLabel();
+            ByteOpcode opcode = GetLeadingOpcode(inst.source->opcode);
+
+            if (opcode == ByteOpcode::TRAP_IF_ZERO || opcode == ByteOpcode::TRAP_IF_NOT_ZERO) {
+                mAsm.mov(Reg::RAX, Mem{ StateReg, AccOffset });
+                mAsm.test(Reg::RAX, Reg::RAX);
+                mAsm.jcc(opcode == ByteOpcode::TRAP_IF_ZERO ? Cond::NE : Cond::E, skip);
+            }
+
+            mAsm.mov(Reg::RDI, VmReg);
+            mAsm.mov(Reg::RSI, StateReg);
+
+            if (inst.op == Op::Trap) {
+                mAsm.mov(Reg::RDX, inst.imm);
+                callRuntime(reinterpret_cast<const void*>(&CompiledTrap));
+            } else {
+                mAsm.mov(Reg::RDX, static_cast<i64>(reinterpret_cast<uintptr_t>(inst.source)));
+                callRuntime(inst.op == Op::Call ? reinterpret_cast<const void*>(&CompiledCall) : reinterpret_cast<const void*>(&CompiledCallDynamic));
+            }
+
+            mAsm.test(Reg::RAX, Reg::RAX);
+            mAsm.jcc(Cond::NE, mExit);
+
+            mAsm.bind(skip);
+            Reg work = workRegister(value);
+            mAsm.mov(work, Mem{ StateReg, AccOffset });
+            store(value, work);
+        }
+
+        struct Move {
+            Location to;
+            Location from;
+            i64 imm; // for constants
+        };
+
+        void emitMove(const Location& to, const Location& from, i64 imm) {
+            if (to.kind == Location::Kind::Register) {
+                if (from.kind == Location::Kind::Register) mAsm.mov(to.reg, from.reg);
+                else if (from.kind == Location::Kind::Stack) mAsm.mov(to.reg, SpillSlot(from.slot));
+                else mAsm.mov(to.reg, imm);
+                return;
+            }
+
+            if (from.kind == Location::Kind::Register) {
+                mAsm.mov(SpillSlot(to.slot), from.reg);
+                return;
+            }
+
+            if (from.kind == Location::Kind::Stack) mAsm.mov(Reg::RAX, SpillSlot(from.slot));
+            else mAsm.mov(Reg::RAX, imm);
+
+            mAsm.mov(SpillSlot(to.slot), Reg::RAX);
+        }
+
+        // The phi moves for the edge into succ, all at once. Cycles go through RCX
+        void phiMoves(BlockId block, BlockId succ) {
+            const std::vector<BlockId>& preds = mGraph.blocks[succ].preds;
+            size_t predIndex = static_cast<size_t>(std::find(preds.begin(), preds.end(), block) - preds.begin());
+
+            std::vector<Move> moves;
+            for (ValueId value : mGraph.blocks[succ].insts) {
+                const Inst& phi = mGraph.insts[value];
+                if (phi.op != Op::Phi) break;
+
+                ValueId operand = phi.operands[predIndex];
+                const Location& to = location(value);
+                const Location& from = location(operand);
+
+                if (to.kind == Location::Kind::None || to == from) continue;
+                moves.push_back({ to, from, mGraph.insts[operand].imm });
+            }
+
+            while (!moves.empty()) {
+                auto ready = std::find_if(moves.begin(), moves.end(), [&moves](const Move& move) {
+                    return std::none_of(moves.begin(), moves.end(), [&move](const Move& other) {
+                        return &other != &move && other.from.kind != Location::Kind::Constant && other.from == move.to;
+                    });
+                });
+
+                if (ready != moves.end()) {
+                    emitMove(ready->to, ready->from, ready->imm);
+                    moves.erase(ready);
+                    continue;
+                }
+
+                // every destination is still needed as a source. free one by saving it
+                Location saved = moves.front().to;
+                Location scratch{ Location::Kind::Register, Reg::RCX, 0 };
+                emitMove(scratch, saved, 0);
+
+                for (Move& move : moves) {
+                    if (move.from == saved) move.from = scratch;
+                }
+            }
+        }
+
+        void jumpTo(BlockId target) {
+            if (target != mNext) mAsm.jmp(mLabels[target]);
+        }
+
+        // Branches on cond, which was just set by whatever compared
+        void branchOn(BlockId block, Cond cond) {
+            BlockId ifTrue = mGraph.blocks[block].succs[0];
+            BlockId ifFalse = mGraph.blocks[block].succs[1];
+
+            if (ifTrue == mNext) {
+                mAsm.jcc(Invert(cond), mLabels[ifFalse]);
+            } else {
+                mAsm.jcc(cond, mLabels[ifTrue]);
+                jumpTo(ifFalse);
+            }
+        }
+
+        // An integer compare only the branch right after it uses, which can branch on the flags directly
+        bool isFusedCompare(BlockId block, size_t index) const {
+            const std::vector<ValueId>& insts = mGraph.blocks[block].insts;
+            if (index + 2 != insts.size()) return false;
+
+            ValueId value = insts[index];
+            const Inst& branch = mGraph.insts[insts.back()];
+
+            return GetIntCondition(mGraph.insts[value].op).has_value() && branch.op == Op::Branch
+                && branch.operands[0] == value && mUses[value] == 1;
+        }
+
+        void compileBlock(BlockId block) {
+            mAsm.bind(mLabels[block]);
+
+            const std::vector<ValueId>& insts = mGraph.blocks[block].insts;
+            for (size_t i = 0; i < insts.size(); i++) {
+                ValueId value = insts[i];
+                const Inst& inst = mGraph.insts[value];
+
+                switch (inst.op) {
+                    case Op::Const:
+                    case Op::Phi:
+                        break;
+
+                    case Op::LoadSlot: {
+                        Reg work = workRegister(value);
+                        mAsm.mov(Reg::RAX, Mem{ StateReg, FrameOffset });
+                        mAsm.mov(work, Mem{ Reg::RAX, static_cast<i32>(inst.slot) * SlotSize });
+                        store(value, work);
+                        break;
+                    }
+
+                    case Op::LoadAcc: {
+                        Reg work = workRegister(value);
+                        mAsm.mov(work, Mem{ StateReg, AccOffset });
+                        store(value, work);
+                        break;
+                    }
+
+                    case Op::Neg:
+                    case Op::Not:
+                    case Op::FNeg:
+                        unary(value, inst);
+                        break;
+
+                    case Op::Call:
+                    case Op::CallDynamic:
+                    case Op::Trap:
+                        frameEffect(value, inst);
+                        break;
+
+                    case Op::Jump:
+                        phiMoves(block, mGraph.blocks[block].succs[0]);
+                        jumpTo(mGraph.blocks[block].succs[0]);
+                        break;
+
+                    case Op::Branch: { // critical edges are split, so neither successor has phis
+                        const Inst& condition = mGraph.insts[inst.operands[0]];
+
+                        if (i > 0 && isFusedCompare(block, i - 1)) {
+                            load(Reg::RAX, condition.operands[0]);
+                            aluOperand(AluOp::CMP, Reg::RAX, condition.operands[1]);
+                            branchOn(block, GetIntCondition(condition.op).value());
+                            break;
+                        }
+
+                        const Location& from = location(inst.operands[0]);
+                        Reg reg = from.kind == Location::Kind::Register ? from.reg : Reg::RAX;
+                        load(reg, inst.operands[0]);
+                        mAsm.test(reg, reg);
+                        branchOn(block, Cond::NE);
+                        break;
+                    }
+
+                    case Op::Return:
+                        writeBack(inst.operands[0], inst.slot);
+                        mAsm.mov(Reg::RAX, DISPATCH_RETURN);
+                        mAsm.jmp(mExit);
+                        break;
+
+                    case Op::Halt:
+                        writeBack(inst.operands[0], inst.slot);
+                        mAsm.mov(Reg::RDI, VmReg);
+                        mAsm.mov(Reg::RSI, inst.imm);
+                        callRuntime(reinterpret_cast<const void*>(&CompiledExit));
+                        mAsm.mov(Reg::RAX, DISPATCH_RETURN);
+                        mAsm.jmp(mExit);
+                        break;
+
+                    case Op::Error:
+                        writeBack(inst.operands[0], inst.slot);
+                        mAsm.mov(Reg::RAX, DISPATCH_ERROR);
+                        mAsm.jmp(mExit);
+                        break;
+
+                    default:
+                        if (isFusedCompare(block, i)) break; // done by the branch
+                        binary(value, inst);
+                        break;
+                }
+            }
+        }
+    };
+#endif
+
+    bool CompileOptimized(VM& vm, u32 module, const DecodedFunction& function, const DispatchTables& tables, u32 instruction, u64 height) {
+#if BIBBLEVM_JIT
+        if (!function.verified || function.baseline.entry == nullptr) return false;
+
+        // what the frame was entered with, going by the height it has at instruction
+        std::optional<i64> depth = GetStackDepths(function)[instruction];
+        if (!depth.has_value() || static_cast<i64>(height) < depth.value()) return false;
+
+        u64 args = height - static_cast<u64>(depth.value());
+        if (args > std::numeric_limits<u32>::max()) return false;
+
+        std::optional<ir::Graph> graph = ir::BuildGraph(vm, module, function, tables, static_cast<u32>(args));
+        if (!graph.has_value()) return false;
+
+        ir::OptimizeGraph(graph.value());
+        ir::Allocation allocation = ir::AllocateRegisters(graph.value());
+
+        std::optional<OptimizedCode> compiled = OptimizingCompiler(function, graph.value(), allocation).compile();
+        if (!compiled.has_value()) return false;
+
+        std::optional<ExecutableMemory> memory = ExecutableMemory::Create(compiled->code);
+        if (!memory.has_value()) return false;
+
+        void* base = const_cast<void*>(memory->data());
+
+        NativeCode& native = function.optimized;
+        native.memory = std::move(memory.value());
+        native.offsets = std::move(compiled->offsets);
+        native.entry = reinterpret_cast<NativeEntry>(base);
+        native.resume = reinterpret_cast<NativeResumeEntry>(static_cast<u8*>(base) + compiled->resumeOffset);
+
+        function.native = native.entry;
+
+        return true;
+#else
+        (void) vm;
+        (void) module;
+        (void) function;
+        (void) tables;
+        (void) instruction;
+        (void) height;
+        return false;
+#endif
+    }
+}
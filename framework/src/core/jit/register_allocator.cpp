@@ -0,0 +1,325 @@
+// Copyright 2025 JesusTouchMe
+
+#include "BibbleVM/core/jit/register_allocator.h"
+
+#include <algorithm>
+
+namespace bibble::ir {
+    using x64::Reg;
+
+    static void SplitCriticalEdges(Graph& graph) {
+        BlockId blockCount = static_cast<BlockId>(graph.blocks.size());
+
+        for (BlockId block = 0; block < blockCount; block++) {
+            if (graph.blocks[block].removed || graph.blocks[block].succs.size() < 2) continue;
+
+            for (size_t i = 0; i < graph.blocks[block].succs.size(); i++) {
+                BlockId succ = graph.blocks[block].succs[i];
+                if (graph.blocks[succ].preds.size() < 2) continue;
+
+                // the edge's own entry in preds, which is what its phi operands line up with
+                size_t occurrence = static_cast<size_t>(std::count(graph.blocks[block].succs.begin(), graph.blocks[block].succs.begin() + static_cast<std::ptrdiff_t>(i), succ));
+
+                BlockId split = graph.addBlock();
+                graph.append(split, Op::Jump);
+                graph.blocks[split].preds.push_back(block);
+                graph.blocks[split].succs.push_back(succ);
+                graph.blocks[block].succs[i] = split;
+
+                for (BlockId& pred : graph.blocks[succ].preds) {
+                    if (pred != block) continue;
+
+                    if (occurrence == 0) {
+                        pred = split;
+                        break;
+                    }
+
+                    occurrence--;
+                }
+            }
+        }
+    }
+
+    static bool HasResult(Op op) {
+        return !IsTerminator(op);
+    }
+
+    // Sets of values, one bit each
+    class ValueSet {
+    public:
+        explicit ValueSet(size_t size = 0)
+            : mWords((size + 63) / 64, 0) {}
+
+        bool contains(ValueId value) const {
+            return (mWords[value / 64] >> (value % 64)) & 1;
+        }
+
+        void insert(ValueId value) {
+            mWords[value / 64] |= u64(1) << (value % 64);
+        }
+
+        void erase(ValueId value) {
+            mWords[value / 64] &= ~(u64(1) << (value % 64));
+        }
+
+        // this |= other, returns whether anything was added
+        bool merge(const ValueSet& other) {
+            bool changed = false;
+
+            for (size_t i = 0; i < mWords.size(); i++) {
+                u64 merged = mWords[i] | other.mWords[i];
+                changed |= merged != mWords[i];
+                mWords[i] = merged;
+            }
+
+            return changed;
+        }
+
+        template <class F>
+        void forEach(F function) const {
+            for (size_t i = 0; i < mWords.size(); i++) {
+                u64 word = mWords[i];
+
+                while (word != 0) {
+                    int bit = __builtin_ctzll(word);
+                    function(static_cast<ValueId>(i * 64 + bit));
+                    word &= word - 1;
+                }
+            }
+        }
+
+    private:
+        std::vector<u64> mWords;
+    };
+
+    class RegisterAllocator {
+    public:
+        explicit RegisterAllocator(Graph& graph)
+            : mGraph(graph) {}
+
+        Allocation run() {
+            SplitCriticalEdges(mGraph);
+
+            mAllocation.order = mGraph.reversePostorder();
+            mAllocation.locations.assign(mGraph.insts.size(), {});
+
+            number();
+            computeLiveness();
+            buildIntervals();
+            scan();
+
+            return std::move(mAllocation);
+        }
+
+    private:
+        struct Interval {
+            ValueId value;
+            u32 start;
+            u32 end;
+            bool crossesCall;
+        };
+
+        Graph& mGraph;
+        Allocation mAllocation;
+
+        std::vector<u32> mPositions; // by value
+        std::vector<u32> mBlockFrom; // position of the first instruction, by block
+        std::vector<u32> mBlockTo; // position of the terminator
+        std::vector<u32> mCallPositions; // of every frame effect, ascending
+
+        std::vector<ValueSet> mLiveOut; // by block
+        std::vector<Interval> mIntervals;
+
+        bool isAllocated(ValueId value) const {
+            const Inst& inst = mGraph.insts[value];
+            return HasResult(inst.op) && inst.op != Op::Const;
+        }
+
+        void number() {
+            mPositions.assign(mGraph.insts.size(), 0);
+            mBlockFrom.assign(mGraph.blocks.size(), 0);
+            mBlockTo.assign(mGraph.blocks.size(), 0);
+
+            u32 position = 0;
+            for (BlockId block : mAllocation.order) {
+                mBlockFrom[block] = position;
+
+                for (ValueId value : mGraph.blocks[block].insts) {
+                    // phis all take their values at once on the way in
+                    mPositions[value] = mGraph.insts[value].op == Op::Phi ? mBlockFrom[block] : position;
+                    if (IsFrameEffect(mGraph.insts[value].op)) mCallPositions.push_back(position);
+
+                    mBlockTo[block] = position;
+                    position += 2;
+                }
+            }
+        }
+
+        void computeLiveness() {
+            size_t valueCount = mGraph.insts.size();
+
+            std::vector<ValueSet> liveIn(mGraph.blocks.size(), ValueSet(valueCount));
+            mLiveOut.assign(mGraph.blocks.size(), ValueSet(valueCount));
+
+            bool changed = true;
+            while (changed) {
+                changed = false;
+
+                for (auto it = mAllocation.order.rbegin(); it != mAllocation.order.rend(); ++it) {
+                    BlockId block = *it;
+                    ValueSet live(valueCount);
+
+                    for (BlockId succ : mGraph.blocks[block].succs) {
+                        live.merge(liveIn[succ]);
+
+                        // phi operands are used at the end of the predecessor they come from
+                        size_t predIndex = static_cast<size_t>(std::find(mGraph.blocks[succ].preds.begin(), mGraph.blocks[succ].preds.end(), block) - mGraph.blocks[succ].preds.begin());
+                        for (ValueId value : mGraph.blocks[succ].insts) {
+                            const Inst& phi = mGraph.insts[value];
+                            if (phi.op != Op::Phi) break;
+
+                            ValueId operand = phi.operands[predIndex];
+                            if (isAllocated(operand)) live.insert(operand);
+                        }
+                    }
+
+                    changed |= mLiveOut[block].merge(live);
+
+                    const std::vector<ValueId>& insts = mGraph.blocks[block].insts;
+                    for (auto inst = insts.rbegin(); inst != insts.rend(); ++inst) {
+                        live.erase(*inst);
+                        if (mGraph.insts[*inst].op == Op::Phi) continue;
+
+                        for (ValueId operand : mGraph.insts[*inst].operands) {
+                            if (isAllocated(operand)) live.insert(operand);
+                        }
+                    }
+
+                    changed |= liveIn[block].merge(live);
+                }
+            }
+        }
+
+        bool crossesCall(u32 start, u32 end) const {
+            auto call = std::upper_bound(mCallPositions.begin(), mCallPositions.end(), start);
+            return call != mCallPositions.end() && *call < end;
+        }
+
+        // Values are defined before anything uses them in reverse postorder, so one interval from the definition to
+        // the last position the value is live at covers it, with any holes in between filled
+        void buildIntervals() {
+            std::vector<u32> starts(mGraph.insts.size(), None);
+            std::vector<u32> ends(mGraph.insts.size(), 0);
+
+            auto extend = [&ends](ValueId value, u32 position) {
+                ends[value] = std::max(ends[value], position);
+            };
+
+            for (BlockId block : mAllocation.order) {
+                mLiveOut[block].forEach([&](ValueId value) {
+                    extend(value, mBlockTo[block] + 1);
+                });
+
+                for (ValueId value : mGraph.blocks[block].insts) {
+                    const Inst& inst = mGraph.insts[value];
+
+                    if (isAllocated(value)) {
+                        starts[value] = std::min(starts[value], mPositions[value]);
+                        extend(value, mPositions[value]);
+                    }
+
+                    if (inst.op == Op::Phi) {
+                        // written by moves at the end of every predecessor, which may come before the phi
+                        for (BlockId pred : mGraph.blocks[block].preds) {
+                            starts[value] = std::min(starts[value], mBlockTo[pred]);
+                            extend(value, mBlockTo[pred] + 1);
+                        }
+
+                        continue;
+                    }
+
+                    for (ValueId operand : inst.operands) {
+                        if (isAllocated(operand)) extend(operand, mPositions[value]);
+                    }
+                }
+            }
+
+            for (ValueId value = 0; value < mGraph.insts.size(); value++) {
+                if (mGraph.insts[value].block == None) continue;
+
+                if (mGraph.insts[value].op == Op::Const) {
+                    mAllocation.locations[value].kind = Location::Kind::Constant;
+                    continue;
+                }
+
+                if (starts[value] == None) continue;
+
+                mIntervals.push_back({ value, starts[value], ends[value], crossesCall(starts[value], ends[value]) });
+            }
+
+            std::sort(mIntervals.begin(), mIntervals.end(), [](const Interval& a, const Interval& b) {
+                return a.start < b.start || (a.start == b.start && a.value < b.value);
+            });
+        }
+
+        static bool IsCalleeSaved(Reg reg) {
+            return std::find(std::begin(CalleeSavedRegisters), std::end(CalleeSavedRegisters), reg) != std::end(CalleeSavedRegisters);
+        }
+
+        void spill(ValueId value) {
+            mAllocation.locations[value] = { Location::Kind::Stack, Reg::RAX, mAllocation.spillSlots++ };
+        }
+
+        void scan() {
+            std::vector<Reg> freeCalleeSaved(std::begin(CalleeSavedRegisters), std::end(CalleeSavedRegisters));
+            std::vector<Reg> freeCallerSaved(std::begin(CallerSavedRegisters), std::end(CallerSavedRegisters));
+            std::vector<const Interval*> active; // holding a register
+
+            auto release = [&](Reg reg) {
+                (IsCalleeSaved(reg) ? freeCalleeSaved : freeCallerSaved).push_back(reg);
+            };
+
+            for (const Interval& interval : mIntervals) {
+                std::erase_if(active, [&](const Interval* other) {
+                    if (other->end >= interval.start) return false;
+
+                    release(mAllocation.locations[other->value].reg);
+                    return true;
+                });
+
+                std::vector<Reg>* pool = nullptr;
+                if (!interval.crossesCall && !freeCallerSaved.empty()) pool = &freeCallerSaved;
+                else if (!freeCalleeSaved.empty()) pool = &freeCalleeSaved;
+
+                if (pool != nullptr) {
+                    mAllocation.locations[interval.value] = { Location::Kind::Register, pool->back(), 0 };
+                    pool->pop_back();
+                    active.push_back(&interval);
+                    continue;
+                }
+
+                // out of registers. whichever usable interval ends last goes to the stack
+                const Interval* victim = nullptr;
+                for (const Interval* other : active) {
+                    if (interval.crossesCall && !IsCalleeSaved(mAllocation.locations[other->value].reg)) continue;
+                    if (victim == nullptr || other->end > victim->end) victim = other;
+                }
+
+                if (victim == nullptr || victim->end <= interval.end) {
+                    spill(interval.value);
+                    continue;
+                }
+
+                mAllocation.locations[interval.value] = mAllocation.locations[victim->value];
+                spill(victim->value);
+
+                std::erase(active, victim);
+                active.push_back(&interval);
+            }
+        }
+    };
+
+    Allocation AllocateRegisters(Graph& graph) {
+        return RegisterAllocator(graph).run();
+    }
+}
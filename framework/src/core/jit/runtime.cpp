@@ -0,0 +1,67 @@
+// Copyright 2025 JesusTouchMe
+
+#include "BibbleVM/core/jit/runtime.h"
+
+#include "BibbleVM/core/vm.h"
+
+namespace bibble {
+    // Callees with native code of their own are entered right from here, like run would, without nesting an execute.
+    // Interpreted and host ones still go through CallNested, and so does everything once there's too little native stack
+    // left for compiled code, which the execute it nests then interprets
+    static DispatchErr CallTarget(VM& vm, ExecState& state, const CallableTarget& target, u16 argc) {
+        if (target.native == nullptr) return CallNested(vm, state, target, argc);
+
+        Interpreter& interpreter = vm.interpreter();
+
+        const DecodedFunction* function = interpreter.decode(vm, target);
+        if (function == nullptr) {
+            vm.exit(-1);
+            return DISPATCH_ERROR;
+        }
+
+        interpreter.countCall(vm, target, *function, argc);
+        if (target.native == nullptr || !interpreter.canEnterCompiled()) return CallNested(vm, state, target, argc);
+
+        return CallCompiled(vm, state, target, *function, argc);
+    }
+
+    DispatchErr CompiledCall(VM* vm, ExecState* state, const Instruction* inst) {
+        const CallableTarget* target = ResolveCallTarget(*vm, *inst);
+        if (target == nullptr) {
+            vm->exit(-2);
+            return DISPATCH_ERROR;
+        }
+
+        return CallTarget(*vm, *state, *target, inst->b);
+    }
+
+    DispatchErr CompiledCallDynamic(VM* vm, ExecState* state, const Instruction* inst) {
+        const CallableTarget* target = vm->currentModule()->data().getCallable(static_cast<u32>(state->acc.integer()), *vm);
+        if (target == nullptr) {
+            vm->exit(-2);
+            return DISPATCH_ERROR;
+        }
+
+        return CallTarget(*vm, *state, *target, inst->b);
+    }
+
+    DispatchErr CompiledTrap(VM* vm, ExecState* state, u32 trapCode) {
+        SpillState(*vm, *state);
+
+        if (!vm->trap(static_cast<u8>(trapCode))) {
+            vm->exit(-2);
+            return DISPATCH_ERROR;
+        }
+
+        ReloadState(*vm, *state);
+        return DISPATCH_SUCCESS;
+    }
+
+    void CompiledExit(VM* vm, i64 code) {
+        vm->exit(static_cast<int>(code));
+    }
+
+    DispatchErr CompiledLoopHot(VM* vm, ExecState* state, const Instruction* branch) {
+        return vm->interpreter().enterOptimizedLoop(*vm, *state, *branch);
+    }
+}
@@ -0,0 +1,403 @@
+// Copyright 2025 JesusTouchMe
+
+#include "BibbleVM/core/jit/x64_assembler.h"
+
+#include <cassert>
+#include <limits>
+
+namespace bibble::x64 {
+    static constexpr size_t Unbound = std::numeric_limits<size_t>::max();
+
+    static constexpr u8 Code(Reg reg) {
+        return static_cast<u8>(reg);
+    }
+
+    static constexpr u8 Code(Xmm reg) {
+        return static_cast<u8>(reg);
+    }
+
+    static constexpr bool FitsI8(i64 value) {
+        return value >= std::numeric_limits<i8>::min() && value <= std::numeric_limits<i8>::max();
+    }
+
+    static constexpr bool FitsI32(i64 value) {
+        return value >= std::numeric_limits<i32>::min() && value <= std::numeric_limits<i32>::max();
+    }
+
+    size_t Assembler::getPosition() const {
+        return mBytes.size();
+    }
+
+    Assembler::Label Assembler::newLabel() {
+        mLabels.push_back(Unbound);
+        return { mLabels.size() - 1 };
+    }
+
+    void Assembler::bind(Label label) {
+        mLabels[label.id] = mBytes.size();
+    }
+
+    size_t Assembler::getPosition(Label label) const {
+        assert(mLabels[label.id] != Unbound);
+        return mLabels[label.id];
+    }
+
+    void Assembler::mov(Reg dst, Reg src) {
+        rex(true, Code(src), Code(dst));
+        byte(0x89);
+        modrm(Code(src), dst);
+    }
+
+    void Assembler::mov(Reg dst, Mem src) {
+        rex(true, Code(dst), Code(src.base));
+        byte(0x8B);
+        modrm(Code(dst), src);
+    }
+
+    void Assembler::mov(Mem dst, Reg src) {
+        rex(true, Code(src), Code(dst.base));
+        byte(0x89);
+        modrm(Code(src), dst);
+    }
+
+    void Assembler::mov(Reg dst, i64 imm) {
+        if (imm >= 0 && imm <= std::numeric_limits<u32>::max()) { // 32-bit moves zero the upper half
+            rex(false, 0, Code(dst));
+            byte(0xB8 + (Code(dst) & 7));
+            dword(static_cast<u32>(imm));
+        } else if (FitsI32(imm)) {
+            rex(true, 0, Code(dst));
+            byte(0xC7);
+            modrm(0, dst);
+            dword(static_cast<u32>(imm));
+        } else {
+            rex(true, 0, Code(dst));
+            byte(0xB8 + (Code(dst) & 7));
+            qword(static_cast<u64>(imm));
+        }
+    }
+
+    void Assembler::alu(AluOp op, Reg dst, Reg src) {
+        rex(true, Code(src), Code(dst));
+        byte((static_cast<u8>(op) << 3) | 0x01);
+        modrm(Code(src), dst);
+    }
+
+    void Assembler::alu(AluOp op, Reg dst, Mem src) {
+        rex(true, Code(dst), Code(src.base));
+        byte((static_cast<u8>(op) << 3) | 0x03);
+        modrm(Code(dst), src);
+    }
+
+    void Assembler::alu(AluOp op, Reg dst, i32 imm) {
+        rex(true, 0, Code(dst));
+
+        if (FitsI8(imm)) {
+            byte(0x83);
+            modrm(static_cast<u8>(op), dst);
+            byte(static_cast<u8>(imm));
+        } else {
+            byte(0x81);
+            modrm(static_cast<u8>(op), dst);
+            dword(static_cast<u32>(imm));
+        }
+    }
+
+    void Assembler::alu32(AluOp op, Mem dst, i32 imm) {
+        rex(false, 0, Code(dst.base));
+
+        if (FitsI8(imm)) {
+            byte(0x83);
+            modrm(static_cast<u8>(op), dst);
+            byte(static_cast<u8>(imm));
+        } else {
+            byte(0x81);
+            modrm(static_cast<u8>(op), dst);
+            dword(static_cast<u32>(imm));
+        }
+    }
+
+    void Assembler::imul(Reg dst, Reg src) {
+        rex(true, Code(dst), Code(src));
+        byte(0x0F);
+        byte(0xAF);
+        modrm(Code(dst), src);
+    }
+
+    void Assembler::imul(Reg dst, Mem src) {
+        rex(true, Code(dst), Code(src.base));
+        byte(0x0F);
+        byte(0xAF);
+        modrm(Code(dst), src);
+    }
+
+    void Assembler::cqo() {
+        byte(0x48);
+        byte(0x99);
+    }
+
+    void Assembler::idiv(Reg src) {
+        rex(true, 0, Code(src));
+        byte(0xF7);
+        modrm(7, src);
+    }
+
+    void Assembler::neg(Reg reg) {
+        rex(true, 0, Code(reg));
+        byte(0xF7);
+        modrm(3, reg);
+    }
+
+    void Assembler::neg(Mem mem) {
+        rex(true, 0, Code(mem.base));
+        byte(0xF7);
+        modrm(3, mem);
+    }
+
+    void Assembler::not_(Reg reg) {
+        rex(true, 0, Code(reg));
+        byte(0xF7);
+        modrm(2, reg);
+    }
+
+    void Assembler::not_(Mem mem) {
+        rex(true, 0, Code(mem.base));
+        byte(0xF7);
+        modrm(2, mem);
+    }
+
+    void Assembler::shlCl(Reg reg) {
+        rex(true, 0, Code(reg));
+        byte(0xD3);
+        modrm(4, reg);
+    }
+
+    void Assembler::sarCl(Reg reg) {
+        rex(true, 0, Code(reg));
+        byte(0xD3);
+        modrm(7, reg);
+    }
+
+    void Assembler::test(Reg a, Reg b) {
+        rex(true, Code(b), Code(a));
+        byte(0x85);
+        modrm(Code(b), a);
+    }
+
+    void Assembler::setcc(Cond cond, Reg dst) {
+        assert(Code(dst) < 4); // anything else needs a REX prefix to not mean AH..BH
+        byte(0x0F);
+        byte(0x90 + static_cast<u8>(cond));
+        modrm(0, dst);
+    }
+
+    void Assembler::movzxByte(Reg dst, Reg src) {
+        assert(Code(src) < 4);
+        rex(false, Code(dst), Code(src));
+        byte(0x0F);
+        byte(0xB6);
+        modrm(Code(dst), src);
+    }
+
+    void Assembler::andByte(Reg dst, Reg src) {
+        assert(Code(dst) < 4 && Code(src) < 4);
+        byte(0x20);
+        modrm(Code(src), dst);
+    }
+
+    void Assembler::orByte(Reg dst, Reg src) {
+        assert(Code(dst) < 4 && Code(src) < 4);
+        byte(0x08);
+        modrm(Code(src), dst);
+    }
+
+    void Assembler::movq(Xmm dst, Reg src) {
+        byte(0x66);
+        rex(true, Code(dst), Code(src));
+        byte(0x0F);
+        byte(0x6E);
+        modrm(Code(dst), src);
+    }
+
+    void Assembler::movq(Reg dst, Xmm src) {
+        byte(0x66);
+        rex(true, Code(src), Code(dst));
+        byte(0x0F);
+        byte(0x7E);
+        modrm(Code(src), dst);
+    }
+
+    void Assembler::movsd(Xmm dst, Mem src) {
+        byte(0xF2);
+        rex(false, Code(dst), Code(src.base));
+        byte(0x0F);
+        byte(0x10);
+        modrm(Code(dst), src);
+    }
+
+    void Assembler::movsd(Mem dst, Xmm src) {
+        byte(0xF2);
+        rex(false, Code(src), Code(dst.base));
+        byte(0x0F);
+        byte(0x11);
+        modrm(Code(src), dst);
+    }
+
+    void Assembler::sse(SseOp op, Xmm dst, Xmm src) {
+        byte(0xF2);
+        rex(false, Code(dst), Code(src));
+        byte(0x0F);
+        byte(static_cast<u8>(op));
+        modrm(Code(dst), static_cast<Reg>(Code(src)));
+    }
+
+    void Assembler::ucomisd(Xmm a, Xmm b) {
+        byte(0x66);
+        rex(false, Code(a), Code(b));
+        byte(0x0F);
+        byte(0x2E);
+        modrm(Code(a), static_cast<Reg>(Code(b)));
+    }
+
+    void Assembler::xorpd(Xmm dst, Xmm src) {
+        byte(0x66);
+        rex(false, Code(dst), Code(src));
+        byte(0x0F);
+        byte(0x57);
+        modrm(Code(dst), static_cast<Reg>(Code(src)));
+    }
+
+    void Assembler::compareSd(Cond cond) {
+        switch (cond) {
+            case Cond::G: // ucomisd sets CF and ZF like an unsigned compare, and all of ZF, PF and CF if unordered
+                ucomisd(Xmm::XMM0, Xmm::XMM1);
+                setcc(Cond::A, Reg::RAX);
+                break;
+            case Cond::GE:
+                ucomisd(Xmm::XMM0, Xmm::XMM1);
+                setcc(Cond::AE, Reg::RAX);
+                break;
+            case Cond::L:
+                ucomisd(Xmm::XMM1, Xmm::XMM0);
+                setcc(Cond::A, Reg::RAX);
+                break;
+            case Cond::LE:
+                ucomisd(Xmm::XMM1, Xmm::XMM0);
+                setcc(Cond::AE, Reg::RAX);
+                break;
+            case Cond::E:
+                ucomisd(Xmm::XMM0, Xmm::XMM1);
+                setcc(Cond::E, Reg::RAX);
+                setcc(Cond::NP, Reg::RCX);
+                andByte(Reg::RAX, Reg::RCX);
+                break;
+            default: // NE
+                ucomisd(Xmm::XMM0, Xmm::XMM1);
+                setcc(Cond::NE, Reg::RAX);
+                setcc(Cond::P, Reg::RCX);
+                orByte(Reg::RAX, Reg::RCX);
+                break;
+        }
+
+        movzxByte(Reg::RAX, Reg::RAX);
+    }
+
+    void Assembler::push(Reg reg) {
+        rex(false, 0, Code(reg));
+        byte(0x50 + (Code(reg) & 7));
+    }
+
+    void Assembler::pop(Reg reg) {
+        rex(false, 0, Code(reg));
+        byte(0x58 + (Code(reg) & 7));
+    }
+
+    void Assembler::call(Reg target) {
+        rex(false, 0, Code(target));
+        byte(0xFF);
+        modrm(2, target);
+    }
+
+    void Assembler::ret() {
+        byte(0xC3);
+    }
+
+    void Assembler::jmp(Label target) {
+        byte(0xE9);
+        jump(target);
+    }
+
+    void Assembler::jmp(Reg target) {
+        rex(false, 0, Code(target));
+        byte(0xFF);
+        modrm(4, target);
+    }
+
+    void Assembler::jcc(Cond cond, Label target) {
+        byte(0x0F);
+        byte(0x80 + static_cast<u8>(cond));
+        jump(target);
+    }
+
+    std::vector<u8> Assembler::finish() {
+        for (const Fixup& fixup : mFixups) {
+            size_t target = mLabels[fixup.label];
+            assert(target != Unbound);
+
+            i32 displacement = static_cast<i32>(static_cast<i64>(target) - static_cast<i64>(fixup.rel32 + 4));
+            u32 bits = static_cast<u32>(displacement);
+
+            for (size_t i = 0; i < 4; i++) {
+                mBytes[fixup.rel32 + i] = static_cast<u8>(bits >> (i * 8));
+            }
+        }
+
+        mFixups.clear();
+        return std::move(mBytes);
+    }
+
+    void Assembler::byte(u8 value) {
+        mBytes.push_back(value);
+    }
+
+    void Assembler::dword(u32 value) {
+        for (size_t i = 0; i < 4; i++) {
+            byte(static_cast<u8>(value >> (i * 8)));
+        }
+    }
+
+    void Assembler::qword(u64 value) {
+        for (size_t i = 0; i < 8; i++) {
+            byte(static_cast<u8>(value >> (i * 8)));
+        }
+    }
+
+    void Assembler::rex(bool w, u8 reg, u8 rm) {
+        u8 prefix = 0x40 | (w ? 0x08 : 0) | ((reg >> 3) << 2) | (rm >> 3);
+        if (prefix != 0x40) byte(prefix);
+    }
+
+    void Assembler::modrm(u8 reg, Reg rm) {
+        byte(0xC0 | ((reg & 7) << 3) | (Code(rm) & 7));
+    }
+
+    void Assembler::modrm(u8 reg, Mem rm) {
+        u8 base = Code(rm.base) & 7;
+
+        u8 mod;
+        if (rm.disp == 0 && base != 5) mod = 0; // RBP and R13 have no displacement-less form
+        else if (FitsI8(rm.disp)) mod = 1;
+        else mod = 2;
+
+        byte((mod << 6) | ((reg & 7) << 3) | base);
+        if (base == 4) byte(0x24); // RSP and R12 need a SIB byte
+
+        if (mod == 1) byte(static_cast<u8>(rm.disp));
+        else if (mod == 2) dword(static_cast<u32>(rm.disp));
+    }
+
+    void Assembler::jump(Label target) {
+        mFixups.push_back({ mBytes.size(), target.id });
+        dword(0);
+    }
+}
@@ -0,0 +1,133 @@
+// Copyright 2025 JesusTouchMe
+
+#include "BibbleVM/core/module/bbx_image.h"
+
+#include <string>
+#include <utility>
+
+#if defined(PLATFORM_LINUX) || defined(PLATFORM_MACOS)
+#define BIBBLEVM_MAP_FILES 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#define BIBBLEVM_MAP_FILES 0
+#endif
+
+namespace bibble {
+    BbxImage::BbxImage(BbxImage&& other) noexcept
+        : mFile(std::exchange(other.mFile, nullptr))
+        , mFileSize(std::exchange(other.mFileSize, 0))
+        , mOffset(std::exchange(other.mOffset, 0))
+        , mLead(std::exchange(other.mLead, 0))
+        , mPrivate(std::exchange(other.mPrivate, nullptr))
+        , mPrivateSize(std::exchange(other.mPrivateSize, 0))
+        , mDescriptor(std::exchange(other.mDescriptor, -1)) {}
+
+    BbxImage& BbxImage::operator=(BbxImage&& other) noexcept {
+        if (this != &other) {
+            BbxImage old(std::move(*this));
+            mFile = std::exchange(other.mFile, nullptr);
+            mFileSize = std::exchange(other.mFileSize, 0);
+            mOffset = std::exchange(other.mOffset, 0);
+            mLead = std::exchange(other.mLead, 0);
+            mPrivate = std::exchange(other.mPrivate, nullptr);
+            mPrivateSize = std::exchange(other.mPrivateSize, 0);
+            mDescriptor = std::exchange(other.mDescriptor, -1);
+        }
+
+        return *this;
+    }
+
+    BbxImage::~BbxImage() {
+#if BIBBLEVM_MAP_FILES
+        if (mFile != nullptr) munmap(mFile, mFileSize);
+        if (mPrivate != nullptr) munmap(mPrivate, mPrivateSize);
+        if (mDescriptor >= 0) close(mDescriptor);
+#endif
+    }
+
+    std::optional<BbxImage> BbxImage::Map(std::string_view path) {
+        return MapRange(path, 0, std::nullopt);
+    }
+
+    std::optional<BbxImage> BbxImage::Map(std::string_view path, size_t offset, size_t size) {
+        return MapRange(path, offset, size);
+    }
+
+    std::span<u8> BbxImage::file() const {
+        if (mFile == nullptr) return {};
+        return { static_cast<u8*>(mFile) + mLead, mFileSize - mLead };
+    }
+
+    std::span<u8> BbxImage::privateBytes(size_t offset, size_t size) {
+#if BIBBLEVM_MAP_FILES
+        if (mDescriptor < 0) return {};
+
+        void* bytes = MAP_FAILED;
+        bool inFile = size != 0 && offset <= file().size() && size <= file().size() - offset;
+
+        // mappings start on a page, so this starts at the one the bytes are in
+        size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        size_t fileOffset = mOffset + offset;
+        size_t start = fileOffset / pageSize * pageSize;
+        size_t mappedSize = fileOffset - start + size;
+
+        if (inFile) {
+            bytes = mmap(nullptr, mappedSize, PROT_READ | PROT_WRITE, MAP_PRIVATE, mDescriptor, static_cast<off_t>(start));
+        }
+
+        // nothing else will be mapped from it
+        close(mDescriptor);
+        mDescriptor = -1;
+
+        if (bytes == MAP_FAILED) return {};
+
+        mPrivate = bytes;
+        mPrivateSize = mappedSize;
+
+        return { static_cast<u8*>(bytes) + (fileOffset - start), size };
+#else
+        (void) offset;
+        (void) size;
+        return {};
+#endif
+    }
+
+    std::optional<BbxImage> BbxImage::MapRange(std::string_view path, size_t offset, std::optional<size_t> size) {
+#if BIBBLEVM_MAP_FILES
+        BbxImage image;
+
+        image.mDescriptor = open(std::string(path).c_str(), O_RDONLY | O_CLOEXEC);
+        if (image.mDescriptor < 0) return std::nullopt;
+
+        struct stat info;
+        if (fstat(image.mDescriptor, &info) != 0 || info.st_size <= 0) return std::nullopt;
+
+        size_t fileSize = static_cast<size_t>(info.st_size);
+        if (offset >= fileSize) return std::nullopt;
+
+        size_t mapped = size.value_or(fileSize - offset);
+        if (mapped == 0 || mapped > fileSize - offset) return std::nullopt;
+
+        size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        size_t start = offset / pageSize * pageSize;
+
+        void* file = mmap(nullptr, offset - start + mapped, PROT_READ, MAP_SHARED, image.mDescriptor, static_cast<off_t>(start));
+        if (file == MAP_FAILED) return std::nullopt;
+
+        image.mFile = file;
+        image.mFileSize = offset - start + mapped;
+        image.mOffset = offset;
+        image.mLead = offset - start;
+
+        return image;
+#else
+        (void) path;
+        (void) offset;
+        (void) size;
+        return std::nullopt;
+#endif
+    }
+}
@@ -0,0 +1,163 @@
+// Copyright 2025 JesusTouchMe
+
+#include "BibbleVM/core/module/bbx_loader.h"
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+namespace bibble {
+    static constexpr u8 BbxMagic[4] = { 'B', 'B', 'X', 0x00 };
+    static constexpr size_t BbxHeaderSize = 8; // magic, version, section count
+    static constexpr size_t BbxSectionHeaderSize = 16; // kind, offset, size, reserved
+
+    struct BbxRange {
+        size_t offset = 0;
+        size_t size = 0;
+    };
+
+    // Where the sections are in the file. Missing ones are empty
+    struct BbxLayout {
+        BbxRange data;
+        BbxRange strtab;
+        BbxRange code;
+        BbxRange link;
+    };
+
+    static std::optional<BbxLayout> ParseBbx(std::span<u8> file) {
+        if (file.size() < BbxHeaderSize || std::memcmp(file.data(), BbxMagic, sizeof(BbxMagic)) != 0) return std::nullopt;
+
+        Section header(file);
+
+        std::optional<u16> version = header.getU16(4);
+        std::optional<u16> sectionCount = header.getU16(6);
+        if (!version.has_value() || version.value() != BbxVersion || !sectionCount.has_value()) return std::nullopt;
+
+        if (BbxHeaderSize + sectionCount.value() * BbxSectionHeaderSize > file.size()) return std::nullopt;
+
+        BbxLayout layout;
+        bool seen[4] = { false, false, false, false };
+
+        for (size_t i = 0; i < sectionCount.value(); i++) {
+            size_t entry = BbxHeaderSize + i * BbxSectionHeaderSize;
+
+            u32 kind = header.getU32(entry).value();
+            u32 offset = header.getU32(entry + 4).value();
+            u32 size = header.getU32(entry + 8).value();
+
+            if (offset > file.size() || size > file.size() - offset) return std::nullopt;
+
+            BbxRange* range;
+            switch (static_cast<BbxSectionKind>(kind)) {
+                case BbxSectionKind::DATA: range = &layout.data; break;
+                case BbxSectionKind::STRTAB: range = &layout.strtab; break;
+                case BbxSectionKind::CODE: range = &layout.code; break;
+                case BbxSectionKind::LINK: range = &layout.link; break;
+                default: continue; // for newer versions of the VM
+            }
+
+            if (seen[kind - 1]) return std::nullopt;
+            seen[kind - 1] = true;
+
+            *range = { offset, size };
+        }
+
+        return layout;
+    }
+
+    static Section SectionAt(std::span<u8> file, const BbxRange& range) {
+        return Section(file.subspan(range.offset, range.size));
+    }
+
+    static std::unique_ptr<Module> LoadBbxCopy(std::unique_ptr<u8[]> bytes, size_t size) {
+        std::span<u8> file(bytes.get(), size);
+
+        std::optional<BbxLayout> layout = ParseBbx(file);
+        if (!layout.has_value()) return nullptr;
+
+        try {
+            return std::make_unique<Module>(std::move(bytes), DataSection(SectionAt(file, layout->data)),
+                StrtabSection(SectionAt(file, layout->strtab)), CodeSection(SectionAt(file, layout->code)),
+                LinkSection(SectionAt(file, layout->link)));
+        } catch (...) {
+            return nullptr;
+        }
+    }
+
+    // to the end of the file without size
+    static std::unique_ptr<Module> ReadBbxFile(std::string_view path, size_t offset, std::optional<size_t> size) {
+        std::FILE* file = std::fopen(std::string(path).c_str(), "rb");
+        if (file == nullptr) return nullptr;
+
+        std::unique_ptr<u8[]> bytes;
+        long fileSize = -1;
+
+        if (std::fseek(file, 0, SEEK_END) == 0) fileSize = std::ftell(file);
+        if (fileSize > 0 && offset < static_cast<size_t>(fileSize)) {
+            size = size.value_or(static_cast<size_t>(fileSize) - offset);
+        } else {
+            size = std::nullopt;
+        }
+
+        bool inFile = size.has_value() && size.value() != 0 && size.value() <= static_cast<size_t>(fileSize) - offset;
+        if (inFile && std::fseek(file, static_cast<long>(offset), SEEK_SET) == 0) {
+            try {
+                bytes = std::make_unique_for_overwrite<u8[]>(size.value());
+            } catch (...) {}
+        }
+
+        bool read = bytes != nullptr && std::fread(bytes.get(), 1, size.value(), file) == size.value();
+        std::fclose(file);
+
+        if (!read) return nullptr;
+        return LoadBbxCopy(std::move(bytes), size.value());
+    }
+
+    static std::unique_ptr<Module> LoadMapped(BbxImage image) {
+        std::span<u8> file = image.file();
+
+        std::optional<BbxLayout> layout = ParseBbx(file);
+        if (!layout.has_value()) return nullptr;
+
+        // linking writes resolved call entries back, so it can't stay on the shared read-only pages
+        std::span<u8> data = image.privateBytes(layout->data.offset, layout->data.size);
+        if (data.size() != layout->data.size) return nullptr;
+
+        try {
+            return std::make_unique<Module>(std::move(image), DataSection(Section(data)),
+                StrtabSection(SectionAt(file, layout->strtab)), CodeSection(SectionAt(file, layout->code)),
+                LinkSection(SectionAt(file, layout->link)));
+        } catch (...) {
+            return nullptr;
+        }
+    }
+
+    std::unique_ptr<Module> LoadBbxFile(std::string_view path) {
+        std::optional<BbxImage> image = BbxImage::Map(path);
+        if (!image.has_value()) return ReadBbxFile(path, 0, std::nullopt);
+
+        return LoadMapped(std::move(image.value()));
+    }
+
+    std::unique_ptr<Module> LoadBbxFile(std::string_view path, size_t offset, size_t size) {
+        std::optional<BbxImage> image = BbxImage::Map(path, offset, size);
+        if (!image.has_value()) return ReadBbxFile(path, offset, size);
+
+        return LoadMapped(std::move(image.value()));
+    }
+
+    std::unique_ptr<Module> LoadBbx(std::span<const u8> bytes) {
+        if (bytes.empty()) return nullptr;
+
+        std::unique_ptr<u8[]> copy;
+        try {
+            copy = std::make_unique_for_overwrite<u8[]>(bytes.size());
+        } catch (...) {
+            return nullptr;
+        }
+
+        std::memcpy(copy.get(), bytes.data(), bytes.size());
+
+        return LoadBbxCopy(std::move(copy), bytes.size());
+    }
+}
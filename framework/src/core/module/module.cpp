@@ -3,12 +3,19 @@
 #include "BibbleVM/core/module/module.h"
 
 namespace bibble {
-    Module::Module(std::unique_ptr<u8[]> bytecode, DataSection dataSection, StrtabSection strtabSection, CodeSection codeSection)
+    Module::Module(std::unique_ptr<u8[]> bytecode, DataSection dataSection, StrtabSection strtabSection, CodeSection codeSection, LinkSection linkSection)
         : mBytecode(std::move(bytecode))
         , mDataSection(std::move(dataSection))
         , mStrtabSection(std::move(strtabSection))
-        , mCodeSection(std::move(codeSection)) {}
+        , mCodeSection(std::move(codeSection))
+        , mLinkSection(std::move(linkSection)) {}
 
+    Module::Module(BbxImage image, DataSection dataSection, StrtabSection strtabSection, CodeSection codeSection, LinkSection linkSection)
+        : mImage(std::move(image))
+        , mDataSection(std::move(dataSection))
+        , mStrtabSection(std::move(strtabSection))
+        , mCodeSection(std::move(codeSection))
+        , mLinkSection(std::move(linkSection)) {}
 
     DataSection& Module::data() {
         return mDataSection;
@@ -21,4 +28,31 @@ namespace bibble {
     const CodeSection& Module::code() const {
         return mCodeSection;
     }
+
+    const LinkSection& Module::links() const {
+        return mLinkSection;
+    }
+
+    const DecodedFunction* Module::getDecodedFunction(size_t entry) const {
+        auto it = mDecodedFunctions.find(entry);
+        if (it == mDecodedFunctions.end()) return nullptr;
+
+        return it->second.get();
+    }
+
+    const DecodedFunction* Module::addDecodedFunction(DecodedFunction function) {
+        size_t entry = function.entry;
+        auto& slot = mDecodedFunctions[entry];
+        slot = std::make_unique<DecodedFunction>(std::move(function));
+
+        return slot.get();
+    }
+
+    const DecodedFunction* Module::findDecodedFunction(const Instruction* code) const {
+        for (const auto& [entry, function] : mDecodedFunctions) {
+            if (function->instructions.data() == code || function->registers.instructions.data() == code) return function.get();
+        }
+
+        return nullptr;
+    }
 }
@@ -2,10 +2,116 @@
 
 #include "BibbleVM/core/stack/stack.h"
 
+#include "BibbleVM/util/scoped_value.h"
+
+#if BIBBLEVM_STACK_GUARD
+#include <csetjmp>
+#include <csignal>
+#include <mutex>
+
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
 namespace bibble {
+    // a frame used to cost at least one slot for its saved base, so this keeps the same worst case depth for much less memory
+    static constexpr i64 SlotsPerFrame = 4;
+
+#if BIBBLEVM_STACK_GUARD
+    // How far past either end one unchecked instruction can reach: an i16 local index from a frame at the end, or a
+    // RESERVE of up to 255 slots
+    static constexpr size_t GuardSlots = 32768 + 256;
+
+    // A runGuarded in progress on this thread. They nest when a host function calls into another VM
+    struct GuardScope {
+        const u8* begin; // the whole mapping of the stack, guard pages included
+        const u8* end;
+        sigjmp_buf resume;
+        GuardScope* previous;
+    };
+
+    static thread_local GuardScope* tGuardScope = nullptr;
+
+    static struct sigaction sPreviousSegv;
+    static struct sigaction sPreviousBus;
+
+    static void HandleFault(int signal, siginfo_t* info, void* context) {
+        const u8* address = static_cast<const u8*>(info->si_addr);
+
+        for (GuardScope* scope = tGuardScope; scope != nullptr; scope = scope->previous) {
+            if (address >= scope->begin && address < scope->end) {
+                tGuardScope = scope->previous;
+                siglongjmp(scope->resume, 1);
+            }
+        }
+
+        // not ours, so whoever had the signal before gets it. For most programs that's crashing like usual
+        struct sigaction& previous = signal == SIGBUS ? sPreviousBus : sPreviousSegv;
+        if (previous.sa_flags & SA_SIGINFO) {
+            previous.sa_sigaction(signal, info, context);
+        } else if (previous.sa_handler == SIG_DFL || previous.sa_handler == SIG_IGN) {
+            std::signal(signal, SIG_DFL); // the faulting instruction runs again and gets the default action
+        } else {
+            previous.sa_handler(signal);
+        }
+    }
+
+    static void InstallFaultHandler() {
+        static std::once_flag installed;
+        std::call_once(installed, [] {
+            struct sigaction action = {};
+            action.sa_sigaction = HandleFault;
+            action.sa_flags = SA_SIGINFO | SA_ONSTACK | SA_NODEFER; // NODEFER as it's left with siglongjmp, which keeps the mask
+            sigemptyset(&action.sa_mask);
+
+            sigaction(SIGSEGV, &action, &sPreviousSegv);
+            sigaction(SIGBUS, &action, &sPreviousBus); // what macOS raises for protected pages
+        });
+    }
+
+    static size_t RoundToPages(size_t size, size_t pageSize) {
+        return (size + pageSize - 1) / pageSize * pageSize;
+    }
+#endif
+
     Stack::Stack(u64 size)
-        : mMemory(std::make_unique<Value[]>(size))
-        , mCapacity(static_cast<i64>(size)) {} // realistically this wouldn't integer overflow
+        : mMemory(nullptr)
+        , mCapacity(static_cast<i64>(size)) // realistically this wouldn't integer overflow
+        , mFrames(new Frame[size / SlotsPerFrame + 1])
+        , mFrameCapacity(static_cast<i64>(size / SlotsPerFrame + 1)) {
+#if BIBBLEVM_STACK_GUARD
+        // PROT_NONE all over, then the slots opened up in the middle. Anonymous pages are committed zeroed on first touch
+        size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        size_t guardSize = RoundToPages(GuardSlots * sizeof(Value), pageSize);
+        size_t slotsSize = RoundToPages(size * sizeof(Value), pageSize);
+        size_t mappingSize = guardSize + slotsSize + guardSize;
+
+        void* mapping = mmap(nullptr, mappingSize, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        if (mapping != MAP_FAILED) {
+            u8* slots = static_cast<u8*>(mapping) + guardSize;
+
+            if (mprotect(slots, slotsSize, PROT_READ | PROT_WRITE) == 0) {
+                InstallFaultHandler();
+
+                mMapping = mapping;
+                mMappingSize = mappingSize;
+                mMemory = reinterpret_cast<Value*>(slots + slotsSize) - size; // ending right at the top guard page
+                return;
+            }
+
+            munmap(mapping, mappingSize);
+        }
+#endif
+
+        mHeapMemory = std::make_unique<Value[]>(size);
+        mMemory = mHeapMemory.get();
+    }
+
+    Stack::~Stack() {
+#if BIBBLEVM_STACK_GUARD
+        if (mMapping != nullptr) munmap(mMapping, mMappingSize);
+#endif
+    }
 
     i64 Stack::sb() const {
         return mStackBase;
@@ -15,31 +121,58 @@ namespace bibble {
         return mStackPointer;
     }
 
-    bool Stack::pushFrame(i64 minSize) {
-        if (mStackPointer.integer() + minSize > mCapacity) {
-            return false; // underflow
+    Value* Stack::data() {
+        return mMemory;
+    }
+
+    i64 Stack::capacity() const {
+        return mCapacity;
+    }
+
+    bool Stack::pushFrame(i64 minSize, const ReturnAddress& returnAddress) {
+        i64 base = mStackPointer.integer();
+        if (base < 0 || base + minSize > mCapacity || mFrameCount == mFrameCapacity) {
+            return false; // overflow
         }
 
-        mMemory[mStackPointer.integer()].integer() = mStackBase;
-        mStackBase = mStackPointer.integer();
-        mStackPointer.integer() += 1;
+        mFrames[mFrameCount++] = { mStackBase, returnAddress.pc, returnAddress.code, returnAddress.module };
+        mStackBase = base;
+
+        return true;
+    }
+
+    bool Stack::pushCallFrame(i64 argc, const ReturnAddress& returnAddress) {
+        i64 base = mStackPointer.integer() - argc;
+        if (base < mStackBase || mFrameCount == mFrameCapacity) {
+            return false; // the caller doesn't have argc values, or too deep
+        }
+
+        mFrames[mFrameCount++] = { mStackBase, returnAddress.pc, returnAddress.code, returnAddress.module };
+        mStackBase = base;
 
         return true;
     }
 
     bool Stack::popFrame() {
-        if (mStackBase < 0 ) {
+        if (mFrameCount == 0) {
             return false; // underflow
         }
 
         mStackPointer = mStackBase;
-        mStackBase = mMemory[mStackPointer.integer()].integer();
+        mStackBase = mFrames[--mFrameCount].savedBase;
 
         return true;
     }
 
+    ReturnAddress Stack::returnAddress() const {
+        if (mFrameCount == 0) return {};
+
+        const Frame& frame = mFrames[mFrameCount - 1];
+        return { frame.returnPc, frame.returnCode, frame.returnModule };
+    }
+
     bool Stack::isWithinBounds(i64 index) const {
-        return index > mStackBase && index < mCapacity;
+        return index >= mStackBase && index < mCapacity;
     }
 
     Value& Stack::operator[](size_t index) {
@@ -49,4 +182,25 @@ namespace bibble {
     const Value& Stack::operator[](size_t index) const {
         return mMemory[index];
     }
+
+    bool Stack::runGuarded(void (*function)(void*), void* context) {
+#if BIBBLEVM_STACK_GUARD
+        if (mMapping != nullptr) {
+            GuardScope scope;
+            scope.begin = static_cast<const u8*>(mMapping);
+            scope.end = scope.begin + mMappingSize;
+            scope.previous = tGuardScope;
+
+            if (sigsetjmp(scope.resume, 0) != 0) return false; // HandleFault already took the scope off
+
+            util::ScopedValue<GuardScope*> guarded(tGuardScope, &scope);
+            function(context);
+
+            return true;
+        }
+#endif
+
+        function(context);
+        return true;
+    }
 }
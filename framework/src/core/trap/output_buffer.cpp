@@ -0,0 +1,72 @@
+// Copyright 2025 JesusTouchMe
+
+#include "BibbleVM/core/trap/output_buffer.h"
+
+#include <charconv>
+#include <cstring>
+
+namespace bibble {
+    // longest std::to_chars output for a double in its shortest round-trip form, with room to spare
+    static constexpr size_t MaxNumberLength = 32;
+
+    OutputBuffer::OutputBuffer(std::FILE* sink)
+        : mSink(sink) {}
+
+    OutputBuffer::~OutputBuffer() {
+        flush();
+    }
+
+    void OutputBuffer::write(std::string_view text) {
+        if (text.size() > mBuffer.size() - mSize) {
+            flush();
+
+            // wouldn't fit even empty, so it goes straight through
+            if (text.size() > mBuffer.size()) {
+                if (mSink != nullptr) std::fwrite(text.data(), 1, text.size(), mSink);
+                return;
+            }
+        }
+
+        std::memcpy(mBuffer.data() + mSize, text.data(), text.size());
+        mSize += text.size();
+    }
+
+    void OutputBuffer::writeChar(char c) {
+        if (mSize == mBuffer.size()) flush();
+        mBuffer[mSize++] = c;
+    }
+
+    void OutputBuffer::writeInteger(i64 value) {
+        if (mBuffer.size() - mSize < MaxNumberLength) flush();
+
+        char* end = std::to_chars(mBuffer.data() + mSize, mBuffer.data() + mBuffer.size(), value).ptr;
+        mSize = end - mBuffer.data();
+    }
+
+    void OutputBuffer::writeFloat(double value) {
+        if (mBuffer.size() - mSize < MaxNumberLength) flush();
+
+        char* end = std::to_chars(mBuffer.data() + mSize, mBuffer.data() + mBuffer.size(), value).ptr;
+        mSize = end - mBuffer.data();
+    }
+
+    void OutputBuffer::flush() {
+        if (mSize == 0) return;
+
+        if (mSink != nullptr) {
+            std::fwrite(mBuffer.data(), 1, mSize, mSink);
+            std::fflush(mSink);
+        }
+
+        mSize = 0;
+    }
+
+    std::FILE* OutputBuffer::getSink() const {
+        return mSink;
+    }
+
+    void OutputBuffer::setSink(std::FILE* sink) {
+        flush();
+        mSink = sink;
+    }
+}
@@ -0,0 +1,82 @@
+// Copyright 2025 JesusTouchMe
+
+#include "BibbleVM/core/trap/trap_table.h"
+
+#include "BibbleVM/core/vm.h"
+
+#include <cstdio>
+
+namespace bibble {
+    static bool PrintIntegerTrap(VM& vm, u8) {
+        OutputBuffer& output = vm.output();
+        output.writeInteger(vm.acc().integer());
+        output.writeChar('\n');
+        return true;
+    }
+
+    static bool PrintFloatTrap(VM& vm, u8) {
+        OutputBuffer& output = vm.output();
+        output.writeFloat(vm.acc().floating());
+        output.writeChar('\n');
+        return true;
+    }
+
+    static bool PrintCharTrap(VM& vm, u8) {
+        vm.output().writeChar(static_cast<char>(vm.acc().integer()));
+        return true;
+    }
+
+    static bool FlushTrap(VM& vm, u8) {
+        vm.output().flush();
+        return true;
+    }
+
+    static bool ReadIntegerTrap(VM& vm, u8) {
+        vm.output().flush(); // anything printed before is a prompt for this
+
+        long long value;
+        if (std::scanf("%lld", &value) != 1) value = 0;
+
+        vm.acc() = Value(static_cast<i64>(value));
+        return true;
+    }
+
+    static TrapTable BuildDefaultTrapTable(bool sandbox) {
+        TrapTable table(sandbox ? RefuseTrap : IgnoreTrap);
+
+        table.set(static_cast<u8>(TrapCode::PRINT_INTEGER), PrintIntegerTrap);
+        table.set(static_cast<u8>(TrapCode::PRINT_FLOAT), PrintFloatTrap);
+        table.set(static_cast<u8>(TrapCode::PRINT_CHAR), PrintCharTrap);
+        table.set(static_cast<u8>(TrapCode::FLUSH), FlushTrap);
+        if (!sandbox) table.set(static_cast<u8>(TrapCode::READ_INTEGER), ReadIntegerTrap);
+
+        return table;
+    }
+
+    bool IgnoreTrap(VM&, u8) {
+        return true;
+    }
+
+    bool RefuseTrap(VM&, u8) {
+        return false;
+    }
+
+    TrapTable::TrapTable(TrapHandler unassigned) {
+        mHandlers.fill(unassigned);
+    }
+
+    TrapHandler TrapTable::get(u8 code) const {
+        return mHandlers[code];
+    }
+
+    void TrapTable::set(u8 code, TrapHandler handler) {
+        mHandlers[code] = handler;
+    }
+
+    const TrapTable& GetDefaultTrapTable(bool sandbox) {
+        static const TrapTable hostedTable = BuildDefaultTrapTable(false);
+        static const TrapTable sandboxTable = BuildDefaultTrapTable(true);
+
+        return sandbox ? sandboxTable : hostedTable;
+    }
+}
@@ -3,7 +3,6 @@
 #include "BibbleVM/core/vm.h"
 
 #include <algorithm>
-#include <iostream>
 
 namespace bibble {
     Module* VM::getModule(u32 index) const {
@@ -14,37 +13,86 @@ namespace bibble {
     }
 
     Function* VM::getFunction(std::string_view name) const {
+        return getFunction(name, util::HashSymbol(name));
+    }
+
+    Function* VM::getFunction(std::string_view name, u32 hash) const {
         if (mExited) return nullptr;
-        auto it = mFunctions.find(name);
-        if (it == mFunctions.end()) return nullptr;
-        return it->second.get();
+
+        u32 id = mSymbols.find(name, hash);
+        if (id == NoFunction) return nullptr;
+
+        return &mSymbols.get(id);
+    }
+
+    Function* VM::getFunction(u32 id) const {
+        if (mExited) return nullptr;
+        if (id >= mSymbols.size()) return nullptr;
+
+        return &mSymbols.get(id);
     }
 
     u32 VM::addModule(std::unique_ptr<Module> module) {
         if (mExited) return 0xFFFFFFFF;
 
+        u32 index;
+
         try {
             mModules.push_back(std::move(module));
-            return mModules.size() - 1;
+            index = mModules.size() - 1;
         } catch (...) {
             exit(1);
             return 0xFFFFFFFF;
         }
+
+        if (mConfig.eagerLink) linkModule(index);
+
+        return index;
     }
 
-    void VM::addFunction(std::unique_ptr<Function> function) {
-        if (mExited) return;
+    u32 VM::addFunction(u32 module, std::string_view name, CallableTarget target) {
+        if (mExited) return NoFunction;
 
-        if (mFunctions.contains(function->getName())) {
+        u32 id;
+
+        try {
+            id = mSymbols.add(Function(module, name, target), util::HashSymbol(name));
+        } catch (...) {
             exit(1);
-            return;
+            return NoFunction;
         }
 
+        if (id == NoFunction) exit(1);
+
+        return id;
+    }
+
+    bool VM::linkModule(u32 module) {
+        Module* linked = getModule(module);
+        if (linked == nullptr) return false;
+
+        const LinkSection& links = linked->links();
+        bool complete = true;
+
         try {
-            mFunctions.emplace(function->getName(), std::move(function));
+            linked->data().reserveCallables(links.getCount());
         } catch (...) {
             exit(1);
+            return false;
         }
+
+        for (size_t i = 0; i < links.getCount(); i++) {
+            std::optional<LinkEntry> entry = links.get(i);
+            if (!entry.has_value() || linked->data().link(entry->offset, *this, module, entry->nameHash) == nullptr) {
+                complete = false;
+            }
+        }
+
+        return complete;
+    }
+
+    void VM::addHostFunction(std::string_view name, HostFunction function) {
+        addFunction(HostModule, name, CallableTarget(function));
     }
 
     Module* VM::currentModule() {
@@ -73,6 +121,10 @@ namespace bibble {
         return mInterpreter;
     }
 
+    Heap& VM::heap() {
+        return mHeap;
+    }
+
     bool VM::push(Value value) {
         if (mExited) return false;
 
@@ -91,20 +143,41 @@ namespace bibble {
         return mStack[--sp().integer()];
     }
 
+    OutputBuffer& VM::output() {
+        return mOutput;
+    }
+
     bool VM::trap(u8 code) {
         if (mExited) return false;
 
-        if (code == 0) {
-            std::cout << acc().integer() << std::endl;
+        return mTraps->invoke(*this, code);
+    }
+
+    const TrapTable& VM::getTrapTable() const {
+        return *mTraps;
+    }
+
+    void VM::setTrapHandler(u8 code, TrapHandler handler) {
+        if (mOwnTraps == nullptr) {
+            try {
+                mOwnTraps = std::make_unique<TrapTable>(*mTraps);
+            } catch (...) {
+                exit(1);
+                return;
+            }
+
+            mTraps = mOwnTraps.get();
         }
 
-        return true;
+        mOwnTraps->set(code, handler);
     }
 
     void VM::exit(int code) {
         if (mExited) return;
         mExitCode = code;
         mExited = true;
+
+        mOutput.flush();
     }
 
     int VM::getExitCode() const {
@@ -118,7 +191,9 @@ namespace bibble {
     VM::VM(VMConfig config)
         : mConfig(config)
         , mStack(config.stackSize)
-        , mInterpreter(config) {}
+        , mInterpreter(config)
+        , mHeap(mStack, mAccumulator, config.nurserySize, config.gcPauseBudget)
+        , mTraps(config.traps != nullptr ? config.traps : &GetDefaultTrapTable(config.sandbox)) {}
 
     std::unique_ptr<VM> CreateVM(VMConfig config) {
         return std::unique_ptr<VM>(new VM(config));
@@ -0,0 +1,260 @@
+// Copyright 2025 JesusTouchMe
+
+#include "BibbleVM/core/module/bbx_loader.h"
+
+#include "BibbleVM/core/vm.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <string>
+
+namespace bibble {
+    // See spec/docs/vm-image.md
+    static constexpr u8 ImageMagic[4] = { 'B', 'B', 'I', 0x00 };
+    static constexpr u16 ImageVersion = 1;
+    static constexpr size_t ImageHeaderSize = 20; // magic, version, reserved, module count, function count, names size
+    static constexpr size_t ImageModuleSize = 8; // offset, size
+    static constexpr size_t ImageFunctionSize = 16; // module, entry, name offset, name size
+
+    static constexpr u8 BbxMagic[4] = { 'B', 'B', 'X', 0x00 };
+    static constexpr size_t BbxSectionCount = 4;
+    static constexpr size_t BbxHeadersSize = 8 + BbxSectionCount * 16;
+
+    static u64 ImageFunctionKey(u32 module, u64 entry) {
+        return static_cast<u64>(module) << 32 | entry;
+    }
+
+    static void Put(std::vector<u8>& bytes, u32 value, int size) {
+        for (int shift = (size - 1) * 8; shift >= 0; shift -= 8) bytes.push_back(static_cast<u8>(value >> shift));
+    }
+
+    // Unchecked, for the directory once it's all been read. a Section read costs more than the rest of loading a function
+    static u32 Get(const u8* bytes) {
+        return static_cast<u32>(bytes[0]) << 24 | static_cast<u32>(bytes[1]) << 16 | static_cast<u32>(bytes[2]) << 8 | bytes[3];
+    }
+
+    bool VM::saveImage(std::string_view path) const {
+        if (mExited) return false;
+
+        std::vector<u8> directory;
+        std::vector<u8> names;
+        std::vector<Function*> functions;
+        size_t functionCount = 0;
+
+        try {
+            directory.assign(ImageMagic, ImageMagic + sizeof(ImageMagic));
+            Put(directory, ImageVersion, 2);
+            Put(directory, 0, 2);
+            Put(directory, static_cast<u32>(mModules.size()), 4);
+            directory.resize(ImageHeaderSize); // function count and names size go in once they're known
+
+            // modules follow the directory, so their offsets need its size
+            size_t namesSize = 0;
+            for (size_t id = 0; id < mSymbols.size(); id++) {
+                Function& function = mSymbols.get(static_cast<u32>(id));
+                if (function.target().host != nullptr) continue;
+
+                functions.push_back(&function);
+                namesSize += function.getName().size();
+            }
+            functionCount = functions.size();
+
+            // by where they are, so the call entries linked to them can be mapped back with a binary search on load
+            std::stable_sort(functions.begin(), functions.end(), [](Function* lhs, Function* rhs) {
+                return ImageFunctionKey(lhs->getModule(), lhs->target().entry.getPosition()) <
+                       ImageFunctionKey(rhs->getModule(), rhs->target().entry.getPosition());
+            });
+
+            size_t offset = ImageHeaderSize + mModules.size() * ImageModuleSize + functionCount * ImageFunctionSize + namesSize;
+
+            for (const std::unique_ptr<Module>& module : mModules) {
+                size_t size = BbxHeadersSize + module->data().getSection().getSize() + module->strtab().getSection().getSize() +
+                              module->code().getSection().getSize() + module->links().getSection().getSize();
+                if (offset + size > std::numeric_limits<u32>::max()) return false;
+
+                Put(directory, static_cast<u32>(offset), 4);
+                Put(directory, static_cast<u32>(size), 4);
+
+                offset += size;
+            }
+
+            for (Function* function : functions) {
+                Put(directory, function->getModule(), 4);
+                Put(directory, static_cast<u32>(function->target().entry.getPosition()), 4);
+                Put(directory, static_cast<u32>(names.size()), 4);
+                Put(directory, static_cast<u32>(function->getName().size()), 4);
+
+                names.insert(names.end(), function->getName().begin(), function->getName().end());
+            }
+
+            directory.insert(directory.end(), names.begin(), names.end());
+        } catch (...) {
+            return false;
+        }
+
+        for (int i = 0; i < 4; i++) {
+            directory[12 + i] = static_cast<u8>(functionCount >> (24 - i * 8));
+            directory[16 + i] = static_cast<u8>(names.size() >> (24 - i * 8));
+        }
+
+        std::FILE* file = std::fopen(std::string(path).c_str(), "wb");
+        if (file == nullptr) return false;
+
+        auto write = [file](std::span<const u8> bytes) {
+            return bytes.empty() || std::fwrite(bytes.data(), 1, bytes.size(), file) == bytes.size();
+        };
+
+        bool written = write(directory);
+
+        // each module as a bbx file of its own, with the data section as linking left it
+        for (const std::unique_ptr<Module>& module : mModules) {
+            std::span<const u8> sections[BbxSectionCount] = {
+                module->data().getSection().getUnderlyingSpan(),
+                module->strtab().getSection().getUnderlyingSpan(),
+                module->code().getSection().getUnderlyingSpan(),
+                module->links().getSection().getUnderlyingSpan(),
+            };
+            BbxSectionKind kinds[BbxSectionCount] = {
+                BbxSectionKind::DATA, BbxSectionKind::STRTAB, BbxSectionKind::CODE, BbxSectionKind::LINK,
+            };
+
+            std::vector<u8> headers(BbxMagic, BbxMagic + sizeof(BbxMagic));
+            Put(headers, BbxVersion, 2);
+            Put(headers, BbxSectionCount, 2);
+
+            u32 sectionOffset = BbxHeadersSize;
+            for (size_t i = 0; i < BbxSectionCount; i++) {
+                Put(headers, static_cast<u32>(kinds[i]), 4);
+                Put(headers, sectionOffset, 4);
+                Put(headers, static_cast<u32>(sections[i].size()), 4);
+                Put(headers, 0, 4);
+
+                sectionOffset += static_cast<u32>(sections[i].size());
+            }
+
+            written = written && write(headers);
+            for (std::span<const u8> section : sections) written = written && write(section);
+        }
+
+        return std::fclose(file) == 0 && written;
+    }
+
+    Function* VM::getImageFunction(u32 module, u32 address) const {
+        if (mExited) return nullptr;
+
+        u64 key = ImageFunctionKey(module, address);
+
+        auto it = std::lower_bound(mImageFunctions.begin(), mImageFunctions.end(), key);
+        if (it == mImageFunctions.end() || *it != key) return nullptr;
+
+        return &mSymbols.get(static_cast<u32>(it - mImageFunctions.begin())); // the first added at that entry
+    }
+
+    std::unique_ptr<VM> CreateVMFromImage(std::string_view path, VMConfig config) {
+        std::FILE* file = std::fopen(std::string(path).c_str(), "rb");
+        if (file == nullptr) return nullptr;
+
+        long fileSize = -1;
+        if (std::fseek(file, 0, SEEK_END) == 0) fileSize = std::ftell(file);
+
+        u8 headerBytes[ImageHeaderSize];
+        bool read = std::fseek(file, 0, SEEK_SET) == 0 && std::fread(headerBytes, 1, ImageHeaderSize, file) == ImageHeaderSize;
+
+        Section header(headerBytes);
+        if (!read || std::memcmp(headerBytes, ImageMagic, sizeof(ImageMagic)) != 0 || header.getU16(4).value() != ImageVersion) {
+            std::fclose(file);
+            return nullptr;
+        }
+
+        u32 moduleCount = header.getU32(8).value();
+        u32 functionCount = header.getU32(12).value();
+        u32 namesSize = header.getU32(16).value();
+
+        // the rest of the directory, which the VM keeps for the names
+        size_t modulesOffset = ImageHeaderSize;
+        size_t functionsOffset = modulesOffset + static_cast<size_t>(moduleCount) * ImageModuleSize;
+        size_t namesOffset = functionsOffset + static_cast<size_t>(functionCount) * ImageFunctionSize;
+        size_t directorySize = namesOffset + namesSize;
+
+        if (directorySize > static_cast<size_t>(fileSize)) {
+            std::fclose(file);
+            return nullptr;
+        }
+
+        std::unique_ptr<u8[]> directoryBytes;
+        try {
+            directoryBytes = std::make_unique_for_overwrite<u8[]>(directorySize);
+        } catch (...) {
+            std::fclose(file);
+            return nullptr;
+        }
+
+        std::memcpy(directoryBytes.get(), headerBytes, ImageHeaderSize);
+        read = std::fread(directoryBytes.get() + ImageHeaderSize, 1, directorySize - ImageHeaderSize, file) == directorySize - ImageHeaderSize;
+        std::fclose(file);
+
+        if (!read) return nullptr;
+
+        std::string_view names(reinterpret_cast<const char*>(directoryBytes.get() + namesOffset), namesSize);
+
+        std::unique_ptr<VM> vm = CreateVM(config);
+
+        // linking waits for the functions, which the linked call entries are mapped back to
+        vm->mConfig.eagerLink = false;
+
+        try {
+            vm->mImageFunctions.reserve(functionCount);
+        } catch (...) {
+            return nullptr;
+        }
+
+        for (u32 i = 0; i < moduleCount; i++) {
+            const u8* entry = directoryBytes.get() + modulesOffset + i * ImageModuleSize;
+
+            std::unique_ptr<Module> module = LoadBbxFile(path, Get(entry), Get(entry + 4));
+            if (module == nullptr) return nullptr;
+
+            // a fresh VM hands out handles in order, which is what the linked call entries refer to
+            if (vm->addModule(std::move(module)) != i) return nullptr;
+        }
+
+        bool sorted = true; // images saved before the table was sorted can't be searched
+
+        for (u32 i = 0; i < functionCount; i++) {
+            const u8* entry = directoryBytes.get() + functionsOffset + i * ImageFunctionSize;
+
+            u32 module = Get(entry);
+            u32 address = Get(entry + 4);
+            u32 nameOffset = Get(entry + 8);
+            u32 nameSize = Get(entry + 12);
+
+            if (nameOffset > namesSize || nameSize > namesSize - nameOffset) return nullptr;
+            std::string_view name = names.substr(nameOffset, nameSize);
+
+            Module* owner = vm->getModule(module);
+            if (owner == nullptr) return nullptr;
+
+            std::optional<BytecodeReader> bytecode = owner->code().getBytecodeReader(address);
+            if (!bytecode.has_value()) return nullptr;
+
+            // a fresh VM hands out ids in order too, so the function table maps to them
+            if (vm->addFunction(module, name, CallableTarget(module, bytecode.value())) != i) return nullptr;
+
+            u64 key = ImageFunctionKey(module, address);
+            if (!vm->mImageFunctions.empty() && key < vm->mImageFunctions.back()) sorted = false;
+            vm->mImageFunctions.push_back(key);
+        }
+
+        if (!sorted) vm->mImageFunctions = {};
+        vm->mImageDirectory = std::move(directoryBytes);
+
+        vm->mConfig.eagerLink = config.eagerLink;
+        if (config.eagerLink) {
+            for (u32 i = 0; i < moduleCount; i++) vm->linkModule(i);
+        }
+
+        return vm;
+    }
+}
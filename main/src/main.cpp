@@ -1,15 +1,32 @@
 // Copyright 2025 JesusTouchMe
 
+#include <BibbleVM/core/module/bbx_loader.h>
 #include <BibbleVM/core/vm.h>
 
 #include <iostream>
 
-int main() {
+int main(int argc, char** argv) {
     auto vm = bibble::CreateVM();
 
     vm->stack().pushFrame(1);
 
-    bibble::u8 bytecodeArr[] = {
+    static constexpr bibble::u8 bytecodeArr[] = {
+        // header
+        'B', 'B', 'X', 0x00, // magic
+        0x00, 0x01, // version
+        0x00, 0x02, // section count
+
+        // section header table
+        0x00, 0x00, 0x00, 0x01, // data
+        0x00, 0x00, 0x00, 0x28, // offset
+        0x00, 0x00, 0x00, 0x10, // size
+        0x00, 0x00, 0x00, 0x00, // reserved
+
+        0x00, 0x00, 0x00, 0x03, // code
+        0x00, 0x00, 0x00, 0x38,
+        0x00, 0x00, 0x00, 0x16,
+        0x00, 0x00, 0x00, 0x00,
+
         // data section
 
         // main
@@ -37,14 +54,17 @@ int main() {
         0x9F, // RET
     };
 
-    std::unique_ptr<bibble::u8[]> bytecode = std::make_unique<bibble::u8[]>(sizeof(bytecodeArr));
-    std::memcpy(bytecode.get(), bytecodeArr, sizeof(bytecodeArr));
+    // main is at the start of the code section, in a bbx file given on the command line or the one above
+    std::unique_ptr<bibble::Module> loaded;
+    if (argc > 1) loaded = bibble::LoadBbxFile(argv[1]);
+    else loaded = bibble::LoadBbx(bytecodeArr);
 
-    bibble::Section data({ &bytecode[0], 16 });
-    bibble::Section strtab({ &bytecode[16], 0 });
-    bibble::Section code({ &bytecode[16], 22 });
+    if (loaded == nullptr) {
+        std::cerr << "Failed to load module\n";
+        return 1;
+    }
 
-    bibble::u32 moduleH = vm->addModule(std::make_unique<bibble::Module>(std::move(bytecode), bibble::DataSection(data), bibble::StrtabSection(strtab), bibble::CodeSection(code)));
+    bibble::u32 moduleH = vm->addModule(std::move(loaded));
     if (vm->hasExited()) {
         std::cerr << "Failed to add module to VM\n";
         return vm->getExitCode();
@@ -64,13 +84,13 @@ int main() {
 
     bibble::CallableTarget mainTarget = {moduleH, mainEntry.value()};
 
-    vm->addFunction(std::make_unique<bibble::Function>(moduleH, "main", mainTarget));
+    bibble::u32 mainId = vm->addFunction(moduleH, "main", mainTarget);
     if (vm->hasExited()) {
         std::cerr << "Failed to add main() to VM\n";
         return vm->getExitCode();
     }
 
-    bibble::Function* mainFunction = vm->getFunction("main");
+    bibble::Function* mainFunction = vm->getFunction(mainId);
     if (mainFunction == nullptr) {
         std::cerr << "VM internal state broken\n";
         return 1;
@@ -81,4 +101,4 @@ int main() {
     if (!vm->hasExited()) return 100;
 
     return vm->getExitCode();
-}
\ No newline at end of file
+}